@@ -0,0 +1,111 @@
+#include "BuddyAllocator.h"
+#include <cassert>
+
+namespace {
+
+[[maybe_unused]] bool IsPowerOfTwo(uint64_t value) {
+	return value != 0 && (value & (value - 1)) == 0;
+}
+
+}
+
+void BuddyAllocator::Initialize(uint64_t capacity, uint64_t minBlockSize) {
+	assert(IsPowerOfTwo(capacity));
+	assert(IsPowerOfTwo(minBlockSize));
+	assert(capacity >= minBlockSize);
+	capacity_ = capacity;
+	levelCount_ = 1;
+	while ((capacity >> (levelCount_ - 1)) > minBlockSize) {
+		++levelCount_;
+	}
+	freeBlocks_.assign(levelCount_, {});
+	// 最初は全体が1つの空きブロック
+	freeBlocks_[0].insert(0);
+	allocations_.clear();
+	usedBytes_ = 0;
+	requestedBytes_ = 0;
+}
+
+uint64_t BuddyAllocator::Allocate(uint64_t size, uint64_t alignment) {
+	assert(capacity_ != 0);
+	assert(size > 0);
+	assert(IsPowerOfTwo(alignment));
+	uint64_t needed = size > alignment ? size : alignment;
+	if (needed > capacity_) {
+		return kInvalidOffset;
+	}
+
+	// 収まる一番小さいレベルを探す
+	uint32_t level = levelCount_ - 1;
+	while (GetBlockSize(level) < needed) {
+		--level;
+	}
+
+	// そのレベルより大きい方へ、空きブロックがあるところまで遡る
+	uint32_t sourceLevel = level;
+	while (freeBlocks_[sourceLevel].empty()) {
+		if (sourceLevel == 0) {
+			return kInvalidOffset;
+		}
+		--sourceLevel;
+	}
+
+	uint64_t offset = *freeBlocks_[sourceLevel].begin();
+	freeBlocks_[sourceLevel].erase(freeBlocks_[sourceLevel].begin());
+	// 目的のサイズになるまで半分に割り、後ろ半分を空きに戻す
+	while (sourceLevel < level) {
+		++sourceLevel;
+		freeBlocks_[sourceLevel].insert(offset + GetBlockSize(sourceLevel));
+	}
+
+	allocations_.emplace(offset, AllocationInfo{ level, size });
+	usedBytes_ += GetBlockSize(level);
+	requestedBytes_ += size;
+	return offset;
+}
+
+void BuddyAllocator::Free(uint64_t offset) {
+	auto it = allocations_.find(offset);
+	assert(it != allocations_.end());
+	uint32_t level = it->second.level;
+	usedBytes_ -= GetBlockSize(level);
+	requestedBytes_ -= it->second.requestedSize;
+	allocations_.erase(it);
+
+	// 相方（バディ）も空いていれば結合して1つ上のレベルへ
+	while (level > 0) {
+		uint64_t buddy = offset ^ GetBlockSize(level);
+		auto buddyIt = freeBlocks_[level].find(buddy);
+		if (buddyIt == freeBlocks_[level].end()) {
+			break;
+		}
+		freeBlocks_[level].erase(buddyIt);
+		offset = offset < buddy ? offset : buddy;
+		--level;
+	}
+	freeBlocks_[level].insert(offset);
+}
+
+BuddyAllocator::Statistics BuddyAllocator::GetStatistics() const {
+	Statistics statistics;
+	statistics.capacity = capacity_;
+	statistics.usedBytes = usedBytes_;
+	statistics.requestedBytes = requestedBytes_;
+	statistics.allocationCount = allocations_.size();
+	for (uint32_t level = 0; level < levelCount_; ++level) {
+		if (!freeBlocks_[level].empty() && statistics.largestFreeBlock == 0) {
+			statistics.largestFreeBlock = GetBlockSize(level);
+		}
+		statistics.freeBlockCount += freeBlocks_[level].size();
+	}
+	return statistics;
+}
+
+float BuddyAllocator::GetFragmentation() const {
+	uint64_t freeBytes = capacity_ - usedBytes_;
+	if (freeBytes == 0) {
+		return 0.0f;
+	}
+	Statistics statistics = GetStatistics();
+	return 1.0f - float(double(statistics.largestFreeBlock) / double(freeBytes));
+}
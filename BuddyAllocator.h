@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <set>
+#include <unordered_map>
+
+// 2の累乗サイズのブロックを分割・結合して領域を管理するバディアロケータ
+// オフセットの管理だけを行い、実際のメモリ（ID3D12Heapなど）には触らない
+class BuddyAllocator {
+public:
+	// 確保できなかったときのオフセット
+	static constexpr uint64_t kInvalidOffset = ~0ull;
+
+	// 使用状況
+	struct Statistics {
+		// 管理している領域全体
+		uint64_t capacity = 0;
+		// 割り当てたブロックの合計（2の累乗に切り上げた後）
+		uint64_t usedBytes = 0;
+		// 要求されたサイズの合計
+		uint64_t requestedBytes = 0;
+		uint64_t allocationCount = 0;
+		// 空いている一番大きなブロック
+		uint64_t largestFreeBlock = 0;
+		uint64_t freeBlockCount = 0;
+	};
+
+	// capacityとminBlockSizeは2の累乗で、capacity >= minBlockSizeであること
+	void Initialize(uint64_t capacity, uint64_t minBlockSize);
+
+	// ブロックは自分のサイズの境界に並ぶので、alignmentはブロックサイズに含めて扱う
+	// 入らなければkInvalidOffsetを返す
+	uint64_t Allocate(uint64_t size, uint64_t alignment = 1);
+	void Free(uint64_t offset);
+
+	Statistics GetStatistics() const;
+	// 外部断片化の度合い。0なら空き領域が1つにまとまっている。1に近いほど細切れ
+	float GetFragmentation() const;
+
+	uint64_t GetCapacity() const { return capacity_; }
+	bool IsEmpty() const { return allocations_.empty(); }
+
+private:
+	struct AllocationInfo {
+		uint32_t level;
+		uint64_t requestedSize;
+	};
+
+	// level 0が全体、levelが1増えるごとにブロックは半分になる
+	uint64_t GetBlockSize(uint32_t level) const { return capacity_ >> level; }
+
+	uint64_t capacity_ = 0;
+	uint32_t levelCount_ = 0;
+	// レベルごとの空きブロックの先頭オフセット。小さいオフセットから使うのでsetで持つ
+	std::vector<std::set<uint64_t>> freeBlocks_;
+	std::unordered_map<uint64_t, AllocationInfo> allocations_;
+	uint64_t usedBytes_ = 0;
+	uint64_t requestedBytes_ = 0;
+};
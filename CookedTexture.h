@@ -0,0 +1,13 @@
+#pragma once
+#include <filesystem>
+
+// TextureCookerが書き出すDDSの置き場所。ゲームとクッカーで同じ規則を使う
+// resources/uvChecker.png -> resources/cooked/uvChecker.dds
+inline std::filesystem::path GetCookedTexturePath(const std::filesystem::path& sourcePath) {
+	std::filesystem::path cookedPath = sourcePath.parent_path() / "cooked" / sourcePath.filename();
+	cookedPath.replace_extension(".dds");
+	return cookedPath;
+}
+
+// クッカーが入力の内容ハッシュを記録するファイル。入力ディレクトリの直下に置く
+inline constexpr const char* kCookedTextureManifestName = "cooked_manifest.txt";
@@ -0,0 +1,45 @@
+#include "D3D12GpuTimeline.h"
+#include <cassert>
+
+void D3D12GpuTimeline::Initialize(ID3D12Device* device, ID3D12CommandQueue* commandQueue) {
+	commandQueue_ = commandQueue;
+	// 初期値０でFenceを作る
+	fenceValue_ = 0;
+	HRESULT hr = device->CreateFence(fenceValue_, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_));
+	assert(SUCCEEDED(hr));
+
+	// FenceのSignalを持つためのイベントを作成する
+	fenceEvent_ = CreateEvent(NULL, FALSE, FALSE, NULL);
+	assert(fenceEvent_ != nullptr);
+}
+
+void D3D12GpuTimeline::Finalize() {
+	CloseHandle(fenceEvent_);
+	fence_->Release();
+	fenceEvent_ = nullptr;
+	fence_ = nullptr;
+}
+
+uint64_t D3D12GpuTimeline::Signal() {
+	// Fenceの値を更新
+	fenceValue_++;
+	// GPUがここまでたどり着いたときに、Fenceの値を指定した値に代入するようにSignalを送る
+	HRESULT hr = commandQueue_->Signal(fence_, fenceValue_);
+	assert(SUCCEEDED(hr));
+	return fenceValue_;
+}
+
+uint64_t D3D12GpuTimeline::GetCompletedValue() {
+	// GetCompletedValueの初期値はFence作成時に渡した初期値
+	return fence_->GetCompletedValue();
+}
+
+void D3D12GpuTimeline::WaitForValue(uint64_t value) {
+	// Fenceの値が指定したSignal値にたどり着いているか確認する
+	if (fence_->GetCompletedValue() < value) {
+		// 指定したSignalにたどりついていないので、たどり着くまで待つようにイベントを設定する
+		fence_->SetEventOnCompletion(value, fenceEvent_);
+		// イベントを待つ
+		WaitForSingleObject(fenceEvent_, INFINITE);
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <Windows.h>
+#include <d3d12.h>
+#include "FrameRing.h"
+
+// CommandQueueとFenceによるIGpuTimelineの実装
+class D3D12GpuTimeline : public IGpuTimeline {
+public:
+	void Initialize(ID3D12Device* device, ID3D12CommandQueue* commandQueue);
+	void Finalize();
+
+	uint64_t Signal() override;
+	uint64_t GetCompletedValue() override;
+	void WaitForValue(uint64_t value) override;
+
+	ID3D12Fence* GetFence() const { return fence_; }
+
+private:
+	ID3D12CommandQueue* commandQueue_ = nullptr;
+	ID3D12Fence* fence_ = nullptr;
+	HANDLE fenceEvent_ = nullptr;
+	uint64_t fenceValue_ = 0;
+};
@@ -0,0 +1,231 @@
+#include "D3D12PipelineStateCache.h"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+
+uint64_t HashShader(const D3D12_SHADER_BYTECODE& shader) {
+	return HashPipelineBytecode(shader.pShaderBytecode, shader.BytecodeLength);
+}
+
+void CopyBlendTarget(const D3D12_RENDER_TARGET_BLEND_DESC& source, PipelineBlendTargetDesc& destination) {
+	destination.blendEnable = source.BlendEnable;
+	destination.logicOpEnable = source.LogicOpEnable;
+	destination.srcBlend = source.SrcBlend;
+	destination.destBlend = source.DestBlend;
+	destination.blendOp = source.BlendOp;
+	destination.srcBlendAlpha = source.SrcBlendAlpha;
+	destination.destBlendAlpha = source.DestBlendAlpha;
+	destination.blendOpAlpha = source.BlendOpAlpha;
+	destination.logicOp = source.LogicOp;
+	destination.renderTargetWriteMask = source.RenderTargetWriteMask;
+}
+
+void CopyStencilOp(const D3D12_DEPTH_STENCILOP_DESC& source, PipelineStencilOpDesc& destination) {
+	destination.failOp = source.StencilFailOp;
+	destination.depthFailOp = source.StencilDepthFailOp;
+	destination.passOp = source.StencilPassOp;
+	destination.func = source.StencilFunc;
+}
+
+}
+
+void D3D12PipelineStateCache::Initialize(ID3D12Device* device, const std::filesystem::path& libraryPath) {
+	device_ = device;
+	libraryPath_ = libraryPath;
+	dirty_ = false;
+	statistics_ = {};
+
+	// PipelineLibraryはID3D12Device1から使える。使えなければファイルには残さずメモリの上だけで使い回す
+	ID3D12Device1* device1 = nullptr;
+	if (FAILED(device_->QueryInterface(IID_PPV_ARGS(&device1)))) {
+		return;
+	}
+	auto start = std::chrono::steady_clock::now();
+	std::ifstream file(libraryPath_, std::ios::binary | std::ios::ate);
+	if (file) {
+		libraryData_.resize(size_t(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(libraryData_.data()), std::streamsize(libraryData_.size()));
+		if (!file) {
+			libraryData_.clear();
+		}
+	}
+	if (!libraryData_.empty()) {
+		// ドライバやGPUが変わっていたり、ファイルが壊れていたりすると失敗する
+		HRESULT hr = device1->CreatePipelineLibrary(libraryData_.data(), libraryData_.size(), IID_PPV_ARGS(&library_));
+		if (FAILED(hr)) {
+			statistics_.libraryRejected = true;
+			libraryData_.clear();
+			library_ = nullptr;
+		}
+	}
+	if (library_ == nullptr) {
+		HRESULT hr = device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&library_));
+		if (FAILED(hr)) {
+			library_ = nullptr;
+		}
+		// 作り直した場合は、古いファイルを次の保存で置き換える
+		dirty_ = statistics_.libraryRejected;
+	}
+	statistics_.libraryLoadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	device1->Release();
+}
+
+void D3D12PipelineStateCache::Finalize() {
+	if (dirty_) {
+		Save();
+	}
+	for (auto& [key, pipelineState] : pipelineStates_) {
+		pipelineState->Release();
+	}
+	pipelineStates_.clear();
+	rootSignatureHashes_.clear();
+	if (library_) {
+		library_->Release();
+		library_ = nullptr;
+	}
+	libraryData_.clear();
+}
+
+void D3D12PipelineStateCache::RegisterRootSignature(ID3D12RootSignature* rootSignature, const void* serializedData, size_t serializedSize) {
+	rootSignatureHashes_[rootSignature] = HashPipelineBytecode(serializedData, serializedSize);
+}
+
+ID3D12PipelineState* D3D12PipelineStateCache::GetGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) {
+	uint64_t key = HashGraphicsPipelineKeyDesc(MakeKeyDesc(desc));
+	auto it = pipelineStates_.find(key);
+	if (it != pipelineStates_.end()) {
+		++statistics_.memoryHitCount;
+		return it->second;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	wchar_t name[32];
+	swprintf_s(name, L"%016llx", static_cast<unsigned long long>(key));
+	ID3D12PipelineState* pipelineState = nullptr;
+	if (library_) {
+		// 無ければE_INVALIDARGが返る
+		if (SUCCEEDED(library_->LoadGraphicsPipeline(name, &desc, IID_PPV_ARGS(&pipelineState)))) {
+			++statistics_.libraryHitCount;
+		} else {
+			pipelineState = nullptr;
+		}
+	}
+	if (pipelineState == nullptr) {
+		HRESULT hr = device_->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipelineState));
+		assert(SUCCEEDED(hr));
+		++statistics_.createdCount;
+		if (library_ && SUCCEEDED(library_->StorePipeline(name, pipelineState))) {
+			dirty_ = true;
+		}
+	}
+	statistics_.createSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	pipelineStates_.emplace(key, pipelineState);
+	return pipelineState;
+}
+
+bool D3D12PipelineStateCache::RemoveGraphicsPipelineState(ID3D12PipelineState* pipelineState) {
+	for (auto it = pipelineStates_.begin(); it != pipelineStates_.end(); ++it) {
+		if (it->second == pipelineState) {
+			pipelineStates_.erase(it);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool D3D12PipelineStateCache::Save() {
+	if (library_ == nullptr) {
+		return false;
+	}
+	std::vector<uint8_t> data(library_->GetSerializedSize());
+	if (FAILED(library_->Serialize(data.data(), data.size()))) {
+		return false;
+	}
+	// 一時ファイルに書いてから置き換えるので、途中で落ちても前のファイルは壊れない
+	std::filesystem::path temporaryPath = libraryPath_;
+	temporaryPath += ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+		if (!file) {
+			return false;
+		}
+	}
+	std::error_code errorCode;
+	std::filesystem::rename(temporaryPath, libraryPath_, errorCode);
+	if (errorCode) {
+		return false;
+	}
+	dirty_ = false;
+	return true;
+}
+
+GraphicsPipelineKeyDesc D3D12PipelineStateCache::MakeKeyDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) const {
+	GraphicsPipelineKeyDesc keyDesc;
+	auto rootSignature = rootSignatureHashes_.find(desc.pRootSignature);
+	// 登録されていないRootSignatureではキーが作れない
+	assert(rootSignature != rootSignatureHashes_.end());
+	keyDesc.rootSignatureHash = rootSignature != rootSignatureHashes_.end() ? rootSignature->second : 0;
+	keyDesc.vertexShaderHash = HashShader(desc.VS);
+	keyDesc.pixelShaderHash = HashShader(desc.PS);
+	keyDesc.domainShaderHash = HashShader(desc.DS);
+	keyDesc.hullShaderHash = HashShader(desc.HS);
+	keyDesc.geometryShaderHash = HashShader(desc.GS);
+	// StreamOutputは使わない
+	assert(desc.StreamOutput.NumEntries == 0);
+
+	keyDesc.alphaToCoverageEnable = desc.BlendState.AlphaToCoverageEnable;
+	keyDesc.independentBlendEnable = desc.BlendState.IndependentBlendEnable;
+	for (uint32_t i = 0; i < GraphicsPipelineKeyDesc::kRenderTargetCount; ++i) {
+		CopyBlendTarget(desc.BlendState.RenderTarget[i], keyDesc.renderTargetBlends[i]);
+		keyDesc.rtvFormats[i] = desc.RTVFormats[i];
+	}
+	keyDesc.sampleMask = desc.SampleMask;
+
+	keyDesc.fillMode = desc.RasterizerState.FillMode;
+	keyDesc.cullMode = desc.RasterizerState.CullMode;
+	keyDesc.frontCounterClockwise = desc.RasterizerState.FrontCounterClockwise;
+	keyDesc.depthBias = desc.RasterizerState.DepthBias;
+	keyDesc.depthBiasClamp = desc.RasterizerState.DepthBiasClamp;
+	keyDesc.slopeScaledDepthBias = desc.RasterizerState.SlopeScaledDepthBias;
+	keyDesc.depthClipEnable = desc.RasterizerState.DepthClipEnable;
+	keyDesc.multisampleEnable = desc.RasterizerState.MultisampleEnable;
+	keyDesc.antialiasedLineEnable = desc.RasterizerState.AntialiasedLineEnable;
+	keyDesc.forcedSampleCount = desc.RasterizerState.ForcedSampleCount;
+	keyDesc.conservativeRaster = desc.RasterizerState.ConservativeRaster;
+
+	keyDesc.depthEnable = desc.DepthStencilState.DepthEnable;
+	keyDesc.depthWriteMask = desc.DepthStencilState.DepthWriteMask;
+	keyDesc.depthFunc = desc.DepthStencilState.DepthFunc;
+	keyDesc.stencilEnable = desc.DepthStencilState.StencilEnable;
+	keyDesc.stencilReadMask = desc.DepthStencilState.StencilReadMask;
+	keyDesc.stencilWriteMask = desc.DepthStencilState.StencilWriteMask;
+	CopyStencilOp(desc.DepthStencilState.FrontFace, keyDesc.frontFace);
+	CopyStencilOp(desc.DepthStencilState.BackFace, keyDesc.backFace);
+
+	keyDesc.inputLayout.resize(desc.InputLayout.NumElements);
+	for (UINT i = 0; i < desc.InputLayout.NumElements; ++i) {
+		const D3D12_INPUT_ELEMENT_DESC& source = desc.InputLayout.pInputElementDescs[i];
+		PipelineInputElementDesc& element = keyDesc.inputLayout[i];
+		element.semanticName = source.SemanticName;
+		element.semanticIndex = source.SemanticIndex;
+		element.format = source.Format;
+		element.inputSlot = source.InputSlot;
+		element.alignedByteOffset = source.AlignedByteOffset;
+		element.inputSlotClass = source.InputSlotClass;
+		element.instanceDataStepRate = source.InstanceDataStepRate;
+	}
+	keyDesc.indexBufferStripCutValue = desc.IBStripCutValue;
+	keyDesc.primitiveTopologyType = desc.PrimitiveTopologyType;
+	keyDesc.numRenderTargets = desc.NumRenderTargets;
+	keyDesc.dsvFormat = desc.DSVFormat;
+	keyDesc.sampleCount = desc.SampleDesc.Count;
+	keyDesc.sampleQuality = desc.SampleDesc.Quality;
+	keyDesc.flags = desc.Flags;
+	// NodeMaskとCachedPSOは中身に関わらないので混ぜない
+	return keyDesc;
+}
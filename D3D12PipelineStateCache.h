@@ -0,0 +1,58 @@
+#pragma once
+#include <d3d12.h>
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
+#include "PipelineStateKey.h"
+
+// GraphicsPipelineStateを記述の中身のハッシュで使い回す
+// 作ったPSOはID3D12PipelineLibraryに入れてファイルへ保存し、次の起動ではドライバのコンパイルを省いて読み込む
+// ドライバが変わるなどで保存したライブラリが使えなければ、空のライブラリから作り直す
+class D3D12PipelineStateCache {
+public:
+	struct Statistics {
+		// このプロセスで作ったものを返した数
+		uint32_t memoryHitCount = 0;
+		// 保存したライブラリから読んだ数
+		uint32_t libraryHitCount = 0;
+		// ドライバでコンパイルした数
+		uint32_t createdCount = 0;
+		double libraryLoadSeconds = 0.0;
+		double createSeconds = 0.0;
+		// 保存したライブラリを使えずに作り直した
+		bool libraryRejected = false;
+	};
+
+	void Initialize(ID3D12Device* device, const std::filesystem::path& libraryPath);
+	// 新しく作ったPSOがあればライブラリを保存し、全てのPSOを解放する
+	void Finalize();
+
+	// RootSignatureはポインタから中身が分からないので、シリアライズしたバイナリと一緒に登録しておく
+	void RegisterRootSignature(ID3D12RootSignature* rootSignature, const void* serializedData, size_t serializedSize);
+
+	// 同じ記述のPSOがあればそれを、無ければ作って返す。返したPSOはキャッシュが持っているのでReleaseしないこと
+	ID3D12PipelineState* GetGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+	// 使わなくなったPSOをキャッシュから外し、解放を呼ぶ側に任せる。GPUが使い終わってからReleaseすること
+	// 同じ記述が次に求められたらライブラリから読み直す。キャッシュに無ければfalse
+	bool RemoveGraphicsPipelineState(ID3D12PipelineState* pipelineState);
+
+	// ライブラリをファイルに書き出す。Finalizeでも呼ばれる
+	bool Save();
+
+	Statistics GetStatistics() const { return statistics_; }
+
+	// D3D12の記述をキーの計算用の値に写す
+	GraphicsPipelineKeyDesc MakeKeyDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) const;
+
+private:
+	ID3D12Device* device_ = nullptr;
+	ID3D12PipelineLibrary* library_ = nullptr;
+	// ライブラリは読み込んだバイナリを参照し続けるので、ライブラリより長く持っておく
+	std::vector<uint8_t> libraryData_;
+	std::filesystem::path libraryPath_;
+	bool dirty_ = false;
+	std::unordered_map<ID3D12RootSignature*, uint64_t> rootSignatureHashes_;
+	std::unordered_map<uint64_t, ID3D12PipelineState*> pipelineStates_;
+	Statistics statistics_;
+};
@@ -0,0 +1,111 @@
+#include "D3D12ResourceAllocator.h"
+#include <cassert>
+
+namespace {
+
+GpuHeapType ToGpuHeapType(D3D12_HEAP_TYPE heapType) {
+	switch (heapType) {
+	case D3D12_HEAP_TYPE_UPLOAD:
+		return GpuHeapType::Upload;
+	case D3D12_HEAP_TYPE_READBACK:
+		return GpuHeapType::Readback;
+	default:
+		assert(heapType == D3D12_HEAP_TYPE_DEFAULT);
+		return GpuHeapType::Default;
+	}
+}
+
+D3D12_HEAP_TYPE ToD3D12HeapType(GpuHeapType heapType) {
+	switch (heapType) {
+	case GpuHeapType::Upload:
+		return D3D12_HEAP_TYPE_UPLOAD;
+	case GpuHeapType::Readback:
+		return D3D12_HEAP_TYPE_READBACK;
+	default:
+		return D3D12_HEAP_TYPE_DEFAULT;
+	}
+}
+
+GpuResourceCategory GetResourceCategory(const D3D12_RESOURCE_DESC& resourceDesc) {
+	if (resourceDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) {
+		return GpuResourceCategory::Buffer;
+	}
+	if (resourceDesc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) {
+		return GpuResourceCategory::RenderTarget;
+	}
+	return GpuResourceCategory::Texture;
+}
+
+}
+
+void D3D12ResourceAllocator::Initialize(ID3D12Device* device, uint64_t heapSize) {
+	device_ = device;
+	memoryAllocator_.Initialize(this, heapSize);
+}
+
+void D3D12ResourceAllocator::Finalize() {
+	assert(allocations_.empty());
+	memoryAllocator_.Finalize();
+}
+
+ID3D12Resource* D3D12ResourceAllocator::CreateResource(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC& resourceDesc, D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* clearValue) {
+	// 必要なサイズと配置単位をドライバに聞く
+	D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = device_->GetResourceAllocationInfo(0, 1, &resourceDesc);
+	assert(allocationInfo.SizeInBytes != UINT64_MAX);
+
+	GpuMemoryAllocation allocation = memoryAllocator_.Allocate(
+		ToGpuHeapType(heapType), GetResourceCategory(resourceDesc), allocationInfo.SizeInBytes, allocationInfo.Alignment);
+
+	// Heapの中の割り当てた位置にResourceを置く
+	ID3D12Resource* resource = nullptr;
+	HRESULT hr = device_->CreatePlacedResource(
+		static_cast<ID3D12Heap*>(allocation.heap),
+		allocation.offset,
+		&resourceDesc,
+		initialState,
+		clearValue,
+		IID_PPV_ARGS(&resource));
+	assert(SUCCEEDED(hr));
+	allocations_.emplace(resource, allocation);
+	return resource;
+}
+
+void D3D12ResourceAllocator::ReleaseResource(ID3D12Resource* resource) {
+	auto it = allocations_.find(resource);
+	assert(it != allocations_.end());
+	// Resourceを先に消してから領域を返す
+	resource->Release();
+	memoryAllocator_.Free(it->second);
+	allocations_.erase(it);
+}
+
+void* D3D12ResourceAllocator::CreateHeap(const GpuHeapDesc& desc) {
+	D3D12_HEAP_DESC heapDesc{};
+	heapDesc.SizeInBytes = desc.size;
+	heapDesc.Properties.Type = ToD3D12HeapType(desc.heapType);
+	// RT/DSはMSAAのものも置けるように4MB単位にしておく
+	heapDesc.Alignment = desc.category == GpuResourceCategory::RenderTarget ?
+		D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	switch (desc.category) {
+	case GpuResourceCategory::Buffer:
+		heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+		break;
+	case GpuResourceCategory::Texture:
+		heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+		break;
+	default:
+		heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+		break;
+	}
+
+	ID3D12Heap* heap = nullptr;
+	HRESULT hr = device_->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap));
+	if (FAILED(hr)) {
+		return nullptr;
+	}
+	return heap;
+}
+
+void D3D12ResourceAllocator::DestroyHeap(void* heap) {
+	static_cast<ID3D12Heap*>(heap)->Release();
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <d3d12.h>
+#include <unordered_map>
+#include "GpuMemoryAllocator.h"
+
+// ID3D12Heapを切り分けてPlacedResourceを作るアロケータ
+// CreateCommittedResourceの代わりに使い、Releaseの代わりにReleaseResourceで返す
+class D3D12ResourceAllocator : public IGpuHeapProvider {
+public:
+	void Initialize(ID3D12Device* device, uint64_t heapSize = GpuMemoryAllocator::kDefaultHeapSize);
+	// 作ったResourceは全て返しておくこと
+	void Finalize();
+
+	ID3D12Resource* CreateResource(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC& resourceDesc, D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* clearValue = nullptr);
+	void ReleaseResource(ID3D12Resource* resource);
+
+	GpuMemoryAllocator::PoolStatistics GetStatistics(GpuHeapType heapType, GpuResourceCategory category) const {
+		return memoryAllocator_.GetStatistics(heapType, category);
+	}
+
+	void* CreateHeap(const GpuHeapDesc& desc) override;
+	void DestroyHeap(void* heap) override;
+
+private:
+	ID3D12Device* device_ = nullptr;
+	GpuMemoryAllocator memoryAllocator_;
+	// Resourceごとの割り当て。解放時に引く
+	std::unordered_map<ID3D12Resource*, GpuMemoryAllocation> allocations_;
+};
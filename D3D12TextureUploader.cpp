@@ -0,0 +1,214 @@
+#include "D3D12TextureUploader.h"
+#include "D3D12ResourceAllocator.h"
+#include "ResourceUtility.h"
+#include <cassert>
+#include <cstring>
+
+void D3D12TextureUploader::Initialize(ID3D12Device* device, D3D12ResourceAllocator* resourceAllocator,
+	D3D12_CPU_DESCRIPTOR_HANDLE srvStart, uint32_t descriptorSize, uint32_t descriptorCount, uint64_t stagingSize) {
+	device_ = device;
+	resourceAllocator_ = resourceAllocator;
+	srvStart_ = srvStart;
+	descriptorSize_ = descriptorSize;
+	descriptorCount_ = descriptorCount;
+	stagingSize_ = stagingSize;
+
+	// コピー専用のCommandQueueを作る。描画のキューとは並行して動く
+	D3D12_COMMAND_QUEUE_DESC commandQueueDesc{};
+	commandQueueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+	HRESULT hr = device_->CreateCommandQueue(&commandQueueDesc, IID_PPV_ARGS(&copyQueue_));
+	assert(SUCCEEDED(hr));
+	for (ID3D12CommandAllocator*& commandAllocator : commandAllocators_) {
+		hr = device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&commandAllocator));
+		assert(SUCCEEDED(hr));
+	}
+	hr = device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, commandAllocators_[0], nullptr, IID_PPV_ARGS(&commandList_));
+	assert(SUCCEEDED(hr));
+	// 作った直後は開いているので閉じておく。BeginCommandsで開き直す
+	commandList_->Close();
+	timeline_.Initialize(device_, copyQueue_);
+	commandRing_.Initialize(&timeline_, kCommandAllocatorCount);
+	recording_ = false;
+	lastFenceValue_ = 0;
+
+	// ステージングバッファは常にMapしたままにする
+	stagingResource_ = CreateBufferResource(resourceAllocator_, stagingSize_);
+	hr = stagingResource_->Map(0, nullptr, reinterpret_cast<void**>(&stagingData_));
+	assert(SUCCEEDED(hr));
+
+	// プレースホルダは白と灰色の4x4の市松模様。小さいのでその場で転送を待つ
+	const uint32_t kPlaceholderSize = 4;
+	uint32_t placeholderPixels[kPlaceholderSize * kPlaceholderSize];
+	for (uint32_t y = 0; y < kPlaceholderSize; ++y) {
+		for (uint32_t x = 0; x < kPlaceholderSize; ++x) {
+			placeholderPixels[y * kPlaceholderSize + x] = ((x ^ y) & 1) ? 0xFF808080 : 0xFFFFFFFF;
+		}
+	}
+	DecodedTexture placeholder;
+	placeholder.width = kPlaceholderSize;
+	placeholder.height = kPlaceholderSize;
+	placeholder.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	placeholder.subresources.push_back({ reinterpret_cast<const uint8_t*>(placeholderPixels),
+		kPlaceholderSize * sizeof(uint32_t), sizeof(placeholderPixels), kPlaceholderSize, kPlaceholderSize });
+	uint64_t uploadSize = 0;
+	placeholder_ = static_cast<ID3D12Resource*>(CreateTexture(placeholder, &uploadSize));
+	assert(uploadSize <= stagingSize_);
+	RecordUpload(placeholder_, placeholder, 0);
+	WaitForValue(Submit());
+	CreateShaderResourceView(kPlaceholderDescriptorIndex, placeholder_, placeholder);
+}
+
+void D3D12TextureUploader::Finalize() {
+	commandRing_.WaitForIdle();
+	ReleaseTemporaryBuffers(lastFenceValue_);
+	resourceAllocator_->ReleaseResource(placeholder_);
+	stagingResource_->Unmap(0, nullptr);
+	resourceAllocator_->ReleaseResource(stagingResource_);
+	commandList_->Release();
+	for (ID3D12CommandAllocator* commandAllocator : commandAllocators_) {
+		commandAllocator->Release();
+	}
+	timeline_.Finalize();
+	copyQueue_->Release();
+}
+
+void* D3D12TextureUploader::CreateTexture(const DecodedTexture& texture, uint64_t* uploadSize) {
+	D3D12_RESOURCE_DESC resourceDesc{};
+	resourceDesc.Width = texture.width;
+	resourceDesc.Height = texture.height;
+	resourceDesc.MipLevels = UINT16(texture.mipLevels);
+	resourceDesc.DepthOrArraySize = UINT16(texture.arraySize);
+	resourceDesc.Format = DXGI_FORMAT(texture.format);
+	resourceDesc.SampleDesc.Count = 1;
+	resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+
+	// ステージングに必要なサイズ。行は256バイト単位に揃えられるので画素の合計より大きくなる
+	device_->GetCopyableFootprints(&resourceDesc, 0, UINT(texture.subresources.size()), 0, nullptr, nullptr, nullptr, uploadSize);
+
+	// 別のキューから触るのでCommonで作る
+	return resourceAllocator_->CreateResource(D3D12_HEAP_TYPE_DEFAULT, resourceDesc, D3D12_RESOURCE_STATE_COMMON);
+}
+
+void D3D12TextureUploader::DestroyTexture(void* texture) {
+	resourceAllocator_->ReleaseResource(static_cast<ID3D12Resource*>(texture));
+}
+
+void D3D12TextureUploader::RecordUpload(void* texture, const DecodedTexture& decoded, uint64_t stagingOffset) {
+	ID3D12Resource* textureResource = static_cast<ID3D12Resource*>(texture);
+	D3D12_RESOURCE_DESC resourceDesc = textureResource->GetDesc();
+	UINT subresourceCount = UINT(decoded.subresources.size());
+	std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(subresourceCount);
+	std::vector<UINT> rowCounts(subresourceCount);
+	std::vector<UINT64> rowSizes(subresourceCount);
+	UINT64 totalSize = 0;
+
+	// リングに入らない大きさなら、このテクスチャ専用の一時バッファを使う
+	ID3D12Resource* sourceBuffer = stagingResource_;
+	uint8_t* sourceData = stagingData_;
+	if (stagingOffset == StagingRing::kInvalidOffset) {
+		device_->GetCopyableFootprints(&resourceDesc, 0, subresourceCount, 0, nullptr, nullptr, nullptr, &totalSize);
+		sourceBuffer = CreateBufferResource(resourceAllocator_, size_t(totalSize));
+		HRESULT hr = sourceBuffer->Map(0, nullptr, reinterpret_cast<void**>(&sourceData));
+		assert(SUCCEEDED(hr));
+		temporaryBuffers_.push_back({ sourceBuffer, 0 });
+		stagingOffset = 0;
+	}
+	device_->GetCopyableFootprints(&resourceDesc, 0, subresourceCount, stagingOffset, layouts.data(), rowCounts.data(), rowSizes.data(), &totalSize);
+	assert(sourceBuffer != stagingResource_ || stagingOffset + totalSize <= stagingSize_);
+
+	BeginCommands();
+	for (UINT i = 0; i < subresourceCount; ++i) {
+		// 1行ずつ、256バイト単位に揃えた行の並びへ詰め替える
+		const TextureSubresource& subresource = decoded.subresources[i];
+		uint8_t* destination = sourceData + layouts[i].Offset;
+		for (UINT row = 0; row < rowCounts[i]; ++row) {
+			std::memcpy(destination + row * layouts[i].Footprint.RowPitch, subresource.pixels + row * subresource.rowPitch, size_t(rowSizes[i]));
+		}
+
+		D3D12_TEXTURE_COPY_LOCATION destinationLocation{};
+		destinationLocation.pResource = textureResource;
+		destinationLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+		destinationLocation.SubresourceIndex = i;
+		D3D12_TEXTURE_COPY_LOCATION sourceLocation{};
+		sourceLocation.pResource = sourceBuffer;
+		sourceLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+		sourceLocation.PlacedFootprint = layouts[i];
+		commandList_->CopyTextureRegion(&destinationLocation, 0, 0, 0, &sourceLocation, nullptr);
+	}
+	if (sourceBuffer != stagingResource_) {
+		sourceBuffer->Unmap(0, nullptr);
+	}
+}
+
+uint64_t D3D12TextureUploader::Submit() {
+	if (!recording_) {
+		return lastFenceValue_;
+	}
+	HRESULT hr = commandList_->Close();
+	assert(SUCCEEDED(hr));
+	ID3D12CommandList* commandLists[] = { commandList_ };
+	copyQueue_->ExecuteCommandLists(1, commandLists);
+	lastFenceValue_ = commandRing_.EndFrame();
+	recording_ = false;
+
+	// この転送で使った一時バッファは、このSignalまで生かしておく
+	for (TemporaryBuffer& temporaryBuffer : temporaryBuffers_) {
+		if (temporaryBuffer.fenceValue == 0) {
+			temporaryBuffer.fenceValue = lastFenceValue_;
+		}
+	}
+	return lastFenceValue_;
+}
+
+uint64_t D3D12TextureUploader::GetCompletedValue() {
+	uint64_t completedValue = timeline_.GetCompletedValue();
+	ReleaseTemporaryBuffers(completedValue);
+	return completedValue;
+}
+
+void D3D12TextureUploader::WaitForValue(uint64_t value) {
+	timeline_.WaitForValue(value);
+}
+
+void D3D12TextureUploader::OnResident(uint32_t textureId, void* texture, const DecodedTexture& decoded) {
+	CreateShaderResourceView(GetDescriptorIndex(textureId), static_cast<ID3D12Resource*>(texture), decoded);
+}
+
+void D3D12TextureUploader::BeginCommands() {
+	if (recording_) {
+		return;
+	}
+	// 前回この区画を使った転送が終わっていればそのまま使える
+	uint32_t index = commandRing_.BeginFrame();
+	HRESULT hr = commandAllocators_[index]->Reset();
+	assert(SUCCEEDED(hr));
+	hr = commandList_->Reset(commandAllocators_[index], nullptr);
+	assert(SUCCEEDED(hr));
+	recording_ = true;
+}
+
+void D3D12TextureUploader::ReleaseTemporaryBuffers(uint64_t completedValue) {
+	for (size_t i = 0; i < temporaryBuffers_.size();) {
+		const TemporaryBuffer& temporaryBuffer = temporaryBuffers_[i];
+		if (temporaryBuffer.fenceValue == 0 || temporaryBuffer.fenceValue > completedValue) {
+			++i;
+			continue;
+		}
+		resourceAllocator_->ReleaseResource(temporaryBuffer.resource);
+		temporaryBuffers_[i] = temporaryBuffers_.back();
+		temporaryBuffers_.pop_back();
+	}
+}
+
+void D3D12TextureUploader::CreateShaderResourceView(uint32_t descriptorIndex, ID3D12Resource* texture, const DecodedTexture& decoded) {
+	assert(descriptorIndex < descriptorCount_);
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+	srvDesc.Format = DXGI_FORMAT(decoded.format);
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;//2Dテクスチャ
+	srvDesc.Texture2D.MipLevels = decoded.mipLevels;
+
+	D3D12_CPU_DESCRIPTOR_HANDLE handle = srvStart_;
+	handle.ptr += size_t(descriptorSize_) * descriptorIndex;
+	device_->CreateShaderResourceView(texture, &srvDesc, handle);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <d3d12.h>
+#include <vector>
+#include "TextureStreamer.h"
+#include "FrameRing.h"
+#include "D3D12GpuTimeline.h"
+
+class D3D12ResourceAllocator;
+
+// CopyQueueでテクスチャを転送するITextureUploadBackendの実装
+// テクスチャはCommonの状態で作る。CopyQueueではCopyDestへ、描画側ではPixelShaderResourceへ暗黙に昇格するのでBarrierは要らない
+class D3D12TextureUploader : public ITextureUploadBackend {
+public:
+	// ステージングバッファの標準サイズ
+	static constexpr uint64_t kDefaultStagingSize = 32ull * 1024 * 1024;
+	// 転送が終わるまで代わりに使うテクスチャのSRVの番号
+	static constexpr uint32_t kPlaceholderDescriptorIndex = 0;
+	// 各テクスチャのSRVの番号。プレースホルダの次から並ぶ
+	static uint32_t GetDescriptorIndex(uint32_t textureId) { return textureId + 1; }
+
+	// srvStartからdescriptorCount個のSRVを使う
+	void Initialize(ID3D12Device* device, D3D12ResourceAllocator* resourceAllocator,
+		D3D12_CPU_DESCRIPTOR_HANDLE srvStart, uint32_t descriptorSize, uint32_t descriptorCount,
+		uint64_t stagingSize = kDefaultStagingSize);
+	void Finalize();
+
+	uint64_t GetStagingCapacity() const override { return stagingSize_; }
+	uint64_t GetStagingAlignment() const override { return D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT; }
+	void* CreateTexture(const DecodedTexture& texture, uint64_t* uploadSize) override;
+	void DestroyTexture(void* texture) override;
+	void RecordUpload(void* texture, const DecodedTexture& decoded, uint64_t stagingOffset) override;
+	uint64_t Submit() override;
+	uint64_t GetCompletedValue() override;
+	void WaitForValue(uint64_t value) override;
+	void OnResident(uint32_t textureId, void* texture, const DecodedTexture& decoded) override;
+
+private:
+	// 転送の途中で一時的に作ったバッファ。fenceValueまで進んだら解放する
+	struct TemporaryBuffer {
+		ID3D12Resource* resource;
+		uint64_t fenceValue;
+	};
+	// CommandListを開いていなければ開く
+	void BeginCommands();
+	void ReleaseTemporaryBuffers(uint64_t completedValue);
+	void CreateShaderResourceView(uint32_t descriptorIndex, ID3D12Resource* texture, const DecodedTexture& decoded);
+
+	// CommandAllocatorの数。CPUは1つ前の転送を待たずに次を積める
+	static constexpr uint32_t kCommandAllocatorCount = 2;
+
+	ID3D12Device* device_ = nullptr;
+	D3D12ResourceAllocator* resourceAllocator_ = nullptr;
+	ID3D12CommandQueue* copyQueue_ = nullptr;
+	ID3D12CommandAllocator* commandAllocators_[kCommandAllocatorCount] = {};
+	ID3D12GraphicsCommandList* commandList_ = nullptr;
+	D3D12GpuTimeline timeline_;
+	FrameRing commandRing_;
+	bool recording_ = false;
+	uint64_t lastFenceValue_ = 0;
+
+	ID3D12Resource* stagingResource_ = nullptr;
+	uint8_t* stagingData_ = nullptr;
+	uint64_t stagingSize_ = 0;
+	std::vector<TemporaryBuffer> temporaryBuffers_;
+
+	ID3D12Resource* placeholder_ = nullptr;
+	D3D12_CPU_DESCRIPTOR_HANDLE srvStart_{};
+	uint32_t descriptorSize_ = 0;
+	uint32_t descriptorCount_ = 0;
+};
@@ -0,0 +1,22 @@
+#include "D3D12UploadPageProvider.h"
+#include "ResourceUtility.h"
+#include "D3D12ResourceAllocator.h"
+#include <cassert>
+
+UploadPage D3D12UploadPageProvider::CreatePage(size_t size) {
+	ID3D12Resource* resource = CreateBufferResource(resourceAllocator_, size);
+	UploadPage page;
+	// UploadHeapはMapしたままで良いので、作ったときに一度だけMapする
+	HRESULT hr = resource->Map(0, nullptr, reinterpret_cast<void**>(&page.cpuAddress));
+	assert(SUCCEEDED(hr));
+	page.gpuAddress = resource->GetGPUVirtualAddress();
+	page.size = size;
+	page.handle = resource;
+	return page;
+}
+
+void D3D12UploadPageProvider::DestroyPage(const UploadPage& page) {
+	ID3D12Resource* resource = static_cast<ID3D12Resource*>(page.handle);
+	resource->Unmap(0, nullptr);
+	resourceAllocator_->ReleaseResource(resource);
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <d3d12.h>
+#include "LinearUploadAllocator.h"
+
+class D3D12ResourceAllocator;
+
+// UploadHeapのバッファをページとして作るIUploadPageProviderの実装
+class D3D12UploadPageProvider : public IUploadPageProvider {
+public:
+	explicit D3D12UploadPageProvider(D3D12ResourceAllocator* resourceAllocator) : resourceAllocator_(resourceAllocator) {}
+
+	UploadPage CreatePage(size_t size) override;
+	void DestroyPage(const UploadPage& page) override;
+
+private:
+	D3D12ResourceAllocator* resourceAllocator_ = nullptr;
+};
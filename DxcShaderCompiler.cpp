@@ -0,0 +1,175 @@
+#include "DxcShaderCompiler.h"
+#include <cassert>
+#include <format>
+#include <fstream>
+
+#ifdef _WIN32
+#pragma comment(lib, "dxcompiler.lib")
+#endif
+
+void DxcShaderCompiler::Initialize() {
+	// dxcCompilerを初期化。1つ目はバージョンを調べるのに使い、そのまま空きとして置いておく
+	Instance instance = CreateInstance();
+	instanceCount_ = 1;
+
+	// dxcompiler.dllが替わったらキャッシュを作り直すように、バージョンとコミットをキーに混ぜる
+	versionString_ = "dxc";
+	IDxcVersionInfo* versionInfo = nullptr;
+	if (SUCCEEDED(instance.dxcCompiler->QueryInterface(IID_PPV_ARGS(&versionInfo)))) {
+		UINT32 major = 0;
+		UINT32 minor = 0;
+		versionInfo->GetVersion(&major, &minor);
+		versionString_ += std::format(" {}.{}", major, minor);
+		IDxcVersionInfo2* versionInfo2 = nullptr;
+		if (SUCCEEDED(versionInfo->QueryInterface(IID_PPV_ARGS(&versionInfo2)))) {
+			UINT32 commitCount = 0;
+			char* commitHash = nullptr;
+			if (SUCCEEDED(versionInfo2->GetCommitInfo(&commitCount, &commitHash))) {
+				versionString_ += std::format(" {} {}", commitCount, commitHash);
+				CoTaskMemFree(commitHash);
+			}
+			versionInfo2->Release();
+		}
+		versionInfo->Release();
+	}
+	freeInstances_.push_back(instance);
+}
+
+void DxcShaderCompiler::Finalize() {
+	// コンパイル中のものは無いので、全て空きに戻っている
+	assert(freeInstances_.size() == instanceCount_);
+	for (Instance& instance : freeInstances_) {
+		ReleaseInstance(instance);
+	}
+	freeInstances_.clear();
+	instanceCount_ = 0;
+}
+
+DxcShaderCompiler::Instance DxcShaderCompiler::CreateInstance() {
+	Instance instance;
+	HRESULT hr = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&instance.dxcUtils));
+	assert(SUCCEEDED(hr));
+	hr = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&instance.dxcCompiler));
+	assert(SUCCEEDED(hr));
+	// includeに対応するための設定を行っておく
+	hr = instance.dxcUtils->CreateDefaultIncludeHandler(&instance.includeHandler);
+	assert(SUCCEEDED(hr));
+	return instance;
+}
+
+void DxcShaderCompiler::ReleaseInstance(Instance& instance) {
+	instance.includeHandler->Release();
+	instance.dxcCompiler->Release();
+	instance.dxcUtils->Release();
+	instance = {};
+}
+
+DxcShaderCompiler::Instance DxcShaderCompiler::AcquireInstance() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!freeInstances_.empty()) {
+			Instance instance = freeInstances_.back();
+			freeInstances_.pop_back();
+			return instance;
+		}
+		++instanceCount_;
+	}
+	// 作るのには時間がかかるのでロックの外で作る
+	return CreateInstance();
+}
+
+void DxcShaderCompiler::ReturnInstance(const Instance& instance) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	freeInstances_.push_back(instance);
+}
+
+bool DxcShaderCompiler::Compile(const ShaderCompileRequest& request, const std::vector<uint8_t>& source, std::vector<uint8_t>& object, std::string& message) {
+	// 読み込んだファイルの内容を設定する
+	DxcBuffer shaderSourceBuffer;
+	shaderSourceBuffer.Ptr = source.data();
+	shaderSourceBuffer.Size = source.size();
+	shaderSourceBuffer.Encoding = DXC_CP_UTF8;  // UTF8の文字コードであることを通知
+
+	// コンパイル対象のhlslファイル名、エントリーポイント、ShaderProfileの後ろに指定されたオプションを並べる
+	std::wstring filePath = request.filePath.wstring();
+	std::vector<LPCWSTR> arguments = {
+		filePath.c_str(),
+		L"-E", request.entryPoint.c_str(),
+		L"-T", request.profile.c_str(),
+	};
+	for (const std::wstring& define : request.defines) {
+		arguments.push_back(L"-D");
+		arguments.push_back(define.c_str());
+	}
+	for (const std::wstring& argument : request.arguments) {
+		arguments.push_back(argument.c_str());
+	}
+
+	// 実際にShaderをコンパイルする
+	Instance instance = AcquireInstance();
+	IDxcResult* shaderResult = nullptr;
+	HRESULT hr = instance.dxcCompiler->Compile(&shaderSourceBuffer, arguments.data(), UINT32(arguments.size()), instance.includeHandler, IID_PPV_ARGS(&shaderResult));
+	ReturnInstance(instance);
+	// コンパイルエラーではなくdxcが起動できないなど致命的な状況
+	assert(SUCCEEDED(hr));
+
+	// 警告・エラーが出ていたら失敗にする
+	bool succeeded = true;
+	IDxcBlobUtf8* shaderError = nullptr;
+	shaderResult->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&shaderError), nullptr);
+	if (shaderError != nullptr) {
+		if (shaderError->GetStringLength() != 0) {
+			message = shaderError->GetStringPointer();
+			succeeded = false;
+		}
+		shaderError->Release();
+	}
+
+	// コンパイル結果から実行用のバイナリ部分を取得
+	if (succeeded) {
+		IDxcBlob* shaderBlob = nullptr;
+		hr = shaderResult->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&shaderBlob), nullptr);
+		assert(SUCCEEDED(hr));
+		const uint8_t* data = static_cast<const uint8_t*>(shaderBlob->GetBufferPointer());
+		object.assign(data, data + shaderBlob->GetBufferSize());
+		shaderBlob->Release();
+		if (!request.pdbDirectory.empty()) {
+			WritePdb(shaderResult, request.pdbDirectory);
+		}
+	}
+	shaderResult->Release();
+	return succeeded;
+}
+
+void DxcShaderCompiler::WritePdb(IDxcResult* shaderResult, const std::filesystem::path& pdbDirectory) {
+	// PDBの名前はDXCが決める。バイナリに同じ名前が記録されているので、PIXはこの名前で探す
+	IDxcBlob* pdbBlob = nullptr;
+	IDxcBlobUtf16* pdbName = nullptr;
+	if (FAILED(shaderResult->GetOutput(DXC_OUT_PDB, IID_PPV_ARGS(&pdbBlob), &pdbName)) || pdbBlob == nullptr) {
+		if (pdbName != nullptr) {
+			pdbName->Release();
+		}
+		return;
+	}
+	const uint8_t* data = static_cast<const uint8_t*>(pdbBlob->GetBufferPointer());
+	const size_t size = pdbBlob->GetBufferSize();
+	std::filesystem::path fileName;
+	if (pdbName != nullptr && pdbName->GetStringLength() != 0) {
+		fileName = pdbName->GetStringPointer();
+	} else {
+		// 名前が返らないコンパイラでは、中身のハッシュ(FNV-1a)から名前を作る
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (size_t i = 0; i < size; ++i) {
+			hash = (hash ^ data[i]) * 0x100000001b3ull;
+		}
+		fileName = std::format("{:016x}.pdb", hash);
+	}
+	std::error_code errorCode;
+	std::filesystem::create_directories(pdbDirectory, errorCode);
+	std::ofstream file(pdbDirectory / fileName, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(data), std::streamsize(size));
+	if (pdbName != nullptr) {
+		pdbName->Release();
+	}
+	pdbBlob->Release();
+}
@@ -0,0 +1,38 @@
+#pragma once
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+#include <dxcapi.h>
+#include <mutex>
+#include "ShaderCache.h"
+
+// DXCでコンパイルするIShaderCompilerの実装
+// IDxcCompiler3とIncludeHandlerはスレッドセーフではないので、同時にコンパイルするスレッドの数だけ作って使い回す
+class DxcShaderCompiler : public IShaderCompiler {
+public:
+	void Initialize();
+	void Finalize();
+
+	std::string GetVersionString() const override { return versionString_; }
+	bool Compile(const ShaderCompileRequest& request, const std::vector<uint8_t>& source, std::vector<uint8_t>& object, std::string& message) override;
+
+private:
+	// 1つのスレッドがコンパイルの間だけ占有するDXCの一式
+	struct Instance {
+		IDxcUtils* dxcUtils = nullptr;
+		IDxcCompiler3* dxcCompiler = nullptr;
+		IDxcIncludeHandler* includeHandler = nullptr;
+	};
+	// -Qstrip_debugで外したデバッグ情報を書き出す
+	static void WritePdb(IDxcResult* shaderResult, const std::filesystem::path& pdbDirectory);
+	static Instance CreateInstance();
+	static void ReleaseInstance(Instance& instance);
+	// 空いているものを取り出す。無ければ作る
+	Instance AcquireInstance();
+	void ReturnInstance(const Instance& instance);
+
+	std::string versionString_;
+	std::mutex mutex_;
+	std::vector<Instance> freeInstances_;
+	uint32_t instanceCount_ = 0;
+};
@@ -0,0 +1,145 @@
+#include "FileWatcher.h"
+#include <algorithm>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+#ifdef _WIN32
+struct FileWatcher::Platform {
+	HANDLE directory = INVALID_HANDLE_VALUE;
+	OVERLAPPED overlapped{};
+	// FILE_NOTIFY_INFORMATIONはDWORD境界に並ぶ
+	std::vector<DWORD> buffer = std::vector<DWORD>(16 * 1024 / sizeof(DWORD));
+
+	// 次の変更を待つ読み込みを出しておく
+	bool Read() {
+		ResetEvent(overlapped.hEvent);
+		return ReadDirectoryChangesW(directory, buffer.data(), DWORD(buffer.size() * sizeof(DWORD)), FALSE,
+			FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME, nullptr, &overlapped, nullptr) != FALSE;
+	}
+};
+#else
+struct FileWatcher::Platform {
+	int inotify = -1;
+	int watch = -1;
+};
+#endif
+
+FileWatcher::FileWatcher() = default;
+
+FileWatcher::~FileWatcher() {
+	Finalize();
+}
+
+bool FileWatcher::Initialize(const std::filesystem::path& directory) {
+	Finalize();
+	directory_ = directory;
+	platform_ = std::make_unique<Platform>();
+#ifdef _WIN32
+	platform_->directory = CreateFileW(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+	if (platform_->directory == INVALID_HANDLE_VALUE) {
+		platform_.reset();
+		return false;
+	}
+	platform_->overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+	if (!platform_->Read()) {
+		Finalize();
+		return false;
+	}
+#else
+	platform_->inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (platform_->inotify < 0) {
+		platform_.reset();
+		return false;
+	}
+	// エディタは書き込んで閉じるか、別名で書いて置き換える
+	platform_->watch = inotify_add_watch(platform_->inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (platform_->watch < 0) {
+		Finalize();
+		return false;
+	}
+#endif
+	return true;
+}
+
+void FileWatcher::Finalize() {
+	if (!platform_) {
+		return;
+	}
+#ifdef _WIN32
+	if (platform_->directory != INVALID_HANDLE_VALUE) {
+		// 出したままの読み込みを取り消し、終わるのを待ってからバッファを捨てる
+		CancelIoEx(platform_->directory, &platform_->overlapped);
+		DWORD bytes = 0;
+		GetOverlappedResult(platform_->directory, &platform_->overlapped, &bytes, TRUE);
+		CloseHandle(platform_->directory);
+	}
+	if (platform_->overlapped.hEvent) {
+		CloseHandle(platform_->overlapped.hEvent);
+	}
+#else
+	if (platform_->watch >= 0) {
+		inotify_rm_watch(platform_->inotify, platform_->watch);
+	}
+	close(platform_->inotify);
+#endif
+	platform_.reset();
+}
+
+std::vector<std::filesystem::path> FileWatcher::Poll() {
+	std::vector<std::filesystem::path> changes;
+	if (!platform_) {
+		return changes;
+	}
+#ifdef _WIN32
+	DWORD bytes = 0;
+	while (GetOverlappedResult(platform_->directory, &platform_->overlapped, &bytes, FALSE)) {
+		if (bytes == 0) {
+			// バッファが溢れて何が変わったか分からない
+			changes.push_back(directory_);
+		} else {
+			const uint8_t* data = reinterpret_cast<const uint8_t*>(platform_->buffer.data());
+			for (;;) {
+				const FILE_NOTIFY_INFORMATION* information = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(data);
+				if (information->Action != FILE_ACTION_REMOVED && information->Action != FILE_ACTION_RENAMED_OLD_NAME) {
+					changes.push_back(directory_ / std::wstring(information->FileName, information->FileNameLength / sizeof(wchar_t)));
+				}
+				if (information->NextEntryOffset == 0) {
+					break;
+				}
+				data += information->NextEntryOffset;
+			}
+		}
+		if (!platform_->Read()) {
+			break;
+		}
+	}
+#else
+	alignas(inotify_event) char buffer[4096];
+	for (;;) {
+		ssize_t length = read(platform_->inotify, buffer, sizeof(buffer));
+		if (length <= 0) {
+			// EAGAINならもう無い
+			break;
+		}
+		for (ssize_t offset = 0; offset < length;) {
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+			if (event->mask & IN_Q_OVERFLOW) {
+				changes.push_back(directory_);
+			} else if (event->len != 0) {
+				changes.push_back(directory_ / event->name);
+			}
+			offset += sizeof(inotify_event) + event->len;
+		}
+	}
+#endif
+	// 1回の保存で何度も通知が来るのでまとめる
+	std::sort(changes.begin(), changes.end());
+	changes.erase(std::unique(changes.begin(), changes.end()), changes.end());
+	return changes;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+// ディレクトリ直下のファイルの書き込みを監視する。サブディレクトリは見ない
+// Windowsは非同期のReadDirectoryChangesW、それ以外はinotifyを使う。どちらも待たずに結果を取り出せる
+class FileWatcher {
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	bool Initialize(const std::filesystem::path& directory);
+	void Finalize();
+
+	// 前回から書き込まれたり作られたりしたファイルのパスを返す。同じファイルは1回にまとめる
+	// 変更が多すぎて取りこぼした場合は、ディレクトリ自身のパスが入る。そのときは全て変わったとみなすこと
+	std::vector<std::filesystem::path> Poll();
+
+	const std::filesystem::path& GetDirectory() const { return directory_; }
+
+private:
+	// OSごとのハンドルなど。cppの中で定義する
+	struct Platform;
+	std::unique_ptr<Platform> platform_;
+	std::filesystem::path directory_;
+};
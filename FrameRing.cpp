@@ -0,0 +1,72 @@
+#include "FrameRing.h"
+#include <cassert>
+
+void FrameRing::Initialize(IGpuTimeline* timeline, uint32_t frameCount) {
+	assert(timeline != nullptr);
+	assert(frameCount > 0 && frameCount <= kMaxFrameCount);
+	timeline_ = timeline;
+	frameCount_ = frameCount;
+	// 最初のBeginFrameで0番から使うように、ひとつ前を指しておく
+	frameIndex_ = frameCount - 1;
+	for (uint64_t& fenceValue : fenceValues_) {
+		fenceValue = 0;
+	}
+	lastFenceValue_ = 0;
+	stallCount_ = 0;
+	inFrame_ = false;
+	// 前のタイムラインで預かったものは、WaitForIdleで解放してから作り直すこと
+	assert(releases_.empty());
+}
+
+uint32_t FrameRing::BeginFrame() {
+	assert(timeline_ != nullptr);
+	assert(!inFrame_);
+	frameIndex_ = (frameIndex_ + 1) % frameCount_;
+	// この区画を前回使ったフレームをGPUが終えていなければ待つ
+	uint64_t fenceValue = fenceValues_[frameIndex_];
+	if (fenceValue != 0 && timeline_->GetCompletedValue() < fenceValue) {
+		timeline_->WaitForValue(fenceValue);
+		++stallCount_;
+	}
+	ReleaseCompleted(timeline_->GetCompletedValue());
+	inFrame_ = true;
+	return frameIndex_;
+}
+
+uint64_t FrameRing::EndFrame() {
+	assert(inFrame_);
+	fenceValues_[frameIndex_] = timeline_->Signal();
+	lastFenceValue_ = fenceValues_[frameIndex_];
+	// このフレームの中で預かったものは、このフレームのSignal値で解放する
+	for (auto it = releases_.rbegin(); it != releases_.rend() && it->fenceValue == 0; ++it) {
+		it->fenceValue = lastFenceValue_;
+	}
+	inFrame_ = false;
+	return fenceValues_[frameIndex_];
+}
+
+void FrameRing::WaitForIdle() {
+	assert(timeline_ != nullptr);
+	uint64_t fenceValue = timeline_->Signal();
+	timeline_->WaitForValue(fenceValue);
+	ReleaseCompleted(fenceValue);
+}
+
+void FrameRing::DeferRelease(std::function<void()> release) {
+	// フレームの外なら、最後に積んだフレームが使っている。まだ1つも積んでいなければGPUは使っていない
+	uint64_t fenceValue = inFrame_ ? 0 : lastFenceValue_;
+	if (!inFrame_ && (fenceValue == 0 || timeline_->GetCompletedValue() >= fenceValue) && releases_.empty()) {
+		release();
+		return;
+	}
+	releases_.push_back({ fenceValue, std::move(release) });
+}
+
+void FrameRing::ReleaseCompleted(uint64_t completedValue) {
+	// 今のフレームの分（0）は、まだSignal値が決まっていないので残す
+	while (!releases_.empty() && releases_.front().fenceValue != 0 && releases_.front().fenceValue <= completedValue) {
+		std::function<void()> release = std::move(releases_.front().release);
+		releases_.pop_front();
+		release();
+	}
+}
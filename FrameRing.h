@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+// GPUの進行状況を扱うインターフェース
+// D3D12ではCommandQueue+Fenceで実装する。FrameRing側はD3D12に依存しない
+class IGpuTimeline {
+public:
+	virtual ~IGpuTimeline() = default;
+	// これまでに積んだコマンドの後ろにSignalを積み、その値を返す
+	virtual uint64_t Signal() = 0;
+	// GPUが到達済みのSignal値
+	virtual uint64_t GetCompletedValue() = 0;
+	// GPUがvalueに到達するまでCPUを止める
+	virtual void WaitForValue(uint64_t value) = 0;
+};
+
+// フレームごとのリソース（CommandAllocatorやConstantBufferの区画）をN個持ち回すための管理
+// CPUはGPUを1周追い越しそうになったときだけ待つ
+// 差し替えたPSOなど、GPUが使っているかもしれないものの解放も、使ったフレームをGPUが終えるまで預かる
+class FrameRing {
+public:
+	// 同時に処理中にできるフレーム数の上限
+	static constexpr uint32_t kMaxFrameCount = 4;
+
+	void Initialize(IGpuTimeline* timeline, uint32_t frameCount);
+
+	// 次のフレームを始める。これから使う区画をGPUがまだ使っていれば、終わるまで待つ
+	// 戻り値はこのフレームで使う区画の番号
+	uint32_t BeginFrame();
+	// フレームのコマンドを全て積んだ後に呼ぶ。区画を使い終わるSignal値を記録して返す
+	uint64_t EndFrame();
+	// GPUの処理が全て終わるまで待つ（終了時やリソースの作り直し時）
+	void WaitForIdle();
+	// 積んだフレームをGPUが全て終えたらreleaseを呼ぶ。フレームの中で呼んだら、そのフレームの終わりまで待つ
+	// 終わったものはBeginFrameとWaitForIdleで解放する
+	void DeferRelease(std::function<void()> release);
+
+	uint32_t GetFrameCount() const { return frameCount_; }
+	uint32_t GetFrameIndex() const { return frameIndex_; }
+	// 今までにCPUがGPU待ちで止まった回数
+	uint64_t GetStallCount() const { return stallCount_; }
+	// 解放を待っている数
+	size_t GetPendingReleaseCount() const { return releases_.size(); }
+
+private:
+	struct DeferredRelease {
+		// このSignal値にGPUが到達したら解放する。0は今のフレームのEndFrameで決まる
+		uint64_t fenceValue;
+		std::function<void()> release;
+	};
+	// completedValueまで終わったものを解放する
+	void ReleaseCompleted(uint64_t completedValue);
+
+	IGpuTimeline* timeline_ = nullptr;
+	uint32_t frameCount_ = 0;
+	uint32_t frameIndex_ = 0;
+	// 各区画を最後に使ったフレームのSignal値。0は未使用
+	uint64_t fenceValues_[kMaxFrameCount] = {};
+	// 最後にEndFrameで積んだSignal値
+	uint64_t lastFenceValue_ = 0;
+	uint64_t stallCount_ = 0;
+	bool inFrame_ = false;
+	// Signal値の順に並ぶ
+	std::deque<DeferredRelease> releases_;
+};
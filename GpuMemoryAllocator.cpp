@@ -0,0 +1,134 @@
+#include "GpuMemoryAllocator.h"
+#include <cassert>
+
+void GpuMemoryAllocator::Initialize(IGpuHeapProvider* heapProvider, uint64_t heapSize) {
+	assert(heapProvider != nullptr);
+	assert(heapSize >= kMinBlockSize && (heapSize & (heapSize - 1)) == 0);
+	heapProvider_ = heapProvider;
+	heapSize_ = heapSize;
+}
+
+void GpuMemoryAllocator::Finalize() {
+	for (Pool& pool : pools_) {
+		assert(pool.dedicatedCount == 0);
+		for (std::unique_ptr<Block>& block : pool.blocks) {
+			if (block) {
+				assert(block->allocator.IsEmpty());
+				heapProvider_->DestroyHeap(block->heap);
+			}
+		}
+		pool.blocks.clear();
+	}
+}
+
+GpuMemoryAllocation GpuMemoryAllocator::Allocate(GpuHeapType heapType, GpuResourceCategory category, uint64_t size, uint64_t alignment) {
+	assert(heapProvider_ != nullptr);
+	assert(size > 0);
+	GpuMemoryAllocation allocation;
+	allocation.poolIndex = GetPoolIndex(heapType, category);
+	Pool& pool = pools_[allocation.poolIndex];
+
+	// Heap1つに収まらないものは専用のHeapを作る
+	if (size > heapSize_ || alignment > heapSize_) {
+		allocation.heap = heapProvider_->CreateHeap({ heapType, category, size });
+		assert(allocation.heap != nullptr);
+		allocation.size = size;
+		allocation.dedicated = true;
+		++pool.dedicatedCount;
+		pool.dedicatedBytes += size;
+		return allocation;
+	}
+
+	// 既存のHeapから入るところを探す
+	uint32_t emptySlot = uint32_t(pool.blocks.size());
+	for (uint32_t i = 0; i < pool.blocks.size(); ++i) {
+		Block* block = pool.blocks[i].get();
+		if (block == nullptr) {
+			emptySlot = i;
+			continue;
+		}
+		uint64_t offset = block->allocator.Allocate(size, alignment);
+		if (offset != BuddyAllocator::kInvalidOffset) {
+			allocation.heap = block->heap;
+			allocation.offset = offset;
+			allocation.size = size;
+			allocation.blockIndex = i;
+			return allocation;
+		}
+	}
+
+	// どこにも入らなければHeapを追加する
+	std::unique_ptr<Block> block = std::make_unique<Block>();
+	block->heap = heapProvider_->CreateHeap({ heapType, category, heapSize_ });
+	assert(block->heap != nullptr);
+	block->allocator.Initialize(heapSize_, kMinBlockSize);
+	allocation.heap = block->heap;
+	allocation.offset = block->allocator.Allocate(size, alignment);
+	assert(allocation.offset != BuddyAllocator::kInvalidOffset);
+	allocation.size = size;
+	allocation.blockIndex = emptySlot;
+	if (emptySlot == pool.blocks.size()) {
+		pool.blocks.push_back(std::move(block));
+	} else {
+		pool.blocks[emptySlot] = std::move(block);
+	}
+	return allocation;
+}
+
+void GpuMemoryAllocator::Free(const GpuMemoryAllocation& allocation) {
+	Pool& pool = pools_[allocation.poolIndex];
+	if (allocation.dedicated) {
+		heapProvider_->DestroyHeap(allocation.heap);
+		--pool.dedicatedCount;
+		pool.dedicatedBytes -= allocation.size;
+		return;
+	}
+
+	std::unique_ptr<Block>& block = pool.blocks[allocation.blockIndex];
+	assert(block && block->heap == allocation.heap);
+	block->allocator.Free(allocation.offset);
+
+	// 空になったHeapは、他に空のHeapがあれば返す。1つは残して作り直しを避ける
+	if (block->allocator.IsEmpty()) {
+		for (std::unique_ptr<Block>& other : pool.blocks) {
+			if (other && other != block && other->allocator.IsEmpty()) {
+				heapProvider_->DestroyHeap(block->heap);
+				block.reset();
+				break;
+			}
+		}
+	}
+}
+
+GpuMemoryAllocator::PoolStatistics GpuMemoryAllocator::GetStatistics(GpuHeapType heapType, GpuResourceCategory category) const {
+	const Pool& pool = pools_[GetPoolIndex(heapType, category)];
+	PoolStatistics statistics;
+	// 割り当ては1つのHeapに収まる必要があるので、断片化はHeapごとに求めて空き容量で重み付けする
+	// プール全体の最大空きブロックと空き容量の比にすると、同じ大きさの空きを持つHeapが2つあるだけで0.5になってしまう
+	// Heapごとの断片化 1 - largestFreeBlock / freeBytes に空き容量を掛けると、最大ブロック以外の空き容量になる
+	uint64_t freeBytes = 0;
+	uint64_t scatteredFreeBytes = 0;
+	for (const std::unique_ptr<Block>& block : pool.blocks) {
+		if (!block) {
+			continue;
+		}
+		BuddyAllocator::Statistics blockStatistics = block->allocator.GetStatistics();
+		++statistics.heapCount;
+		statistics.reservedBytes += blockStatistics.capacity;
+		statistics.usedBytes += blockStatistics.usedBytes;
+		statistics.requestedBytes += blockStatistics.requestedBytes;
+		statistics.allocationCount += blockStatistics.allocationCount;
+		if (blockStatistics.largestFreeBlock > statistics.largestFreeBlock) {
+			statistics.largestFreeBlock = blockStatistics.largestFreeBlock;
+		}
+		uint64_t blockFreeBytes = blockStatistics.capacity - blockStatistics.usedBytes;
+		freeBytes += blockFreeBytes;
+		scatteredFreeBytes += blockFreeBytes - blockStatistics.largestFreeBlock;
+	}
+	statistics.dedicatedCount = pool.dedicatedCount;
+	statistics.dedicatedBytes = pool.dedicatedBytes;
+	if (freeBytes != 0) {
+		statistics.fragmentation = float(double(scatteredFreeBytes) / double(freeBytes));
+	}
+	return statistics;
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include "BuddyAllocator.h"
+
+// Heapの種類。D3D12_HEAP_TYPEに対応する
+enum class GpuHeapType : uint32_t {
+	Default,
+	Upload,
+	Readback,
+	Count,
+};
+
+// 1つのHeapに同居できるResourceの分類
+// ResourceHeapTier1ではバッファ・テクスチャ・RT/DSテクスチャを別々のHeapに置く必要がある
+enum class GpuResourceCategory : uint32_t {
+	Buffer,
+	Texture,
+	RenderTarget, // RenderTargetとDepthStencil
+	Count,
+};
+
+// 作ってほしいHeapの情報
+struct GpuHeapDesc {
+	GpuHeapType heapType = GpuHeapType::Default;
+	GpuResourceCategory category = GpuResourceCategory::Buffer;
+	uint64_t size = 0;
+};
+
+// Heapの作成・破棄を行うインターフェース。D3D12ではID3D12Heapを作る
+class IGpuHeapProvider {
+public:
+	virtual ~IGpuHeapProvider() = default;
+	// 作ったHeapを識別する値を返す。失敗したらnullptr
+	virtual void* CreateHeap(const GpuHeapDesc& desc) = 0;
+	virtual void DestroyHeap(void* heap) = 0;
+};
+
+// Heap内の1つの割り当て
+struct GpuMemoryAllocation {
+	void* heap = nullptr;
+	uint64_t offset = 0;
+	uint64_t size = 0;
+	// 以下は解放時に使う管理情報
+	uint32_t poolIndex = 0;
+	uint32_t blockIndex = 0;
+	bool dedicated = false;
+};
+
+// Heapを大きめに作り、その中をバディアロケータで切り分けて配る
+// Heapの種類とResourceの分類の組ごとにプールを持つ
+class GpuMemoryAllocator {
+public:
+	// 1つのHeapの標準サイズ
+	static constexpr uint64_t kDefaultHeapSize = 64ull * 1024 * 1024;
+	// 割り当ての最小単位。PlacedResourceの標準の配置単位と同じ
+	static constexpr uint64_t kMinBlockSize = 64ull * 1024;
+
+	// プールごとの使用状況
+	struct PoolStatistics {
+		uint32_t heapCount = 0;
+		// 作ったHeapの合計
+		uint64_t reservedBytes = 0;
+		// 割り当てたブロックの合計
+		uint64_t usedBytes = 0;
+		// 要求されたサイズの合計。usedBytesとの差がブロックの切り上げによる無駄
+		uint64_t requestedBytes = 0;
+		uint64_t allocationCount = 0;
+		uint64_t largestFreeBlock = 0;
+		// Heapに収まらず専用のHeapを作った割り当て
+		uint32_t dedicatedCount = 0;
+		uint64_t dedicatedBytes = 0;
+		// 外部断片化の度合い（0～1）。HeapごとのBuddyAllocator::GetFragmentationを空き容量で重み付けした平均
+		float fragmentation = 0.0f;
+	};
+
+	// heapSizeは2の累乗であること
+	void Initialize(IGpuHeapProvider* heapProvider, uint64_t heapSize = kDefaultHeapSize);
+	// 割り当ては全て解放されていること
+	void Finalize();
+
+	// alignmentは2の累乗であること
+	GpuMemoryAllocation Allocate(GpuHeapType heapType, GpuResourceCategory category, uint64_t size, uint64_t alignment);
+	void Free(const GpuMemoryAllocation& allocation);
+
+	PoolStatistics GetStatistics(GpuHeapType heapType, GpuResourceCategory category) const;
+
+private:
+	struct Block {
+		void* heap = nullptr;
+		BuddyAllocator allocator;
+	};
+	struct Pool {
+		// 解放して空いた位置はnullptrにして使い回す。割り当てが持つblockIndexをずらさないため
+		std::vector<std::unique_ptr<Block>> blocks;
+		uint32_t dedicatedCount = 0;
+		uint64_t dedicatedBytes = 0;
+	};
+
+	static uint32_t GetPoolIndex(GpuHeapType heapType, GpuResourceCategory category) {
+		return uint32_t(heapType) * uint32_t(GpuResourceCategory::Count) + uint32_t(category);
+	}
+
+	IGpuHeapProvider* heapProvider_ = nullptr;
+	uint64_t heapSize_ = 0;
+	Pool pools_[uint32_t(GpuHeapType::Count) * uint32_t(GpuResourceCategory::Count)];
+};
@@ -0,0 +1,83 @@
+#include "LinearUploadAllocator.h"
+#include <cassert>
+
+namespace {
+
+size_t AlignUp(size_t value, size_t alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+void LinearUploadAllocator::Initialize(IUploadPageProvider* pageProvider, size_t pageSize) {
+	assert(pageProvider != nullptr);
+	assert(pageSize >= kConstantBufferAlignment);
+	pageProvider_ = pageProvider;
+	pageSize_ = pageSize;
+	currentPage_ = 0;
+	offset_ = 0;
+	usedBytes_ = 0;
+}
+
+void LinearUploadAllocator::Finalize() {
+	Reset();
+	for (const UploadPage& page : pages_) {
+		pageProvider_->DestroyPage(page);
+	}
+	pages_.clear();
+}
+
+UploadAllocation LinearUploadAllocator::Allocate(size_t size, size_t alignment) {
+	assert(pageProvider_ != nullptr);
+	assert(size > 0);
+	assert((alignment & (alignment - 1)) == 0);
+	usedBytes_ += size;
+
+	// 1ページに収まらないものは専用のページを作る
+	if (size > pageSize_) {
+		UploadPage page = pageProvider_->CreatePage(AlignUp(size, kConstantBufferAlignment));
+		assert(page.cpuAddress != nullptr);
+		largePages_.push_back(page);
+		return { page.cpuAddress, page.gpuAddress, size };
+	}
+
+	// 今のページに入らなければ次のページへ。無ければ作る
+	size_t alignedOffset = AlignUp(offset_, alignment);
+	if (currentPage_ >= pages_.size() || alignedOffset + size > pages_[currentPage_].size) {
+		if (currentPage_ < pages_.size()) {
+			++currentPage_;
+		}
+		if (currentPage_ >= pages_.size()) {
+			UploadPage page = pageProvider_->CreatePage(pageSize_);
+			assert(page.cpuAddress != nullptr);
+			pages_.push_back(page);
+		}
+		alignedOffset = 0;
+	}
+
+	const UploadPage& page = pages_[currentPage_];
+	offset_ = alignedOffset + size;
+	return { page.cpuAddress + alignedOffset, page.gpuAddress + alignedOffset, size };
+}
+
+void LinearUploadAllocator::Reset() {
+	// 通常のページは次も使うので残し、先頭から使い直す
+	currentPage_ = 0;
+	offset_ = 0;
+	usedBytes_ = 0;
+	for (const UploadPage& page : largePages_) {
+		pageProvider_->DestroyPage(page);
+	}
+	largePages_.clear();
+}
+
+size_t LinearUploadAllocator::GetReservedBytes() const {
+	size_t reserved = 0;
+	for (const UploadPage& page : pages_) {
+		reserved += page.size;
+	}
+	for (const UploadPage& page : largePages_) {
+		reserved += page.size;
+	}
+	return reserved;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// CPUから書き込めて、GPUから読める1ページ分のメモリ
+struct UploadPage {
+	uint8_t* cpuAddress = nullptr;
+	uint64_t gpuAddress = 0;
+	size_t size = 0;
+	// ページを作った側が解放に使う情報（D3D12ならID3D12Resource*）
+	void* handle = nullptr;
+};
+
+// ページの確保・解放を行うインターフェース。アロケータ本体をD3D12に依存させないために分けている
+class IUploadPageProvider {
+public:
+	virtual ~IUploadPageProvider() = default;
+	// 永続的にMapされたページを作る
+	virtual UploadPage CreatePage(size_t size) = 0;
+	virtual void DestroyPage(const UploadPage& page) = 0;
+};
+
+// 切り出した領域
+struct UploadAllocation {
+	uint8_t* cpuAddress = nullptr;
+	uint64_t gpuAddress = 0;
+	size_t size = 0;
+};
+
+// 大きなUploadBufferから先頭詰めで切り出すアロケータ
+// 個別の解放はなく、Resetで全て捨てる。フレームの区画ごとに1つ持ち、区画を使い回すときにResetする
+class LinearUploadAllocator {
+public:
+	// ConstantBufferViewの配置単位
+	static constexpr size_t kConstantBufferAlignment = 256;
+	// 1ページの標準サイズ
+	static constexpr size_t kDefaultPageSize = 2 * 1024 * 1024;
+
+	void Initialize(IUploadPageProvider* pageProvider, size_t pageSize = kDefaultPageSize);
+	void Finalize();
+
+	// alignmentは2の累乗であること
+	UploadAllocation Allocate(size_t size, size_t alignment = kConstantBufferAlignment);
+
+	// ConstantBuffer用にdataをコピーし、GPUアドレスを返す
+	template<class T>
+	uint64_t AllocateConstant(const T& data) {
+		UploadAllocation allocation = Allocate(sizeof(T));
+		*reinterpret_cast<T*>(allocation.cpuAddress) = data;
+		return allocation.gpuAddress;
+	}
+
+	// 全ての割り当てを捨てる。GPUがこのアロケータの領域を読み終わってから呼ぶこと
+	void Reset();
+
+	// 今の区画で使っているバイト数と、確保済みのページの合計
+	size_t GetUsedBytes() const { return usedBytes_; }
+	size_t GetReservedBytes() const;
+
+private:
+	IUploadPageProvider* pageProvider_ = nullptr;
+	size_t pageSize_ = 0;
+	// 使い回すページ。currentPage_より前は使用済み
+	std::vector<UploadPage> pages_;
+	size_t currentPage_ = 0;
+	size_t offset_ = 0;
+	// ページに収まらない大きな割り当て。Resetで解放する
+	std::vector<UploadPage> largePages_;
+	size_t usedBytes_ = 0;
+};
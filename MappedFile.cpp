@@ -0,0 +1,76 @@
+#include "MappedFile.h"
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+bool MappedFile::Open(const std::filesystem::path& path) {
+	Close();
+#ifdef _WIN32
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	// ビューはマッピングとファイルのハンドルを閉じても有効なので、ここで閉じてしまう
+	CloseHandle(file);
+	if (mapping == nullptr) {
+		return false;
+	}
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (view == nullptr) {
+		return false;
+	}
+	data_ = static_cast<const uint8_t*>(view);
+	size_ = size_t(fileSize.QuadPart);
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat fileStat {};
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+		close(fd);
+		return false;
+	}
+	void* view = mmap(nullptr, size_t(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	// マップした後はファイルディスクリプタは要らない
+	close(fd);
+	if (view == MAP_FAILED) {
+		return false;
+	}
+	// 先頭から順に読むので先読みさせる
+	madvise(view, size_t(fileStat.st_size), MADV_SEQUENTIAL);
+	madvise(view, size_t(fileStat.st_size), MADV_WILLNEED);
+	data_ = static_cast<const uint8_t*>(view);
+	size_ = size_t(fileStat.st_size);
+#endif
+	return true;
+}
+
+void MappedFile::Close() {
+	if (data_ == nullptr) {
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(data_);
+#else
+	munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+	data_ = nullptr;
+	size_ = 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+
+// ファイルを読み取り専用でメモリにマップする。Windowsはファイルマッピング、それ以外はmmap
+// 読み込みでのコピーが無く、触ったページだけがOSによって読み込まれる
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// 空のファイルは開けない
+	bool Open(const std::filesystem::path& path);
+	void Close();
+
+	bool IsOpen() const { return data_ != nullptr; }
+	const uint8_t* GetData() const { return data_; }
+	size_t GetSize() const { return size_; }
+
+private:
+	const uint8_t* data_ = nullptr;
+	size_t size_ = 0;
+};
@@ -0,0 +1,404 @@
+#include "Mesh.h"
+#include <cassert>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+namespace {
+
+// バイナリ形式の先頭
+struct MeshFileHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	// 2か4
+	uint32_t indexSize;
+	uint32_t vertexStride;
+};
+const uint32_t kMeshFileMagic = 0x4853454D; // "MESH"
+const uint32_t kMeshFileVersion = 1;
+
+// FNV-1a 64bit
+uint64_t HashBytes(const void* data, size_t size) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+bool IsSameVertex(const VertexData& a, const VertexData& b) {
+	return memcmp(&a, &b, sizeof(VertexData)) == 0;
+}
+
+bool IsNearVertex(const VertexData& a, const VertexData& b, const MeshWeldTolerance& tolerance) {
+	return std::abs(a.position.x - b.position.x) <= tolerance.position &&
+		std::abs(a.position.y - b.position.y) <= tolerance.position &&
+		std::abs(a.position.z - b.position.z) <= tolerance.position &&
+		a.position.w == b.position.w &&
+		std::abs(a.texcoord.x - b.texcoord.x) <= tolerance.texcoord &&
+		std::abs(a.texcoord.y - b.texcoord.y) <= tolerance.texcoord;
+}
+
+// 溶接で探す格子のセル。セルの大きさを許容差にすると、相手は隣のセルまでに必ずある
+// 位置の許容差が0なら、位置のビットそのものをセルにする
+struct WeldCell {
+	int64_t x;
+	int64_t y;
+	int64_t z;
+	bool operator==(const WeldCell& other) const { return x == other.x && y == other.y && z == other.z; }
+};
+
+struct WeldCellHash {
+	size_t operator()(const WeldCell& cell) const {
+		return size_t(HashBytes(&cell, sizeof(cell)));
+	}
+};
+
+// Forsythの方法の点数。キャッシュの大きさは実際のGPUより大きめにしておくと、大きさの違うGPUでも悪くならない
+const uint32_t kOptimizerCacheSize = 32;
+const float kCacheDecayPower = 1.5f;
+const float kLastTriangleScore = 0.75f;
+const float kValenceBoostScale = 2.0f;
+const float kValenceBoostPower = 0.5f;
+
+float GetVertexScore(int32_t cachePosition, uint32_t remainingTriangles) {
+	if (remainingTriangles == 0) {
+		// もう使わない頂点
+		return -1.0f;
+	}
+	float score = 0.0f;
+	if (cachePosition >= 0) {
+		if (cachePosition < 3) {
+			// 直前の三角形の頂点。同じ点数にしないと、直前の三角形と向きの揃った三角形ばかり選んでしまう
+			score = kLastTriangleScore;
+		} else {
+			float scale = 1.0f / float(kOptimizerCacheSize - 3);
+			score = std::pow(1.0f - float(cachePosition - 3) * scale, kCacheDecayPower);
+		}
+	}
+	// 残りの三角形が少ない頂点を先に使い切り、ぽつんと残る三角形を減らす
+	score += kValenceBoostScale * std::pow(float(remainingTriangles), -kValenceBoostPower);
+	return score;
+}
+
+// 許容差が小さいとセルの番号はint32_tに収まらないので、int64_tで求めて隣のセルを足しても溢れない範囲に抑える
+// 抑えたセルには遠くの頂点も入るが、IsNearVertexで確かめるので結果は変わらない。NaNも端のセルに入れる
+int64_t GetWeldCellCoordinate(float value, float cellSize) {
+	const double kLimit = 4611686018427387904.0; // 2^62
+	double cell = std::floor(double(value) / double(cellSize));
+	if (!(cell > -kLimit)) {
+		return -(int64_t(1) << 62);
+	}
+	if (cell >= kLimit) {
+		return int64_t(1) << 62;
+	}
+	return int64_t(cell);
+}
+
+WeldCell GetWeldCell(const Vector4& position, float cellSize) {
+	return { GetWeldCellCoordinate(position.x, cellSize), GetWeldCellCoordinate(position.y, cellSize), GetWeldCellCoordinate(position.z, cellSize) };
+}
+
+// 完全に同じ位置だけを探すときのセル。-0.0fは0.0fと同じ位置なので揃える
+int64_t GetExactWeldCellCoordinate(float value) {
+	float normalized = value == 0.0f ? 0.0f : value;
+	uint32_t bits = 0;
+	memcpy(&bits, &normalized, sizeof(bits));
+	return int64_t(bits);
+}
+
+WeldCell GetExactWeldCell(const Vector4& position) {
+	return { GetExactWeldCellCoordinate(position.x), GetExactWeldCellCoordinate(position.y), GetExactWeldCellCoordinate(position.z) };
+}
+
+}
+
+Mesh BuildIndexedMesh(const std::vector<VertexData>& triangleVertices, const MeshWeldTolerance& tolerance) {
+	Mesh mesh;
+	std::vector<uint32_t> remap(triangleVertices.size());
+	mesh.vertices.reserve(triangleVertices.size());
+
+	if (tolerance.position <= 0.0f && tolerance.texcoord <= 0.0f) {
+		// 中身のハッシュで完全に同じ頂点を探す。表は頂点番号だけを持つ開番地法で、入力の2倍以上の大きさにする
+		const uint32_t kEmpty = ~0u;
+		size_t tableSize = 1;
+		while (tableSize < triangleVertices.size() * 2) {
+			tableSize <<= 1;
+		}
+		std::vector<uint32_t> table(tableSize, kEmpty);
+		for (size_t i = 0; i < triangleVertices.size(); ++i) {
+			const VertexData& vertex = triangleVertices[i];
+			size_t slot = size_t(HashBytes(&vertex, sizeof(vertex))) & (tableSize - 1);
+			while (table[slot] != kEmpty && !IsSameVertex(mesh.vertices[table[slot]], vertex)) {
+				slot = (slot + 1) & (tableSize - 1);
+			}
+			if (table[slot] == kEmpty) {
+				table[slot] = uint32_t(mesh.vertices.size());
+				mesh.vertices.push_back(vertex);
+			}
+			remap[i] = table[slot];
+		}
+	} else {
+		// 位置の格子で近くの頂点を探す。最初に見つかった頂点に寄せる
+		// 位置の許容差が0ならUVだけに許容差があるので、同じ位置のセルだけを見る
+		bool exactPosition = tolerance.position <= 0.0f;
+		int32_t range = exactPosition ? 0 : 1;
+		std::unordered_map<WeldCell, std::vector<uint32_t>, WeldCellHash> cells;
+		for (size_t i = 0; i < triangleVertices.size(); ++i) {
+			const VertexData& vertex = triangleVertices[i];
+			WeldCell cell = exactPosition ? GetExactWeldCell(vertex.position) : GetWeldCell(vertex.position, tolerance.position);
+			uint32_t index = uint32_t(mesh.vertices.size());
+			for (int32_t z = -range; z <= range && index == mesh.vertices.size(); ++z) {
+				for (int32_t y = -range; y <= range && index == mesh.vertices.size(); ++y) {
+					for (int32_t x = -range; x <= range && index == mesh.vertices.size(); ++x) {
+						auto it = cells.find({ cell.x + x, cell.y + y, cell.z + z });
+						if (it == cells.end()) {
+							continue;
+						}
+						for (uint32_t candidate : it->second) {
+							if (IsNearVertex(mesh.vertices[candidate], vertex, tolerance)) {
+								index = candidate;
+								break;
+							}
+						}
+					}
+				}
+			}
+			if (index == mesh.vertices.size()) {
+				mesh.vertices.push_back(vertex);
+				cells[cell].push_back(index);
+			}
+			remap[i] = index;
+		}
+	}
+
+	// 溶接で2頂点以上が同じになった三角形は面積が無いので捨てる
+	mesh.indices.reserve(triangleVertices.size());
+	for (size_t i = 0; i + 2 < triangleVertices.size(); i += 3) {
+		uint32_t a = remap[i];
+		uint32_t b = remap[i + 1];
+		uint32_t c = remap[i + 2];
+		if (a == b || b == c || c == a) {
+			continue;
+		}
+		mesh.indices.insert(mesh.indices.end(), { a, b, c });
+	}
+	mesh.vertices.shrink_to_fit();
+	return mesh;
+}
+
+void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount) {
+	uint32_t triangleCount = uint32_t(indices.size() / 3);
+	if (triangleCount == 0) {
+		return;
+	}
+
+	// 頂点ごとに、その頂点を使う三角形の一覧を作る
+	std::vector<uint32_t> triangleOffsets(vertexCount + 1, 0);
+	for (uint32_t index : indices) {
+		assert(index < vertexCount);
+		++triangleOffsets[index + 1];
+	}
+	for (uint32_t i = 0; i < vertexCount; ++i) {
+		triangleOffsets[i + 1] += triangleOffsets[i];
+	}
+	std::vector<uint32_t> vertexTriangles(indices.size());
+	std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+	for (uint32_t triangle = 0; triangle < triangleCount; ++triangle) {
+		for (uint32_t corner = 0; corner < 3; ++corner) {
+			uint32_t vertex = indices[triangle * 3 + corner];
+			vertexTriangles[triangleOffsets[vertex] + remainingTriangles[vertex]++] = triangle;
+		}
+	}
+
+	std::vector<int32_t> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (uint32_t vertex = 0; vertex < vertexCount; ++vertex) {
+		vertexScores[vertex] = GetVertexScore(-1, remainingTriangles[vertex]);
+	}
+	std::vector<float> triangleScores(triangleCount);
+	for (uint32_t triangle = 0; triangle < triangleCount; ++triangle) {
+		triangleScores[triangle] = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+	}
+	std::vector<bool> emitted(triangleCount, false);
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	// キャッシュは先頭が最新。新しく入れる3頂点の分だけ余分に持つ
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> nextCache;
+	cache.reserve(kOptimizerCacheSize + 3);
+	nextCache.reserve(kOptimizerCacheSize + 3);
+
+	uint32_t bestTriangle = uint32_t(std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin());
+	// キャッシュの中に候補が無いときに全体を探し直す位置。出した三角形は飛ばすので前から1度だけ舐める
+	uint32_t searchStart = 0;
+	for (uint32_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+		emitted[bestTriangle] = true;
+		const uint32_t* triangleIndices = &indices[bestTriangle * 3];
+		result.insert(result.end(), triangleIndices, triangleIndices + 3);
+
+		// 使った三角形を各頂点の一覧の後ろへ寄せ、残りの数を減らす
+		for (uint32_t corner = 0; corner < 3; ++corner) {
+			uint32_t vertex = triangleIndices[corner];
+			uint32_t* begin = &vertexTriangles[triangleOffsets[vertex]];
+			uint32_t* end = begin + remainingTriangles[vertex];
+			uint32_t* it = std::find(begin, end, bestTriangle);
+			assert(it != end);
+			std::swap(*it, *(end - 1));
+			--remainingTriangles[vertex];
+		}
+
+		// 出した三角形の頂点をキャッシュの先頭へ入れ、残りを後ろへずらす
+		nextCache.assign(triangleIndices, triangleIndices + 3);
+		for (uint32_t vertex : cache) {
+			if (vertex != triangleIndices[0] && vertex != triangleIndices[1] && vertex != triangleIndices[2]) {
+				nextCache.push_back(vertex);
+			}
+		}
+		std::swap(cache, nextCache);
+
+		// キャッシュの中の頂点と、押し出された頂点の点数を付け直し、それらを使う三角形の点数も付け直す
+		for (size_t i = 0; i < cache.size(); ++i) {
+			uint32_t vertex = cache[i];
+			int32_t position = i < kOptimizerCacheSize ? int32_t(i) : -1;
+			cachePositions[vertex] = position;
+			float score = GetVertexScore(position, remainingTriangles[vertex]);
+			float delta = score - vertexScores[vertex];
+			vertexScores[vertex] = score;
+			for (uint32_t j = 0; j < remainingTriangles[vertex]; ++j) {
+				triangleScores[vertexTriangles[triangleOffsets[vertex] + j]] += delta;
+			}
+		}
+		if (cache.size() > kOptimizerCacheSize) {
+			cache.resize(kOptimizerCacheSize);
+		}
+
+		// 次はキャッシュの頂点を使う三角形の中から一番点数の高いものを選ぶ
+		float bestScore = -1.0f;
+		bestTriangle = triangleCount;
+		for (uint32_t vertex : cache) {
+			for (uint32_t j = 0; j < remainingTriangles[vertex]; ++j) {
+				uint32_t triangle = vertexTriangles[triangleOffsets[vertex] + j];
+				if (triangleScores[triangle] > bestScore) {
+					bestScore = triangleScores[triangle];
+					bestTriangle = triangle;
+				}
+			}
+		}
+		if (bestTriangle == triangleCount) {
+			// キャッシュと繋がった三角形が無い。まだ出していない三角形から始め直す
+			while (searchStart < triangleCount && emitted[searchStart]) {
+				++searchStart;
+			}
+			bestTriangle = searchStart;
+		}
+	}
+	indices.swap(result);
+}
+
+void OptimizeVertexFetch(Mesh& mesh) {
+	const uint32_t kUnused = ~0u;
+	std::vector<uint32_t> remap(mesh.vertices.size(), kUnused);
+	std::vector<VertexData> vertices;
+	vertices.reserve(mesh.vertices.size());
+	for (uint32_t& index : mesh.indices) {
+		if (remap[index] == kUnused) {
+			remap[index] = uint32_t(vertices.size());
+			vertices.push_back(mesh.vertices[index]);
+		}
+		index = remap[index];
+	}
+	mesh.vertices.swap(vertices);
+}
+
+float ComputeACMR(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize) {
+	uint32_t triangleCount = uint32_t(indices.size() / 3);
+	if (triangleCount == 0) {
+		return 0.0f;
+	}
+	// 頂点ごとに最後にキャッシュへ入れた時刻を持つ。今の時刻との差がcacheSize未満ならまだ残っている
+	std::vector<uint64_t> insertedTimes(vertexCount, 0);
+	uint64_t time = cacheSize + 1;
+	uint32_t missCount = 0;
+	for (uint32_t index : indices) {
+		if (time - insertedTimes[index] > cacheSize) {
+			insertedTimes[index] = time++;
+			++missCount;
+		}
+	}
+	return float(missCount) / float(triangleCount);
+}
+
+bool SaveMesh(const std::filesystem::path& path, const Mesh& mesh) {
+	MeshFileHeader header{};
+	header.magic = kMeshFileMagic;
+	header.version = kMeshFileVersion;
+	header.vertexCount = uint32_t(mesh.vertices.size());
+	header.indexCount = uint32_t(mesh.indices.size());
+	header.indexSize = mesh.UsesShortIndices() ? sizeof(uint16_t) : sizeof(uint32_t);
+	header.vertexStride = sizeof(VertexData);
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		return false;
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(mesh.vertices.data()), std::streamsize(mesh.vertices.size() * sizeof(VertexData)));
+	if (header.indexSize == sizeof(uint16_t)) {
+		std::vector<uint16_t> shortIndices(mesh.indices.begin(), mesh.indices.end());
+		file.write(reinterpret_cast<const char*>(shortIndices.data()), std::streamsize(shortIndices.size() * sizeof(uint16_t)));
+	} else {
+		file.write(reinterpret_cast<const char*>(mesh.indices.data()), std::streamsize(mesh.indices.size() * sizeof(uint32_t)));
+	}
+	return bool(file);
+}
+
+bool LoadMesh(const std::filesystem::path& path, Mesh& mesh) {
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file) {
+		return false;
+	}
+	uint64_t fileSize = uint64_t(file.tellg());
+	file.seekg(0);
+	MeshFileHeader header{};
+	if (fileSize < sizeof(header) || !file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+		return false;
+	}
+	if (header.magic != kMeshFileMagic || header.version != kMeshFileVersion || header.vertexStride != sizeof(VertexData) ||
+		(header.indexSize != sizeof(uint16_t) && header.indexSize != sizeof(uint32_t)) || header.indexCount % 3 != 0) {
+		return false;
+	}
+	uint64_t vertexBytes = uint64_t(header.vertexCount) * header.vertexStride;
+	uint64_t indexBytes = uint64_t(header.indexCount) * header.indexSize;
+	if (sizeof(header) + vertexBytes + indexBytes != fileSize) {
+		return false;
+	}
+
+	mesh.vertices.resize(header.vertexCount);
+	file.read(reinterpret_cast<char*>(mesh.vertices.data()), std::streamsize(vertexBytes));
+	mesh.indices.resize(header.indexCount);
+	if (header.indexSize == sizeof(uint16_t)) {
+		std::vector<uint16_t> shortIndices(header.indexCount);
+		file.read(reinterpret_cast<char*>(shortIndices.data()), std::streamsize(indexBytes));
+		mesh.indices.assign(shortIndices.begin(), shortIndices.end());
+	} else {
+		file.read(reinterpret_cast<char*>(mesh.indices.data()), std::streamsize(indexBytes));
+	}
+	if (!file) {
+		return false;
+	}
+	// 範囲外のインデックスがあればGPUが範囲外を読むので弾く
+	for (uint32_t index : mesh.indices) {
+		if (index >= header.vertexCount) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+#include "MyMath.h"
+
+struct VertexData {
+	Vector4 position;
+	Vector2 texcoord;
+};
+
+// インデックス付きの三角形リスト
+struct Mesh {
+	std::vector<VertexData> vertices;
+	std::vector<uint32_t> indices;
+
+	// 頂点が65536個未満なら16bitのインデックスで足りる
+	bool UsesShortIndices() const { return vertices.size() <= 0xFFFF; }
+	uint32_t GetTriangleCount() const { return uint32_t(indices.size() / 3); }
+};
+
+// 頂点をまとめるときの許容差。どちらも0なら完全に同じ頂点だけをまとめる
+struct MeshWeldTolerance {
+	float position = 0.0f;
+	float texcoord = 0.0f;
+};
+
+// 頂点を3つずつ並べた三角形リストからインデックス付きのメッシュを作る。同じ頂点は1つにまとめる
+// 許容差を渡すと、位置とUVがそれぞれその範囲に収まる頂点を1つに溶接する。まとめた結果潰れた三角形は捨てる
+Mesh BuildIndexedMesh(const std::vector<VertexData>& triangleVertices, const MeshWeldTolerance& tolerance = {});
+
+// 頂点キャッシュ(変換後の頂点を使い回すGPUのキャッシュ)に当たりやすいよう三角形を並べ替える。Forsythの方法
+// 頂点はキャッシュの中の位置と、まだ使う三角形の数で点数を付け、点数の合計が一番高い三角形から順に出す
+void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+// 頂点をインデックスから最初に使われる順に並べ替える。頂点の読み込みが前から順になる。使われない頂点は消える
+void OptimizeVertexFetch(Mesh& mesh);
+
+// 三角形1つあたりに頂点シェーダーが走る回数(ACMR)。cacheSize個のFIFOのキャッシュとして数える
+// 全く使い回せなければ3.0で、小さいほど良い
+float ComputeACMR(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = 16);
+
+// メッシュのバイナリ形式。ヘッダの後ろに頂点とインデックスをそのまま並べる。インデックスは足りれば16bitで持つ
+// 読み込みは検証してからそのままコピーするだけなので、パースが要らない
+// 今はModelCookerだけが使う（書いたファイルをLoadMeshで読み戻して確かめる）。ゲームはメッシュをコードで作っていて、まだ読まない
+bool SaveMesh(const std::filesystem::path& path, const Mesh& mesh);
+bool LoadMesh(const std::filesystem::path& path, Mesh& mesh);
+
+// ModelCookerが書き出すメッシュの置き場所。ゲームで読むようにするときはこの規則で探す
+// resources/unit.obj -> resources/cooked/unit.mesh
+inline std::filesystem::path GetCookedMeshPath(const std::filesystem::path& sourcePath) {
+	std::filesystem::path cookedPath = sourcePath.parent_path() / "cooked" / sourcePath.filename();
+	cookedPath.replace_extension(".mesh");
+	return cookedPath;
+}
+
+// ModelCookerが入力の内容ハッシュを記録するファイル。TextureCookerのものとは分ける
+inline constexpr const char* kCookedMeshManifestName = "cooked_mesh_manifest.txt";
@@ -0,0 +1,269 @@
+// OBJとglTFのモデルをインデックス付きのバイナリメッシュに変換するオフラインツール
+// 使い方: ModelCooker <入力ディレクトリ> [--force] [--threads N] [--benchmark-parse]
+// 入力ディレクトリ以下のモデルをそれぞれ <ディレクトリ>/cooked/<名前>.mesh に書き出す
+// 内容のハッシュをマニフェストに記録し、変わっていないものは変換し直さない
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <map>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+
+#include "../Mesh.h"
+#include "../ModelLoader.h"
+#include "../MappedFile.h"
+#include "../ThreadPool.h"
+#include "../VertexCompression.h"
+
+namespace {
+
+// 出力形式や最適化を変えたら上げる。マニフェストのハッシュに含まれるので全て作り直しになる
+const uint32_t kCookerVersion = 1;
+
+struct CookOptions {
+	std::filesystem::path inputDirectory;
+	bool force = false;
+	// 0ならハードウェアスレッド数に合わせる
+	uint32_t threadCount = 0;
+	// 変換せず、モデルの解析速度を測る
+	bool benchmarkParse = false;
+};
+
+// FNV-1a 64bit
+uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+// マニフェストは1行に「ハッシュ 入力ディレクトリからの相対パス」
+std::map<std::string, uint64_t> LoadManifest(const std::filesystem::path& path) {
+	std::map<std::string, uint64_t> manifest;
+	std::ifstream file(path);
+	std::string line;
+	while (std::getline(file, line)) {
+		std::istringstream stream(line);
+		std::string hash;
+		if (!(stream >> hash)) {
+			continue;
+		}
+		std::string relativePath;
+		std::getline(stream >> std::ws, relativePath);
+		// 壊れた行は記録が無いものとして扱い、そのファイルは変換し直す
+		uint64_t value = 0;
+		auto [end, error] = std::from_chars(hash.data(), hash.data() + hash.size(), value, 16);
+		if (error != std::errc() || end != hash.data() + hash.size() || relativePath.empty()) {
+			continue;
+		}
+		manifest[relativePath] = value;
+	}
+	return manifest;
+}
+
+void SaveManifest(const std::filesystem::path& path, const std::map<std::string, uint64_t>& manifest) {
+	std::ofstream file(path);
+	for (const auto& [relativePath, hash] : manifest) {
+		char hashText[17];
+		snprintf(hashText, sizeof(hashText), "%016llx", static_cast<unsigned long long>(hash));
+		file << hashText << ' ' << relativePath << '\n';
+	}
+}
+
+// 入力ディレクトリ以下のモデルを集める。出力先のcookedディレクトリは見ない
+std::vector<std::filesystem::path> FindModels(const std::filesystem::path& directory) {
+	std::vector<std::filesystem::path> paths;
+	for (auto it = std::filesystem::recursive_directory_iterator(directory); it != std::filesystem::recursive_directory_iterator(); ++it) {
+		if (it->is_directory() && it->path().filename() == "cooked") {
+			it.disable_recursion_pending();
+			continue;
+		}
+		if (it->is_regular_file() && IsModelFile(it->path())) {
+			paths.push_back(it->path());
+		}
+	}
+	std::sort(paths.begin(), paths.end());
+	return paths;
+}
+
+bool ParseOptions(int argc, char* argv[], CookOptions& options) {
+	if (argc < 2) {
+		return false;
+	}
+	options.inputDirectory = argv[1];
+	for (int i = 2; i < argc; ++i) {
+		std::string argument = argv[i];
+		if (argument == "--force") {
+			options.force = true;
+		} else if (argument == "--benchmark-parse") {
+			options.benchmarkParse = true;
+		} else if (argument == "--threads" && i + 1 < argc) {
+			options.threadCount = uint32_t(std::stoul(argv[++i]));
+		} else {
+			return false;
+		}
+	}
+	return true;
+}
+
+// 入力ディレクトリ以下のモデルを全て変換する
+int CookDirectory(const CookOptions& options, ThreadPool& threadPool) {
+	std::filesystem::path manifestPath = options.inputDirectory / kCookedMeshManifestName;
+	std::map<std::string, uint64_t> manifest = LoadManifest(manifestPath);
+
+	uint32_t cookedCount = 0;
+	uint32_t skippedCount = 0;
+	uint32_t failedCount = 0;
+	auto totalStart = std::chrono::steady_clock::now();
+	for (const std::filesystem::path& sourcePath : FindModels(options.inputDirectory)) {
+		std::string relativePath = std::filesystem::relative(sourcePath, options.inputDirectory).generic_string();
+		std::filesystem::path cookedPath = GetCookedMeshPath(sourcePath);
+
+		// 入力の内容からハッシュを作る。glTFの外部バッファの中身も混ぜ、バッファだけ変えたときも変換し直す
+		MappedFile sourceFile;
+		if (!sourceFile.Open(sourcePath)) {
+			printf("[failed ] %s: read failed\n", relativePath.c_str());
+			++failedCount;
+			continue;
+		}
+		uint64_t hash = HashBytes(sourceFile.GetData(), sourceFile.GetSize());
+		hash = HashBytes(&kCookerVersion, sizeof(kCookerVersion), hash);
+		sourceFile.Close();
+		std::vector<std::filesystem::path> dependencies;
+		std::string dependencyMessage;
+		// 解析できなければ、この後の読み込みで失敗して理由を出す
+		if (GetModelDependencies(sourcePath, dependencies, dependencyMessage)) {
+			for (const std::filesystem::path& dependency : dependencies) {
+				// 開けないバッファは大きさ0として混ぜる。読み込みで失敗するので、マニフェストには残らない
+				MappedFile dependencyFile;
+				uint64_t dependencySize = dependencyFile.Open(dependency) ? dependencyFile.GetSize() : 0;
+				hash = HashBytes(&dependencySize, sizeof(dependencySize), hash);
+				if (dependencySize != 0) {
+					hash = HashBytes(dependencyFile.GetData(), dependencyFile.GetSize(), hash);
+				}
+			}
+		}
+
+		auto found = manifest.find(relativePath);
+		if (!options.force && found != manifest.end() && found->second == hash && std::filesystem::exists(cookedPath)) {
+			printf("[skipped] %s\n", relativePath.c_str());
+			++skippedCount;
+			continue;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		Mesh mesh;
+		std::string message;
+		ModelLoadStatistics statistics;
+		if (!LoadModel(sourcePath, &threadPool, mesh, message, &statistics)) {
+			printf("[failed ] %s: %s\n", relativePath.c_str(), message.c_str());
+			manifest.erase(relativePath);
+			++failedCount;
+			continue;
+		}
+		float acmrBefore = ComputeACMR(mesh.indices, uint32_t(mesh.vertices.size()));
+		OptimizeVertexCache(mesh.indices, uint32_t(mesh.vertices.size()));
+		OptimizeVertexFetch(mesh);
+		float acmrAfter = ComputeACMR(mesh.indices, uint32_t(mesh.vertices.size()));
+
+		std::error_code errorCode;
+		std::filesystem::create_directories(cookedPath.parent_path(), errorCode);
+		// 書いたものを読み戻し、読み込みの検証を通ることまで確かめる
+		Mesh writtenMesh;
+		if (!SaveMesh(cookedPath, mesh) || !LoadMesh(cookedPath, writtenMesh) || writtenMesh.indices != mesh.indices ||
+			writtenMesh.vertices.size() != mesh.vertices.size()) {
+			printf("[failed ] %s: cannot write %s\n", relativePath.c_str(), cookedPath.generic_string().c_str());
+			manifest.erase(relativePath);
+			++failedCount;
+			continue;
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		printf("[cooked ] %s -> %s (%zu vertices, %u triangles, ACMR %.3f -> %.3f, parse %.0f MB/s, %.2f s, %llu -> %llu bytes)\n",
+			relativePath.c_str(), cookedPath.generic_string().c_str(), mesh.vertices.size(), mesh.GetTriangleCount(), acmrBefore, acmrAfter,
+			double(statistics.fileBytes) / (1024.0 * 1024.0) / statistics.parseSeconds, seconds,
+			static_cast<unsigned long long>(statistics.fileBytes), static_cast<unsigned long long>(std::filesystem::file_size(cookedPath)));
+
+		// ゲームは頂点を詰めて使うので、その誤差と頂点バッファの大きさも出しておく
+		CompressedMesh compressedMesh = CompressMesh(mesh);
+		VertexCompressionReport compression = MeasureVertexCompression(mesh, compressedMesh);
+		printf("          vertex compression: %llu -> %llu bytes (%.0f%%), position error %.6f (bound %.6f), texcoord error %.6f (%s)\n",
+			static_cast<unsigned long long>(compression.sourceBytes), static_cast<unsigned long long>(compression.compressedBytes),
+			compression.sourceBytes ? 100.0 * double(compression.compressedBytes) / double(compression.sourceBytes) : 0.0,
+			compression.maxPositionError, compression.positionErrorBound, compression.maxTexcoordError,
+			compressedMesh.texcoordEncoding == TexcoordEncoding::Unorm16 ? "unorm16" : "half");
+		if (compression.maxPositionError > compression.positionErrorBound) {
+			printf("          warning: position error exceeds the quantization bound\n");
+		}
+		manifest[relativePath] = hash;
+		++cookedCount;
+	}
+	SaveManifest(manifestPath, manifest);
+
+	double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - totalStart).count();
+	printf("%u cooked, %u up to date, %u failed (%.2f s)\n", cookedCount, skippedCount, failedCount, totalSeconds);
+	return failedCount == 0 ? 0 : 1;
+}
+
+// モデルを1スレッドとスレッドプールで繰り返し読み、解析と変換の速度を比べる
+// 比べやすいように、解析と変換はそれぞれ一番速かった回を使う
+int BenchmarkParse(const CookOptions& options, ThreadPool& threadPool) {
+	std::vector<std::filesystem::path> sourcePaths = FindModels(options.inputDirectory);
+	if (sourcePaths.empty()) {
+		printf("no models under %s\n", options.inputDirectory.string().c_str());
+		return 1;
+	}
+
+	const int kIterations = 5;
+	printf("%-40s %10s %14s %14s %14s %14s\n", "model", "MB", "parse 1T MB/s", "parse MB/s", "convert 1T ms", "convert ms");
+	for (const std::filesystem::path& sourcePath : sourcePaths) {
+		ModelLoadStatistics best[2];
+		for (int iteration = 0; iteration < kIterations; ++iteration) {
+			// 交互に測って、ファイルキャッシュの条件を揃える
+			for (int parallel = 0; parallel < 2; ++parallel) {
+				Mesh mesh;
+				std::string message;
+				ModelLoadStatistics statistics;
+				if (!LoadModel(sourcePath, parallel ? &threadPool : nullptr, mesh, message, &statistics)) {
+					printf("%s\n", message.c_str());
+					return 1;
+				}
+				if (iteration == 0 || statistics.parseSeconds < best[parallel].parseSeconds) {
+					best[parallel].parseSeconds = statistics.parseSeconds;
+				}
+				if (iteration == 0 || statistics.convertSeconds < best[parallel].convertSeconds) {
+					best[parallel].convertSeconds = statistics.convertSeconds;
+				}
+				best[parallel].fileBytes = statistics.fileBytes;
+			}
+		}
+		double megabytes = double(best[0].fileBytes) / (1024.0 * 1024.0);
+		std::string relativePath = std::filesystem::relative(sourcePath, options.inputDirectory).generic_string();
+		printf("%-40s %10.1f %14.0f %14.0f %14.1f %14.1f\n", relativePath.c_str(), megabytes,
+			megabytes / best[0].parseSeconds, megabytes / best[1].parseSeconds, best[0].convertSeconds * 1000.0, best[1].convertSeconds * 1000.0);
+	}
+	printf("%u worker threads + main thread\n", threadPool.GetThreadCount());
+	return 0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+	CookOptions options;
+	if (!ParseOptions(argc, argv, options)) {
+		printf("usage: ModelCooker <input directory> [--force] [--threads N] [--benchmark-parse]\n");
+		return 1;
+	}
+	if (!std::filesystem::is_directory(options.inputDirectory)) {
+		printf("not a directory: %s\n", options.inputDirectory.string().c_str());
+		return 1;
+	}
+	ThreadPool threadPool(options.threadCount);
+	return options.benchmarkParse ? BenchmarkParse(options, threadPool) : CookDirectory(options, threadPool);
+}
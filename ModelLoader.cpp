@@ -0,0 +1,1238 @@
+#include "ModelLoader.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <cassert>
+#include <cctype>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <memory>
+#include <string_view>
+
+namespace {
+
+// OBJを分けて解析する単位。行の途中では切らない
+const size_t kObjChunkSize = 1 << 20;
+// glTFの変換を分ける単位
+const uint32_t kGltfVertexGrainSize = 1 << 16;
+
+void ParallelFor(ThreadPool* threadPool, size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& function) {
+	if (threadPool) {
+		threadPool->ParallelFor(count, grainSize, function);
+	} else if (count != 0) {
+		function(0, count);
+	}
+}
+
+double GetSecondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string GetLowerExtension(const std::filesystem::path& path) {
+	std::string extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return char(tolower(static_cast<unsigned char>(c))); });
+	return extension;
+}
+
+// 左手系へ。Xを反転する。三角形の向きは呼び出し側で逆にする
+Vector4 ToLeftHanded(const Vector3& position) {
+	return { -position.x, position.y, position.z, 1.0f };
+}
+
+//------------------------------------------------------------------------------
+// OBJ
+//------------------------------------------------------------------------------
+
+// 面の1頂点。インデックスは0始まり。負のインデックスで書かれていたものは、チャンクの先頭からの位置で持つ
+struct ObjCorner {
+	int32_t position;
+	int32_t texcoord;
+	uint32_t flags;
+};
+const uint32_t kObjRelativePosition = 1;
+const uint32_t kObjRelativeTexcoord = 2;
+const uint32_t kObjNoTexcoord = 4;
+
+struct ObjChunk {
+	const char* begin = nullptr;
+	const char* end = nullptr;
+	std::vector<Vector3> positions;
+	std::vector<Vector2> texcoords;
+	std::vector<ObjCorner> corners;
+	// 面ごとの頂点数
+	std::vector<uint32_t> faceSizes;
+	uint32_t triangleCount = 0;
+	// 前のチャンクまでの数
+	uint32_t positionBase = 0;
+	uint32_t texcoordBase = 0;
+	uint32_t triangleBase = 0;
+	// 解析に失敗した位置。nullptrなら成功
+	const char* errorPosition = nullptr;
+	const char* error = nullptr;
+};
+
+// 文字列を作らずにバイト列の上を進む字句解析器
+class ObjTokenizer {
+public:
+	ObjTokenizer(const char* begin, const char* end) : current_(begin), end_(end) {}
+
+	bool IsEnd() const { return current_ >= end_; }
+	const char* GetPosition() const { return current_; }
+
+	// 行の中の空白を飛ばす
+	void SkipSpaces() {
+		while (current_ < end_ && (*current_ == ' ' || *current_ == '\t' || *current_ == '\r')) {
+			++current_;
+		}
+	}
+	bool IsLineEnd() {
+		SkipSpaces();
+		return current_ >= end_ || *current_ == '\n';
+	}
+	void NextLine() {
+		const char* newline = static_cast<const char*>(memchr(current_, '\n', size_t(end_ - current_)));
+		current_ = newline ? newline + 1 : end_;
+	}
+	// 行の先頭の命令(v、vt、fなど)を読む
+	std::string_view ReadKeyword() {
+		SkipSpaces();
+		const char* begin = current_;
+		while (current_ < end_ && !isspace(static_cast<unsigned char>(*current_))) {
+			++current_;
+		}
+		return { begin, size_t(current_ - begin) };
+	}
+	bool ReadFloat(float& value) {
+		SkipSpaces();
+		// from_charsは先頭の+を受け付けない
+		if (current_ < end_ && *current_ == '+') {
+			++current_;
+		}
+		auto [next, error] = std::from_chars(current_, end_, value);
+		if (error != std::errc()) {
+			return false;
+		}
+		current_ = next;
+		return true;
+	}
+	bool ReadInt(int32_t& value) {
+		auto [next, error] = std::from_chars(current_, end_, value);
+		if (error != std::errc()) {
+			return false;
+		}
+		current_ = next;
+		return true;
+	}
+	bool Consume(char c) {
+		if (current_ < end_ && *current_ == c) {
+			++current_;
+			return true;
+		}
+		return false;
+	}
+
+private:
+	const char* current_;
+	const char* end_;
+};
+
+// 1が先頭。負なら直前に定義したものからの相対
+bool ResolveObjIndex(int32_t index, uint32_t localCount, int32_t& resolved, bool& relative) {
+	if (index > 0) {
+		resolved = index - 1;
+		relative = false;
+		return true;
+	}
+	if (index < 0) {
+		// チャンクより前を指すこともあるので、負のまま持って後で足す
+		resolved = int32_t(localCount) + index;
+		relative = true;
+		return true;
+	}
+	return false;
+}
+
+void ParseObjChunk(ObjChunk& chunk) {
+	ObjTokenizer tokenizer(chunk.begin, chunk.end);
+	auto fail = [&](const char* error) {
+		chunk.errorPosition = tokenizer.GetPosition();
+		chunk.error = error;
+	};
+	for (; !tokenizer.IsEnd(); tokenizer.NextLine()) {
+		std::string_view keyword = tokenizer.ReadKeyword();
+		if (keyword == "v") {
+			Vector3 position;
+			if (!tokenizer.ReadFloat(position.x) || !tokenizer.ReadFloat(position.y) || !tokenizer.ReadFloat(position.z)) {
+				return fail("invalid vertex position");
+			}
+			chunk.positions.push_back(position);
+		} else if (keyword == "vt") {
+			Vector2 texcoord;
+			if (!tokenizer.ReadFloat(texcoord.x)) {
+				return fail("invalid texture coordinate");
+			}
+			// vは省略できる
+			if (!tokenizer.ReadFloat(texcoord.y)) {
+				texcoord.y = 0.0f;
+			}
+			chunk.texcoords.push_back(texcoord);
+		} else if (keyword == "f") {
+			uint32_t cornerCount = 0;
+			while (!tokenizer.IsLineEnd()) {
+				// v、v/vt、v//vn、v/vt/vnのどれか
+				ObjCorner corner{ 0, 0, kObjNoTexcoord };
+				int32_t index = 0;
+				bool relative = false;
+				if (!tokenizer.ReadInt(index) || !ResolveObjIndex(index, uint32_t(chunk.positions.size()), corner.position, relative)) {
+					return fail("invalid face index");
+				}
+				if (relative) {
+					corner.flags |= kObjRelativePosition;
+				}
+				if (tokenizer.Consume('/')) {
+					if (tokenizer.ReadInt(index)) {
+						if (!ResolveObjIndex(index, uint32_t(chunk.texcoords.size()), corner.texcoord, relative)) {
+							return fail("invalid face index");
+						}
+						corner.flags &= ~kObjNoTexcoord;
+						if (relative) {
+							corner.flags |= kObjRelativeTexcoord;
+						}
+					}
+					// 法線は使わない
+					if (tokenizer.Consume('/')) {
+						tokenizer.ReadInt(index);
+					}
+				}
+				chunk.corners.push_back(corner);
+				++cornerCount;
+			}
+			if (cornerCount < 3) {
+				return fail("face with fewer than 3 vertices");
+			}
+			chunk.faceSizes.push_back(cornerCount);
+			chunk.triangleCount += cornerCount - 2;
+		}
+		// vn、o、g、s、usemtl、mtllib、コメントなどは読み飛ばす
+	}
+}
+
+// 面を三角形に分け、VertexDataにして並べる
+bool ConvertObjChunk(const ObjChunk& chunk, const std::vector<Vector3>& positions, const std::vector<Vector2>& texcoords, VertexData* output) {
+	auto getVertex = [&](const ObjCorner& corner, VertexData& vertex) {
+		int64_t position = corner.position + ((corner.flags & kObjRelativePosition) ? int64_t(chunk.positionBase) : 0);
+		if (position < 0 || position >= int64_t(positions.size())) {
+			return false;
+		}
+		vertex.position = ToLeftHanded(positions[size_t(position)]);
+		vertex.texcoord = { 0.0f, 0.0f };
+		if (!(corner.flags & kObjNoTexcoord)) {
+			int64_t texcoord = corner.texcoord + ((corner.flags & kObjRelativeTexcoord) ? int64_t(chunk.texcoordBase) : 0);
+			if (texcoord < 0 || texcoord >= int64_t(texcoords.size())) {
+				return false;
+			}
+			// OBJのvは下から上。テクスチャは上から下
+			vertex.texcoord = { texcoords[size_t(texcoord)].x, 1.0f - texcoords[size_t(texcoord)].y };
+		}
+		return true;
+	};
+
+	const ObjCorner* corners = chunk.corners.data();
+	for (uint32_t faceSize : chunk.faceSizes) {
+		VertexData first;
+		if (!getVertex(corners[0], first)) {
+			return false;
+		}
+		for (uint32_t i = 1; i + 1 < faceSize; ++i) {
+			// 左手系にしたので向きを逆にする
+			output[0] = first;
+			if (!getVertex(corners[i + 1], output[1]) || !getVertex(corners[i], output[2])) {
+				return false;
+			}
+			output += 3;
+		}
+		corners += faceSize;
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// JSON
+//------------------------------------------------------------------------------
+
+enum class JsonType : uint8_t {
+	Object,
+	Array,
+	String,
+	Number,
+	True,
+	False,
+	Null,
+};
+
+// 値1つ。文字列は元のテキストの範囲だけを持ち、エスケープは解かない
+struct JsonToken {
+	JsonType type;
+	uint32_t begin;
+	uint32_t end;
+	// オブジェクトはメンバーの数、配列は要素の数
+	uint32_t size;
+	// 子を全て飛ばした次のトークン
+	uint32_t next;
+};
+
+// トークンを平らに並べたJSON。オブジェクトのメンバーはキーの文字列と値のトークンが交互に並ぶ
+class JsonDocument {
+public:
+	static constexpr uint32_t kNone = ~0u;
+
+	bool Parse(const char* text, size_t size) {
+		text_ = text;
+		size_ = size;
+		position_ = 0;
+		tokens_.clear();
+		// 大体の数を見込んでおく
+		tokens_.reserve(size / 8 + 16);
+		if (!ParseValue(0)) {
+			return false;
+		}
+		SkipSpaces();
+		return position_ == size_;
+	}
+
+	uint32_t GetRoot() const { return 0; }
+	JsonType GetType(uint32_t token) const { return tokens_[token].type; }
+	// 配列の要素の数。配列でなければ0なので、配列のはずの値がオブジェクトなどでも要素を辿らない
+	uint32_t GetSize(uint32_t token) const { return token == kNone || tokens_[token].type != JsonType::Array ? 0 : tokens_[token].size; }
+
+	// オブジェクトのメンバーを探す。無ければkNone
+	uint32_t Find(uint32_t object, std::string_view key) const {
+		if (object == kNone || tokens_[object].type != JsonType::Object) {
+			return kNone;
+		}
+		uint32_t token = object + 1;
+		for (uint32_t i = 0; i < tokens_[object].size; ++i) {
+			uint32_t value = token + 1;
+			if (GetString(token) == key) {
+				return value;
+			}
+			token = tokens_[value].next;
+		}
+		return kNone;
+	}
+	// 配列の要素。範囲外ならkNone
+	uint32_t At(uint32_t array, uint32_t index) const {
+		if (array == kNone || tokens_[array].type != JsonType::Array || index >= tokens_[array].size) {
+			return kNone;
+		}
+		uint32_t token = array + 1;
+		for (uint32_t i = 0; i < index; ++i) {
+			token = tokens_[token].next;
+		}
+		return token;
+	}
+	// 無いか配列なら真。配列のはずのメンバーを確かめる
+	bool IsArrayOrNone(uint32_t token) const { return token == kNone || tokens_[token].type == JsonType::Array; }
+	// 配列の要素を前から順に辿るとき用。最後の要素の次は配列の外を指すので、GetSizeの数だけ辿ること
+	uint32_t GetNext(uint32_t token) const { return token == kNone ? kNone : tokens_[token].next; }
+
+	std::string_view GetString(uint32_t token) const {
+		if (token == kNone || tokens_[token].type != JsonType::String) {
+			return {};
+		}
+		return { text_ + tokens_[token].begin, tokens_[token].end - tokens_[token].begin };
+	}
+	double GetNumber(uint32_t token, double defaultValue) const {
+		if (token == kNone || tokens_[token].type != JsonType::Number) {
+			return defaultValue;
+		}
+		double value = defaultValue;
+		std::from_chars(text_ + tokens_[token].begin, text_ + tokens_[token].end, value);
+		return value;
+	}
+	bool GetBool(uint32_t token) const {
+		return token != kNone && tokens_[token].type == JsonType::True;
+	}
+	// 整数として読む。無い、または負なら-1
+	int64_t GetIndex(uint32_t token) const {
+		double value = GetNumber(token, -1.0);
+		return value >= 0.0 ? int64_t(value) : -1;
+	}
+	double GetMemberNumber(uint32_t object, std::string_view key, double defaultValue) const {
+		return GetNumber(Find(object, key), defaultValue);
+	}
+	int64_t GetMemberIndex(uint32_t object, std::string_view key) const {
+		return GetIndex(Find(object, key));
+	}
+
+private:
+	// 深すぎる入れ子は壊れたファイルとして扱う
+	static constexpr uint32_t kMaxDepth = 64;
+
+	void SkipSpaces() {
+		while (position_ < size_ && (text_[position_] == ' ' || text_[position_] == '\t' || text_[position_] == '\r' || text_[position_] == '\n')) {
+			++position_;
+		}
+	}
+
+	uint32_t AddToken(JsonType type, size_t begin) {
+		tokens_.push_back({ type, uint32_t(begin), uint32_t(begin), 0, 0 });
+		return uint32_t(tokens_.size() - 1);
+	}
+
+	bool ParseString() {
+		// 開きの"は読んである
+		size_t begin = position_;
+		while (position_ < size_ && text_[position_] != '"') {
+			if (text_[position_] == '\\') {
+				++position_;
+			}
+			++position_;
+		}
+		if (position_ >= size_) {
+			return false;
+		}
+		uint32_t token = AddToken(JsonType::String, begin);
+		tokens_[token].end = uint32_t(position_);
+		tokens_[token].next = token + 1;
+		++position_;
+		return true;
+	}
+
+	bool ParseValue(uint32_t depth) {
+		if (depth > kMaxDepth) {
+			return false;
+		}
+		SkipSpaces();
+		if (position_ >= size_) {
+			return false;
+		}
+		char c = text_[position_];
+		if (c == '{' || c == '[') {
+			bool isObject = c == '{';
+			char close = isObject ? '}' : ']';
+			uint32_t token = AddToken(isObject ? JsonType::Object : JsonType::Array, position_);
+			++position_;
+			SkipSpaces();
+			uint32_t size = 0;
+			if (position_ < size_ && text_[position_] == close) {
+				++position_;
+			} else {
+				for (;;) {
+					if (isObject) {
+						SkipSpaces();
+						if (position_ >= size_ || text_[position_] != '"') {
+							return false;
+						}
+						++position_;
+						if (!ParseString()) {
+							return false;
+						}
+						SkipSpaces();
+						if (position_ >= size_ || text_[position_] != ':') {
+							return false;
+						}
+						++position_;
+					}
+					if (!ParseValue(depth + 1)) {
+						return false;
+					}
+					++size;
+					SkipSpaces();
+					if (position_ < size_ && text_[position_] == ',') {
+						++position_;
+						continue;
+					}
+					if (position_ < size_ && text_[position_] == close) {
+						++position_;
+						break;
+					}
+					return false;
+				}
+			}
+			tokens_[token].size = size;
+			tokens_[token].end = uint32_t(position_);
+			tokens_[token].next = uint32_t(tokens_.size());
+			return true;
+		}
+		if (c == '"') {
+			++position_;
+			return ParseString();
+		}
+
+		// 数値とtrue/false/null。区切りまでをまとめて読む
+		size_t begin = position_;
+		while (position_ < size_ && text_[position_] != ',' && text_[position_] != '}' && text_[position_] != ']' &&
+			!isspace(static_cast<unsigned char>(text_[position_]))) {
+			++position_;
+		}
+		std::string_view literal(text_ + begin, position_ - begin);
+		JsonType type = JsonType::Number;
+		if (literal == "true") {
+			type = JsonType::True;
+		} else if (literal == "false") {
+			type = JsonType::False;
+		} else if (literal == "null") {
+			type = JsonType::Null;
+		} else {
+			double value = 0.0;
+			auto [next, error] = std::from_chars(literal.data(), literal.data() + literal.size(), value);
+			if (error != std::errc() || next != literal.data() + literal.size()) {
+				return false;
+			}
+		}
+		uint32_t token = AddToken(type, begin);
+		tokens_[token].end = uint32_t(position_);
+		tokens_[token].next = token + 1;
+		return true;
+	}
+
+	const char* text_ = nullptr;
+	size_t size_ = 0;
+	size_t position_ = 0;
+	std::vector<JsonToken> tokens_;
+};
+
+//------------------------------------------------------------------------------
+// glTF
+//------------------------------------------------------------------------------
+
+const uint32_t kGlbMagic = 0x46546C67; // "glTF"
+const uint32_t kGlbChunkJson = 0x4E4F534A; // "JSON"
+const uint32_t kGlbChunkBin = 0x004E4942; // "BIN"
+
+const uint32_t kGltfByte = 5120;
+const uint32_t kGltfUnsignedByte = 5121;
+const uint32_t kGltfShort = 5122;
+const uint32_t kGltfUnsignedShort = 5123;
+const uint32_t kGltfUnsignedInt = 5125;
+const uint32_t kGltfFloat = 5126;
+const uint32_t kGltfTriangles = 4;
+
+struct GltfBuffer {
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+};
+
+// アクセサを解決したもの。要素iはdata + stride * iから始まる
+struct GltfAccessor {
+	const uint8_t* data = nullptr;
+	uint32_t count = 0;
+	uint32_t componentType = 0;
+	uint32_t componentCount = 0;
+	uint32_t stride = 0;
+	bool normalized = false;
+};
+
+uint32_t GetComponentSize(uint32_t componentType) {
+	switch (componentType) {
+	case kGltfByte:
+	case kGltfUnsignedByte:
+		return 1;
+	case kGltfShort:
+	case kGltfUnsignedShort:
+		return 2;
+	case kGltfUnsignedInt:
+	case kGltfFloat:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+uint32_t GetComponentCount(std::string_view type) {
+	if (type == "SCALAR") {
+		return 1;
+	}
+	if (type == "VEC2") {
+		return 2;
+	}
+	if (type == "VEC3") {
+		return 3;
+	}
+	if (type == "VEC4") {
+		return 4;
+	}
+	return 0;
+}
+
+template<class T>
+T ReadUnaligned(const uint8_t* data) {
+	T value;
+	memcpy(&value, data, sizeof(T));
+	return value;
+}
+
+float ReadComponent(const GltfAccessor& accessor, uint32_t index, uint32_t component) {
+	const uint8_t* data = accessor.data + size_t(accessor.stride) * index + GetComponentSize(accessor.componentType) * component;
+	switch (accessor.componentType) {
+	case kGltfFloat:
+		return ReadUnaligned<float>(data);
+	case kGltfUnsignedByte: {
+		float value = float(*data);
+		return accessor.normalized ? value / 255.0f : value;
+	}
+	case kGltfUnsignedShort: {
+		float value = float(ReadUnaligned<uint16_t>(data));
+		return accessor.normalized ? value / 65535.0f : value;
+	}
+	case kGltfByte: {
+		float value = float(int8_t(*data));
+		return accessor.normalized ? std::max(value / 127.0f, -1.0f) : value;
+	}
+	case kGltfShort: {
+		float value = float(ReadUnaligned<int16_t>(data));
+		return accessor.normalized ? std::max(value / 32767.0f, -1.0f) : value;
+	}
+	default:
+		return 0.0f;
+	}
+}
+
+uint32_t ReadIndex(const GltfAccessor& accessor, uint32_t index) {
+	const uint8_t* data = accessor.data + size_t(accessor.stride) * index;
+	switch (accessor.componentType) {
+	case kGltfUnsignedByte:
+		return *data;
+	case kGltfUnsignedShort:
+		return ReadUnaligned<uint16_t>(data);
+	default:
+		return ReadUnaligned<uint32_t>(data);
+	}
+}
+
+// URIの%エスケープとJSONの\エスケープを解く
+std::string DecodeUri(std::string_view uri) {
+	std::string result;
+	result.reserve(uri.size());
+	for (size_t i = 0; i < uri.size(); ++i) {
+		if (uri[i] == '\\' && i + 1 < uri.size()) {
+			result += uri[++i];
+		} else if (uri[i] == '%' && i + 2 < uri.size()) {
+			int value = 0;
+			std::from_chars(uri.data() + i + 1, uri.data() + i + 3, value, 16);
+			result += char(value);
+			i += 2;
+		} else {
+			result += uri[i];
+		}
+	}
+	return result;
+}
+
+bool DecodeBase64(std::string_view text, std::vector<uint8_t>& data) {
+	auto decode = [](char c) -> int {
+		if (c >= 'A' && c <= 'Z') {
+			return c - 'A';
+		}
+		if (c >= 'a' && c <= 'z') {
+			return c - 'a' + 26;
+		}
+		if (c >= '0' && c <= '9') {
+			return c - '0' + 52;
+		}
+		if (c == '+') {
+			return 62;
+		}
+		if (c == '/') {
+			return 63;
+		}
+		return -1;
+	};
+	data.clear();
+	data.reserve(text.size() / 4 * 3);
+	uint32_t bits = 0;
+	int bitCount = 0;
+	for (char c : text) {
+		if (c == '=') {
+			break;
+		}
+		int value = decode(c);
+		if (value < 0) {
+			return false;
+		}
+		bits = (bits << 6) | uint32_t(value);
+		bitCount += 6;
+		if (bitCount >= 8) {
+			bitCount -= 8;
+			data.push_back(uint8_t(bits >> bitCount));
+		}
+	}
+	return true;
+}
+
+// glTFの読み込み中の状態。バッファのマップとデコードしたデータを持つ
+class GltfLoader {
+public:
+	bool Load(const std::filesystem::path& path, ThreadPool* threadPool, Mesh& mesh, std::string& message, ModelLoadStatistics& statistics);
+	// ファイルを開いてJSONを解析する。.glbならBINチャンクも見つけておく。fileは解析した結果より長く持っておくこと
+	bool ParseDocument(const std::filesystem::path& path, MappedFile& file, std::string& message);
+	// 解析した後に呼ぶ。外部ファイルのバッファのパス
+	std::vector<std::filesystem::path> GetExternalBufferPaths(const std::filesystem::path& directory) const;
+
+private:
+	// URIはUTF-8でパーセントエンコードされている
+	static std::filesystem::path GetBufferPath(const std::filesystem::path& directory, std::string_view uri);
+	// バッファの中に収まることまで確かめる
+	bool GetAccessor(int64_t index, GltfAccessor& accessor, std::string& message) const;
+	bool LoadBuffers(const std::filesystem::path& directory, std::string& message, ModelLoadStatistics& statistics);
+	Matrix4x4 GetLocalMatrix(uint32_t node) const;
+
+	JsonDocument document_;
+	// .glbのBINチャンク
+	GltfBuffer binaryChunk_;
+	std::vector<GltfBuffer> buffers_;
+	std::vector<std::unique_ptr<MappedFile>> externalFiles_;
+	std::vector<std::vector<uint8_t>> decodedBuffers_;
+};
+
+std::filesystem::path GltfLoader::GetBufferPath(const std::filesystem::path& directory, std::string_view uri) {
+	std::string decodedUri = DecodeUri(uri);
+	return directory / std::u8string(decodedUri.begin(), decodedUri.end());
+}
+
+bool GltfLoader::LoadBuffers(const std::filesystem::path& directory, std::string& message, ModelLoadStatistics& statistics) {
+	uint32_t buffers = document_.Find(document_.GetRoot(), "buffers");
+	if (!document_.IsArrayOrNone(buffers)) {
+		message = "buffers must be an array";
+		return false;
+	}
+	buffers_.resize(document_.GetSize(buffers));
+	uint32_t buffer = document_.At(buffers, 0);
+	for (size_t i = 0; i < buffers_.size(); ++i, buffer = document_.GetNext(buffer)) {
+		size_t byteLength = size_t(document_.GetMemberNumber(buffer, "byteLength", 0.0));
+		uint32_t uriToken = document_.Find(buffer, "uri");
+		if (uriToken == JsonDocument::kNone) {
+			// .glbの最初のバッファはBINチャンク
+			if (i != 0 || binaryChunk_.data == nullptr) {
+				message = "buffer " + std::to_string(i) + " has no uri";
+				return false;
+			}
+			buffers_[i] = binaryChunk_;
+		} else {
+			std::string_view uri = document_.GetString(uriToken);
+			if (uri.substr(0, 5) == "data:") {
+				size_t comma = uri.find(";base64,");
+				decodedBuffers_.emplace_back();
+				if (comma == std::string_view::npos || !DecodeBase64(uri.substr(comma + 8), decodedBuffers_.back())) {
+					message = "buffer " + std::to_string(i) + " has an unsupported data uri";
+					return false;
+				}
+				buffers_[i] = { decodedBuffers_.back().data(), decodedBuffers_.back().size() };
+			} else {
+				externalFiles_.push_back(std::make_unique<MappedFile>());
+				std::filesystem::path bufferPath = GetBufferPath(directory, uri);
+				if (!externalFiles_.back()->Open(bufferPath)) {
+					message = "cannot open " + bufferPath.string();
+					return false;
+				}
+				buffers_[i] = { externalFiles_.back()->GetData(), externalFiles_.back()->GetSize() };
+				statistics.fileBytes += buffers_[i].size;
+			}
+		}
+		if (buffers_[i].size < byteLength) {
+			message = "buffer " + std::to_string(i) + " is shorter than byteLength";
+			return false;
+		}
+	}
+	return true;
+}
+
+bool GltfLoader::GetAccessor(int64_t index, GltfAccessor& accessor, std::string& message) const {
+	uint32_t root = document_.GetRoot();
+	uint32_t accessorToken = index >= 0 ? document_.At(document_.Find(root, "accessors"), uint32_t(index)) : JsonDocument::kNone;
+	if (accessorToken == JsonDocument::kNone) {
+		message = "invalid accessor " + std::to_string(index);
+		return false;
+	}
+	if (document_.Find(accessorToken, "sparse") != JsonDocument::kNone) {
+		message = "sparse accessors are not supported";
+		return false;
+	}
+	int64_t bufferViewIndex = document_.GetMemberIndex(accessorToken, "bufferView");
+	uint32_t bufferView = bufferViewIndex >= 0 ? document_.At(document_.Find(root, "bufferViews"), uint32_t(bufferViewIndex)) : JsonDocument::kNone;
+	if (bufferView == JsonDocument::kNone) {
+		message = "accessors without a bufferView are not supported";
+		return false;
+	}
+	int64_t bufferIndex = document_.GetMemberIndex(bufferView, "buffer");
+	if (bufferIndex < 0 || bufferIndex >= int64_t(buffers_.size())) {
+		message = "invalid buffer " + std::to_string(bufferIndex);
+		return false;
+	}
+	const GltfBuffer& buffer = buffers_[size_t(bufferIndex)];
+
+	accessor.count = uint32_t(document_.GetMemberNumber(accessorToken, "count", 0.0));
+	accessor.componentType = uint32_t(document_.GetMemberNumber(accessorToken, "componentType", 0.0));
+	accessor.componentCount = GetComponentCount(document_.GetString(document_.Find(accessorToken, "type")));
+	accessor.normalized = document_.GetBool(document_.Find(accessorToken, "normalized"));
+	uint32_t elementSize = GetComponentSize(accessor.componentType) * accessor.componentCount;
+	if (elementSize == 0) {
+		message = "unsupported accessor type";
+		return false;
+	}
+	uint64_t viewOffset = uint64_t(document_.GetMemberNumber(bufferView, "byteOffset", 0.0));
+	uint64_t viewLength = uint64_t(document_.GetMemberNumber(bufferView, "byteLength", 0.0));
+	uint64_t accessorOffset = uint64_t(document_.GetMemberNumber(accessorToken, "byteOffset", 0.0));
+	accessor.stride = uint32_t(document_.GetMemberNumber(bufferView, "byteStride", 0.0));
+	if (accessor.stride == 0) {
+		accessor.stride = elementSize;
+	}
+	// 最後の要素の終わりまでがビューとバッファに収まること
+	uint64_t accessorEnd = accessor.count == 0 ? accessorOffset : accessorOffset + uint64_t(accessor.stride) * (accessor.count - 1) + elementSize;
+	if (viewOffset + viewLength > buffer.size || accessorEnd > viewLength) {
+		message = "accessor " + std::to_string(index) + " is out of range";
+		return false;
+	}
+	accessor.data = buffer.data + viewOffset + accessorOffset;
+	return true;
+}
+
+Matrix4x4 GltfLoader::GetLocalMatrix(uint32_t node) const {
+	uint32_t matrixToken = document_.Find(node, "matrix");
+	if (document_.GetSize(matrixToken) == 16) {
+		// glTFは列優先で列ベクトル。行ベクトルの行列として読むとそのまま並ぶ
+		Matrix4x4 matrix;
+		uint32_t element = document_.At(matrixToken, 0);
+		for (uint32_t i = 0; i < 16; ++i, element = document_.GetNext(element)) {
+			matrix.m[i / 4][i % 4] = float(document_.GetNumber(element, 0.0));
+		}
+		return matrix;
+	}
+	auto readArray = [&](const char* key, float* values, uint32_t count) {
+		uint32_t array = document_.Find(node, key);
+		if (document_.GetSize(array) != count) {
+			return;
+		}
+		uint32_t element = document_.At(array, 0);
+		for (uint32_t i = 0; i < count; ++i, element = document_.GetNext(element)) {
+			values[i] = float(document_.GetNumber(element, values[i]));
+		}
+	};
+	Vector3 scale = { 1.0f, 1.0f, 1.0f };
+	Quaternion rotate = { 0.0f, 0.0f, 0.0f, 1.0f };
+	Vector3 translate = { 0.0f, 0.0f, 0.0f };
+	readArray("scale", &scale.x, 3);
+	readArray("rotation", &rotate.x, 4);
+	readArray("translation", &translate.x, 3);
+	return MakeAffineMatrixFromQuaternion(scale, rotate, translate);
+}
+
+bool GltfLoader::ParseDocument(const std::filesystem::path& path, MappedFile& file, std::string& message) {
+	if (!file.Open(path)) {
+		message = "cannot open " + path.string();
+		return false;
+	}
+
+	const char* json = reinterpret_cast<const char*>(file.GetData());
+	size_t jsonSize = file.GetSize();
+	if (GetLowerExtension(path) == ".glb") {
+		// 12バイトのヘッダの後に、長さと種類を先頭に持つチャンクが並ぶ
+		const uint8_t* data = file.GetData();
+		size_t size = file.GetSize();
+		if (size < 20 || ReadUnaligned<uint32_t>(data) != kGlbMagic || ReadUnaligned<uint32_t>(data + 4) != 2) {
+			message = "not a glTF 2.0 binary";
+			return false;
+		}
+		json = nullptr;
+		for (size_t offset = 12; offset + 8 <= size;) {
+			uint32_t chunkLength = ReadUnaligned<uint32_t>(data + offset);
+			uint32_t chunkType = ReadUnaligned<uint32_t>(data + offset + 4);
+			if (offset + 8 + chunkLength > size) {
+				message = "truncated glb chunk";
+				return false;
+			}
+			if (chunkType == kGlbChunkJson && json == nullptr) {
+				json = reinterpret_cast<const char*>(data + offset + 8);
+				jsonSize = chunkLength;
+			} else if (chunkType == kGlbChunkBin && binaryChunk_.data == nullptr) {
+				binaryChunk_ = { data + offset + 8, chunkLength };
+			}
+			offset += 8 + size_t(chunkLength);
+		}
+		if (json == nullptr) {
+			message = "glb has no JSON chunk";
+			return false;
+		}
+	}
+	if (!document_.Parse(json, jsonSize) || document_.GetType(document_.GetRoot()) != JsonType::Object) {
+		message = "invalid JSON";
+		return false;
+	}
+	return true;
+}
+
+std::vector<std::filesystem::path> GltfLoader::GetExternalBufferPaths(const std::filesystem::path& directory) const {
+	std::vector<std::filesystem::path> paths;
+	uint32_t buffers = document_.Find(document_.GetRoot(), "buffers");
+	uint32_t buffer = document_.At(buffers, 0);
+	for (uint32_t i = 0; i < document_.GetSize(buffers); ++i, buffer = document_.GetNext(buffer)) {
+		uint32_t uriToken = document_.Find(buffer, "uri");
+		std::string_view uri = document_.GetString(uriToken);
+		if (uriToken != JsonDocument::kNone && uri.substr(0, 5) != "data:") {
+			paths.push_back(GetBufferPath(directory, uri));
+		}
+	}
+	return paths;
+}
+
+bool GltfLoader::Load(const std::filesystem::path& path, ThreadPool* threadPool, Mesh& mesh, std::string& message, ModelLoadStatistics& statistics) {
+	auto parseStart = std::chrono::steady_clock::now();
+	MappedFile file;
+	if (!ParseDocument(path, file, message)) {
+		return false;
+	}
+	statistics.fileBytes += file.GetSize();
+	if (!LoadBuffers(path.parent_path(), message, statistics)) {
+		return false;
+	}
+	statistics.parseSeconds += GetSecondsSince(parseStart);
+
+	auto convertStart = std::chrono::steady_clock::now();
+	uint32_t root = document_.GetRoot();
+	uint32_t meshes = document_.Find(root, "meshes");
+	uint32_t nodes = document_.Find(root, "nodes");
+
+	// 描くメッシュと、そのワールド行列を集める
+	struct MeshInstance {
+		uint32_t mesh;
+		Matrix4x4 world;
+	};
+	std::vector<MeshInstance> instances;
+	uint32_t scenes = document_.Find(root, "scenes");
+	if (!document_.IsArrayOrNone(meshes) || !document_.IsArrayOrNone(nodes) || !document_.IsArrayOrNone(scenes)) {
+		message = "meshes, nodes and scenes must be arrays";
+		return false;
+	}
+	if (document_.GetSize(scenes) == 0) {
+		// シーンが無ければメッシュをそのまま全て使う
+		uint32_t meshToken = document_.At(meshes, 0);
+		for (uint32_t i = 0; i < document_.GetSize(meshes); ++i, meshToken = document_.GetNext(meshToken)) {
+			instances.push_back({ meshToken, MakeIdentity4x4() });
+		}
+	} else {
+		int64_t sceneIndex = std::max<int64_t>(document_.GetMemberIndex(root, "scene"), 0);
+		uint32_t scene = document_.At(scenes, uint32_t(sceneIndex));
+		struct NodeEntry {
+			int64_t node;
+			Matrix4x4 parentWorld;
+		};
+		std::vector<NodeEntry> stack;
+		uint32_t rootNodes = document_.Find(scene, "nodes");
+		if (!document_.IsArrayOrNone(rootNodes)) {
+			message = "scene nodes must be an array";
+			return false;
+		}
+		uint32_t element = document_.At(rootNodes, 0);
+		for (uint32_t i = 0; i < document_.GetSize(rootNodes); ++i, element = document_.GetNext(element)) {
+			stack.push_back({ document_.GetIndex(element), MakeIdentity4x4() });
+		}
+		// 親子が輪になった壊れたファイルで止まらないよう、辿る数をノードの数までにする
+		uint32_t visitCount = 0;
+		while (!stack.empty()) {
+			NodeEntry entry = stack.back();
+			stack.pop_back();
+			uint32_t node = entry.node >= 0 ? document_.At(nodes, uint32_t(entry.node)) : JsonDocument::kNone;
+			if (node == JsonDocument::kNone || ++visitCount > document_.GetSize(nodes)) {
+				message = "invalid node hierarchy";
+				return false;
+			}
+			Matrix4x4 world = Multiply(GetLocalMatrix(node), entry.parentWorld);
+			int64_t meshIndex = document_.GetMemberIndex(node, "mesh");
+			if (meshIndex >= 0) {
+				uint32_t meshToken = document_.At(meshes, uint32_t(meshIndex));
+				if (meshToken == JsonDocument::kNone) {
+					message = "invalid mesh " + std::to_string(meshIndex);
+					return false;
+				}
+				instances.push_back({ meshToken, world });
+			}
+			uint32_t children = document_.Find(node, "children");
+			if (!document_.IsArrayOrNone(children)) {
+				message = "node children must be an array";
+				return false;
+			}
+			uint32_t child = document_.At(children, 0);
+			for (uint32_t i = 0; i < document_.GetSize(children); ++i, child = document_.GetNext(child)) {
+				stack.push_back({ document_.GetIndex(child), world });
+			}
+		}
+	}
+
+	// プリミティブごとにアクセサを解決し、出力の中の位置を決める
+	struct PrimitiveRange {
+		GltfAccessor positions;
+		GltfAccessor texcoords;
+		GltfAccessor indices;
+		bool hasTexcoords;
+		bool hasIndices;
+		const Matrix4x4* world;
+		// 行列が裏返していれば、向きを逆にしなくて良い
+		bool mirrored;
+		uint32_t vertexBase;
+		uint32_t indexBase;
+		uint32_t indexCount;
+	};
+	std::vector<PrimitiveRange> primitives;
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+	for (const MeshInstance& instance : instances) {
+		uint32_t primitiveList = document_.Find(instance.mesh, "primitives");
+		if (!document_.IsArrayOrNone(primitiveList)) {
+			message = "mesh primitives must be an array";
+			return false;
+		}
+		uint32_t primitive = document_.At(primitiveList, 0);
+		for (uint32_t i = 0; i < document_.GetSize(primitiveList); ++i, primitive = document_.GetNext(primitive)) {
+			// 線や点は描かない
+			if (uint32_t(document_.GetMemberNumber(primitive, "mode", kGltfTriangles)) != kGltfTriangles) {
+				continue;
+			}
+			PrimitiveRange range{};
+			uint32_t attributes = document_.Find(primitive, "attributes");
+			if (!GetAccessor(document_.GetMemberIndex(attributes, "POSITION"), range.positions, message)) {
+				return false;
+			}
+			if (range.positions.componentCount != 3) {
+				message = "POSITION must be VEC3";
+				return false;
+			}
+			range.hasTexcoords = document_.Find(attributes, "TEXCOORD_0") != JsonDocument::kNone;
+			if (range.hasTexcoords) {
+				if (!GetAccessor(document_.GetMemberIndex(attributes, "TEXCOORD_0"), range.texcoords, message)) {
+					return false;
+				}
+				if (range.texcoords.componentCount != 2 || range.texcoords.count < range.positions.count) {
+					message = "invalid TEXCOORD_0";
+					return false;
+				}
+			}
+			range.hasIndices = document_.Find(primitive, "indices") != JsonDocument::kNone;
+			range.indexCount = range.positions.count;
+			if (range.hasIndices) {
+				if (!GetAccessor(document_.GetMemberIndex(primitive, "indices"), range.indices, message)) {
+					return false;
+				}
+				if (range.indices.componentCount != 1 || (range.indices.componentType != kGltfUnsignedByte &&
+					range.indices.componentType != kGltfUnsignedShort && range.indices.componentType != kGltfUnsignedInt)) {
+					message = "invalid indices";
+					return false;
+				}
+				range.indexCount = range.indices.count;
+			}
+			range.indexCount -= range.indexCount % 3;
+			range.world = &instance.world;
+			const float(*m)[4] = instance.world.m;
+			float determinant = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+				m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+			range.mirrored = determinant < 0.0f;
+			range.vertexBase = vertexCount;
+			range.indexBase = indexCount;
+			if (uint64_t(vertexCount) + range.positions.count > UINT32_MAX || uint64_t(indexCount) + range.indexCount > UINT32_MAX) {
+				message = "model is too large";
+				return false;
+			}
+			vertexCount += range.positions.count;
+			indexCount += range.indexCount;
+			primitives.push_back(range);
+		}
+	}
+
+	// プリミティブを一定の頂点数ずつの仕事に分けて並列に変換する。大きいプリミティブ1つでも分かれる
+	struct ConvertTask {
+		uint32_t primitive;
+		uint32_t begin;
+		uint32_t end;
+		bool indices;
+	};
+	std::vector<ConvertTask> tasks;
+	for (uint32_t i = 0; i < primitives.size(); ++i) {
+		for (uint32_t begin = 0; begin < primitives[i].positions.count; begin += kGltfVertexGrainSize) {
+			tasks.push_back({ i, begin, std::min<uint32_t>(begin + kGltfVertexGrainSize, primitives[i].positions.count), false });
+		}
+		// インデックスは三角形の途中で切らない
+		const uint32_t kIndexGrainSize = kGltfVertexGrainSize * 3;
+		for (uint32_t begin = 0; begin < primitives[i].indexCount; begin += kIndexGrainSize) {
+			tasks.push_back({ i, begin, std::min<uint32_t>(begin + kIndexGrainSize, primitives[i].indexCount), true });
+		}
+	}
+
+	mesh.vertices.resize(vertexCount);
+	mesh.indices.resize(indexCount);
+	std::atomic<bool> indexOutOfRange = false;
+	ParallelFor(threadPool, tasks.size(), 1, [&](size_t taskBegin, size_t taskEnd) {
+		for (size_t t = taskBegin; t < taskEnd; ++t) {
+			const ConvertTask& task = tasks[t];
+			const PrimitiveRange& range = primitives[task.primitive];
+			if (!task.indices) {
+				for (uint32_t i = task.begin; i < task.end; ++i) {
+					Vector3 position = { ReadComponent(range.positions, i, 0), ReadComponent(range.positions, i, 1), ReadComponent(range.positions, i, 2) };
+					VertexData& vertex = mesh.vertices[range.vertexBase + i];
+					vertex.position = ToLeftHanded(TransformCoord(position, *range.world));
+					// glTFのUVは左上が原点なのでそのまま使える
+					vertex.texcoord = range.hasTexcoords ? Vector2{ ReadComponent(range.texcoords, i, 0), ReadComponent(range.texcoords, i, 1) } : Vector2{ 0.0f, 0.0f };
+				}
+				continue;
+			}
+			for (uint32_t i = task.begin; i < task.end; i += 3) {
+				uint32_t corners[3];
+				for (uint32_t c = 0; c < 3; ++c) {
+					corners[c] = range.hasIndices ? ReadIndex(range.indices, i + c) : i + c;
+					if (corners[c] >= range.positions.count) {
+						indexOutOfRange = true;
+						corners[c] = 0;
+					}
+				}
+				uint32_t* output = &mesh.indices[range.indexBase + i];
+				// 左手系にしたので向きを逆にする。行列が裏返していればそれで元に戻る
+				output[0] = range.vertexBase + corners[0];
+				output[1] = range.vertexBase + corners[range.mirrored ? 1 : 2];
+				output[2] = range.vertexBase + corners[range.mirrored ? 2 : 1];
+			}
+		}
+	});
+	statistics.convertSeconds += GetSecondsSince(convertStart);
+	if (indexOutOfRange) {
+		message = "index out of range";
+		return false;
+	}
+	if (primitives.empty()) {
+		message = "no triangle primitives";
+		return false;
+	}
+	return true;
+}
+
+}
+
+bool LoadObjModel(const std::filesystem::path& path, ThreadPool* threadPool, Mesh& mesh, std::string& message, ModelLoadStatistics* statistics) {
+	ModelLoadStatistics localStatistics;
+	ModelLoadStatistics& stats = statistics ? *statistics : localStatistics;
+	auto parseStart = std::chrono::steady_clock::now();
+	MappedFile file;
+	if (!file.Open(path)) {
+		message = "cannot open " + path.string();
+		return false;
+	}
+	stats.fileBytes += file.GetSize();
+
+	// 行の区切りでチャンクに分け、それぞれを並列に解析する
+	const char* text = reinterpret_cast<const char*>(file.GetData());
+	const char* textEnd = text + file.GetSize();
+	std::vector<ObjChunk> chunks;
+	for (const char* begin = text; begin < textEnd;) {
+		const char* end = begin + std::min<size_t>(kObjChunkSize, size_t(textEnd - begin));
+		if (end < textEnd) {
+			const char* newline = static_cast<const char*>(memchr(end, '\n', size_t(textEnd - end)));
+			end = newline ? newline + 1 : textEnd;
+		}
+		chunks.emplace_back();
+		chunks.back().begin = begin;
+		chunks.back().end = end;
+		begin = end;
+	}
+	ParallelFor(threadPool, chunks.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			ParseObjChunk(chunks[i]);
+		}
+	});
+	for (const ObjChunk& chunk : chunks) {
+		if (chunk.error) {
+			size_t line = 1 + size_t(std::count(text, chunk.errorPosition, '\n'));
+			message = path.filename().string() + "(" + std::to_string(line) + "): " + chunk.error;
+			return false;
+		}
+	}
+	stats.parseSeconds += GetSecondsSince(parseStart);
+
+	// 前のチャンクまでの数を足し込み、頂点の属性を1つの配列に集める
+	auto convertStart = std::chrono::steady_clock::now();
+	uint64_t positionCount = 0;
+	uint64_t texcoordCount = 0;
+	uint64_t triangleCount = 0;
+	for (ObjChunk& chunk : chunks) {
+		chunk.positionBase = uint32_t(positionCount);
+		chunk.texcoordBase = uint32_t(texcoordCount);
+		chunk.triangleBase = uint32_t(triangleCount);
+		positionCount += chunk.positions.size();
+		texcoordCount += chunk.texcoords.size();
+		triangleCount += chunk.triangleCount;
+	}
+	if (triangleCount * 3 > UINT32_MAX || positionCount > INT32_MAX || texcoordCount > INT32_MAX) {
+		message = "model is too large";
+		return false;
+	}
+	std::vector<Vector3> positions(positionCount);
+	std::vector<Vector2> texcoords(texcoordCount);
+	std::vector<VertexData> triangleVertices(size_t(triangleCount) * 3);
+	std::atomic<bool> indexOutOfRange = false;
+	ParallelFor(threadPool, chunks.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			std::copy(chunks[i].positions.begin(), chunks[i].positions.end(), positions.begin() + chunks[i].positionBase);
+			std::copy(chunks[i].texcoords.begin(), chunks[i].texcoords.end(), texcoords.begin() + chunks[i].texcoordBase);
+		}
+	});
+	// 面は後ろのチャンクの頂点を指すこともあるので、全て集め終わってから変換する
+	ParallelFor(threadPool, chunks.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			if (!ConvertObjChunk(chunks[i], positions, texcoords, triangleVertices.data() + size_t(chunks[i].triangleBase) * 3)) {
+				indexOutOfRange = true;
+			}
+		}
+	});
+	if (indexOutOfRange) {
+		message = path.filename().string() + ": face index out of range";
+		return false;
+	}
+	mesh = BuildIndexedMesh(triangleVertices);
+	stats.convertSeconds += GetSecondsSince(convertStart);
+	if (mesh.indices.empty()) {
+		message = path.filename().string() + ": no faces";
+		return false;
+	}
+	return true;
+}
+
+bool LoadGltfModel(const std::filesystem::path& path, ThreadPool* threadPool, Mesh& mesh, std::string& message, ModelLoadStatistics* statistics) {
+	ModelLoadStatistics localStatistics;
+	GltfLoader loader;
+	if (!loader.Load(path, threadPool, mesh, message, statistics ? *statistics : localStatistics)) {
+		message = path.filename().string() + ": " + message;
+		return false;
+	}
+	return true;
+}
+
+bool LoadModel(const std::filesystem::path& path, ThreadPool* threadPool, Mesh& mesh, std::string& message, ModelLoadStatistics* statistics) {
+	std::string extension = GetLowerExtension(path);
+	if (extension == ".obj") {
+		return LoadObjModel(path, threadPool, mesh, message, statistics);
+	}
+	if (extension == ".gltf" || extension == ".glb") {
+		return LoadGltfModel(path, threadPool, mesh, message, statistics);
+	}
+	message = "unsupported model format: " + path.string();
+	return false;
+}
+
+bool GetModelDependencies(const std::filesystem::path& path, std::vector<std::filesystem::path>& dependencies, std::string& message) {
+	dependencies.clear();
+	std::string extension = GetLowerExtension(path);
+	if (extension == ".gltf" || extension == ".glb") {
+		GltfLoader loader;
+		MappedFile file;
+		if (!loader.ParseDocument(path, file, message)) {
+			message = path.filename().string() + ": " + message;
+			return false;
+		}
+		dependencies = loader.GetExternalBufferPaths(path.parent_path());
+	}
+	return true;
+}
+
+bool IsModelFile(const std::filesystem::path& path) {
+	std::string extension = GetLowerExtension(path);
+	return extension == ".obj" || extension == ".gltf" || extension == ".glb";
+}
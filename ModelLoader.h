@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "Mesh.h"
+
+class ThreadPool;
+
+// 読み込みにかかった時間の内訳
+struct ModelLoadStatistics {
+	// 読んだファイルの合計。glTFは外部のバッファも含む
+	uint64_t fileBytes = 0;
+	// テキストを字句解析して数値にするまで
+	double parseSeconds = 0.0;
+	// VertexDataへの変換とインデックスの作成
+	double convertSeconds = 0.0;
+};
+
+// OBJとglTF 2.0(.gltf/.glb)をVertexDataのメッシュとして読み込む。拡張子で形式を選ぶ
+// ファイルはマップして読み、字句解析は文字列を作らずにマップしたバイト列の上で行う
+// 右手系から左手系にするためにXを反転し、三角形の向きを逆にする
+// threadPoolを渡すと解析と変換を並列に行う。nullptrなら呼び出したスレッドだけで行う
+bool LoadModel(const std::filesystem::path& path, ThreadPool* threadPool, Mesh& mesh, std::string& message, ModelLoadStatistics* statistics = nullptr);
+
+// v、vt、fだけを見る。多角形は扇形に三角形に分ける。同じ頂点はまとめる
+bool LoadObjModel(const std::filesystem::path& path, ThreadPool* threadPool, Mesh& mesh, std::string& message, ModelLoadStatistics* statistics = nullptr);
+
+// デフォルトのシーンのノードを辿り、三角形のプリミティブを全て1つのメッシュにまとめる。ノードの変形は頂点に焼き込む
+// POSITIONとTEXCOORD_0だけを使う。バッファは.glbのBINチャンク、外部ファイル、base64のdata URIに対応する
+bool LoadGltfModel(const std::filesystem::path& path, ThreadPool* threadPool, Mesh& mesh, std::string& message, ModelLoadStatistics* statistics = nullptr);
+
+// モデルのファイルのほかに読み込むファイル（glTFの外部バッファ）。OBJはマテリアルを読まないので無い
+// クッカーが変更を調べるのに使う。ファイルを開けないか解析できなければfalse
+bool GetModelDependencies(const std::filesystem::path& path, std::vector<std::filesystem::path>& dependencies, std::string& message);
+
+// モデルとして読み込める拡張子か
+bool IsModelFile(const std::filesystem::path& path);
@@ -0,0 +1,649 @@
+#include "MyMath.h"
+#include <cmath>
+#include <cassert>
+
+#if defined(MYMATH_SSE_INTRINSICS)
+#include <emmintrin.h>
+#endif
+#if defined(MYMATH_AVX_INTRINSICS)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+#if defined(MYMATH_SSE_INTRINSICS)
+
+// _mm_shuffle_ps用のマスク。引数は取り出す要素の番号(x,y,z,w)
+constexpr int MakeShuffleMask(int x, int y, int z, int w) {
+	return x | (y << 2) | (z << 4) | (w << 6);
+}
+
+#define MYMATH_SWIZZLE(v, x, y, z, w) _mm_shuffle_ps((v), (v), MakeShuffleMask(x, y, z, w))
+#define MYMATH_SHUFFLE(v1, v2, x, y, z, w) _mm_shuffle_ps((v1), (v2), MakeShuffleMask(x, y, z, w))
+
+// 2x2行列（x,y,z,w = m00,m01,m10,m11）の積 A*B
+inline __m128 Mat2Mul(__m128 a, __m128 b) {
+	return _mm_add_ps(
+		_mm_mul_ps(a, MYMATH_SWIZZLE(b, 0, 3, 0, 3)),
+		_mm_mul_ps(MYMATH_SWIZZLE(a, 1, 0, 3, 2), MYMATH_SWIZZLE(b, 2, 1, 2, 1)));
+}
+// 余因子行列との積 adj(A)*B
+inline __m128 Mat2AdjMul(__m128 a, __m128 b) {
+	return _mm_sub_ps(
+		_mm_mul_ps(MYMATH_SWIZZLE(a, 3, 3, 0, 0), b),
+		_mm_mul_ps(MYMATH_SWIZZLE(a, 1, 1, 2, 2), MYMATH_SWIZZLE(b, 2, 3, 0, 1)));
+}
+// 余因子行列との積 A*adj(B)
+inline __m128 Mat2MulAdj(__m128 a, __m128 b) {
+	return _mm_sub_ps(
+		_mm_mul_ps(a, MYMATH_SWIZZLE(b, 3, 0, 3, 0)),
+		_mm_mul_ps(MYMATH_SWIZZLE(a, 1, 0, 3, 2), MYMATH_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// 1行分（ベクトル）と行列の積。rowの各要素を各行にブロードキャストして足し合わせる
+inline __m128 MultiplyRow(__m128 row, __m128 r0, __m128 r1, __m128 r2, __m128 r3) {
+	__m128 result = _mm_mul_ps(MYMATH_SWIZZLE(row, 0, 0, 0, 0), r0);
+	result = _mm_add_ps(result, _mm_mul_ps(MYMATH_SWIZZLE(row, 1, 1, 1, 1), r1));
+	result = _mm_add_ps(result, _mm_mul_ps(MYMATH_SWIZZLE(row, 2, 2, 2, 2), r2));
+	result = _mm_add_ps(result, _mm_mul_ps(MYMATH_SWIZZLE(row, 3, 3, 3, 3), r3));
+	return result;
+}
+
+#endif // MYMATH_SSE_INTRINSICS
+
+#if defined(MYMATH_AVX_INTRINSICS)
+
+// 1行分を上下のレーンに複製して読み込む
+inline __m256 BroadcastRow(const float* row) {
+	__m128 v = _mm_loadu_ps(row);
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(v), v, 1);
+}
+
+// 2行分（256bit）と行列の積。m2の各行を上下のレーンに複製しておく
+inline __m256 MultiplyTwoRows(__m256 rows, __m256 r0, __m256 r1, __m256 r2, __m256 r3) {
+#if defined(__FMA__) || defined(__AVX2__)
+	__m256 result = _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0x00), r0);
+	result = _mm256_fmadd_ps(_mm256_shuffle_ps(rows, rows, 0x55), r1, result);
+	result = _mm256_fmadd_ps(_mm256_shuffle_ps(rows, rows, 0xAA), r2, result);
+	result = _mm256_fmadd_ps(_mm256_shuffle_ps(rows, rows, 0xFF), r3, result);
+#else
+	__m256 result = _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0x00), r0);
+	result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0x55), r1));
+	result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0xAA), r2));
+	result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0xFF), r3));
+#endif
+	return result;
+}
+
+#endif // MYMATH_AVX_INTRINSICS
+
+#if defined(MYMATH_SSE_INTRINSICS)
+
+// 4つの角度のsin/cosをまとめて求める（Cephesのsinf/cosfと同じ多項式近似）
+// π/4単位で範囲を縮小してから多項式で近似する。|angle| < 8192程度までは誤差2ulp程度
+inline void SinCosVector(__m128 angle, __m128* sine, __m128* cosine) {
+	const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+	const __m128i one = _mm_set1_epi32(1);
+	const __m128i two = _mm_set1_epi32(2);
+	const __m128i four = _mm_set1_epi32(4);
+
+	// 符号を外して絶対値で計算する
+	__m128 signSin = _mm_and_ps(angle, signMask);
+	__m128 x = _mm_andnot_ps(signMask, angle);
+
+	// どのπ/4区間にいるか（偶数に丸める）
+	__m128i quadrant = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f)));
+	quadrant = _mm_and_si128(_mm_add_epi32(quadrant, one), _mm_set1_epi32(~1));
+	__m128 y = _mm_cvtepi32_ps(quadrant);
+
+	// 区間によってsinとcosの符号と、どちらの多項式を使うかが変わる
+	__m128 swapSignSin = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, four), 29));
+	__m128 signCos = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(quadrant, two), four), 29));
+	__m128 polyMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, two), _mm_setzero_si128()));
+	signSin = _mm_xor_ps(signSin, swapSignSin);
+
+	// x - y*π/4 を3段階に分けて精度を落とさないように計算する
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(0.78515625f)));
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(2.4187564849853515625e-4f)));
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(3.77489497744594108e-8f)));
+	__m128 z = _mm_mul_ps(x, x);
+
+	// cosの多項式
+	__m128 polyCos = _mm_set1_ps(2.443315711809948e-5f);
+	polyCos = _mm_add_ps(_mm_mul_ps(polyCos, z), _mm_set1_ps(-1.388731625493765e-3f));
+	polyCos = _mm_add_ps(_mm_mul_ps(polyCos, z), _mm_set1_ps(4.166664568298827e-2f));
+	polyCos = _mm_mul_ps(_mm_mul_ps(polyCos, z), z);
+	polyCos = _mm_sub_ps(polyCos, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+	polyCos = _mm_add_ps(polyCos, _mm_set1_ps(1.0f));
+	// sinの多項式
+	__m128 polySin = _mm_set1_ps(-1.9515295891e-4f);
+	polySin = _mm_add_ps(_mm_mul_ps(polySin, z), _mm_set1_ps(8.3321608736e-3f));
+	polySin = _mm_add_ps(_mm_mul_ps(polySin, z), _mm_set1_ps(-1.6666654611e-1f));
+	polySin = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(polySin, z), x), x);
+
+	// 区間に応じて多項式を選んで符号を付ける
+	__m128 resultSin = _mm_or_ps(_mm_and_ps(polyMask, polySin), _mm_andnot_ps(polyMask, polyCos));
+	__m128 resultCos = _mm_or_ps(_mm_and_ps(polyMask, polyCos), _mm_andnot_ps(polyMask, polySin));
+	*sine = _mm_xor_ps(resultSin, signSin);
+	*cosine = _mm_xor_ps(resultCos, signCos);
+}
+
+#endif // MYMATH_SSE_INTRINSICS
+
+// RotateX * RotateY * RotateZ の3x3部分を直接求める。sin/cosは各軸1回ずつしか計算しない
+void MakeRotateXYZ(const Vector3& rotate, float rotateXYZ[3][3]) {
+#if defined(MYMATH_SSE_INTRINSICS)
+	alignas(16) float sines[4];
+	alignas(16) float cosines[4];
+	__m128 sineVector, cosineVector;
+	SinCosVector(_mm_setr_ps(rotate.x, rotate.y, rotate.z, 0.0f), &sineVector, &cosineVector);
+	_mm_store_ps(sines, sineVector);
+	_mm_store_ps(cosines, cosineVector);
+	float sx = sines[0], cx = cosines[0];
+	float sy = sines[1], cy = cosines[1];
+	float sz = sines[2], cz = cosines[2];
+#else
+	float sx = std::sin(rotate.x), cx = std::cos(rotate.x);
+	float sy = std::sin(rotate.y), cy = std::cos(rotate.y);
+	float sz = std::sin(rotate.z), cz = std::cos(rotate.z);
+#endif
+	float sxsy = sx * sy;
+	float cxsy = cx * sy;
+	rotateXYZ[0][0] = cy * cz;
+	rotateXYZ[0][1] = cy * sz;
+	rotateXYZ[0][2] = -sy;
+	rotateXYZ[1][0] = sxsy * cz - cx * sz;
+	rotateXYZ[1][1] = sxsy * sz + cx * cz;
+	rotateXYZ[1][2] = sx * cy;
+	rotateXYZ[2][0] = cxsy * cz + sx * sz;
+	rotateXYZ[2][1] = cxsy * sz - sx * cz;
+	rotateXYZ[2][2] = cx * cy;
+}
+
+// 3x3の回転部分・スケール・平行移動からアフィン変換行列を組み立てる
+Matrix4x4 ComposeAffine(const Vector3& scale, const float rotate[3][3], const Vector3& translate) {
+	Matrix4x4 result;
+	result.m[0][0] = scale.x * rotate[0][0];
+	result.m[0][1] = scale.x * rotate[0][1];
+	result.m[0][2] = scale.x * rotate[0][2];
+	result.m[0][3] = 0.0f;
+	result.m[1][0] = scale.y * rotate[1][0];
+	result.m[1][1] = scale.y * rotate[1][1];
+	result.m[1][2] = scale.y * rotate[1][2];
+	result.m[1][3] = 0.0f;
+	result.m[2][0] = scale.z * rotate[2][0];
+	result.m[2][1] = scale.z * rotate[2][1];
+	result.m[2][2] = scale.z * rotate[2][2];
+	result.m[2][3] = 0.0f;
+	result.m[3][0] = translate.x;
+	result.m[3][1] = translate.y;
+	result.m[3][2] = translate.z;
+	result.m[3][3] = 1.0f;
+	return result;
+}
+
+// クォータニオンから3x3の回転部分を求める
+void MakeRotateFromQuaternion(const Quaternion& q, float rotate[3][3]) {
+	float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+	float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+	float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+	rotate[0][0] = 1.0f - 2.0f * (yy + zz);
+	rotate[0][1] = 2.0f * (xy + wz);
+	rotate[0][2] = 2.0f * (xz - wy);
+	rotate[1][0] = 2.0f * (xy - wz);
+	rotate[1][1] = 1.0f - 2.0f * (xx + zz);
+	rotate[1][2] = 2.0f * (yz + wx);
+	rotate[2][0] = 2.0f * (xz + wy);
+	rotate[2][1] = 2.0f * (yz - wx);
+	rotate[2][2] = 1.0f - 2.0f * (xx + yy);
+}
+
+}
+
+// ベクトルの加算
+Vector3 Add(const Vector3& v1, const Vector3& v2) {
+	return { v1.x + v2.x, v1.y + v2.y, v1.z + v2.z };
+}
+// ベクトルの減算
+Vector3 Subtract(const Vector3& v1, const Vector3& v2) {
+	return { v1.x - v2.x, v1.y - v2.y, v1.z - v2.z };
+}
+// 内積
+float Dot(const Vector3& v1, const Vector3& v2) {
+	return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+}
+// クロス積
+Vector3 Cross(const Vector3& v1, const Vector3& v2) {
+	return { v1.y * v2.z - v1.z * v2.y, v1.z * v2.x - v1.x * v2.z, v1.x * v2.y - v1.y * v2.x };
+}
+// 長さ
+float Length(const Vector3& v) {
+	return std::sqrt(Dot(v, v));
+}
+// 正規化
+Vector3 Normalize(const Vector3& v) {
+	float length = Length(v);
+	assert(length != 0.0f);
+	return { v.x / length, v.y / length, v.z / length };
+}
+
+// 単位行列の作成
+Matrix4x4 MakeIdentity4x4() {
+	Matrix4x4 result = {};
+	result.m[0][0] = 1.0f;
+	result.m[1][1] = 1.0f;
+	result.m[2][2] = 1.0f;
+	result.m[3][3] = 1.0f;
+	return result;
+}
+
+// 4x4行列の積
+Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2) {
+	Matrix4x4 result;
+#if defined(MYMATH_AVX_INTRINSICS)
+	// m2の各行を上下両方のレーンに置き、m1は2行ずつ処理する
+	__m256 r0 = BroadcastRow(m2.m[0]);
+	__m256 r1 = BroadcastRow(m2.m[1]);
+	__m256 r2 = BroadcastRow(m2.m[2]);
+	__m256 r3 = BroadcastRow(m2.m[3]);
+	_mm256_storeu_ps(result.m[0], MultiplyTwoRows(_mm256_loadu_ps(m1.m[0]), r0, r1, r2, r3));
+	_mm256_storeu_ps(result.m[2], MultiplyTwoRows(_mm256_loadu_ps(m1.m[2]), r0, r1, r2, r3));
+#elif defined(MYMATH_SSE_INTRINSICS)
+	__m128 r0 = _mm_loadu_ps(m2.m[0]);
+	__m128 r1 = _mm_loadu_ps(m2.m[1]);
+	__m128 r2 = _mm_loadu_ps(m2.m[2]);
+	__m128 r3 = _mm_loadu_ps(m2.m[3]);
+	_mm_storeu_ps(result.m[0], MultiplyRow(_mm_loadu_ps(m1.m[0]), r0, r1, r2, r3));
+	_mm_storeu_ps(result.m[1], MultiplyRow(_mm_loadu_ps(m1.m[1]), r0, r1, r2, r3));
+	_mm_storeu_ps(result.m[2], MultiplyRow(_mm_loadu_ps(m1.m[2]), r0, r1, r2, r3));
+	_mm_storeu_ps(result.m[3], MultiplyRow(_mm_loadu_ps(m1.m[3]), r0, r1, r2, r3));
+#else
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) {
+			result.m[i][j] =
+				m1.m[i][0] * m2.m[0][j] + m1.m[i][1] * m2.m[1][j] +
+				m1.m[i][2] * m2.m[2][j] + m1.m[i][3] * m2.m[3][j];
+		}
+	}
+#endif
+	return result;
+}
+
+// 転置行列
+Matrix4x4 Transpose(const Matrix4x4& m) {
+	Matrix4x4 result;
+#if defined(MYMATH_SSE_INTRINSICS)
+	__m128 r0 = _mm_loadu_ps(m.m[0]);
+	__m128 r1 = _mm_loadu_ps(m.m[1]);
+	__m128 r2 = _mm_loadu_ps(m.m[2]);
+	__m128 r3 = _mm_loadu_ps(m.m[3]);
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	_mm_storeu_ps(result.m[0], r0);
+	_mm_storeu_ps(result.m[1], r1);
+	_mm_storeu_ps(result.m[2], r2);
+	_mm_storeu_ps(result.m[3], r3);
+#else
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) {
+			result.m[i][j] = m.m[j][i];
+		}
+	}
+#endif
+	return result;
+}
+
+// X軸回転行列
+Matrix4x4 MakeRotateXMatrix(float angle) {
+	float s = std::sin(angle);
+	float c = std::cos(angle);
+	Matrix4x4 result = {};
+	result.m[0][0] = 1.0f;
+	result.m[3][3] = 1.0f;
+	result.m[1][1] = c;
+	result.m[1][2] = s;
+	result.m[2][1] = -s;
+	result.m[2][2] = c;
+	return result;
+}
+// Y軸回転行列
+Matrix4x4 MakeRotateYMatrix(float angle) {
+	float s = std::sin(angle);
+	float c = std::cos(angle);
+	Matrix4x4 result = {};
+	result.m[1][1] = 1.0f;
+	result.m[3][3] = 1.0f;
+	result.m[0][0] = c;
+	result.m[0][2] = -s;
+	result.m[2][0] = s;
+	result.m[2][2] = c;
+	return result;
+}
+// Z軸回転行列
+Matrix4x4 MakeRotateZMatrix(float angle) {
+	float s = std::sin(angle);
+	float c = std::cos(angle);
+	Matrix4x4 result = {};
+	result.m[2][2] = 1.0f;
+	result.m[3][3] = 1.0f;
+	result.m[0][0] = c;
+	result.m[0][1] = s;
+	result.m[1][0] = -s;
+	result.m[1][1] = c;
+	return result;
+}
+
+// 3次元アフィン変換行列
+// 回転行列を3つ作って掛け合わせる代わりに、展開済みの式で直接書き込む
+Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Vector3& rotate, const Vector3& translate) {
+	float rotateXYZ[3][3];
+	MakeRotateXYZ(rotate, rotateXYZ);
+	return ComposeAffine(scale, rotateXYZ, translate);
+}
+
+// クォータニオンで回転を指定する3次元アフィン変換行列
+Matrix4x4 MakeAffineMatrixFromQuaternion(const Vector3& scale, const Quaternion& rotate, const Vector3& translate) {
+	float rotateMatrix[3][3];
+	MakeRotateFromQuaternion(rotate, rotateMatrix);
+	return ComposeAffine(scale, rotateMatrix, translate);
+}
+
+// クォータニオンから回転行列を作る
+Matrix4x4 MakeRotateMatrix(const Quaternion& rotate) {
+	float rotateMatrix[3][3];
+	MakeRotateFromQuaternion(rotate, rotateMatrix);
+	return ComposeAffine({ 1.0f, 1.0f, 1.0f }, rotateMatrix, { 0.0f, 0.0f, 0.0f });
+}
+
+// 任意軸回転を表すクォータニオン
+Quaternion MakeRotateAxisAngleQuaternion(const Vector3& axis, float angle) {
+	Vector3 n = Normalize(axis);
+	float s = std::sin(angle * 0.5f);
+	return { n.x * s, n.y * s, n.z * s, std::cos(angle * 0.5f) };
+}
+
+// オイラー角（X→Y→Zの順に回す。MakeAffineMatrixと同じ）からクォータニオンを作る
+Quaternion MakeRotateQuaternion(const Vector3& rotate) {
+	float sx = std::sin(rotate.x * 0.5f), cx = std::cos(rotate.x * 0.5f);
+	float sy = std::sin(rotate.y * 0.5f), cy = std::cos(rotate.y * 0.5f);
+	float sz = std::sin(rotate.z * 0.5f), cz = std::cos(rotate.z * 0.5f);
+	// Multiply(qx, Multiply(qy, qz))を展開したもの
+	return {
+		sx * cy * cz - cx * sy * sz,
+		cx * sy * cz + sx * cy * sz,
+		cx * cy * sz - sx * sy * cz,
+		cx * cy * cz + sx * sy * sz,
+	};
+}
+
+// クォータニオンの積。行列のMultiplyと同じく、q1の回転をしてからq2の回転をする
+Quaternion Multiply(const Quaternion& q1, const Quaternion& q2) {
+	return {
+		q2.w * q1.x + q2.x * q1.w + q2.y * q1.z - q2.z * q1.y,
+		q2.w * q1.y - q2.x * q1.z + q2.y * q1.w + q2.z * q1.x,
+		q2.w * q1.z + q2.x * q1.y - q2.y * q1.x + q2.z * q1.w,
+		q2.w * q1.w - q2.x * q1.x - q2.y * q1.y - q2.z * q1.z,
+	};
+}
+
+// クォータニオンの正規化
+Quaternion Normalize(const Quaternion& q) {
+	float length = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+	assert(length != 0.0f);
+	return { q.x / length, q.y / length, q.z / length, q.w / length };
+}
+
+// sin/cosをまとめて求める
+void SinCos(const float* angles, float* sines, float* cosines, size_t count) {
+	size_t i = 0;
+#if defined(MYMATH_SSE_INTRINSICS)
+	for (; i + 4 <= count; i += 4) {
+		__m128 sineVector, cosineVector;
+		SinCosVector(_mm_loadu_ps(angles + i), &sineVector, &cosineVector);
+		_mm_storeu_ps(sines + i, sineVector);
+		_mm_storeu_ps(cosines + i, cosineVector);
+	}
+#endif
+	for (; i < count; ++i) {
+		sines[i] = std::sin(angles[i]);
+		cosines[i] = std::cos(angles[i]);
+	}
+}
+
+// 透視投影行列
+Matrix4x4 MakePerspectiveFovMatrix(float fovY, float aspectRatio, float nearClip, float farClip) {
+	float cot = 1.0f / std::tan(fovY / 2.0f);
+	Matrix4x4 result = {};
+	result.m[0][0] = cot / aspectRatio;
+	result.m[1][1] = cot;
+	result.m[2][2] = farClip / (farClip - nearClip);
+	result.m[2][3] = 1.0f;
+	result.m[3][2] = -(farClip * nearClip) / (farClip - nearClip);
+	return result;
+}
+
+// 逆行列
+// 2x2の小行列に分けて計算することで、同じ積を何度も計算しないようにしている
+Matrix4x4 Inverse(const Matrix4x4& m) {
+	Matrix4x4 result;
+#if defined(MYMATH_SSE_INTRINSICS)
+	__m128 r0 = _mm_loadu_ps(m.m[0]);
+	__m128 r1 = _mm_loadu_ps(m.m[1]);
+	__m128 r2 = _mm_loadu_ps(m.m[2]);
+	__m128 r3 = _mm_loadu_ps(m.m[3]);
+
+	// | A B |
+	// | C D | に分割する
+	__m128 a = _mm_movelh_ps(r0, r1);
+	__m128 b = _mm_movehl_ps(r1, r0);
+	__m128 c = _mm_movelh_ps(r2, r3);
+	__m128 d = _mm_movehl_ps(r3, r2);
+
+	// 各小行列の行列式 (|A|, |B|, |C|, |D|)
+	__m128 detSub = _mm_sub_ps(
+		_mm_mul_ps(MYMATH_SHUFFLE(r0, r2, 0, 2, 0, 2), MYMATH_SHUFFLE(r1, r3, 1, 3, 1, 3)),
+		_mm_mul_ps(MYMATH_SHUFFLE(r0, r2, 1, 3, 1, 3), MYMATH_SHUFFLE(r1, r3, 0, 2, 0, 2)));
+	__m128 detA = MYMATH_SWIZZLE(detSub, 0, 0, 0, 0);
+	__m128 detB = MYMATH_SWIZZLE(detSub, 1, 1, 1, 1);
+	__m128 detC = MYMATH_SWIZZLE(detSub, 2, 2, 2, 2);
+	__m128 detD = MYMATH_SWIZZLE(detSub, 3, 3, 3, 3);
+
+	__m128 dc = Mat2AdjMul(d, c);
+	__m128 ab = Mat2AdjMul(a, b);
+	// 逆行列の各ブロック（の余因子行列）
+	__m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), Mat2Mul(b, dc));
+	__m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), Mat2Mul(c, ab));
+	__m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), Mat2MulAdj(d, ab));
+	__m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), Mat2MulAdj(a, dc));
+
+	// |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+	__m128 detM = _mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC));
+	__m128 tr = _mm_mul_ps(ab, MYMATH_SWIZZLE(dc, 0, 2, 1, 3));
+	tr = _mm_add_ps(tr, MYMATH_SWIZZLE(tr, 2, 3, 0, 1));
+	tr = _mm_add_ps(tr, MYMATH_SWIZZLE(tr, 1, 0, 3, 2));
+	detM = _mm_sub_ps(detM, tr);
+	assert(_mm_cvtss_f32(detM) != 0.0f);
+
+	__m128 rDetM = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+	x = _mm_mul_ps(x, rDetM);
+	y = _mm_mul_ps(y, rDetM);
+	z = _mm_mul_ps(z, rDetM);
+	w = _mm_mul_ps(w, rDetM);
+
+	// 余因子行列の並び替えと格納をまとめて行う
+	_mm_storeu_ps(result.m[0], MYMATH_SHUFFLE(x, y, 3, 1, 3, 1));
+	_mm_storeu_ps(result.m[1], MYMATH_SHUFFLE(x, y, 2, 0, 2, 0));
+	_mm_storeu_ps(result.m[2], MYMATH_SHUFFLE(z, w, 3, 1, 3, 1));
+	_mm_storeu_ps(result.m[3], MYMATH_SHUFFLE(z, w, 2, 0, 2, 0));
+#else
+	// 上2行と下2行から作った2x2の小行列式を使い回す
+	float s0 = m.m[0][0] * m.m[1][1] - m.m[1][0] * m.m[0][1];
+	float s1 = m.m[0][0] * m.m[1][2] - m.m[1][0] * m.m[0][2];
+	float s2 = m.m[0][0] * m.m[1][3] - m.m[1][0] * m.m[0][3];
+	float s3 = m.m[0][1] * m.m[1][2] - m.m[1][1] * m.m[0][2];
+	float s4 = m.m[0][1] * m.m[1][3] - m.m[1][1] * m.m[0][3];
+	float s5 = m.m[0][2] * m.m[1][3] - m.m[1][2] * m.m[0][3];
+
+	float c5 = m.m[2][2] * m.m[3][3] - m.m[3][2] * m.m[2][3];
+	float c4 = m.m[2][1] * m.m[3][3] - m.m[3][1] * m.m[2][3];
+	float c3 = m.m[2][1] * m.m[3][2] - m.m[3][1] * m.m[2][2];
+	float c2 = m.m[2][0] * m.m[3][3] - m.m[3][0] * m.m[2][3];
+	float c1 = m.m[2][0] * m.m[3][2] - m.m[3][0] * m.m[2][2];
+	float c0 = m.m[2][0] * m.m[3][1] - m.m[3][0] * m.m[2][1];
+
+	// 行列式を計算
+	float determinant = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+	assert(determinant != 0.0f);
+	float invDet = 1.0f / determinant;
+
+	result.m[0][0] = (m.m[1][1] * c5 - m.m[1][2] * c4 + m.m[1][3] * c3) * invDet;
+	result.m[0][1] = (-m.m[0][1] * c5 + m.m[0][2] * c4 - m.m[0][3] * c3) * invDet;
+	result.m[0][2] = (m.m[3][1] * s5 - m.m[3][2] * s4 + m.m[3][3] * s3) * invDet;
+	result.m[0][3] = (-m.m[2][1] * s5 + m.m[2][2] * s4 - m.m[2][3] * s3) * invDet;
+
+	result.m[1][0] = (-m.m[1][0] * c5 + m.m[1][2] * c2 - m.m[1][3] * c1) * invDet;
+	result.m[1][1] = (m.m[0][0] * c5 - m.m[0][2] * c2 + m.m[0][3] * c1) * invDet;
+	result.m[1][2] = (-m.m[3][0] * s5 + m.m[3][2] * s2 - m.m[3][3] * s1) * invDet;
+	result.m[1][3] = (m.m[2][0] * s5 - m.m[2][2] * s2 + m.m[2][3] * s1) * invDet;
+
+	result.m[2][0] = (m.m[1][0] * c4 - m.m[1][1] * c2 + m.m[1][3] * c0) * invDet;
+	result.m[2][1] = (-m.m[0][0] * c4 + m.m[0][1] * c2 - m.m[0][3] * c0) * invDet;
+	result.m[2][2] = (m.m[3][0] * s4 - m.m[3][1] * s2 + m.m[3][3] * s0) * invDet;
+	result.m[2][3] = (-m.m[2][0] * s4 + m.m[2][1] * s2 - m.m[2][3] * s0) * invDet;
+
+	result.m[3][0] = (-m.m[1][0] * c3 + m.m[1][1] * c1 - m.m[1][2] * c0) * invDet;
+	result.m[3][1] = (m.m[0][0] * c3 - m.m[0][1] * c1 + m.m[0][2] * c0) * invDet;
+	result.m[3][2] = (-m.m[3][0] * s3 + m.m[3][1] * s1 - m.m[3][2] * s0) * invDet;
+	result.m[3][3] = (m.m[2][0] * s3 - m.m[2][1] * s1 + m.m[2][2] * s0) * invDet;
+#endif
+	return result;
+}
+
+// アフィン変換行列の逆行列
+// | A 0 |        | A^-1      0 |
+// | t 1 | の逆は | -t*A^-1   1 | なので、3x3の逆行列だけ求めればよい
+Matrix4x4 InverseAffine(const Matrix4x4& m) {
+	assert(m.m[0][3] == 0.0f && m.m[1][3] == 0.0f && m.m[2][3] == 0.0f && m.m[3][3] == 1.0f);
+	Vector3 r0 = { m.m[0][0], m.m[0][1], m.m[0][2] };
+	Vector3 r1 = { m.m[1][0], m.m[1][1], m.m[1][2] };
+	Vector3 r2 = { m.m[2][0], m.m[2][1], m.m[2][2] };
+	// 3x3の逆行列の各列は、行同士のクロス積を行列式で割ったもの
+	Vector3 c0 = Cross(r1, r2);
+	Vector3 c1 = Cross(r2, r0);
+	Vector3 c2 = Cross(r0, r1);
+	float determinant = Dot(r0, c0);
+	assert(determinant != 0.0f);
+	float invDet = 1.0f / determinant;
+
+	Matrix4x4 result;
+	result.m[0][0] = c0.x * invDet;
+	result.m[0][1] = c1.x * invDet;
+	result.m[0][2] = c2.x * invDet;
+	result.m[0][3] = 0.0f;
+	result.m[1][0] = c0.y * invDet;
+	result.m[1][1] = c1.y * invDet;
+	result.m[1][2] = c2.y * invDet;
+	result.m[1][3] = 0.0f;
+	result.m[2][0] = c0.z * invDet;
+	result.m[2][1] = c1.z * invDet;
+	result.m[2][2] = c2.z * invDet;
+	result.m[2][3] = 0.0f;
+	// 平行移動は -t * A^-1
+	Vector3 t = { m.m[3][0], m.m[3][1], m.m[3][2] };
+	result.m[3][0] = -(t.x * result.m[0][0] + t.y * result.m[1][0] + t.z * result.m[2][0]);
+	result.m[3][1] = -(t.x * result.m[0][1] + t.y * result.m[1][1] + t.z * result.m[2][1]);
+	result.m[3][2] = -(t.x * result.m[0][2] + t.y * result.m[1][2] + t.z * result.m[2][2]);
+	result.m[3][3] = 1.0f;
+	return result;
+}
+
+// 回転と平行移動だけの行列の逆行列。回転行列の逆行列は転置行列
+Matrix4x4 InverseOrthonormal(const Matrix4x4& m) {
+	assert(m.m[0][3] == 0.0f && m.m[1][3] == 0.0f && m.m[2][3] == 0.0f && m.m[3][3] == 1.0f);
+	Matrix4x4 result;
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			result.m[i][j] = m.m[j][i];
+		}
+		result.m[i][3] = 0.0f;
+	}
+	// 平行移動は -t * R^T。R^Tの列はRの行なので、各行との内積になる
+	for (int j = 0; j < 3; j++) {
+		result.m[3][j] = -(m.m[3][0] * m.m[j][0] + m.m[3][1] * m.m[j][1] + m.m[3][2] * m.m[j][2]);
+	}
+	result.m[3][3] = 1.0f;
+	return result;
+}
+
+// カメラのTransformからビュー行列を作る
+// (S*R*T)^-1 = T^-1 * R^T * S^-1 なので、逆行列を計算せずに直接組み立てる
+Matrix4x4 MakeViewMatrix(const Transform& camera) {
+	assert(camera.scale.x != 0.0f && camera.scale.y != 0.0f && camera.scale.z != 0.0f);
+	float rotateXYZ[3][3];
+	MakeRotateXYZ(camera.rotate, rotateXYZ);
+	float invScale[3] = { 1.0f / camera.scale.x, 1.0f / camera.scale.y, 1.0f / camera.scale.z };
+	const Vector3& t = camera.translate;
+
+	Matrix4x4 result;
+	for (int j = 0; j < 3; j++) {
+		for (int i = 0; i < 3; i++) {
+			result.m[i][j] = rotateXYZ[j][i] * invScale[j];
+		}
+		result.m[3][j] = -(t.x * rotateXYZ[j][0] + t.y * rotateXYZ[j][1] + t.z * rotateXYZ[j][2]) * invScale[j];
+	}
+	result.m[0][3] = 0.0f;
+	result.m[1][3] = 0.0f;
+	result.m[2][3] = 0.0f;
+	result.m[3][3] = 1.0f;
+	return result;
+}
+
+// 注視点からビュー行列を作る（左手座標系）
+Matrix4x4 MakeLookAtMatrix(const Vector3& eye, const Vector3& target, const Vector3& up) {
+	// カメラの軸。zが視線方向
+	Vector3 zAxis = Normalize(Subtract(target, eye));
+	Vector3 xAxis = Normalize(Cross(up, zAxis));
+	Vector3 yAxis = Cross(zAxis, xAxis);
+
+	// カメラのワールド行列は各軸を行に並べたものなので、その逆（転置と平行移動の打ち消し）を作る
+	Matrix4x4 result;
+	result.m[0][0] = xAxis.x;
+	result.m[0][1] = yAxis.x;
+	result.m[0][2] = zAxis.x;
+	result.m[0][3] = 0.0f;
+	result.m[1][0] = xAxis.y;
+	result.m[1][1] = yAxis.y;
+	result.m[1][2] = zAxis.y;
+	result.m[1][3] = 0.0f;
+	result.m[2][0] = xAxis.z;
+	result.m[2][1] = yAxis.z;
+	result.m[2][2] = zAxis.z;
+	result.m[2][3] = 0.0f;
+	result.m[3][0] = -Dot(xAxis, eye);
+	result.m[3][1] = -Dot(yAxis, eye);
+	result.m[3][2] = -Dot(zAxis, eye);
+	result.m[3][3] = 1.0f;
+	return result;
+}
+
+// 座標変換（w除算あり）
+Vector3 TransformCoord(const Vector3& vector, const Matrix4x4& matrix) {
+	Vector4 result = Multiply(Vector4{ vector.x, vector.y, vector.z, 1.0f }, matrix);
+	assert(result.w != 0.0f);
+	return { result.x / result.w, result.y / result.w, result.z / result.w };
+}
+
+// 4次元ベクトルと行列の積（行ベクトル）
+Vector4 Multiply(const Vector4& vector, const Matrix4x4& matrix) {
+	Vector4 result;
+#if defined(MYMATH_SSE_INTRINSICS)
+	__m128 row = _mm_loadu_ps(&vector.x);
+	_mm_storeu_ps(&result.x, MultiplyRow(row,
+		_mm_loadu_ps(matrix.m[0]), _mm_loadu_ps(matrix.m[1]), _mm_loadu_ps(matrix.m[2]), _mm_loadu_ps(matrix.m[3])));
+#else
+	result.x = vector.x * matrix.m[0][0] + vector.y * matrix.m[1][0] + vector.z * matrix.m[2][0] + vector.w * matrix.m[3][0];
+	result.y = vector.x * matrix.m[0][1] + vector.y * matrix.m[1][1] + vector.z * matrix.m[2][1] + vector.w * matrix.m[3][1];
+	result.z = vector.x * matrix.m[0][2] + vector.y * matrix.m[1][2] + vector.z * matrix.m[2][2] + vector.w * matrix.m[3][2];
+	result.w = vector.x * matrix.m[0][3] + vector.y * matrix.m[1][3] + vector.z * matrix.m[2][3] + vector.w * matrix.m[3][3];
+#endif
+	return result;
+}
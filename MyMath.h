@@ -0,0 +1,122 @@
+#pragma once
+#include <cstddef>
+
+// 使用するSIMD命令セットの選択（DirectXMathの_XM_*_INTRINSICS_と同じ考え方）
+// MYMATH_NO_INTRINSICSを定義するとスカラー実装のみを使う
+#if !defined(MYMATH_NO_INTRINSICS)
+#if defined(__AVX__)
+#define MYMATH_AVX_INTRINSICS
+#endif
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define MYMATH_SSE_INTRINSICS
+#endif
+#endif
+
+#if !defined(MYMATH_SSE_INTRINSICS) && !defined(MYMATH_NO_INTRINSICS)
+#define MYMATH_NO_INTRINSICS
+#endif
+
+struct Vector2 {
+	float x;
+	float y;
+};
+
+struct Vector3 {
+	float x;
+	float y;
+	float z;
+};
+
+struct Vector4 {
+	float x;
+	float y;
+	float z;
+	float w;
+};
+
+// 回転を表すクォータニオン
+struct Quaternion {
+	float x;
+	float y;
+	float z;
+	float w;
+};
+
+// 行優先（row-major）。HLSL側は-Zprでコンパイルしているのでそのまま転送できる
+struct Matrix4x4 {
+	float m[4][4];
+};
+
+struct Transform {
+	Vector3 scale;
+	Vector3 rotate;
+	Vector3 translate;
+};
+
+// ベクトルの加算・減算
+Vector3 Add(const Vector3& v1, const Vector3& v2);
+Vector3 Subtract(const Vector3& v1, const Vector3& v2);
+// 内積・クロス積
+float Dot(const Vector3& v1, const Vector3& v2);
+Vector3 Cross(const Vector3& v1, const Vector3& v2);
+// 長さ・正規化
+float Length(const Vector3& v);
+Vector3 Normalize(const Vector3& v);
+
+// 単位行列の作成
+Matrix4x4 MakeIdentity4x4();
+
+// 4x4行列の積
+Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2);
+
+// 転置行列
+Matrix4x4 Transpose(const Matrix4x4& m);
+
+// X軸回転行列
+Matrix4x4 MakeRotateXMatrix(float angle);
+// Y軸回転行列
+Matrix4x4 MakeRotateYMatrix(float angle);
+// Z軸回転行列
+Matrix4x4 MakeRotateZMatrix(float angle);
+
+// 3次元アフィン変換行列
+Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Vector3& rotate, const Vector3& translate);
+
+// クォータニオンで回転を指定する3次元アフィン変換行列
+Matrix4x4 MakeAffineMatrixFromQuaternion(const Vector3& scale, const Quaternion& rotate, const Vector3& translate);
+
+// クォータニオンから回転行列を作る
+Matrix4x4 MakeRotateMatrix(const Quaternion& rotate);
+// 任意軸回転を表すクォータニオン
+Quaternion MakeRotateAxisAngleQuaternion(const Vector3& axis, float angle);
+// オイラー角（MakeAffineMatrixと同じ回転順）からクォータニオンを作る
+Quaternion MakeRotateQuaternion(const Vector3& rotate);
+// クォータニオンの積（q1の回転の後にq2の回転）
+Quaternion Multiply(const Quaternion& q1, const Quaternion& q2);
+// クォータニオンの正規化
+Quaternion Normalize(const Quaternion& q);
+
+// sin/cosをまとめて求める。SIMDが使えるときは4つずつ計算する
+void SinCos(const float* angles, float* sines, float* cosines, size_t count);
+
+// 透視投影行列
+Matrix4x4 MakePerspectiveFovMatrix(float fovY, float aspectRatio, float nearClip, float farClip);
+
+// 逆行列
+Matrix4x4 Inverse(const Matrix4x4& m);
+
+// アフィン変換行列（4列目が(0,0,0,1)）専用の逆行列。左上3x3の逆行列と平行移動から求める
+Matrix4x4 InverseAffine(const Matrix4x4& m);
+// 回転と平行移動だけの行列（スケールなし）専用の逆行列。回転部分の転置で済ませる
+Matrix4x4 InverseOrthonormal(const Matrix4x4& m);
+
+// カメラのTransformからビュー行列を作る。Inverse(MakeAffineMatrix(...))と同じ結果になる
+Matrix4x4 MakeViewMatrix(const Transform& camera);
+// 注視点からビュー行列を作る（左手座標系）
+Matrix4x4 MakeLookAtMatrix(const Vector3& eye, const Vector3& target, const Vector3& up);
+
+// 座標変換（w除算あり）
+Vector3 TransformCoord(const Vector3& vector, const Matrix4x4& matrix);
+
+// 4次元ベクトルと行列の積（行ベクトル）
+Vector4 Multiply(const Vector4& vector, const Matrix4x4& matrix);
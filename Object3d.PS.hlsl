@@ -1,10 +1,19 @@
 #include "Object3d.hlsli"
 
+// 機能キーワード。ShaderPermutationSetが全て0か1で定義する。単体でコンパイルしたときはテクスチャありにする
+#ifndef TEXTURED
+#define TEXTURED 1
+#endif
+#ifndef ALPHA_TEST
+#define ALPHA_TEST 0
+#endif
+
 struct Material {
     float4 color : color;
 };
 
-ConstantBuffer<Material> gMaterial : register(b0);
+// 全マテリアルの配列。インスタンスごとの番号で引く
+StructuredBuffer<Material> gMaterials : register(t2);
 
 Texture2D<float4> gTexture : register(t0);
 SamplerState gSampler : register(s0);
@@ -15,9 +24,17 @@ struct PixelShaderOutput {
 
 PixelShaderOutput main(VertexShaderOutput input) {
     PixelShaderOutput output;
-    
+    Material material = gMaterials[input.materialIndex];
+
+#if TEXTURED
     float4 textureColor = gTexture.Sample(gSampler, input.texcoord);
-    
-    output.color = gMaterial.color * textureColor;
+    output.color = material.color * textureColor;
+#else
+    output.color = material.color;
+#endif
+#if ALPHA_TEST
+    // 半分より薄いところは描かない
+    clip(output.color.a - 0.5f);
+#endif
     return output;
 }
\ No newline at end of file
@@ -1,18 +1,33 @@
 #include "Object3d.hlsli"
 
-struct TransformmationMatrix {
+// インスタンスごとの値。C++のInstanceDataと同じ並び
+struct InstanceData {
     float4x4 WVP;
+    uint materialIndex;
+    uint3 padding;
 };
-ConstantBuffer<TransformmationMatrix> gTransformmationMatrix : register(b0);
+// RootSignatureでバッチの先頭のインスタンスを指しているので、SV_InstanceIDをそのまま使える
+StructuredBuffer<InstanceData> gInstances : register(t1);
+
+// 量子化した位置を戻す値。position.xyz * scale + offset
+struct PositionDecode {
+    float4 scale;
+    float4 offset;
+};
+ConstantBuffer<PositionDecode> gPositionDecode : register(b1);
 
 struct VertexShaderInput {
+    // R16G16B16A16_UNORMで、バウンディングボックスの中の0～1の位置が入る
     float4 position : POSITION0;
     float2 texcoord : TEXCOORD0;
 };
 
-VertexShaderOutput main(VertexShaderInput input) {
+VertexShaderOutput main(VertexShaderInput input, uint instanceId : SV_InstanceID) {
     VertexShaderOutput output;
-    output.position = mul(input.position, gTransformmationMatrix.WVP);
+    InstanceData instance = gInstances[instanceId];
+    float4 position = float4(input.position.xyz * gPositionDecode.scale.xyz + gPositionDecode.offset.xyz, 1.0f);
+    output.position = mul(position, instance.WVP);
     output.texcoord = input.texcoord;
+    output.materialIndex = instance.materialIndex;
     return output;
 }
\ No newline at end of file
@@ -2,4 +2,6 @@
 struct VertexShaderOutput {
     float4 position : SV_Position;
     float2 texcoord : TEXCOORD0;
+    // 補間しない。インスタンスごとのマテリアルの番号
+    nointerpolation uint materialIndex : MATERIAL0;
 };
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "PipelineStateKey.h"
+#include <cctype>
+
+namespace {
+
+// FNV-1a 64bit
+class Hasher {
+public:
+	void Add(const void* data, size_t size) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; ++i) {
+			hash_ ^= bytes[i];
+			hash_ *= 0x100000001b3ull;
+		}
+	}
+	// 構造体を丸ごと混ぜるとパディングの中身まで混ざるので、値は1つずつ混ぜる
+	template<class T>
+	void Add(const T& value) {
+		Add(&value, sizeof(value));
+	}
+	void Add(const std::string& string) {
+		Add(uint64_t(string.size()));
+		Add(string.data(), string.size());
+	}
+	uint64_t Get() const { return hash_; }
+
+private:
+	uint64_t hash_ = 0xcbf29ce484222325ull;
+};
+
+uint32_t NormalizeBool(uint32_t value) {
+	return value != 0 ? 1 : 0;
+}
+
+float NormalizeFloat(float value) {
+	// -0.0fと0.0fを同じにする
+	return value == 0.0f ? 0.0f : value;
+}
+
+void AddBlendTarget(Hasher& hasher, const PipelineBlendTargetDesc& blend) {
+	hasher.Add(blend.blendEnable);
+	hasher.Add(blend.logicOpEnable);
+	hasher.Add(blend.srcBlend);
+	hasher.Add(blend.destBlend);
+	hasher.Add(blend.blendOp);
+	hasher.Add(blend.srcBlendAlpha);
+	hasher.Add(blend.destBlendAlpha);
+	hasher.Add(blend.blendOpAlpha);
+	hasher.Add(blend.logicOp);
+	hasher.Add(blend.renderTargetWriteMask);
+}
+
+void AddStencilOp(Hasher& hasher, const PipelineStencilOpDesc& stencilOp) {
+	hasher.Add(stencilOp.failOp);
+	hasher.Add(stencilOp.depthFailOp);
+	hasher.Add(stencilOp.passOp);
+	hasher.Add(stencilOp.func);
+}
+
+}
+
+void NormalizeGraphicsPipelineKeyDesc(GraphicsPipelineKeyDesc& desc) {
+	// BOOLは0以外なら何でも真なので0と1に揃える
+	desc.alphaToCoverageEnable = NormalizeBool(desc.alphaToCoverageEnable);
+	desc.independentBlendEnable = NormalizeBool(desc.independentBlendEnable);
+	desc.frontCounterClockwise = NormalizeBool(desc.frontCounterClockwise);
+	desc.depthClipEnable = NormalizeBool(desc.depthClipEnable);
+	desc.multisampleEnable = NormalizeBool(desc.multisampleEnable);
+	desc.antialiasedLineEnable = NormalizeBool(desc.antialiasedLineEnable);
+	desc.depthEnable = NormalizeBool(desc.depthEnable);
+	desc.stencilEnable = NormalizeBool(desc.stencilEnable);
+	desc.depthBiasClamp = NormalizeFloat(desc.depthBiasClamp);
+	desc.slopeScaledDepthBias = NormalizeFloat(desc.slopeScaledDepthBias);
+
+	for (uint32_t i = 0; i < GraphicsPipelineKeyDesc::kRenderTargetCount; ++i) {
+		PipelineBlendTargetDesc& blend = desc.renderTargetBlends[i];
+		// 使わないRenderTargetと、IndependentBlendEnableが無いときの2枚目以降は見られない
+		if (i >= desc.numRenderTargets || (i != 0 && !desc.independentBlendEnable)) {
+			blend = {};
+		}
+		if (i >= desc.numRenderTargets) {
+			desc.rtvFormats[i] = 0;
+		}
+		blend.blendEnable = NormalizeBool(blend.blendEnable);
+		blend.logicOpEnable = NormalizeBool(blend.logicOpEnable);
+		if (!blend.blendEnable) {
+			blend.srcBlend = 0;
+			blend.destBlend = 0;
+			blend.blendOp = 0;
+			blend.srcBlendAlpha = 0;
+			blend.destBlendAlpha = 0;
+			blend.blendOpAlpha = 0;
+		}
+		if (!blend.logicOpEnable) {
+			blend.logicOp = 0;
+		}
+	}
+
+	// サンプル数より上のビットは使われない
+	if (desc.sampleCount < 32) {
+		desc.sampleMask &= (1u << desc.sampleCount) - 1;
+	}
+
+	if (!desc.depthEnable) {
+		desc.depthWriteMask = 0;
+		desc.depthFunc = 0;
+	}
+	if (!desc.stencilEnable) {
+		desc.stencilReadMask = 0;
+		desc.stencilWriteMask = 0;
+		desc.frontFace = {};
+		desc.backFace = {};
+	}
+
+	// セマンティクス名は大文字小文字を区別しない
+	for (PipelineInputElementDesc& element : desc.inputLayout) {
+		for (char& c : element.semanticName) {
+			c = char(toupper(static_cast<unsigned char>(c)));
+		}
+	}
+}
+
+uint64_t HashGraphicsPipelineKeyDesc(const GraphicsPipelineKeyDesc& source) {
+	GraphicsPipelineKeyDesc desc = source;
+	NormalizeGraphicsPipelineKeyDesc(desc);
+
+	Hasher hasher;
+	hasher.Add(desc.rootSignatureHash);
+	hasher.Add(desc.vertexShaderHash);
+	hasher.Add(desc.pixelShaderHash);
+	hasher.Add(desc.domainShaderHash);
+	hasher.Add(desc.hullShaderHash);
+	hasher.Add(desc.geometryShaderHash);
+
+	hasher.Add(desc.alphaToCoverageEnable);
+	hasher.Add(desc.independentBlendEnable);
+	for (const PipelineBlendTargetDesc& blend : desc.renderTargetBlends) {
+		AddBlendTarget(hasher, blend);
+	}
+	hasher.Add(desc.sampleMask);
+
+	hasher.Add(desc.fillMode);
+	hasher.Add(desc.cullMode);
+	hasher.Add(desc.frontCounterClockwise);
+	hasher.Add(desc.depthBias);
+	hasher.Add(desc.depthBiasClamp);
+	hasher.Add(desc.slopeScaledDepthBias);
+	hasher.Add(desc.depthClipEnable);
+	hasher.Add(desc.multisampleEnable);
+	hasher.Add(desc.antialiasedLineEnable);
+	hasher.Add(desc.forcedSampleCount);
+	hasher.Add(desc.conservativeRaster);
+
+	hasher.Add(desc.depthEnable);
+	hasher.Add(desc.depthWriteMask);
+	hasher.Add(desc.depthFunc);
+	hasher.Add(desc.stencilEnable);
+	hasher.Add(desc.stencilReadMask);
+	hasher.Add(desc.stencilWriteMask);
+	AddStencilOp(hasher, desc.frontFace);
+	AddStencilOp(hasher, desc.backFace);
+
+	hasher.Add(uint64_t(desc.inputLayout.size()));
+	for (const PipelineInputElementDesc& element : desc.inputLayout) {
+		hasher.Add(element.semanticName);
+		hasher.Add(element.semanticIndex);
+		hasher.Add(element.format);
+		hasher.Add(element.inputSlot);
+		hasher.Add(element.alignedByteOffset);
+		hasher.Add(element.inputSlotClass);
+		hasher.Add(element.instanceDataStepRate);
+	}
+	hasher.Add(desc.indexBufferStripCutValue);
+	hasher.Add(desc.primitiveTopologyType);
+	hasher.Add(desc.numRenderTargets);
+	for (uint32_t format : desc.rtvFormats) {
+		hasher.Add(format);
+	}
+	hasher.Add(desc.dsvFormat);
+	hasher.Add(desc.sampleCount);
+	hasher.Add(desc.sampleQuality);
+	hasher.Add(desc.flags);
+	return hasher.Get();
+}
+
+uint64_t HashPipelineBytecode(const void* data, size_t size) {
+	if (data == nullptr || size == 0) {
+		return 0;
+	}
+	Hasher hasher;
+	hasher.Add(data, size);
+	return hasher.Get();
+}
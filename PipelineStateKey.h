@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// GraphicsPipelineStateの中身を、ポインタを含まない値だけで表したもの
+// D3D12_GRAPHICS_PIPELINE_STATE_DESCの列挙値はそのままuint32_tで持つ。D3D12に依存しないのでどの環境でも計算できる
+// シェーダーとRootSignatureはポインタではなく中身のハッシュで持つ
+
+struct PipelineBlendTargetDesc {
+	uint32_t blendEnable = 0;
+	uint32_t logicOpEnable = 0;
+	uint32_t srcBlend = 0;
+	uint32_t destBlend = 0;
+	uint32_t blendOp = 0;
+	uint32_t srcBlendAlpha = 0;
+	uint32_t destBlendAlpha = 0;
+	uint32_t blendOpAlpha = 0;
+	uint32_t logicOp = 0;
+	uint32_t renderTargetWriteMask = 0;
+};
+
+struct PipelineStencilOpDesc {
+	uint32_t failOp = 0;
+	uint32_t depthFailOp = 0;
+	uint32_t passOp = 0;
+	uint32_t func = 0;
+};
+
+struct PipelineInputElementDesc {
+	std::string semanticName;
+	uint32_t semanticIndex = 0;
+	uint32_t format = 0;
+	uint32_t inputSlot = 0;
+	uint32_t alignedByteOffset = 0;
+	uint32_t inputSlotClass = 0;
+	uint32_t instanceDataStepRate = 0;
+};
+
+struct GraphicsPipelineKeyDesc {
+	static constexpr uint32_t kRenderTargetCount = 8;
+
+	uint64_t rootSignatureHash = 0;
+	// 使わないステージは0
+	uint64_t vertexShaderHash = 0;
+	uint64_t pixelShaderHash = 0;
+	uint64_t domainShaderHash = 0;
+	uint64_t hullShaderHash = 0;
+	uint64_t geometryShaderHash = 0;
+
+	// BlendState
+	uint32_t alphaToCoverageEnable = 0;
+	uint32_t independentBlendEnable = 0;
+	PipelineBlendTargetDesc renderTargetBlends[kRenderTargetCount];
+	uint32_t sampleMask = 0;
+
+	// RasterizerState
+	uint32_t fillMode = 0;
+	uint32_t cullMode = 0;
+	uint32_t frontCounterClockwise = 0;
+	int32_t depthBias = 0;
+	float depthBiasClamp = 0.0f;
+	float slopeScaledDepthBias = 0.0f;
+	uint32_t depthClipEnable = 0;
+	uint32_t multisampleEnable = 0;
+	uint32_t antialiasedLineEnable = 0;
+	uint32_t forcedSampleCount = 0;
+	uint32_t conservativeRaster = 0;
+
+	// DepthStencilState
+	uint32_t depthEnable = 0;
+	uint32_t depthWriteMask = 0;
+	uint32_t depthFunc = 0;
+	uint32_t stencilEnable = 0;
+	uint32_t stencilReadMask = 0;
+	uint32_t stencilWriteMask = 0;
+	PipelineStencilOpDesc frontFace;
+	PipelineStencilOpDesc backFace;
+
+	std::vector<PipelineInputElementDesc> inputLayout;
+	uint32_t indexBufferStripCutValue = 0;
+	uint32_t primitiveTopologyType = 0;
+	uint32_t numRenderTargets = 0;
+	uint32_t rtvFormats[kRenderTargetCount] = {};
+	uint32_t dsvFormat = 0;
+	uint32_t sampleCount = 0;
+	uint32_t sampleQuality = 0;
+	uint32_t flags = 0;
+};
+
+// 結果が変わらない違いを消す。例えば無効なBlendの係数、無効なDepthの比較関数、使わないRenderTargetのフォーマット、
+// IndependentBlendEnableが無いときの2枚目以降のBlend、セマンティクス名の大文字小文字、-0.0fなど
+void NormalizeGraphicsPipelineKeyDesc(GraphicsPipelineKeyDesc& desc);
+
+// 正規化してからハッシュを取る。同じPSOになる記述は同じキーになる
+uint64_t HashGraphicsPipelineKeyDesc(const GraphicsPipelineKeyDesc& desc);
+
+// シェーダーやRootSignatureのバイナリのハッシュ。空なら0
+uint64_t HashPipelineBytecode(const void* data, size_t size);
@@ -0,0 +1,68 @@
+#include "RenderBatcher.h"
+#include <cassert>
+#include <algorithm>
+#include <cstring>
+
+void RenderBatcher::Clear() {
+	items_.clear();
+	sortKeys_.clear();
+	batches_.clear();
+	instanceObjects_.clear();
+	instanceMaterials_.clear();
+	objectInstances_.clear();
+}
+
+void RenderBatcher::Reserve(size_t capacity) {
+	items_.reserve(capacity);
+	sortKeys_.reserve(capacity);
+	instanceObjects_.reserve(capacity);
+	instanceMaterials_.reserve(capacity);
+}
+
+void RenderBatcher::Add(const RenderItem& item) {
+	items_.push_back(item);
+}
+
+uint64_t RenderBatcher::MakeSortKey(uint32_t pipeline, uint32_t mesh) {
+	assert(pipeline < (1u << kPipelineBits));
+	assert(mesh < (1u << kMeshBits));
+	return (uint64_t(pipeline) << kMeshBits) | mesh;
+}
+
+void RenderBatcher::Build(size_t objectCount, uint32_t maxInstancesPerBatch) {
+	sortKeys_.clear();
+	batches_.clear();
+	instanceObjects_.clear();
+	instanceMaterials_.clear();
+	objectInstances_.assign(objectCount, UINT32_MAX);
+
+	// キーが同じものは追加した順になるよう、番号も比べる
+	for (uint32_t i = 0; i < items_.size(); ++i) {
+		sortKeys_.emplace_back(MakeSortKey(items_[i].pipeline, items_[i].mesh), i);
+	}
+	std::sort(sortKeys_.begin(), sortKeys_.end());
+
+	for (size_t i = 0; i < sortKeys_.size(); ++i) {
+		const RenderItem& item = items_[sortKeys_[i].second];
+		bool sameKey = i != 0 && sortKeys_[i].first == sortKeys_[i - 1].first;
+		if (!sameKey || (maxInstancesPerBatch != 0 && batches_.back().instanceCount == maxInstancesPerBatch)) {
+			batches_.push_back({ item.pipeline, item.mesh, uint32_t(i), 0 });
+		}
+		++batches_.back().instanceCount;
+		// WVPはオブジェクトごとに1つの場所へ書くので、同じオブジェクトを2回は描けない
+		assert(item.object < objectCount);
+		assert(objectInstances_[item.object] == UINT32_MAX);
+		objectInstances_[item.object] = uint32_t(i);
+		instanceObjects_.push_back(item.object);
+		instanceMaterials_.push_back(item.material);
+	}
+}
+
+void RenderBatcher::WriteMaterialIndices(InstanceData* destination) const {
+	for (size_t i = 0; i < instanceMaterials_.size(); ++i) {
+		// 書き込み結合のメモリへは、WVPの後ろの16バイトを1回でまとめて書く
+		const uint32_t values[4] = { instanceMaterials_[i], 0, 0, 0 };
+		static_assert(sizeof(values) == sizeof(InstanceData::materialIndex) + sizeof(InstanceData::padding));
+		std::memcpy(&destination[i].materialIndex, values, sizeof(values));
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "MyMath.h"
+
+// 描画したいオブジェクト1つ。pipeline、mesh、materialは呼び出し側の表の番号
+// materialはインスタンスの値としてシェーダーへ渡すので、違っても同じバッチで描ける
+struct RenderItem {
+	uint32_t pipeline;
+	uint32_t mesh;
+	uint32_t material;
+	// TransformBatchの番号。WVPをここから引く
+	uint32_t object;
+};
+
+// 1回のDrawIndexedInstancedで描く範囲。インスタンスはGetInstanceObjectsの[firstInstance, firstInstance + instanceCount)
+struct RenderBatch {
+	uint32_t pipeline;
+	uint32_t mesh;
+	uint32_t firstInstance;
+	uint32_t instanceCount;
+};
+
+// Object3d.VS.hlslのInstanceDataと同じ並び。StructuredBufferは詰めて並ぶので、16バイト単位に揃えておく
+struct InstanceData {
+	Matrix4x4 wvp;
+	uint32_t materialIndex;
+	uint32_t padding[3];
+};
+
+// オブジェクトをPSO、メッシュの順に並べ替え、同じものが続く範囲を1つのインスタンス描画にまとめる
+// 切り替えの重いPSOほど上位に置くので、PSOとメッシュの切り替えの回数も最小になる
+// 同じ組の中は追加した順に並ぶ。D3D12に依存しないのでGPU無しで動かせる
+class RenderBatcher {
+public:
+	// キーに使うビット数。超える番号はassertで止める
+	static constexpr uint32_t kPipelineBits = 16;
+	static constexpr uint32_t kMeshBits = 24;
+
+	void Clear();
+	void Reserve(size_t capacity);
+	void Add(const RenderItem& item);
+
+	// 並べ替えてバッチを作る。objectCountはTransformBatchのオブジェクト数で、各オブジェクトを描くのは1回まで
+	// maxInstancesPerBatchを超える組は分ける。0なら分けない
+	void Build(size_t objectCount, uint32_t maxInstancesPerBatch = 0);
+
+	const std::vector<RenderBatch>& GetBatches() const { return batches_; }
+	// i番目のインスタンスが描くオブジェクトの番号
+	const std::vector<uint32_t>& GetInstanceObjects() const { return instanceObjects_; }
+	// オブジェクトの番号で引くインスタンスの番号。描かないものはTransformBatch::kNoSlotと同じUINT32_MAX
+	// TransformBatch::UpdateのdestinationSlotsに渡すと、WVPを描く順に書き込める
+	const std::vector<uint32_t>& GetObjectInstances() const { return objectInstances_; }
+	size_t GetItemCount() const { return items_.size(); }
+
+	// Buildした順に、各インスタンスのマテリアルの番号をdestinationへ書き込む。WVPは書かない
+	// destinationはMapしたUploadBufferでも良い(前から順に書くだけ)
+	void WriteMaterialIndices(InstanceData* destination) const;
+
+	static uint64_t MakeSortKey(uint32_t pipeline, uint32_t mesh);
+
+private:
+	std::vector<RenderItem> items_;
+	// 並べ替えのキーと、items_の番号
+	std::vector<std::pair<uint64_t, uint32_t>> sortKeys_;
+	std::vector<RenderBatch> batches_;
+	std::vector<uint32_t> instanceObjects_;
+	std::vector<uint32_t> instanceMaterials_;
+	std::vector<uint32_t> objectInstances_;
+};
@@ -0,0 +1,51 @@
+#include "ResourceUtility.h"
+#include "D3D12ResourceAllocator.h"
+#include <cassert>
+
+ID3D12Resource* CreateBufferResource(D3D12ResourceAllocator* allocator, size_t sizeInBytes, D3D12_HEAP_TYPE heapType) {
+	// リソース設定（バッファ用）
+	D3D12_RESOURCE_DESC vertexResourceDesc{};
+	vertexResourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	vertexResourceDesc.Width = sizeInBytes;
+	vertexResourceDesc.Height = 1;
+	vertexResourceDesc.DepthOrArraySize = 1;
+	vertexResourceDesc.MipLevels = 1;
+	vertexResourceDesc.SampleDesc.Count = 1;
+	vertexResourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+	// UploadHeapはGenericRead、ReadbackHeapはCopyDestで作る決まり
+	D3D12_RESOURCE_STATES initialState = D3D12_RESOURCE_STATE_COMMON;
+	if (heapType == D3D12_HEAP_TYPE_UPLOAD) {
+		initialState = D3D12_RESOURCE_STATE_GENERIC_READ;
+	} else if (heapType == D3D12_HEAP_TYPE_READBACK) {
+		initialState = D3D12_RESOURCE_STATE_COPY_DEST;
+	}
+
+	// リソース作成。Heapはアロケータがまとめて持っている
+	return allocator->CreateResource(heapType, vertexResourceDesc, initialState);
+}
+
+ID3D12Resource* CreateDepthStencilTextureResource(D3D12ResourceAllocator* allocator, int32_t width, int32_t height) {
+	// Resourceの設定
+	D3D12_RESOURCE_DESC resourceDesc{};
+	resourceDesc.Width = width; // Textureの幅
+	resourceDesc.Height = height; // Textureの高さ
+	resourceDesc.MipLevels = 1; // mipmapの数
+	resourceDesc.DepthOrArraySize = 1; // 奥行き or 配列Textureの配列数
+	resourceDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT; // DepthStencilとして利用可能なフォーマット
+	resourceDesc.SampleDesc.Count = 1; // サンプリングカウント。1固定。
+	resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D; // 2次元
+	resourceDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL; // DepthStencilとして使う通知
+
+	// 深度値のクリア設定
+	D3D12_CLEAR_VALUE depthClearValue{};
+	depthClearValue.DepthStencil.Depth = 1.0f; // 1.0f（最大値）でクリア
+	depthClearValue.Format = DXGI_FORMAT_D24_UNORM_S8_UINT; // フォーマット。Resourceと合わせる
+
+	// Resourceの生成。VRAM上（DefaultHeap）に置く
+	return allocator->CreateResource(
+		D3D12_HEAP_TYPE_DEFAULT,
+		resourceDesc,  // Resourceの設定
+		D3D12_RESOURCE_STATE_DEPTH_WRITE,  // 深度値を書き込む状態にしておく
+		&depthClearValue); // Clear最適値。
+}
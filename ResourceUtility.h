@@ -0,0 +1,11 @@
+#pragma once
+#include <d3d12.h>
+#include <cstdint>
+
+class D3D12ResourceAllocator;
+
+// バッファを作る。UploadHeapならMapして書き込める
+ID3D12Resource* CreateBufferResource(D3D12ResourceAllocator* allocator, size_t sizeInBytes, D3D12_HEAP_TYPE heapType = D3D12_HEAP_TYPE_UPLOAD);
+
+// DepthStencil用のテクスチャを作る
+ID3D12Resource* CreateDepthStencilTextureResource(D3D12ResourceAllocator* allocator, int32_t width, int32_t height);
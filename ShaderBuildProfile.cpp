@@ -0,0 +1,38 @@
+#include "ShaderBuildProfile.h"
+
+ShaderBuildProfile GetDefaultShaderBuildProfile() {
+#ifdef _DEBUG
+	return ShaderBuildProfile::Debug;
+#else
+	return ShaderBuildProfile::Release;
+#endif
+}
+
+const char* GetShaderBuildProfileName(ShaderBuildProfile profile) {
+	switch (profile) {
+	case ShaderBuildProfile::Debug:
+		return "debug";
+	case ShaderBuildProfile::Release:
+		return "release";
+	}
+	return "unknown";
+}
+
+void ApplyShaderBuildProfile(ShaderBuildProfile profile, const std::filesystem::path& pdbDirectory, ShaderCompileRequest& request) {
+	switch (profile) {
+	case ShaderBuildProfile::Debug:
+		request.arguments.insert(request.arguments.end(), {
+			L"-Zi", L"-Qembed_debug",   // デバッグ用の情報を埋め込む
+			L"-Od",     // 最適化を外しておく
+		});
+		break;
+	case ShaderBuildProfile::Release:
+		request.arguments.insert(request.arguments.end(), {
+			L"-O3",     // 最適化する
+			L"-Zi", L"-Qstrip_debug",   // デバッグ情報は作るが、バイナリからは外してPDBへ
+			L"-Qstrip_reflect",     // リフレクションはRootSignatureを自前で書くので要らない
+		});
+		request.pdbDirectory = pdbDirectory;
+		break;
+	}
+}
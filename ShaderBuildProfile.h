@@ -0,0 +1,18 @@
+#pragma once
+#include <filesystem>
+#include "ShaderCache.h"
+
+// シェーダーのビルド設定
+enum class ShaderBuildProfile {
+	// 最適化なし、デバッグ情報をバイナリに埋め込む。PIXでそのままソースを追える
+	Debug,
+	// -O3で最適化し、デバッグ情報とリフレクションをバイナリから外す。デバッグ情報はPDBとして別のディレクトリに書き出す
+	Release,
+};
+
+// ビルド構成に合わせた標準の設定。_DEBUGならDebug
+ShaderBuildProfile GetDefaultShaderBuildProfile();
+const char* GetShaderBuildProfileName(ShaderBuildProfile profile);
+
+// profileのオプションをrequestに足す。ReleaseのPDBはpdbDirectoryに書き出す
+void ApplyShaderBuildProfile(ShaderBuildProfile profile, const std::filesystem::path& pdbDirectory, ShaderCompileRequest& request);
@@ -0,0 +1,366 @@
+#include "ShaderCache.h"
+#include "ThreadPool.h"
+#include <cassert>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <set>
+
+namespace {
+
+// FNV-1a 64bit
+const uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ull;
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t hash = kFnvOffsetBasis) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+uint64_t HashString(const std::wstring& string, uint64_t hash) {
+	// 長さも混ぜて、引数の区切りが変わったものを区別する
+	uint64_t length = string.size();
+	hash = HashBytes(&length, sizeof(length), hash);
+	return HashBytes(string.data(), string.size() * sizeof(wchar_t), hash);
+}
+
+bool ReadFile(const std::filesystem::path& path, std::vector<uint8_t>& data) {
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file) {
+		return false;
+	}
+	data.resize(size_t(file.tellg()));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(data.data()), std::streamsize(data.size()));
+	return bool(file);
+}
+
+// #include "..."と#include <...>の名前を拾う。コメントや#ifの中も拾うが、余計に作り直すだけで困らない
+std::vector<std::string> FindIncludes(const std::vector<uint8_t>& source) {
+	std::vector<std::string> includes;
+	size_t position = 0;
+	while (position < source.size()) {
+		size_t lineEnd = position;
+		while (lineEnd < source.size() && source[lineEnd] != '\n') {
+			++lineEnd;
+		}
+		size_t i = position;
+		while (i < lineEnd && isspace(source[i])) {
+			++i;
+		}
+		if (i < lineEnd && source[i] == '#') {
+			++i;
+			while (i < lineEnd && isspace(source[i])) {
+				++i;
+			}
+			const char kInclude[] = "include";
+			const size_t kIncludeLength = sizeof(kInclude) - 1;
+			if (lineEnd - i > kIncludeLength && std::equal(kInclude, kInclude + kIncludeLength, source.begin() + i)) {
+				i += kIncludeLength;
+				while (i < lineEnd && isspace(source[i])) {
+					++i;
+				}
+				if (i < lineEnd && (source[i] == '"' || source[i] == '<')) {
+					char terminator = source[i] == '"' ? '"' : '>';
+					size_t nameBegin = ++i;
+					while (i < lineEnd && source[i] != terminator) {
+						++i;
+					}
+					if (i < lineEnd) {
+						includes.emplace_back(source.begin() + nameBegin, source.begin() + i);
+					}
+				}
+			}
+		}
+		position = lineEnd + 1;
+	}
+	return includes;
+}
+
+// includeを辿り、見つかったファイルの名前と中身をハッシュに混ぜる
+// DXCの標準のIncludeHandlerと同じく、includeしたファイルのディレクトリ、次にメインのファイルのディレクトリから探す
+uint64_t HashIncludes(const std::vector<uint8_t>& source, const std::filesystem::path& directory,
+	const std::filesystem::path& rootDirectory, std::set<std::filesystem::path>& visited, uint64_t hash) {
+	for (const std::string& include : FindIncludes(source)) {
+		std::filesystem::path includePath = directory / include;
+		if (!std::filesystem::exists(includePath)) {
+			includePath = rootDirectory / include;
+		}
+		// 見つからなくても名前は混ぜる。後から置かれたら別のキーになる
+		hash = HashBytes(include.data(), include.size(), hash);
+		std::vector<uint8_t> includeSource;
+		if (!ReadFile(includePath, includeSource)) {
+			continue;
+		}
+		if (!visited.insert(std::filesystem::weakly_canonical(includePath)).second) {
+			continue;
+		}
+		hash = HashBytes(includeSource.data(), includeSource.size(), hash);
+		hash = HashIncludes(includeSource, includePath.parent_path(), rootDirectory, visited, hash);
+	}
+	return hash;
+}
+
+}
+
+void ShaderCache::Initialize(const std::filesystem::path& directory, IShaderCompiler* compiler, uint64_t maxCacheBytes) {
+	assert(compiler != nullptr);
+	directory_ = directory;
+	compiler_ = compiler;
+	std::error_code errorCode;
+	std::filesystem::create_directories(directory_, errorCode);
+	ResetStatistics();
+	Prune(maxCacheBytes);
+}
+
+void ShaderCache::Prune(uint64_t maxBytes) {
+	struct CacheFile {
+		std::filesystem::path path;
+		std::filesystem::file_time_type lastUsedTime;
+		uint64_t size;
+	};
+	std::vector<CacheFile> files;
+	uint64_t totalBytes = 0;
+	std::error_code errorCode;
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory_, errorCode)) {
+		if (!entry.is_regular_file(errorCode)) {
+			continue;
+		}
+		const std::filesystem::path& path = entry.path();
+		if (path.extension() == ".tmp") {
+			// 書き込み途中で落ちた一時ファイル。Initializeの時点では誰も書いていない
+			std::filesystem::remove(path, errorCode);
+			continue;
+		}
+		if (path.extension() != ".bin") {
+			continue;
+		}
+		CacheFile file{ path, entry.last_write_time(errorCode), entry.file_size(errorCode) };
+		if (errorCode) {
+			continue;
+		}
+		totalBytes += file.size;
+		files.push_back(std::move(file));
+	}
+	if (totalBytes <= maxBytes) {
+		return;
+	}
+
+	std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) { return a.lastUsedTime < b.lastUsedTime; });
+	uint32_t evictedCount = 0;
+	for (const CacheFile& file : files) {
+		if (totalBytes <= maxBytes) {
+			break;
+		}
+		if (std::filesystem::remove(file.path, errorCode)) {
+			totalBytes -= file.size;
+			++evictedCount;
+		}
+	}
+	std::lock_guard<std::mutex> lock(mutex_);
+	statistics_.evictedCount += evictedCount;
+}
+
+bool ShaderCache::GetOrCompile(const ShaderCompileRequest& request, std::vector<uint8_t>& object, std::string& message, bool* cached) {
+	if (cached) {
+		*cached = false;
+	}
+	auto start = std::chrono::steady_clock::now();
+	std::vector<uint8_t> source;
+	uint64_t key = 0;
+	if (!ComputeKey(request, source, key)) {
+		message = "cannot read " + request.filePath.string();
+		std::lock_guard<std::mutex> lock(mutex_);
+		++statistics_.failedCount;
+		return false;
+	}
+	bool hit = Load(key, object);
+	auto lookupEnd = std::chrono::steady_clock::now();
+	double lookupSeconds = std::chrono::duration<double>(lookupEnd - start).count();
+	if (hit) {
+		if (cached) {
+			*cached = true;
+		}
+		std::lock_guard<std::mutex> lock(mutex_);
+		++statistics_.hitCount;
+		statistics_.lookupSeconds += lookupSeconds;
+		return true;
+	}
+
+	bool succeeded = compiler_->Compile(request, source, object, message);
+	double compileSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - lookupEnd).count();
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		++statistics_.missCount;
+		statistics_.lookupSeconds += lookupSeconds;
+		// 並列にコンパイルした場合は各スレッドの時間の合計になる
+		statistics_.compileSeconds += compileSeconds;
+		if (!succeeded) {
+			++statistics_.failedCount;
+		}
+	}
+	if (!succeeded) {
+		// 失敗した結果は残さない
+		return false;
+	}
+	Store(key, object);
+	return true;
+}
+
+std::vector<std::future<ShaderCompileResult>> ShaderCache::CompileBatch(const std::vector<ShaderCompileRequest>& requests, ThreadPool& threadPool) {
+	std::vector<std::future<ShaderCompileResult>> futures;
+	futures.reserve(requests.size());
+	for (const ShaderCompileRequest& request : requests) {
+		// requestはタスクの中へコピーする。呼び出し側のリストが先に消えても良い
+		futures.push_back(threadPool.Submit([this, request]() {
+			auto start = std::chrono::steady_clock::now();
+			ShaderCompileResult result;
+			result.succeeded = GetOrCompile(request, result.object, result.message, &result.cached);
+			result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			return result;
+		}));
+	}
+	return futures;
+}
+
+ShaderBatchDiagnostics ShaderCache::WaitForBatch(const std::vector<ShaderCompileRequest>& requests,
+	std::vector<std::future<ShaderCompileResult>>& futures, std::vector<ShaderCompileResult>& results) {
+	assert(requests.size() == futures.size());
+	ShaderBatchDiagnostics diagnostics;
+	results.clear();
+	results.reserve(futures.size());
+	for (size_t i = 0; i < futures.size(); ++i) {
+		results.push_back(futures[i].get());
+		const ShaderCompileResult& result = results.back();
+		if (!result.succeeded) {
+			++diagnostics.failedCount;
+			// 同じファイルを定義違いでコンパイルすることがあるので、定義も並べる
+			std::wstring variant = requests[i].profile;
+			for (const std::wstring& define : requests[i].defines) {
+				variant += L" " + define;
+			}
+			diagnostics.messages += requests[i].filePath.string() + " (" + std::filesystem::path(variant).string() + "):\n" + result.message;
+			if (!result.message.empty() && result.message.back() != '\n') {
+				diagnostics.messages += '\n';
+			}
+			continue;
+		}
+		++diagnostics.succeededCount;
+		if (result.cached) {
+			++diagnostics.cachedCount;
+		}
+	}
+	return diagnostics;
+}
+
+bool ShaderCache::ComputeKey(const ShaderCompileRequest& request, std::vector<uint8_t>& source, uint64_t& key) const {
+	if (!ReadFile(request.filePath, source)) {
+		return false;
+	}
+	uint64_t hash = HashBytes(&kVersion, sizeof(kVersion));
+	std::string compilerVersion = compiler_->GetVersionString();
+	hash = HashBytes(compilerVersion.data(), compilerVersion.size(), hash);
+	hash = HashString(request.entryPoint, hash);
+	hash = HashString(request.profile, hash);
+	for (const std::wstring& define : request.defines) {
+		hash = HashString(L"-D" + define, hash);
+	}
+	for (const std::wstring& argument : request.arguments) {
+		hash = HashString(argument, hash);
+	}
+	// ファイル名はエラーメッセージやデバッグ情報に入るので混ぜる
+	hash = HashString(request.filePath.generic_wstring(), hash);
+	// PDBはコンパイルしたときにしか書かないので、書き出し先が変わったらキャッシュに当てない
+	hash = HashString(request.pdbDirectory.generic_wstring(), hash);
+	hash = HashBytes(source.data(), source.size(), hash);
+	std::set<std::filesystem::path> visited;
+	std::filesystem::path directory = request.filePath.parent_path();
+	key = HashIncludes(source, directory, directory, visited, hash);
+	return true;
+}
+
+std::filesystem::path ShaderCache::GetEntryPath(uint64_t key) const {
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+	return directory_ / name;
+}
+
+bool ShaderCache::Load(uint64_t key, std::vector<uint8_t>& object) {
+	std::filesystem::path entryPath = GetEntryPath(key);
+	std::vector<uint8_t> data;
+	if (!ReadFile(entryPath, data)) {
+		return false;
+	}
+	EntryHeader header{};
+	bool valid = data.size() >= sizeof(header);
+	if (valid) {
+		memcpy(&header, data.data(), sizeof(header));
+		valid = header.magic == kMagic && header.version == kVersion && header.key == key &&
+			header.objectSize == data.size() - sizeof(header) &&
+			header.checksum == HashBytes(data.data() + sizeof(header), size_t(header.objectSize));
+	}
+	if (!valid) {
+		// 書き込み途中で落ちたなどで壊れている。消してコンパイルし直す
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			++statistics_.corruptCount;
+		}
+		std::error_code errorCode;
+		std::filesystem::remove(entryPath, errorCode);
+		return false;
+	}
+	object.assign(data.begin() + sizeof(header), data.end());
+	// Pruneで消す順番に使うので、最後に使った時刻を更新する。失敗しても読めた結果は使える
+	std::error_code errorCode;
+	std::filesystem::last_write_time(entryPath, std::filesystem::file_time_type::clock::now(), errorCode);
+	return true;
+}
+
+void ShaderCache::Store(uint64_t key, const std::vector<uint8_t>& object) {
+	EntryHeader header{};
+	header.magic = kMagic;
+	header.version = kVersion;
+	header.key = key;
+	header.objectSize = object.size();
+	header.checksum = HashBytes(object.data(), object.size());
+
+	// 一時ファイルに書いてから置き換えるので、途中で落ちても中途半端なファイルは残らない
+	std::filesystem::path entryPath = GetEntryPath(key);
+	std::filesystem::path temporaryPath = entryPath;
+	temporaryPath += "." + std::to_string(temporaryIndex_++) + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			return;
+		}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(object.data()), std::streamsize(object.size()));
+		if (!file) {
+			file.close();
+			std::error_code errorCode;
+			std::filesystem::remove(temporaryPath, errorCode);
+			return;
+		}
+	}
+	std::error_code errorCode;
+	std::filesystem::rename(temporaryPath, entryPath, errorCode);
+	if (errorCode) {
+		std::filesystem::remove(temporaryPath, errorCode);
+	}
+}
+
+ShaderCache::Statistics ShaderCache::GetStatistics() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return statistics_;
+}
+
+void ShaderCache::ResetStatistics() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	statistics_ = {};
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <atomic>
+
+class ThreadPool;
+
+// シェーダー1つ分のコンパイル内容
+struct ShaderCompileRequest {
+	// コンパイルするhlslファイルへのパス
+	std::filesystem::path filePath;
+	std::wstring entryPoint = L"main";
+	// vs_6_0など
+	std::wstring profile;
+	// マクロの定義。NAMEまたはNAME=VALUEの形で書く
+	std::vector<std::wstring> defines;
+	// -E、-T、-D以外のコンパイルオプション
+	std::vector<std::wstring> arguments;
+	// 空でなければ、コンパイルしたときにPDBをここへ書き出す。キャッシュから読んだときは書き出さない
+	// キーに混ぜるので、書き出し先を変えればコンパイルし直してそこへ書く。PDBだけを消したときはキャッシュも消すこと
+	std::filesystem::path pdbDirectory;
+};
+
+// 1つのシェーダーのコンパイル結果
+struct ShaderCompileResult {
+	bool succeeded = false;
+	// キャッシュから読んだ
+	bool cached = false;
+	std::vector<uint8_t> object;
+	// 警告・エラー
+	std::string message;
+	// キャッシュの確認とコンパイルにかかった時間
+	double seconds = 0.0;
+};
+
+// まとめてコンパイルした結果の集計
+struct ShaderBatchDiagnostics {
+	uint32_t succeededCount = 0;
+	uint32_t cachedCount = 0;
+	uint32_t failedCount = 0;
+	// 失敗したシェーダーのメッセージを、ファイル名とプロファイルを付けて並べたもの
+	std::string messages;
+};
+
+// シェーダーコンパイラの抽象。DXCを使う実装はDxcShaderCompiler
+class IShaderCompiler {
+public:
+	virtual ~IShaderCompiler() = default;
+	// キャッシュのキーに混ぜる。コンパイラが更新されたらキャッシュは全て作り直しになる
+	virtual std::string GetVersionString() const = 0;
+	// sourceはrequest.filePathの中身。警告・エラーはmessageに入れる。警告が出た場合も失敗とする
+	// 複数のスレッドから同時に呼ばれる
+	virtual bool Compile(const ShaderCompileRequest& request, const std::vector<uint8_t>& source, std::vector<uint8_t>& object, std::string& message) = 0;
+};
+
+// コンパイル結果をディスクに残し、次回以降の起動でコンパイルを省く
+// キーはソースとincludeしたファイル全ての中身、エントリーポイント、プロファイル、オプション、PDBの書き出し先、コンパイラのバージョンのハッシュ
+// キャッシュのファイルは先頭にヘッダとチェックサムを持ち、壊れていれば消してコンパイルし直す
+// キーが変わると古いファイルは二度と読まれないので、Initializeで合計が上限を超えた分を最後に使った時刻の古い順に消す
+// GetOrCompileは複数のスレッドから同時に呼んで良い
+class ShaderCache {
+public:
+	struct Statistics {
+		uint32_t hitCount = 0;
+		uint32_t missCount = 0;
+		// 壊れていて読み捨てたキャッシュの数
+		uint32_t corruptCount = 0;
+		// 容量の上限を超えて消したキャッシュの数
+		uint32_t evictedCount = 0;
+		uint32_t failedCount = 0;
+		// ハッシュの計算とキャッシュの読み込みにかかった時間
+		double lookupSeconds = 0.0;
+		double compileSeconds = 0.0;
+	};
+
+	// キャッシュ全体の標準の上限
+	static constexpr uint64_t kDefaultMaxCacheBytes = 256ull * 1024 * 1024;
+
+	// キャッシュのファイルはdirectoryに置く。無ければ作る。その後Prune(maxCacheBytes)する
+	void Initialize(const std::filesystem::path& directory, IShaderCompiler* compiler, uint64_t maxCacheBytes = kDefaultMaxCacheBytes);
+
+	// 書き込み途中で残った一時ファイルを消し、キャッシュの合計がmaxBytes以下になるまで最後に使ったのが古いものから消す
+	// 最後に使った時刻はファイルの更新時刻で、キャッシュから読むたびに今の時刻にする
+	void Prune(uint64_t maxBytes);
+
+	// キャッシュにあればそれを返し、無ければコンパイルして保存する。ソースが読めないかコンパイルに失敗したらfalse
+	// cachedを渡すと、キャッシュから読めたかどうかが入る
+	bool GetOrCompile(const ShaderCompileRequest& request, std::vector<uint8_t>& object, std::string& message, bool* cached = nullptr);
+
+	// requestsをthreadPoolで並列にコンパイルする。結果はrequestsと同じ順に並ぶ
+	std::vector<std::future<ShaderCompileResult>> CompileBatch(const std::vector<ShaderCompileRequest>& requests, ThreadPool& threadPool);
+	// CompileBatchの結果を全て待ってresultsに受け取り、診断をまとめる
+	static ShaderBatchDiagnostics WaitForBatch(const std::vector<ShaderCompileRequest>& requests,
+		std::vector<std::future<ShaderCompileResult>>& futures, std::vector<ShaderCompileResult>& results);
+
+	// キャッシュのキーを求める。sourceにはrequest.filePathの中身が入る
+	bool ComputeKey(const ShaderCompileRequest& request, std::vector<uint8_t>& source, uint64_t& key) const;
+	std::filesystem::path GetEntryPath(uint64_t key) const;
+
+	Statistics GetStatistics() const;
+	void ResetStatistics();
+
+private:
+	// キャッシュのファイルの先頭
+	struct EntryHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		uint64_t objectSize;
+		uint64_t checksum;
+	};
+	static constexpr uint32_t kMagic = 0x43485344; // "DSHC"
+	// ファイルの形式かキーの作り方を変えたら上げる
+	static constexpr uint32_t kVersion = 1;
+
+	// 無い、または壊れていればfalse。壊れていたファイルは消す
+	bool Load(uint64_t key, std::vector<uint8_t>& object);
+	void Store(uint64_t key, const std::vector<uint8_t>& object);
+
+	std::filesystem::path directory_;
+	IShaderCompiler* compiler_ = nullptr;
+	// 同時に書き込むスレッド同士で一時ファイルの名前がぶつからないようにする連番
+	std::atomic<uint32_t> temporaryIndex_ = 0;
+	mutable std::mutex mutex_;
+	Statistics statistics_;
+};
@@ -0,0 +1,136 @@
+#include "ShaderHotReloader.h"
+#include "ThreadPool.h"
+#include <cassert>
+
+bool ShaderHotReloader::Initialize(ShaderCache* shaderCache, ThreadPool* threadPool, const std::filesystem::path& directory) {
+	assert(shaderCache != nullptr);
+	assert(threadPool != nullptr);
+	shaderCache_ = shaderCache;
+	threadPool_ = threadPool;
+	changed_ = false;
+	statistics_ = {};
+	watching_ = fileWatcher_.Initialize(directory);
+	return watching_;
+}
+
+void ShaderHotReloader::Finalize() {
+	for (Program& program : programs_) {
+		for (std::future<ShaderCompileResult>& future : program.futures) {
+			future.wait();
+		}
+	}
+	programs_.clear();
+	fileWatcher_.Finalize();
+	watching_ = false;
+}
+
+uint32_t ShaderHotReloader::AddProgram(const std::vector<ShaderCompileRequest>& requests, const std::vector<ShaderCompileResult>& results, const std::string& messages) {
+	assert(requests.size() == results.size());
+	Program program;
+	program.requests = requests;
+	ComputeKeys(program, program.keys);
+	bool succeeded = true;
+	for (const ShaderCompileResult& result : results) {
+		succeeded = succeeded && result.succeeded;
+	}
+	if (succeeded) {
+		program.results = results;
+	} else {
+		program.errors = messages;
+	}
+	programs_.push_back(std::move(program));
+	return uint32_t(programs_.size() - 1);
+}
+
+std::vector<uint32_t> ShaderHotReloader::Update() {
+	std::vector<uint32_t> reloaded;
+
+	// シェーダーのファイルが変わったか見る
+	for (const std::filesystem::path& path : fileWatcher_.Poll()) {
+		std::filesystem::path extension = path.extension();
+		// ディレクトリ自身なら取りこぼしがあったので、全て変わったとみなす
+		if (path == fileWatcher_.GetDirectory() || extension == ".hlsl" || extension == ".hlsli") {
+			changed_ = true;
+			lastChangeTime_ = std::chrono::steady_clock::now();
+		}
+	}
+
+	// 落ち着いたら、中身が変わったプログラムのコンパイルを始める。includeしたファイルの変更もキーで分かる
+	if (changed_ && std::chrono::steady_clock::now() - lastChangeTime_ >= kSettleTime) {
+		changed_ = false;
+		for (Program& program : programs_) {
+			if (!program.futures.empty()) {
+				// コンパイル中なら、終わってからもう一度見る
+				changed_ = true;
+				continue;
+			}
+			std::vector<uint64_t> keys;
+			if (!ComputeKeys(program, keys) || keys == program.keys) {
+				continue;
+			}
+			program.keys = keys;
+			program.compileStart = std::chrono::steady_clock::now();
+			program.futures = shaderCache_->CompileBatch(program.requests, *threadPool_);
+		}
+	}
+
+	// 終わったものを受け取る。組の全てが終わるまで待たずに次のフレームへ進む
+	for (uint32_t programId = 0; programId < programs_.size(); ++programId) {
+		Program& program = programs_[programId];
+		if (program.futures.empty()) {
+			continue;
+		}
+		bool ready = true;
+		for (std::future<ShaderCompileResult>& future : program.futures) {
+			ready = ready && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+		}
+		if (!ready) {
+			continue;
+		}
+		std::vector<ShaderCompileResult> results;
+		ShaderBatchDiagnostics diagnostics = ShaderCache::WaitForBatch(program.requests, program.futures, results);
+		program.futures.clear();
+		statistics_.lastReloadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - program.compileStart).count();
+		if (diagnostics.failedCount != 0) {
+			// 前の結果はそのまま使い続ける
+			program.errors = diagnostics.messages;
+			++statistics_.failedCount;
+			continue;
+		}
+		program.results = std::move(results);
+		program.errors.clear();
+		++statistics_.reloadCount;
+		reloaded.push_back(programId);
+	}
+	return reloaded;
+}
+
+const std::vector<ShaderCompileResult>& ShaderHotReloader::GetResults(uint32_t programId) const {
+	assert(programId < programs_.size());
+	return programs_[programId].results;
+}
+
+const std::string& ShaderHotReloader::GetErrors(uint32_t programId) const {
+	assert(programId < programs_.size());
+	return programs_[programId].errors;
+}
+
+bool ShaderHotReloader::IsCompiling() const {
+	for (const Program& program : programs_) {
+		if (!program.futures.empty()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ShaderHotReloader::ComputeKeys(const Program& program, std::vector<uint64_t>& keys) const {
+	keys.resize(program.requests.size());
+	std::vector<uint8_t> source;
+	for (size_t i = 0; i < program.requests.size(); ++i) {
+		if (!shaderCache_->ComputeKey(program.requests[i], source, keys[i])) {
+			return false;
+		}
+	}
+	return true;
+}
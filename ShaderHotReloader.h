@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <chrono>
+#include <future>
+#include <string>
+#include <vector>
+#include "FileWatcher.h"
+#include "ShaderCache.h"
+
+class ThreadPool;
+
+// シェーダーのファイルを監視し、変わったものをワーカースレッドでコンパイルし直す
+// 1つのパイプラインで使うシェーダーの組をプログラムとして登録する。組の全てが通ったときだけ結果を差し替え、
+// 1つでも失敗したら前の結果を持ったまま、エラーを表示用に残す
+// 全てメインスレッドから呼ぶ
+class ShaderHotReloader {
+public:
+	struct Statistics {
+		uint32_t reloadCount = 0;
+		uint32_t failedCount = 0;
+		// 最後にコンパイルし直すのにかかった時間
+		double lastReloadSeconds = 0.0;
+	};
+
+	// directoryのhlslとhlsliを監視する。監視を始められなければfalse（コンパイルはできる）
+	bool Initialize(ShaderCache* shaderCache, ThreadPool* threadPool, const std::filesystem::path& directory);
+	// コンパイル中のものを待ってから止める
+	void Finalize();
+
+	// 起動時にコンパイルした組と、その結果を登録する。起動時に失敗していれば、resultsの失敗したものとmessagesを渡す
+	uint32_t AddProgram(const std::vector<ShaderCompileRequest>& requests, const std::vector<ShaderCompileResult>& results, const std::string& messages);
+
+	// 毎フレーム呼ぶ。変更があればコンパイルを始め、全て通って結果が差し替わったプログラムの番号を返す
+	std::vector<uint32_t> Update();
+
+	// 最後に全て通った結果。requestsと同じ順に並ぶ。一度も通っていなければ空
+	const std::vector<ShaderCompileResult>& GetResults(uint32_t programId) const;
+	// 最後のコンパイルのエラー。通っていれば空
+	const std::string& GetErrors(uint32_t programId) const;
+	bool IsCompiling() const;
+	bool IsWatching() const { return watching_; }
+	Statistics GetStatistics() const { return statistics_; }
+
+private:
+	struct Program {
+		std::vector<ShaderCompileRequest> requests;
+		// 最後にコンパイルを試した内容のキー。変わっていなければコンパイルし直さない
+		std::vector<uint64_t> keys;
+		std::vector<ShaderCompileResult> results;
+		std::string errors;
+		// コンパイル中のもの
+		std::vector<std::future<ShaderCompileResult>> futures;
+		std::chrono::steady_clock::time_point compileStart;
+	};
+	// ファイルの保存は何回かに分けて通知されるので、最後の通知から少し待ってからコンパイルする
+	static constexpr std::chrono::milliseconds kSettleTime{ 100 };
+
+	// 今のファイルでのキーを求める。読めなければfalse
+	bool ComputeKeys(const Program& program, std::vector<uint64_t>& keys) const;
+
+	ShaderCache* shaderCache_ = nullptr;
+	ThreadPool* threadPool_ = nullptr;
+	FileWatcher fileWatcher_;
+	bool watching_ = false;
+	bool changed_ = false;
+	std::chrono::steady_clock::time_point lastChangeTime_;
+	std::vector<Program> programs_;
+	Statistics statistics_;
+};
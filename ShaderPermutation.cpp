@@ -0,0 +1,123 @@
+#include "ShaderPermutation.h"
+#include "ThreadPool.h"
+#include <cassert>
+
+void ShaderPermutationSet::Initialize(ShaderCache* shaderCache, const ShaderCompileRequest& baseRequest, const std::vector<std::string>& keywords, uint32_t variantCap) {
+	assert(shaderCache != nullptr);
+	assert(keywords.size() <= kMaxKeywordCount);
+	shaderCache_ = shaderCache;
+	baseRequest_ = baseRequest;
+	keywords_ = keywords;
+	variantCap_ = variantCap;
+	rejectedCount_ = 0;
+	variants_.clear();
+}
+
+uint32_t ShaderPermutationSet::GetKeywordMask(const std::string& keyword) const {
+	for (size_t i = 0; i < keywords_.size(); ++i) {
+		if (keywords_[i] == keyword) {
+			return 1u << i;
+		}
+	}
+	assert(false);
+	return 0;
+}
+
+uint32_t ShaderPermutationSet::MakeMask(std::initializer_list<const char*> keywords) const {
+	uint32_t mask = 0;
+	for (const char* keyword : keywords) {
+		mask |= GetKeywordMask(keyword);
+	}
+	return mask;
+}
+
+bool ShaderPermutationSet::Request(uint32_t mask) {
+	// キーワードに無いビットは使えない
+	assert(keywords_.size() == kMaxKeywordCount || (mask >> keywords_.size()) == 0);
+	if (variants_.count(mask) != 0) {
+		return true;
+	}
+	if (variants_.size() >= variantCap_) {
+		++rejectedCount_;
+		return false;
+	}
+	variants_.emplace(mask, Variant());
+	return true;
+}
+
+ShaderBatchDiagnostics ShaderPermutationSet::CompilePending(ThreadPool& threadPool) {
+	std::vector<uint32_t> masks;
+	std::vector<ShaderCompileRequest> requests;
+	for (const auto& [mask, variant] : variants_) {
+		if (!variant.compiled && !variant.failed) {
+			masks.push_back(mask);
+			requests.push_back(MakeRequest(mask));
+		}
+	}
+	std::vector<std::future<ShaderCompileResult>> futures = shaderCache_->CompileBatch(requests, threadPool);
+	std::vector<ShaderCompileResult> results;
+	ShaderBatchDiagnostics diagnostics = ShaderCache::WaitForBatch(requests, futures, results);
+	for (size_t i = 0; i < results.size(); ++i) {
+		Variant& variant = variants_[masks[i]];
+		variant.compiled = results[i].succeeded;
+		variant.failed = !results[i].succeeded;
+		variant.cached = results[i].cached;
+		variant.seconds = results[i].seconds;
+		variant.object = std::move(results[i].object);
+	}
+	return diagnostics;
+}
+
+uint32_t ShaderPermutationSet::ClearFailed() {
+	uint32_t clearedCount = 0;
+	for (auto it = variants_.begin(); it != variants_.end();) {
+		if (it->second.failed) {
+			it = variants_.erase(it);
+			++clearedCount;
+		} else {
+			++it;
+		}
+	}
+	return clearedCount;
+}
+
+const std::vector<uint8_t>* ShaderPermutationSet::Find(uint32_t mask) const {
+	auto it = variants_.find(mask);
+	if (it == variants_.end() || !it->second.compiled) {
+		return nullptr;
+	}
+	return &it->second.object;
+}
+
+ShaderCompileRequest ShaderPermutationSet::MakeRequest(uint32_t mask) const {
+	// 立っていないキーワードも0で定義して、#ifで書けるようにする
+	ShaderCompileRequest request = baseRequest_;
+	for (size_t i = 0; i < keywords_.size(); ++i) {
+		std::wstring keyword(keywords_[i].begin(), keywords_[i].end());
+		request.defines.push_back(keyword + ((mask & (1u << i)) ? L"=1" : L"=0"));
+	}
+	return request;
+}
+
+ShaderPermutationSet::Report ShaderPermutationSet::GetReport() const {
+	Report report;
+	report.keywordCount = uint32_t(keywords_.size());
+	report.possibleCount = 1ull << keywords_.size();
+	report.requestedCount = uint32_t(variants_.size());
+	report.rejectedCount = rejectedCount_;
+	report.variantCap = variantCap_;
+	for (const auto& [mask, variant] : variants_) {
+		if (variant.compiled) {
+			++report.compiledCount;
+			report.objectBytes += variant.object.size();
+			if (variant.cached) {
+				++report.cachedCount;
+			}
+		}
+		if (variant.failed) {
+			++report.failedCount;
+		}
+		report.compileSeconds += variant.seconds;
+	}
+	return report;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <initializer_list>
+#include "ShaderCache.h"
+
+class ThreadPool;
+
+// 1つのシェーダーを機能キーワードの組み合わせでコンパイルし分ける
+// キーワードはビットマスクで表し、i番目のキーワードがi番目のビットになる。全てのキーワードを0か1で定義してコンパイルする
+// 組み合わせは2^キーワード数あるので、使うと申告されたものだけをコンパイルし、バリアントの数に上限を設ける
+// 上限はコンパイル時間ではなく数で見る。時間はキャッシュに当たるかどうかで大きく変わるので、Reportで確認する
+class ShaderPermutationSet {
+public:
+	// キーワードの最大数
+	static constexpr uint32_t kMaxKeywordCount = 32;
+
+	// 上限と時間を見るための集計
+	struct Report {
+		uint32_t keywordCount = 0;
+		// 2^keywordCount
+		uint64_t possibleCount = 0;
+		uint32_t requestedCount = 0;
+		uint32_t compiledCount = 0;
+		uint32_t cachedCount = 0;
+		uint32_t failedCount = 0;
+		// 上限を超えたので断った数
+		uint32_t rejectedCount = 0;
+		uint32_t variantCap = 0;
+		// コンパイルにかかった時間の合計（並列に動いた分も足す）
+		double compileSeconds = 0.0;
+		size_t objectBytes = 0;
+	};
+
+	// baseRequestにキーワードの定義を足してコンパイルする。variantCapはコンパイルするバリアントの最大数
+	void Initialize(ShaderCache* shaderCache, const ShaderCompileRequest& baseRequest, const std::vector<std::string>& keywords, uint32_t variantCap);
+
+	// キーワードからマスクを作る。知らないキーワードはassert
+	uint32_t GetKeywordMask(const std::string& keyword) const;
+	uint32_t MakeMask(std::initializer_list<const char*> keywords) const;
+
+	// 使うバリアントを申告する。コンパイルはCompilePendingでまとめて行う。上限を超えるならfalse
+	bool Request(uint32_t mask);
+	// 申告されてまだコンパイルしていないものを並列にコンパイルし、終わるまで待つ
+	ShaderBatchDiagnostics CompilePending(ThreadPool& threadPool);
+	// 失敗したバリアントを消し、上限の数からも外す。シェーダーが直されたときに申告し直せるように、ホットリロードで呼ぶ
+	// 消した数を返す
+	uint32_t ClearFailed();
+
+	// コンパイル済みのバイナリを引く。無ければnullptr
+	const std::vector<uint8_t>* Find(uint32_t mask) const;
+	// maskのバリアントのコンパイル内容
+	ShaderCompileRequest MakeRequest(uint32_t mask) const;
+
+	Report GetReport() const;
+	const std::vector<std::string>& GetKeywords() const { return keywords_; }
+
+private:
+	struct Variant {
+		bool compiled = false;
+		bool failed = false;
+		bool cached = false;
+		double seconds = 0.0;
+		std::vector<uint8_t> object;
+	};
+
+	ShaderCache* shaderCache_ = nullptr;
+	ShaderCompileRequest baseRequest_;
+	std::vector<std::string> keywords_;
+	uint32_t variantCap_ = 0;
+	uint32_t rejectedCount_ = 0;
+	std::unordered_map<uint32_t, Variant> variants_;
+};
@@ -0,0 +1,79 @@
+#include "StagingRing.h"
+#include <cassert>
+
+namespace {
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+void StagingRing::Initialize(uint64_t capacity) {
+	assert(capacity > 0);
+	capacity_ = capacity;
+	head_ = 0;
+	tail_ = 0;
+	usedBytes_ = 0;
+	openBytes_ = 0;
+	submissions_.clear();
+}
+
+uint64_t StagingRing::Allocate(uint64_t size, uint64_t alignment) {
+	assert(size > 0);
+	assert((alignment & (alignment - 1)) == 0);
+	// 何も使っていなければ先頭から使い直す
+	if (usedBytes_ == 0) {
+		head_ = 0;
+		tail_ = 0;
+	} else if (head_ == tail_) {
+		// 一周して満杯
+		return kInvalidOffset;
+	}
+
+	uint64_t offset = AlignUp(head_, alignment);
+	uint64_t newHead = 0;
+	bool wrapped = false;
+	if (head_ >= tail_) {
+		// 空きは[head_, capacity_)と[0, tail_)の2か所
+		if (offset + size <= capacity_) {
+			newHead = offset + size;
+		} else if (size <= tail_) {
+			// 末尾に入らないので先頭へ回り込む。末尾の余りは捨てる
+			offset = 0;
+			newHead = size;
+			wrapped = true;
+		} else {
+			return kInvalidOffset;
+		}
+	} else {
+		// 空きは[head_, tail_)
+		if (offset + size > tail_) {
+			return kInvalidOffset;
+		}
+		newHead = offset + size;
+	}
+
+	// 回り込んだときは末尾の余りも使用中として数え、Retireで一緒に返す
+	uint64_t consumed = wrapped ? (capacity_ - head_) + newHead : newHead - head_;
+	usedBytes_ += consumed;
+	openBytes_ += consumed;
+	head_ = newHead == capacity_ ? 0 : newHead;
+	return offset;
+}
+
+void StagingRing::Close(uint64_t fenceValue) {
+	if (openBytes_ == 0) {
+		return;
+	}
+	submissions_.push_back({ fenceValue, head_, openBytes_ });
+	openBytes_ = 0;
+}
+
+void StagingRing::Retire(uint64_t completedValue) {
+	while (!submissions_.empty() && submissions_.front().fenceValue <= completedValue) {
+		tail_ = submissions_.front().end;
+		usedBytes_ -= submissions_.front().size;
+		submissions_.pop_front();
+	}
+}
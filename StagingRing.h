@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+
+// 転送用バッファを先頭から順に使い、GPUがコピーを終えた分を古い順に返すリングバッファ
+// オフセットの管理だけを行う。Closeで直前までの割り当てにSignal値を結び付け、Retireで完了したものを返す
+class StagingRing {
+public:
+	static constexpr uint64_t kInvalidOffset = ~0ull;
+
+	void Initialize(uint64_t capacity);
+
+	// alignmentは2の累乗であること。空きが無ければkInvalidOffset
+	uint64_t Allocate(uint64_t size, uint64_t alignment);
+	// ここまでの割り当てはfenceValueに到達したら使い終わる
+	void Close(uint64_t fenceValue);
+	// completedValueまで到達した割り当てを返す
+	void Retire(uint64_t completedValue);
+
+	uint64_t GetCapacity() const { return capacity_; }
+	uint64_t GetUsedBytes() const { return usedBytes_; }
+
+private:
+	struct Submission {
+		uint64_t fenceValue;
+		// このSubmissionを返すと、tail_がここまで進む
+		uint64_t end;
+		uint64_t size;
+	};
+
+	uint64_t capacity_ = 0;
+	// head_から書き足し、tail_から返す
+	uint64_t head_ = 0;
+	uint64_t tail_ = 0;
+	uint64_t usedBytes_ = 0;
+	// まだCloseしていない割り当ての量
+	uint64_t openBytes_ = 0;
+	std::deque<Submission> submissions_;
+};
@@ -0,0 +1,7 @@
+#pragma once
+#include <string>
+
+// string->wstring
+std::wstring ConvertString(const std::string& str);
+// wstring->string
+std::string ConvertString(const std::wstring& str);
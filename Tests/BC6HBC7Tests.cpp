@@ -0,0 +1,364 @@
+#include "Test.h"
+#include "DirectXTexFastMath.h"
+#include "../externals/DirectXTex/DirectXTex.h"
+#include <cmath>
+#include <cstring>
+#include <iterator>
+
+namespace {
+
+// 8ブロック分の固定のRGBA8の画素。ブロックごとに一色、グラデーション、境界、ノイズ、アルファなど性質を変える
+void GetBC7TestTexel(size_t block, size_t x, size_t y, uint8_t rgba[4]) {
+	const uint32_t noise = uint32_t((x + 4 * y + 16 * block) * 2654435761u) >> 24;
+	uint8_t r = 0, g = 0, b = 0, a = 255;
+	switch (block) {
+	case 0: // 一色
+		r = 200; g = 100; b = 50;
+		break;
+	case 1: // 横と縦のグラデーション
+		r = uint8_t(20 + x * 60); g = uint8_t(40 + y * 50); b = uint8_t(90 + (x + y) * 10);
+		break;
+	case 2: // 斜めの境界で2色
+		if (x > y) { r = 230; g = 30; b = 40; } else { r = 20; g = 60; b = 210; }
+		break;
+	case 3: // 3つの領域
+		if (x < 2 && y < 2) { r = 250; g = 250; b = 20; } else if (x >= 2) { r = 10; g = 160; b = 60; } else { r = 90; g = 20; b = 120; }
+		break;
+	case 4: // ノイズ
+		r = uint8_t(noise); g = uint8_t(noise * 7); b = uint8_t(noise * 13);
+		break;
+	case 5: // 色とアルファのグラデーション
+		r = uint8_t(255 - x * 40); g = uint8_t(128 + y * 30); b = uint8_t(x * y * 15); a = uint8_t(30 + (x + y) * 35);
+		break;
+	case 6: // アルファが0と255の2つの領域
+		r = uint8_t(60 + x * 40); g = uint8_t(70 + x * 30); b = 140; a = x + y < 3 ? 0 : 255;
+		break;
+	default: // ほぼ一様な灰色
+		r = g = b = uint8_t(120 + (noise & 7));
+		break;
+	}
+	rgba[0] = r; rgba[1] = g; rgba[2] = b; rgba[3] = a;
+}
+
+// 変更前のBC7エンコーダー（品質の段階を入れる前）がGetBC7TestTexelの8ブロックに出したバイト。
+// 速い浮動小数点でなければ、最適化の度合いやFMAの縮約に依らず同じバイトになるブロックを選んである
+const uint8_t kBC7Golden[8][16] = {
+	{ 0x08, 0x90, 0xc9, 0x64, 0xb2, 0x4c, 0x26, 0x93, 0x65, 0x32, 0x99, 0x0c, 0x00, 0x00, 0x00, 0x00 },
+	{ 0xd8, 0x28, 0xc8, 0x63, 0x05, 0x08, 0x24, 0x95, 0xbe, 0x7c, 0xc8, 0x9c, 0xc9, 0xc9, 0x37, 0x36 },
+	{ 0x08, 0x28, 0xe6, 0x8a, 0xb9, 0xe7, 0xe1, 0x79, 0xa4, 0x29, 0x69, 0x0a, 0xf8, 0xe1, 0x81, 0x01 },
+	{ 0x08, 0xf4, 0x5b, 0x85, 0x42, 0x5f, 0x01, 0x85, 0x2a, 0x78, 0x1e, 0x0f, 0x00, 0x00, 0x1e, 0x1e },
+	{ 0xe2, 0xd5, 0xca, 0x13, 0xf3, 0x01, 0x4b, 0x55, 0x39, 0x46, 0x70, 0xe1, 0xc3, 0xd9, 0x0f, 0x1f },
+	{ 0x80, 0x80, 0xe7, 0x92, 0x46, 0xce, 0x21, 0x20, 0x10, 0x1c, 0xeb, 0x1d, 0xe2, 0x49, 0xd3, 0x3c },
+	{ 0x20, 0x1e, 0xed, 0x08, 0x6a, 0x34, 0x02, 0xfc, 0xcb, 0xc9, 0xc9, 0xc9, 0xc1, 0xf0, 0xfc, 0xff },
+	{ 0x96, 0xde, 0xd7, 0x81, 0xde, 0xd7, 0x81, 0xde, 0xd7, 0x81, 0xc2, 0x2b, 0xfd, 0x04, 0xaf, 0xf4 },
+};
+
+// 横4×縦2ブロックの画像にGetBC7TestTexelの画素を並べる
+DirectX::ScratchImage MakeBC7TestImage() {
+	DirectX::ScratchImage image;
+	CHECK(SUCCEEDED(image.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, 16, 8, 1, 1)));
+	const DirectX::Image& pixels = *image.GetImage(0, 0, 0);
+	for (size_t y = 0; y < 8; ++y) {
+		for (size_t x = 0; x < 16; ++x) {
+			GetBC7TestTexel(x / 4 + 4 * (y / 4), x % 4, y % 4, pixels.pixels + pixels.rowPitch * y + x * 4);
+		}
+	}
+	return image;
+}
+
+// 品質の比較に使う32x32の画像。0はアルファで抜いた円と弱いノイズ、1は滑らかな面と市松の境界
+DirectX::ScratchImage MakeBC7QualityImage(int kind) {
+	DirectX::ScratchImage image;
+	CHECK(SUCCEEDED(image.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, 32, 32, 1, 1)));
+	const DirectX::Image& pixels = *image.GetImage(0, 0, 0);
+	for (size_t y = 0; y < 32; ++y) {
+		for (size_t x = 0; x < 32; ++x) {
+			const uint32_t noise = uint32_t((x * 73856093u) ^ (y * 19349663u)) * 2654435761u >> 24;
+			uint8_t* p = pixels.pixels + pixels.rowPitch * y + x * 4;
+			if (kind == 0) {
+				const float dx = float(x) - 16.0f;
+				const float dy = float(y) - 14.0f;
+				const bool inside = dx * dx + dy * dy < 100.0f;
+				p[0] = inside ? uint8_t(220 - y * 2) : uint8_t(30 + x * 3);
+				p[1] = inside ? 180 : uint8_t(60 + (noise & 15));
+				p[2] = uint8_t(40 + y * 4);
+				p[3] = inside ? 255 : uint8_t(x * 8);
+			} else {
+				p[0] = uint8_t(x * 8 + (noise & 7));
+				p[1] = uint8_t(y * 8 + ((noise >> 3) & 7));
+				p[2] = ((x / 8) + (y / 8)) % 2 ? 200 : 40;
+				p[3] = 255;
+			}
+		}
+	}
+	return image;
+}
+
+// 8ブロック分の固定のHDRの画素（RGB、アルファは1）。一色、空、太陽、ノイズ、暗部、明暗の境界、赤のグラデーション、対数のランプ
+void GetBC6HTestTexel(size_t block, size_t x, size_t y, float rgb[3]) {
+	const uint32_t noise = uint32_t((x + 4 * y + 16 * block) * 2654435761u) >> 24;
+	const float fx = float(x);
+	const float fy = float(y);
+	float r = 0.0f, g = 0.0f, b = 0.0f;
+	switch (block) {
+	case 0: // 一色
+		r = 1.0f; g = 0.5f; b = 0.25f;
+		break;
+	case 1: // 空のグラデーション
+		r = 0.2f + 0.05f * fx; g = 0.4f + 0.05f * fy; b = 1.2f + 0.1f * (fx + fy);
+		break;
+	case 2: // 太陽。中心だけが非常に明るい
+		r = g = b = 1.0f + 59.0f / (1.0f + 4.0f * ((fx - 1.0f) * (fx - 1.0f) + (fy - 1.0f) * (fy - 1.0f)));
+		b *= 0.9f;
+		break;
+	case 3: // ノイズ
+		r = float(noise) / 64.0f; g = float((noise * 7) & 255) / 64.0f; b = float((noise * 13) & 255) / 64.0f;
+		break;
+	case 4: // 暗部
+		r = 0.001f + 0.001f * fx; g = 0.002f + 0.004f * fy; b = 0.02f - 0.001f * (fx + fy);
+		break;
+	case 5: // 明暗の境界
+		r = g = b = x + y < 4 ? 10.0f : 0.1f;
+		break;
+	case 6: // 彩度の高い赤のグラデーション
+		r = 2.0f + 0.4f * (fx + 4.0f * fy); g = 0.05f; b = 0.0f;
+		break;
+	default: // 0.001から100までの対数のランプ
+		r = g = b = powf(10.0f, -3.0f + 5.0f * float(x + 4 * y) / 15.0f);
+		break;
+	}
+	rgb[0] = r; rgb[1] = g; rgb[2] = b;
+}
+
+// 変更前のBC6Hエンコーダー（高速な探索を入れる前）がGetBC6HTestTexelの8ブロックをBC6H_UF16に圧縮したバイト。
+// 最適化の度合いやFMAの縮約に依らず同じバイトになる
+const uint8_t kBC6HGolden[8][16] = {
+	{ 0xc7, 0x7b, 0xce, 0xb5, 0x46, 0xe0, 0x00, 0x03, 0x12, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11 },
+	{ 0xf2, 0x0c, 0x38, 0xfa, 0x38, 0x28, 0x98, 0xb1, 0x90, 0xa0, 0xb1, 0x3e, 0xf4, 0xcf, 0xe5, 0x54 },
+	{ 0xe3, 0x44, 0x12, 0x3f, 0x8c, 0x75, 0xd6, 0x56, 0x79, 0x14, 0xf7, 0x27, 0x74, 0x14, 0x21, 0x01 },
+	{ 0x81, 0x88, 0x9e, 0x88, 0xcb, 0x0d, 0x19, 0x40, 0x00, 0x5b, 0x7d, 0xf0, 0x29, 0x12, 0xc4, 0xe4 },
+	{ 0x81, 0x72, 0xcc, 0x4d, 0x07, 0x80, 0x81, 0xdf, 0x0f, 0x43, 0xf0, 0x9f, 0x24, 0xbd, 0xed, 0x92 },
+	{ 0x43, 0x4b, 0x2d, 0xb5, 0xfc, 0xeb, 0xaf, 0xbf, 0x00, 0x00, 0x00, 0xf0, 0x00, 0xff, 0xf0, 0xff },
+	{ 0x67, 0x04, 0x5e, 0x01, 0xb0, 0x14, 0x00, 0x00, 0x10, 0x42, 0x65, 0x87, 0x98, 0xaa, 0xcb, 0xdc },
+	{ 0x5e, 0x69, 0xe5, 0x15, 0x8c, 0x22, 0xba, 0x28, 0xe2, 0xcc, 0x21, 0xfe, 0xbf, 0x5d, 0x72, 0x53 },
+};
+
+// 横4×縦2ブロックのfloatの画像にGetBC6HTestTexelの画素を並べる
+DirectX::ScratchImage MakeBC6HTestImage() {
+	DirectX::ScratchImage image;
+	CHECK(SUCCEEDED(image.Initialize2D(DXGI_FORMAT_R32G32B32A32_FLOAT, 16, 8, 1, 1)));
+	const DirectX::Image& pixels = *image.GetImage(0, 0, 0);
+	for (size_t y = 0; y < 8; ++y) {
+		for (size_t x = 0; x < 16; ++x) {
+			float* p = reinterpret_cast<float*>(pixels.pixels + pixels.rowPitch * y + x * 16);
+			GetBC6HTestTexel(x / 4 + 4 * (y / 4), x % 4, y % 4, p);
+			p[3] = 1.0f;
+		}
+	}
+	return image;
+}
+
+// 誤差の比較に使う64x64のHDRの画像。0は太陽のある空と暗い地面、1は明るい窓のある室内
+DirectX::ScratchImage MakeBC6HQualityImage(int kind) {
+	DirectX::ScratchImage image;
+	CHECK(SUCCEEDED(image.Initialize2D(DXGI_FORMAT_R32G32B32A32_FLOAT, 64, 64, 1, 1)));
+	const DirectX::Image& pixels = *image.GetImage(0, 0, 0);
+	for (size_t y = 0; y < 64; ++y) {
+		for (size_t x = 0; x < 64; ++x) {
+			const uint32_t noise = uint32_t((x * 73856093u) ^ (y * 19349663u)) * 2654435761u >> 24;
+			const float fx = float(x) / 64.0f;
+			const float fy = float(y) / 64.0f;
+			float* p = reinterpret_cast<float*>(pixels.pixels + pixels.rowPitch * y + x * 16);
+			if (kind == 0) {
+				const float dx = fx - 0.7f;
+				const float dy = fy - 0.25f;
+				const float sun = 40.0f / (1.0f + 2000.0f * (dx * dx + dy * dy));
+				p[0] = 0.3f + 0.4f * fy + sun; p[1] = 0.5f + 0.3f * fy + sun; p[2] = 1.4f - 0.6f * fy + sun * 0.8f;
+				if (fy > 0.75f) {
+					p[0] = 0.08f + float(noise & 15) / 400.0f; p[1] = 0.1f + float(noise & 15) / 500.0f; p[2] = 0.05f;
+				}
+			} else {
+				const bool window = fx > 0.25f && fx < 0.6f && fy > 0.2f && fy < 0.55f && fabsf(fx - 0.425f) > 0.02f;
+				const float wall = 0.05f + 0.15f * (1.0f - fy) * (1.0f - fabsf(fx - 0.425f)) + float(noise & 7) / 800.0f;
+				p[0] = window ? 6.0f + 4.0f * fy : wall * 1.1f; p[1] = window ? 7.0f + 3.0f * fy : wall; p[2] = window ? 9.0f : wall * 0.8f;
+			}
+			p[3] = 1.0f;
+		}
+	}
+	return image;
+}
+
+// BC6Hを展開した画像と元の画像のRGBの誤差を、log2(1 + x)の空間の1チャンネルあたりのRMSEで返す。明るい画素に引きずられない
+double ComputeBC6HLogRMSE(const DirectX::ScratchImage& source, const DirectX::ScratchImage& compressed) {
+	DirectX::ScratchImage decoded;
+	CHECK(SUCCEEDED(DirectX::Decompress(*compressed.GetImage(0, 0, 0), DXGI_FORMAT_R32G32B32A32_FLOAT, decoded)));
+	const DirectX::Image& a = *source.GetImage(0, 0, 0);
+	const DirectX::Image& b = *decoded.GetImage(0, 0, 0);
+	double sum = 0.0;
+	for (size_t y = 0; y < a.height; ++y) {
+		for (size_t x = 0; x < a.width; ++x) {
+			const float* p = reinterpret_cast<const float*>(a.pixels + a.rowPitch * y + x * 16);
+			const float* q = reinterpret_cast<const float*>(b.pixels + b.rowPitch * y + x * 16);
+			for (size_t c = 0; c < 3; ++c) {
+				const double d = log2(1.0 + double(p[c])) - log2(1.0 + double(q[c]));
+				sum += d * d;
+			}
+		}
+	}
+	return sqrt(sum / double(a.width * a.height * 3));
+}
+
+// block番目のブロックのRGBの二乗誤差を、エンコーダーと同じ半精度浮動小数のビット列の差（ULP）で返す
+double ComputeBC6HBlockError(const DirectX::ScratchImage& source, const DirectX::ScratchImage& compressed, size_t block) {
+	DirectX::ScratchImage sourceHalf;
+	CHECK(SUCCEEDED(DirectX::Convert(*source.GetImage(0, 0, 0), DXGI_FORMAT_R16G16B16A16_FLOAT, DirectX::TEX_FILTER_DEFAULT,
+		DirectX::TEX_THRESHOLD_DEFAULT, sourceHalf)));
+	DirectX::ScratchImage decodedHalf;
+	CHECK(SUCCEEDED(DirectX::Decompress(*compressed.GetImage(0, 0, 0), DXGI_FORMAT_R16G16B16A16_FLOAT, decodedHalf)));
+	const DirectX::Image& a = *sourceHalf.GetImage(0, 0, 0);
+	const DirectX::Image& b = *decodedHalf.GetImage(0, 0, 0);
+	double sum = 0.0;
+	for (size_t y = (block / 4) * 4; y < (block / 4) * 4 + 4; ++y) {
+		for (size_t x = (block % 4) * 4; x < (block % 4) * 4 + 4; ++x) {
+			const uint16_t* p = reinterpret_cast<const uint16_t*>(a.pixels + a.rowPitch * y + x * 8);
+			const uint16_t* q = reinterpret_cast<const uint16_t*>(b.pixels + b.rowPitch * y + x * 8);
+			for (size_t c = 0; c < 3; ++c) {
+				const double d = double(p[c]) - double(q[c]);
+				sum += d * d;
+			}
+		}
+	}
+	return sum;
+}
+
+// BC6Hのブロックのモードを表すビット。下位2ビットが0か1ならその2ビット、それ以外は下位5ビット
+uint8_t GetBC6HModeBits(const uint8_t* block) {
+	return (block[0] & 2) == 0 ? uint8_t(block[0] & 1) : uint8_t(block[0] & 0x1f);
+}
+
+// 圧縮した画像のblock番目のブロックの先頭
+uint8_t* GetBlock(const DirectX::ScratchImage& compressed, size_t block) {
+	const DirectX::Image& image = *compressed.GetImage(0, 0, 0);
+	return image.pixels + image.rowPitch * (block / 4) + (block % 4) * 16;
+}
+
+}
+
+// 既定の品質とBASICは変更前のエンコーダーと同じバイトを出す
+// DirectXTexが速い浮動小数点のときは、両者が同じバイトで、誤差が変更前のバイトの1%以内であることだけを確かめる
+TEST(BC7DefaultAndBasicMatchPreviousEncoder) {
+	DirectX::ScratchImage source = MakeBC7TestImage();
+	DirectX::ScratchImage compressed[2];
+	const DirectX::TEX_COMPRESS_FLAGS qualities[2] = { DirectX::TEX_COMPRESS_DEFAULT, DirectX::TEX_COMPRESS_BC7_BASIC };
+	for (size_t i = 0; i < 2; ++i) {
+		CHECK(SUCCEEDED(DirectX::Compress(*source.GetImage(0, 0, 0), DXGI_FORMAT_BC7_UNORM, qualities[i],
+			DirectX::TEX_THRESHOLD_DEFAULT, compressed[i])));
+	}
+	CHECK(memcmp(compressed[0].GetPixels(), compressed[1].GetPixels(), compressed[0].GetPixelsSize()) == 0);
+
+#if DIRECTXTEX_TESTS_FAST_MATH
+	DirectX::ScratchImage golden;
+	CHECK(SUCCEEDED(golden.Initialize2D(DXGI_FORMAT_BC7_UNORM, 16, 8, 1, 1)));
+	for (size_t block = 0; block < 8; ++block) {
+		memcpy(GetBlock(golden, block), kBC7Golden[block], 16);
+	}
+	float goldenMSE = 0.0f;
+	float mse = 0.0f;
+	CHECK(SUCCEEDED(DirectX::ComputeMSE(*source.GetImage(0, 0, 0), *golden.GetImage(0, 0, 0), goldenMSE, nullptr)));
+	CHECK(SUCCEEDED(DirectX::ComputeMSE(*source.GetImage(0, 0, 0), *compressed[0].GetImage(0, 0, 0), mse, nullptr)));
+	CHECK(mse <= goldenMSE * 1.01f);
+#else
+	for (size_t block = 0; block < 8; ++block) {
+		CHECK(memcmp(GetBlock(compressed[0], block), kBC7Golden[block], 16) == 0);
+	}
+#endif
+}
+
+// 品質を上げても画像全体の誤差は増えない。ULTRAFAST、VERYFAST、FAST、BASICの順に比べる
+// 段階ごとの探索は包含関係にないので、ブロック単位では逆転がある（kBC7Goldenのノイズのブロックでは、FASTの誤差がBASICより0.2%小さい）
+TEST(BC7ErrorDoesNotIncreaseWithQuality) {
+	const DirectX::TEX_COMPRESS_FLAGS qualities[] = {
+		DirectX::TEX_COMPRESS_BC7_ULTRAFAST,
+		DirectX::TEX_COMPRESS_BC7_VERYFAST,
+		DirectX::TEX_COMPRESS_BC7_FAST,
+		DirectX::TEX_COMPRESS_BC7_BASIC,
+	};
+	for (int kind = 0; kind < 2; ++kind) {
+		DirectX::ScratchImage source = MakeBC7QualityImage(kind);
+		float previous = 0.0f;
+		for (size_t i = 0; i < std::size(qualities); ++i) {
+			DirectX::ScratchImage compressed;
+			CHECK(SUCCEEDED(DirectX::Compress(*source.GetImage(0, 0, 0), DXGI_FORMAT_BC7_UNORM, qualities[i],
+				DirectX::TEX_THRESHOLD_DEFAULT, compressed)));
+			float mse = 0.0f;
+			CHECK(SUCCEEDED(DirectX::ComputeMSE(*source.GetImage(0, 0, 0), *compressed.GetImage(0, 0, 0), mse, nullptr)));
+			CHECK(i == 0 || mse <= previous);
+			previous = mse;
+		}
+	}
+}
+
+// 既定のBC6Hの探索は変更前のエンコーダーと同じバイトを出す
+// DirectXTexが速い浮動小数点のときは、8ブロックの半精度の二乗誤差の合計が変更前のバイトの1%以内であることだけを確かめる
+TEST(BC6HDefaultMatchesPreviousEncoder) {
+	DirectX::ScratchImage source = MakeBC6HTestImage();
+	DirectX::ScratchImage compressed;
+	CHECK(SUCCEEDED(DirectX::Compress(*source.GetImage(0, 0, 0), DXGI_FORMAT_BC6H_UF16, DirectX::TEX_COMPRESS_DEFAULT,
+		DirectX::TEX_THRESHOLD_DEFAULT, compressed)));
+
+#if DIRECTXTEX_TESTS_FAST_MATH
+	DirectX::ScratchImage golden;
+	CHECK(SUCCEEDED(golden.Initialize2D(DXGI_FORMAT_BC6H_UF16, 16, 8, 1, 1)));
+	double goldenError = 0.0;
+	double error = 0.0;
+	for (size_t block = 0; block < 8; ++block) {
+		memcpy(GetBlock(golden, block), kBC6HGolden[block], 16);
+		goldenError += ComputeBC6HBlockError(source, golden, block);
+		error += ComputeBC6HBlockError(source, compressed, block);
+	}
+	CHECK(error <= goldenError * 1.01);
+#else
+	for (size_t block = 0; block < 8; ++block) {
+		CHECK(memcmp(GetBlock(compressed, block), kBC6HGolden[block], 16) == 0);
+	}
+#endif
+}
+
+// 高速な探索のlog2(1 + x)の空間のRMSEは、既定の探索の1.25倍以内に収まる（空は1.11倍、室内は1.09倍だった）
+TEST(BC6HFastErrorStaysNearDefault) {
+	for (int kind = 0; kind < 2; ++kind) {
+		DirectX::ScratchImage source = MakeBC6HQualityImage(kind);
+		double rmse[2] = {};
+		const DirectX::TEX_COMPRESS_FLAGS searches[2] = { DirectX::TEX_COMPRESS_DEFAULT, DirectX::TEX_COMPRESS_BC6H_FAST };
+		for (size_t i = 0; i < 2; ++i) {
+			DirectX::ScratchImage compressed;
+			CHECK(SUCCEEDED(DirectX::Compress(*source.GetImage(0, 0, 0), DXGI_FORMAT_BC6H_UF16, searches[i],
+				DirectX::TEX_THRESHOLD_DEFAULT, compressed)));
+			rmse[i] = ComputeBC6HLogRMSE(source, compressed);
+		}
+		CHECK(rmse[0] > 0.0 && rmse[1] <= rmse[0] * 1.25);
+	}
+}
+
+// 高速な探索は、最初に試すモード11（モードのビットが0x03）で半精度の二乗誤差が12*12*3*16以下になればそこで止める
+// 一色のブロックはモード11で止まり、既定の探索はその先のモードで誤差を0にする。太陽のブロックはモード11では足りず先へ進む
+TEST(BC6HFastStopsAtGoodEnoughBlock) {
+	DirectX::ScratchImage source = MakeBC6HTestImage();
+	DirectX::ScratchImage compressed[2];
+	const DirectX::TEX_COMPRESS_FLAGS searches[2] = { DirectX::TEX_COMPRESS_DEFAULT, DirectX::TEX_COMPRESS_BC6H_FAST };
+	for (size_t i = 0; i < 2; ++i) {
+		CHECK(SUCCEEDED(DirectX::Compress(*source.GetImage(0, 0, 0), DXGI_FORMAT_BC6H_UF16, searches[i],
+			DirectX::TEX_THRESHOLD_DEFAULT, compressed[i])));
+	}
+	const double goodEnough = 12.0 * 12.0 * 3.0 * 16.0;
+
+	const size_t flatBlock = 0;
+	const double fastError = ComputeBC6HBlockError(source, compressed[1], flatBlock);
+	CHECK(GetBC6HModeBits(GetBlock(compressed[1], flatBlock)) == 0x03);
+	CHECK(fastError > 0.0 && fastError <= goodEnough);
+	CHECK(ComputeBC6HBlockError(source, compressed[0], flatBlock) < fastError);
+
+	const size_t sunBlock = 2;
+	CHECK(GetBC6HModeBits(GetBlock(compressed[1], sunBlock)) != 0x03);
+	CHECK(ComputeBC6HBlockError(source, compressed[1], sunBlock) > goodEnough);
+}
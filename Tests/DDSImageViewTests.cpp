@@ -0,0 +1,153 @@
+#include "Test.h"
+#include "StubShaderCompiler.h"
+#include "../MappedFile.h"
+#include "../externals/DirectXTex/DirectXTex.h"
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+// DDSファイルの先頭からの位置。マジック(4) + DDS_HEADER(124) + DDS_HEADER_DXT10(20)
+const size_t kHeightOffset = 12;
+const size_t kWidthOffset = 16;
+const size_t kMipCountOffset = 28;
+const size_t kDX10FormatOffset = 128;
+const size_t kDX10ArraySizeOffset = 140;
+const size_t kPixelOffset = 148;
+
+uint32_t ReadUint32(const uint8_t* data, size_t offset) {
+	uint32_t value;
+	memcpy(&value, data + offset, sizeof(value));
+	return value;
+}
+
+// ヘッダーの形式と大きさから1枚の行ピッチとサイズを求める。DirectXTexのComputePitchは使わない
+void GetExpectedPitch(DXGI_FORMAT format, size_t width, size_t height, size_t& rowPitch, size_t& slicePitch) {
+	if (format == DXGI_FORMAT_BC1_UNORM) {
+		size_t blocksWide = width < 4 ? 1 : (width + 3) / 4;
+		size_t blocksHigh = height < 4 ? 1 : (height + 3) / 4;
+		rowPitch = blocksWide * 8;
+		slicePitch = rowPitch * blocksHigh;
+	} else {
+		rowPitch = width * 4;
+		slicePitch = rowPitch * height;
+	}
+}
+
+// 配列2枚・全ミップの画像を作り、全てのバイトに位置ごとに違う値を入れる
+DirectX::ScratchImage MakeArrayImage(DXGI_FORMAT format, size_t width, size_t height) {
+	DirectX::ScratchImage image;
+	CHECK(SUCCEEDED(image.Initialize2D(format, width, height, 2, 0)));
+	uint8_t* pixels = image.GetPixels();
+	for (size_t i = 0; i < image.GetPixelsSize(); ++i) {
+		pixels[i] = uint8_t(i * 7 + i / 251);
+	}
+	return image;
+}
+
+std::vector<uint8_t> SaveDDS(const DirectX::ScratchImage& image) {
+	DirectX::Blob blob;
+	CHECK(SUCCEEDED(DirectX::SaveToDDSMemory(image.GetImages(), image.GetImageCount(), image.GetMetadata(),
+		DirectX::DDS_FLAGS_FORCE_DX10_EXT, blob)));
+	const uint8_t* data = static_cast<const uint8_t*>(blob.GetBufferPointer());
+	return std::vector<uint8_t>(data, data + blob.GetBufferSize());
+}
+
+void WriteBytes(const std::filesystem::path& path, const uint8_t* data, size_t size) {
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(data), std::streamsize(size));
+}
+
+}
+
+// マップしたDDSのビューが、ヘッダーから求めた位置・ピッチ・サイズでファイルの中を直接指す
+TEST(DDSImageViewsPointIntoMappedFile) {
+	TemporaryDirectory directory("dds");
+	for (DXGI_FORMAT format : { DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC1_UNORM }) {
+		// 4の倍数でない大きさで、BCのミップの端が1ブロックに切り上がるようにする
+		DirectX::ScratchImage source = MakeArrayImage(format, 20, 12);
+		std::vector<uint8_t> bytes = SaveDDS(source);
+		std::filesystem::path path = directory.GetPath() / "array.dds";
+		WriteBytes(path, bytes.data(), bytes.size());
+
+		MappedFile file;
+		CHECK(file.Open(path));
+		CHECK(file.GetSize() == bytes.size());
+		const uint8_t* data = file.GetData();
+
+		DirectX::TexMetadata metadata;
+		std::vector<DirectX::Image> images;
+		CHECK(SUCCEEDED(DirectX::GetDDSImageViews(data, file.GetSize(), DirectX::DDS_FLAGS_NONE, metadata, images)));
+
+		const size_t width = ReadUint32(data, kWidthOffset);
+		const size_t height = ReadUint32(data, kHeightOffset);
+		const size_t mipLevels = ReadUint32(data, kMipCountOffset);
+		const size_t arraySize = ReadUint32(data, kDX10ArraySizeOffset);
+		CHECK(ReadUint32(data, kDX10FormatOffset) == uint32_t(format));
+		CHECK(width == 20 && height == 12 && mipLevels == 5 && arraySize == 2);
+		CHECK(metadata.width == width && metadata.height == height && metadata.mipLevels == mipLevels &&
+			metadata.arraySize == arraySize && metadata.format == format);
+		CHECK(images.size() == arraySize * mipLevels);
+		if (images.size() != arraySize * mipLevels) {
+			continue;
+		}
+
+		// 配列の1枚ごとに全ミップが並ぶ
+		size_t offset = kPixelOffset;
+		for (size_t item = 0; item < arraySize; ++item) {
+			size_t mipWidth = width;
+			size_t mipHeight = height;
+			for (size_t level = 0; level < mipLevels; ++level) {
+				const DirectX::Image& view = images[item * mipLevels + level];
+				size_t rowPitch = 0;
+				size_t slicePitch = 0;
+				GetExpectedPitch(format, mipWidth, mipHeight, rowPitch, slicePitch);
+				CHECK(view.pixels == data + offset);
+				CHECK(view.width == mipWidth && view.height == mipHeight && view.format == format);
+				CHECK(view.rowPitch == rowPitch && view.slicePitch == slicePitch);
+
+				const DirectX::Image* sourceImage = source.GetImage(level, item, 0);
+				CHECK(sourceImage->slicePitch == slicePitch);
+				CHECK(memcmp(view.pixels, sourceImage->pixels, slicePitch) == 0);
+
+				offset += slicePitch;
+				mipWidth = mipWidth > 1 ? mipWidth / 2 : 1;
+				mipHeight = mipHeight > 1 ? mipHeight / 2 : 1;
+			}
+		}
+		CHECK(offset == file.GetSize());
+	}
+}
+
+// 途中で切れたファイルや変換が要る読み方はビューを返さない
+TEST(DDSImageViewsRejectTruncatedFiles) {
+	TemporaryDirectory directory("dds");
+	DirectX::ScratchImage source = MakeArrayImage(DXGI_FORMAT_BC1_UNORM, 20, 12);
+	std::vector<uint8_t> bytes = SaveDDS(source);
+
+	// ピクセルが1バイト足りない、ピクセルが無い、ヘッダーの途中で切れている
+	const size_t truncatedSizes[] = { bytes.size() - 1, kPixelOffset, 100 };
+	for (size_t size : truncatedSizes) {
+		std::filesystem::path path = directory.GetPath() / ("truncated" + std::to_string(size) + ".dds");
+		WriteBytes(path, bytes.data(), size);
+		MappedFile file;
+		CHECK(file.Open(path));
+		DirectX::TexMetadata metadata;
+		std::vector<DirectX::Image> images;
+		CHECK(FAILED(DirectX::GetDDSImageViews(file.GetData(), file.GetSize(), DirectX::DDS_FLAGS_NONE, metadata, images)));
+		CHECK(images.empty());
+	}
+
+	// ピクセルだけが足りないときはEOFとして返す
+	DirectX::TexMetadata metadata;
+	std::vector<DirectX::Image> images;
+	CHECK(DirectX::GetDDSImageViews(bytes.data(), bytes.size() - 1, DirectX::DDS_FLAGS_NONE, metadata, images) ==
+		HRESULT_FROM_WIN32(ERROR_HANDLE_EOF));
+
+	// 切れていなくても、ピッチを変える読み方は扱わない
+	CHECK(DirectX::GetDDSImageViews(bytes.data(), bytes.size(), DirectX::DDS_FLAGS_LEGACY_DWORD, metadata, images) ==
+		HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED));
+	CHECK(images.empty());
+	CHECK(SUCCEEDED(DirectX::GetDDSImageViews(bytes.data(), bytes.size(), DirectX::DDS_FLAGS_NONE, metadata, images)));
+}
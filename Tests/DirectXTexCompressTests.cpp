@@ -0,0 +1,264 @@
+#include "Test.h"
+#include "../externals/DirectXTex/DirectXTex.h"
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace {
+
+// 4の倍数でない大きさの全ミップ画像。ミップごとに模様を変え、ブロックの端数も埋める
+DirectX::ScratchImage MakeMipImage(size_t width, size_t height) {
+	DirectX::ScratchImage image;
+	CHECK(SUCCEEDED(image.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, width, height, 1, 0)));
+	for (size_t level = 0; level < image.GetMetadata().mipLevels; ++level) {
+		const DirectX::Image* mip = image.GetImage(level, 0, 0);
+		for (size_t y = 0; y < mip->height; ++y) {
+			uint8_t* row = mip->pixels + mip->rowPitch * y;
+			for (size_t x = 0; x < mip->width; ++x) {
+				uint32_t noise = uint32_t((x * 73856093u) ^ (y * 19349663u) ^ (level * 83492791u));
+				row[x * 4 + 0] = uint8_t(x * 255 / mip->width);
+				row[x * 4 + 1] = uint8_t(y * 255 / mip->height);
+				row[x * 4 + 2] = uint8_t(noise >> 8);
+				row[x * 4 + 3] = uint8_t((x + y) % 7 == 0 ? 0 : 255 - (noise & 63));
+			}
+		}
+	}
+	return image;
+}
+
+// 2つの画像の全ミップのバイトが同じか。ピッチは同じ形式なら一致する
+bool SameImages(const DirectX::ScratchImage& a, const DirectX::ScratchImage& b) {
+	if (a.GetImageCount() != b.GetImageCount() || a.GetMetadata().format != b.GetMetadata().format) {
+		return false;
+	}
+	for (size_t i = 0; i < a.GetImageCount(); ++i) {
+		const DirectX::Image& imageA = a.GetImages()[i];
+		const DirectX::Image& imageB = b.GetImages()[i];
+		if (imageA.slicePitch != imageB.slicePitch || memcmp(imageA.pixels, imageB.pixels, imageA.slicePitch) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// 全てのバイトを疑似乱数で埋めたBCの画像。BC1のcolor0 <= color1の3色のブロックや、BC3の6段階のアルファも必ず含む
+DirectX::ScratchImage MakeRandomBlocks(DXGI_FORMAT format, size_t width, size_t height) {
+	DirectX::ScratchImage image;
+	CHECK(SUCCEEDED(image.Initialize2D(format, width, height, 1, 1)));
+	uint32_t state = 12345u + uint32_t(format);
+	uint8_t* pixels = image.GetPixels();
+	for (size_t i = 0; i < image.GetPixelsSize(); ++i) {
+		state = state * 1664525u + 1013904223u;
+		pixels[i] = uint8_t(state >> 24);
+	}
+	return image;
+}
+
+// Decompressでfloatに展開し、ConvertでRGBA8に直した画像
+DirectX::ScratchImage DecompressThroughFloat(const DirectX::ScratchImage& compressed, DXGI_FORMAT format) {
+	DirectX::ScratchImage decoded;
+	CHECK(SUCCEEDED(DirectX::Decompress(compressed.GetImages(), compressed.GetImageCount(), compressed.GetMetadata(),
+		DXGI_FORMAT_R32G32B32A32_FLOAT, decoded)));
+	DirectX::ScratchImage converted;
+	CHECK(SUCCEEDED(DirectX::Convert(decoded.GetImages(), decoded.GetImageCount(), decoded.GetMetadata(), format,
+		DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, converted)));
+	return converted;
+}
+
+// このプロセスのスレッド数。Linuxでは/proc/self/taskを数え、数えられない環境では0を返す
+size_t CountThreads() {
+	std::error_code error;
+	size_t count = 0;
+	for (std::filesystem::directory_iterator it("/proc/self/task", error), end; !error && it != end; it.increment(error)) {
+		++count;
+	}
+	return error ? 0 : count;
+}
+
+}
+
+// 並列圧縮はスレッド数やタイルの大きさに依らず、逐次のCompressと同じバイトを出す
+TEST(ParallelCompressMatchesSerial) {
+	DirectX::ScratchImage source = MakeMipImage(70, 38);
+	// BC7はタイルの分け方が同じでも既定の品質だと遅いので、QUICKで回す
+	const struct {
+		DXGI_FORMAT format;
+		DirectX::TEX_COMPRESS_FLAGS flags;
+	} cases[] = {
+		{ DXGI_FORMAT_BC1_UNORM, DirectX::TEX_COMPRESS_DEFAULT },
+		{ DXGI_FORMAT_BC3_UNORM, DirectX::TEX_COMPRESS_DEFAULT },
+		{ DXGI_FORMAT_BC7_UNORM, DirectX::TEX_COMPRESS_BC7_QUICK },
+	};
+	for (const auto& c : cases) {
+		DirectX::ScratchImage serial;
+		CHECK(SUCCEEDED(DirectX::Compress(source.GetImages(), source.GetImageCount(), source.GetMetadata(),
+			c.format, c.flags, DirectX::TEX_THRESHOLD_DEFAULT, serial)));
+
+		// 1ブロックのタイルを4スレッドで奪い合う場合と、既定のタイルを3スレッドで分ける場合
+		const size_t settings[][2] = { { 4, 1 }, { 3, 0 }, { 1, 2 } };
+		for (const auto& setting : settings) {
+			DirectX::CompressOptions options;
+			options.flags = c.flags | DirectX::TEX_COMPRESS_PARALLEL;
+			options.threadCount = setting[0];
+			options.tileSize = setting[1];
+			DirectX::ScratchImage parallel;
+			CHECK(SUCCEEDED(DirectX::CompressEx(source.GetImages(), source.GetImageCount(), source.GetMetadata(),
+				c.format, options, parallel)));
+			CHECK(SameImages(serial, parallel));
+		}
+	}
+}
+
+// 進捗コールバックがfalseを返すとE_ABORTで戻り、結果を捨て、戻る前に全てのスレッドを止める
+TEST(CompressCallbackCancels) {
+	// 最初の報告の時点で作業スレッドが終わっていないよう、ブロック数を多くする
+	DirectX::ScratchImage source = MakeMipImage(514, 258);
+	DirectX::CompressOptions options;
+	options.flags = DirectX::TEX_COMPRESS_PARALLEL;
+	options.threadCount = 4;
+	options.tileSize = 1;
+
+	for (size_t cancelAt : { size_t(0), size_t(3) }) {
+		const size_t threadsBefore = CountThreads();
+		size_t threadsDuringCallback = 0;
+		size_t calls = 0;
+		size_t callsAfterCancel = 0;
+		bool cancelled = false;
+		size_t total = 0;
+		auto callback = [&](size_t, size_t count) -> bool {
+			if (cancelled) {
+				++callsAfterCancel;
+				return false;
+			}
+			total = count;
+			threadsDuringCallback = CountThreads();
+			if (calls++ == cancelAt) {
+				cancelled = true;
+				return false;
+			}
+			return true;
+		};
+
+		DirectX::ScratchImage result;
+		CHECK(DirectX::CompressEx(source.GetImages(), source.GetImageCount(), source.GetMetadata(),
+			DXGI_FORMAT_BC1_UNORM, options, result, callback) == E_ABORT);
+		CHECK(cancelled && callsAfterCancel == 0);
+		CHECK(total > 0);
+		CHECK(result.GetImageCount() == 0 && result.GetPixels() == nullptr);
+
+		// 最初の報告で取り消した時点では作業スレッドが居て、戻ったときには全て合流している
+		if (threadsBefore != 0) {
+			CHECK(cancelAt != 0 || threadsDuringCallback > threadsBefore);
+			CHECK(CountThreads() == threadsBefore);
+		}
+	}
+
+	// 取り消さなければ最後に全タイル完了を1度だけ知らせる
+	size_t finished = 0;
+	DirectX::ScratchImage result;
+	CHECK(SUCCEEDED(DirectX::CompressEx(source.GetImages(), source.GetImageCount(), source.GetMetadata(),
+		DXGI_FORMAT_BC1_UNORM, options, result, [&](size_t done, size_t count) {
+			finished += done == count ? 1 : 0;
+			return true;
+		})));
+	CHECK(finished == 1);
+}
+
+// DecompressExはスレッド数に依らず、Decompressと同じ画素を出す
+TEST(DecompressExMatchesDecompress) {
+	DirectX::ScratchImage source = MakeMipImage(70, 38);
+	for (DXGI_FORMAT format : { DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC7_UNORM }) {
+		DirectX::ScratchImage compressed;
+		CHECK(SUCCEEDED(DirectX::Compress(source.GetImages(), source.GetImageCount(), source.GetMetadata(),
+			format, DirectX::TEX_COMPRESS_BC7_QUICK, DirectX::TEX_THRESHOLD_DEFAULT, compressed)));
+
+		// 浮動小数点の出力は8ビットの近道を通らず、Decompressと同じ変換になる
+		for (DXGI_FORMAT target : { DXGI_FORMAT_R32G32B32A32_FLOAT, DXGI_FORMAT_R16G16B16A16_UNORM }) {
+			DirectX::ScratchImage reference;
+			CHECK(SUCCEEDED(DirectX::Decompress(compressed.GetImages(), compressed.GetImageCount(),
+				compressed.GetMetadata(), target, reference)));
+			for (size_t threadCount : { size_t(1), size_t(3) }) {
+				DirectX::DecompressOptions options;
+				options.threadCount = threadCount;
+				DirectX::ScratchImage result;
+				CHECK(SUCCEEDED(DirectX::DecompressEx(compressed.GetImages(), compressed.GetImageCount(),
+					compressed.GetMetadata(), target, options, result)));
+				CHECK(SameImages(reference, result));
+			}
+		}
+
+		// 1枚だけの版も同じ
+		DirectX::ScratchImage reference;
+		CHECK(SUCCEEDED(DirectX::Decompress(*compressed.GetImage(1, 0, 0), DXGI_FORMAT_R32G32B32A32_FLOAT, reference)));
+		DirectX::ScratchImage result;
+		CHECK(SUCCEEDED(DirectX::DecompressEx(*compressed.GetImage(1, 0, 0), DXGI_FORMAT_R32G32B32A32_FLOAT,
+			DirectX::DecompressOptions{ 2 }, result)));
+		CHECK(SameImages(reference, result));
+	}
+}
+
+// BC1〜BC5とBC7をRGBA8へ直接展開した結果は、floatに展開してRGBA8に変換した結果と1バイトも違わない
+// 乱数のブロックで全ての補間の丸めを通し、圧縮した画像でBC1の抜きやミップの端数のブロックを通す
+TEST(DecompressExRGBA8MatchesFloatDecode) {
+	DirectX::ScratchImage source = MakeMipImage(70, 38);
+	const DXGI_FORMAT formats[] = {
+		DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC2_UNORM, DXGI_FORMAT_BC3_UNORM,
+		DXGI_FORMAT_BC4_UNORM, DXGI_FORMAT_BC5_UNORM, DXGI_FORMAT_BC7_UNORM,
+	};
+	for (DXGI_FORMAT format : formats) {
+		DirectX::ScratchImage compressed[2];
+		compressed[0] = MakeRandomBlocks(format, 64, 64);
+		CHECK(SUCCEEDED(DirectX::Compress(source.GetImages(), source.GetImageCount(), source.GetMetadata(),
+			format, DirectX::TEX_COMPRESS_BC7_QUICK, DirectX::TEX_THRESHOLD_DEFAULT, compressed[1])));
+		for (const DirectX::ScratchImage& blocks : compressed) {
+			DirectX::ScratchImage reference = DecompressThroughFloat(blocks, DXGI_FORMAT_R8G8B8A8_UNORM);
+			DirectX::ScratchImage direct;
+			CHECK(SUCCEEDED(DirectX::DecompressEx(blocks.GetImages(), blocks.GetImageCount(), blocks.GetMetadata(),
+				DXGI_FORMAT_R8G8B8A8_UNORM, DirectX::DecompressOptions{ 2 }, direct)));
+			CHECK(SameImages(reference, direct));
+
+			// BC4は灰色をRGBに複製し、BC5は青を0にする。どちらもアルファは255
+			if (format == DXGI_FORMAT_BC4_UNORM || format == DXGI_FORMAT_BC5_UNORM) {
+				const uint8_t* pixels = direct.GetPixels();
+				bool expanded = true;
+				for (size_t i = 0; i < direct.GetPixelsSize(); i += 4) {
+					const bool rgb = format == DXGI_FORMAT_BC4_UNORM ?
+						pixels[i + 1] == pixels[i] && pixels[i + 2] == pixels[i] : pixels[i + 2] == 0;
+					expanded = expanded && rgb && pixels[i + 3] == 255;
+				}
+				CHECK(expanded);
+			}
+		}
+
+		// BC1は元のアルファが閾値より小さい画素を透明な黒にする
+		if (format == DXGI_FORMAT_BC1_UNORM) {
+			DirectX::ScratchImage direct;
+			CHECK(SUCCEEDED(DirectX::DecompressEx(compressed[1].GetImages(), compressed[1].GetImageCount(),
+				compressed[1].GetMetadata(), DXGI_FORMAT_R8G8B8A8_UNORM, DirectX::DecompressOptions{ 1 }, direct)));
+			const DirectX::Image& top = *direct.GetImage(0, 0, 0);
+			const DirectX::Image& original = *source.GetImage(0, 0, 0);
+			size_t transparent = 0;
+			bool punchThrough = true;
+			for (size_t y = 0; y < top.height; ++y) {
+				for (size_t x = 0; x < top.width; ++x) {
+					const uint8_t* texel = top.pixels + top.rowPitch * y + x * 4;
+					const bool clear = original.pixels[original.rowPitch * y + x * 4 + 3] < 128;
+					transparent += clear ? 1 : 0;
+					punchThrough = punchThrough && (clear ? texel[0] == 0 && texel[1] == 0 && texel[2] == 0 && texel[3] == 0 : texel[3] == 255);
+				}
+			}
+			CHECK(transparent > 0 && punchThrough);
+		}
+	}
+
+	// sRGBの形式はsRGBのRGBA8へ、変換なしで同じバイトになる
+	for (DXGI_FORMAT format : { DXGI_FORMAT_BC1_UNORM_SRGB, DXGI_FORMAT_BC3_UNORM_SRGB, DXGI_FORMAT_BC7_UNORM_SRGB }) {
+		DirectX::ScratchImage blocks = MakeRandomBlocks(format, 32, 32);
+		DirectX::ScratchImage reference;
+		CHECK(SUCCEEDED(DirectX::Decompress(*blocks.GetImage(0, 0, 0), DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, reference)));
+		DirectX::ScratchImage direct;
+		CHECK(SUCCEEDED(DirectX::DecompressEx(*blocks.GetImage(0, 0, 0), DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,
+			DirectX::DecompressOptions{ 1 }, direct)));
+		CHECK(SameImages(reference, direct));
+	}
+}
@@ -0,0 +1,9 @@
+#pragma once
+// DirectXTexが速い浮動小数点（/fp:fast、-ffast-math）で作られているか。バイト単位の一致を確かめるテストは、そのときだけ誤差の比較に替える
+// Tests.vcxprojが参照するDirectXTexのプロジェクトは/fp:fastなので、Tests.vcxprojでDIRECTXTEX_FAST_MATHを定義する
+// CMakeではDirectXTexもテストも同じフラグで作るので、テスト側のコンパイラーの定義で分かる
+#if defined(DIRECTXTEX_FAST_MATH) || defined(__FAST_MATH__) || defined(_M_FP_FAST)
+#define DIRECTXTEX_TESTS_FAST_MATH 1
+#else
+#define DIRECTXTEX_TESTS_FAST_MATH 0
+#endif
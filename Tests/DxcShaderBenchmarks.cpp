@@ -0,0 +1,131 @@
+#include "Test.h"
+#include "../DxcShaderCompiler.h"
+#include "../ShaderBuildProfile.h"
+#include "../ShaderCache.h"
+#include "../ThreadPool.h"
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// ゲームと同じObject3dのシェーダー。VSと、PSのTEXTURED/ALPHA_TESTの4通り
+// 同じものばかりだとキーが重なるので、copyごとに使わないマクロを足して別のシェーダーとして数える
+std::vector<ShaderCompileRequest> MakeObject3dRequests(ShaderBuildProfile profile, const std::filesystem::path& pdbDirectory, int copyCount) {
+	const std::filesystem::path sourceDirectory = std::filesystem::path(__FILE__).parent_path().parent_path();
+	std::vector<ShaderCompileRequest> requests;
+	for (int copy = 0; copy < copyCount; ++copy) {
+		for (int variant = -1; variant < 4; ++variant) {
+			ShaderCompileRequest request;
+			if (variant < 0) {
+				request.filePath = sourceDirectory / "Object3d.VS.hlsl";
+				request.profile = L"vs_6_0";
+			} else {
+				request.filePath = sourceDirectory / "Object3d.PS.hlsl";
+				request.profile = L"ps_6_0";
+				request.defines = {
+					std::wstring(L"TEXTURED=") + ((variant & 1) != 0 ? L"1" : L"0"),
+					std::wstring(L"ALPHA_TEST=") + ((variant & 2) != 0 ? L"1" : L"0"),
+				};
+			}
+			request.defines.push_back(L"BENCHMARK_COPY=" + std::to_wstring(copy));
+			request.arguments = { L"-Zpr" };
+			ApplyShaderBuildProfile(profile, pdbDirectory, request);
+			requests.push_back(request);
+		}
+	}
+	return requests;
+}
+
+// ディレクトリの中のファイルの数と合計の大きさ
+std::pair<size_t, uint64_t> GetDirectorySize(const std::filesystem::path& directory) {
+	size_t count = 0;
+	uint64_t bytes = 0;
+	std::error_code errorCode;
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, errorCode)) {
+		if (entry.is_regular_file()) {
+			++count;
+			bytes += entry.file_size();
+		}
+	}
+	return { count, bytes };
+}
+
+}
+
+// DXCでのまとめてコンパイルの速さ。スレッド数ごとに、空のキャッシュからのコンパイルと、全てキャッシュに当たる2回目を測る
+// DebugとReleaseのバイナリとPDBの大きさ、1スレッドでのコンパイル時間も並べて比べる
+BENCHMARK(dxc) {
+	const int kCopyCount = 16;
+	DxcShaderCompiler compiler;
+	compiler.Initialize();
+	printf("%s\n", compiler.GetVersionString().c_str());
+
+	std::vector<uint32_t> threadCounts = { 1, 2, 4 };
+	threadCounts.push_back(std::max(1u, std::thread::hardware_concurrency()));
+	threadCounts.erase(std::remove_if(threadCounts.begin(), threadCounts.end(),
+		[](uint32_t count) { return count > std::max(1u, std::thread::hardware_concurrency()); }), threadCounts.end());
+	threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()), threadCounts.end());
+
+	struct ProfileSummary {
+		ShaderBuildProfile profile;
+		double secondsPerShader;
+		uint64_t objectBytes;
+		size_t pdbCount;
+		uint64_t pdbBytes;
+	};
+	std::vector<ProfileSummary> summaries;
+	for (ShaderBuildProfile profile : { ShaderBuildProfile::Debug, ShaderBuildProfile::Release }) {
+		double singleThreadSeconds = 0.0;
+		for (uint32_t threadCount : threadCounts) {
+			std::filesystem::path directory = std::filesystem::temp_directory_path() / ("DxcShaderBenchmarks-" + std::to_string(std::random_device()()));
+			std::vector<ShaderCompileRequest> requests = MakeObject3dRequests(profile, directory / "pdb", kCopyCount);
+			ShaderCache cache;
+			cache.Initialize(directory / "cache", &compiler);
+			ThreadPool threadPool(threadCount);
+
+			std::vector<ShaderCompileResult> results;
+			Stopwatch coldStopwatch;
+			std::vector<std::future<ShaderCompileResult>> futures = cache.CompileBatch(requests, threadPool);
+			ShaderBatchDiagnostics cold = ShaderCache::WaitForBatch(requests, futures, results);
+			double coldSeconds = coldStopwatch.GetSeconds();
+			CHECK(cold.failedCount == 0 && cold.cachedCount == 0);
+
+			Stopwatch warmStopwatch;
+			futures = cache.CompileBatch(requests, threadPool);
+			ShaderBatchDiagnostics warm = ShaderCache::WaitForBatch(requests, futures, results);
+			double warmSeconds = warmStopwatch.GetSeconds();
+			CHECK(warm.failedCount == 0 && warm.cachedCount == requests.size());
+
+			if (threadCount == threadCounts.front()) {
+				singleThreadSeconds = coldSeconds;
+				uint64_t objectBytes = 0;
+				for (const ShaderCompileResult& result : results) {
+					objectBytes += result.object.size();
+				}
+				auto [pdbCount, pdbBytes] = GetDirectorySize(directory / "pdb");
+				// ReleaseはデバッグをPDBへ外し、Debugはバイナリに埋め込むのでPDBは無い
+				CHECK((profile == ShaderBuildProfile::Release) == (pdbCount != 0));
+				summaries.push_back({ profile, coldSeconds / double(requests.size()), objectBytes, pdbCount, pdbBytes });
+			}
+			printf("%s, %u threads, %zu shaders: compile %.1f ms (%.2f ms per shader, x%.2f), cached %.1f ms\n",
+				GetShaderBuildProfileName(profile), threadCount, requests.size(), coldSeconds * 1e3, coldSeconds * 1e3 / double(requests.size()),
+				singleThreadSeconds / coldSeconds, warmSeconds * 1e3);
+			if (!cold.messages.empty()) {
+				printf("%s\n", cold.messages.c_str());
+			}
+
+			std::error_code errorCode;
+			std::filesystem::remove_all(directory, errorCode);
+		}
+	}
+	printf("%8s %16s %16s %16s\n", "profile", "ms per shader", "object bytes", "pdb bytes");
+	for (const ProfileSummary& summary : summaries) {
+		printf("%8s %16.2f %16llu %9llu (%zu files)\n", GetShaderBuildProfileName(summary.profile), summary.secondsPerShader * 1e3,
+			static_cast<unsigned long long>(summary.objectBytes), static_cast<unsigned long long>(summary.pdbBytes), summary.pdbCount);
+	}
+	compiler.Finalize();
+}
@@ -0,0 +1,166 @@
+#include "Test.h"
+#include "RecordingGpuTimeline.h"
+#include "../FrameRing.h"
+#include <vector>
+
+namespace {
+
+// 記録のうちWaitだけを取り出す
+std::vector<uint64_t> GetWaitValues(const RecordingGpuTimeline& timeline) {
+	std::vector<uint64_t> values;
+	for (const RecordingGpuTimeline::Event& event : timeline.GetEvents()) {
+		if (event.type == RecordingGpuTimeline::EventType::kWait) {
+			values.push_back(event.value);
+		}
+	}
+	return values;
+}
+
+// GPUがlagフレーム遅れで追いかけるとして、frameCount個の区画でフレームを回したときに待った回数
+uint64_t CountStalls(uint32_t frameCount, uint32_t lag, int frames) {
+	RecordingGpuTimeline timeline;
+	FrameRing ring;
+	ring.Initialize(&timeline, frameCount);
+	std::vector<uint64_t> endValues;
+	for (int frame = 0; frame < frames; ++frame) {
+		ring.BeginFrame();
+		endValues.push_back(ring.EndFrame());
+		if (endValues.size() > lag) {
+			timeline.CompleteUpTo(endValues[endValues.size() - 1 - lag]);
+		}
+	}
+	CHECK(timeline.GetInvalidWaitCount() == 0);
+	return ring.GetStallCount();
+}
+
+}
+
+// GPUの遅れがframeCount-1フレームまでなら待たない。それ以上遅れると毎フレーム待つ
+TEST(FrameRingWaitsOnlyWhenLappingGpu) {
+	for (uint32_t frameCount = 1; frameCount <= FrameRing::kMaxFrameCount; ++frameCount) {
+		CHECK(CountStalls(frameCount, 0, 100) == 0);
+		CHECK(CountStalls(frameCount, frameCount - 1, 100) == 0);
+		CHECK(CountStalls(frameCount, frameCount, 100) == 100 - frameCount);
+	}
+}
+
+// GPUが止まっているとき、n番目のフレームはn-frameCount番目のフレームのSignal値を待つ
+TEST(FrameRingWaitsForFenceOfSameSlot) {
+	const uint32_t kFrameCount = 3;
+	RecordingGpuTimeline timeline;
+	FrameRing ring;
+	ring.Initialize(&timeline, kFrameCount);
+	std::vector<uint64_t> endValues;
+	for (uint32_t frame = 0; frame < 10; ++frame) {
+		timeline.ClearEvents();
+		CHECK(ring.BeginFrame() == frame % kFrameCount);
+		std::vector<uint64_t> waits = GetWaitValues(timeline);
+		if (frame < kFrameCount) {
+			CHECK(waits.empty());
+		} else {
+			CHECK(waits.size() == 1 && waits[0] == endValues[frame - kFrameCount]);
+		}
+		endValues.push_back(ring.EndFrame());
+	}
+	CHECK(ring.GetStallCount() == 10 - kFrameCount);
+	CHECK(timeline.GetInvalidWaitCount() == 0);
+}
+
+// Signal値はフレームごとに1ずつ増え、待つ値は既にSignalした値だけで、減ることもない
+TEST(FrameRingFenceValuesAreOrdered) {
+	RecordingGpuTimeline timeline;
+	FrameRing ring;
+	ring.Initialize(&timeline, 2);
+	uint64_t lastEndValue = 0;
+	for (int frame = 0; frame < 50; ++frame) {
+		ring.BeginFrame();
+		uint64_t endValue = ring.EndFrame();
+		CHECK(endValue == lastEndValue + 1);
+		lastEndValue = endValue;
+		// 3フレームに1回だけGPUを進める
+		if (frame % 3 == 0) {
+			timeline.CompleteUpTo(endValue);
+		}
+	}
+	uint64_t signaled = 0;
+	uint64_t lastWait = 0;
+	for (const RecordingGpuTimeline::Event& event : timeline.GetEvents()) {
+		if (event.type == RecordingGpuTimeline::EventType::kSignal) {
+			CHECK(event.value == signaled + 1);
+			signaled = event.value;
+		} else {
+			CHECK(event.value <= signaled);
+			CHECK(event.value >= lastWait);
+			lastWait = event.value;
+		}
+	}
+	CHECK(timeline.GetInvalidWaitCount() == 0);
+}
+
+// WaitForIdleは新しいSignalを積んでそれを待つ。その後のフレームは待たない
+TEST(FrameRingWaitForIdleDrainsGpu) {
+	const uint32_t kFrameCount = 3;
+	RecordingGpuTimeline timeline;
+	FrameRing ring;
+	ring.Initialize(&timeline, kFrameCount);
+	for (uint32_t frame = 0; frame < kFrameCount; ++frame) {
+		ring.BeginFrame();
+		ring.EndFrame();
+	}
+	timeline.ClearEvents();
+	ring.WaitForIdle();
+	const std::vector<RecordingGpuTimeline::Event>& events = timeline.GetEvents();
+	CHECK(events.size() == 2);
+	CHECK(events[0].type == RecordingGpuTimeline::EventType::kSignal && events[0].value == kFrameCount + 1);
+	CHECK(events[1].type == RecordingGpuTimeline::EventType::kWait && events[1].value == kFrameCount + 1);
+	CHECK(timeline.GetCompletedValue() == timeline.GetLastSignaledValue());
+
+	timeline.ClearEvents();
+	for (uint32_t frame = 0; frame < kFrameCount; ++frame) {
+		ring.BeginFrame();
+		ring.EndFrame();
+	}
+	CHECK(GetWaitValues(timeline).empty());
+	CHECK(ring.GetStallCount() == 0);
+}
+
+// 預けた解放は、その時点までに積んだフレーム（フレームの中ならそのフレーム）をGPUが終えてから呼ばれる
+TEST(FrameRingDefersReleaseUntilGpuFinishes) {
+	RecordingGpuTimeline timeline;
+	FrameRing ring;
+	ring.Initialize(&timeline, 2);
+	std::vector<char> released;
+	auto defer = [&](char name) { ring.DeferRelease([&released, name]() { released.push_back(name); }); };
+
+	// まだ何も積んでいなければすぐ解放する
+	defer('a');
+	CHECK(released == std::vector<char>{ 'a' });
+
+	ring.BeginFrame();
+	uint64_t firstFrame = ring.EndFrame();
+	// フレームの外で預けたものは、最後に積んだフレームを待つ
+	defer('b');
+	ring.BeginFrame();
+	// フレームの中で預けたものは、このフレームを待つ
+	defer('c');
+	uint64_t secondFrame = ring.EndFrame();
+	CHECK(released.size() == 1);
+	CHECK(ring.GetPendingReleaseCount() == 2);
+
+	timeline.CompleteUpTo(firstFrame);
+	ring.BeginFrame();
+	CHECK(released == (std::vector<char>{ 'a', 'b' }));
+	ring.EndFrame();
+	timeline.CompleteUpTo(secondFrame);
+	ring.BeginFrame();
+	CHECK(released == (std::vector<char>{ 'a', 'b', 'c' }));
+	ring.EndFrame();
+
+	// WaitForIdleはGPUを待ってから残りを全て解放する
+	defer('d');
+	CHECK(released.size() == 3);
+	ring.WaitForIdle();
+	CHECK(released == (std::vector<char>{ 'a', 'b', 'c', 'd' }));
+	CHECK(ring.GetPendingReleaseCount() == 0);
+	CHECK(timeline.GetInvalidWaitCount() == 0);
+}
@@ -0,0 +1,233 @@
+#include "Test.h"
+#include "../GpuMemoryAllocator.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+// ID3D12Heapの代わりに、作られたHeapの情報だけを持つ
+class FakeHeapProvider : public IGpuHeapProvider {
+public:
+	struct FakeHeap {
+		GpuHeapDesc desc;
+		// このHeapに今ある割り当て。オフセット→終端
+		std::map<uint64_t, uint64_t> ranges;
+	};
+
+	void* CreateHeap(const GpuHeapDesc& desc) override {
+		heaps_.push_back(std::make_unique<FakeHeap>());
+		heaps_.back()->desc = desc;
+		++createCount_;
+		return heaps_.back().get();
+	}
+	void DestroyHeap(void* heap) override {
+		auto it = std::find_if(heaps_.begin(), heaps_.end(), [heap](const std::unique_ptr<FakeHeap>& h) { return h.get() == heap; });
+		CHECK(it != heaps_.end());
+		if (it != heaps_.end()) {
+			// 割り当てが残っているHeapを返してはいけない
+			CHECK((*it)->ranges.empty());
+			heaps_.erase(it);
+		}
+		++destroyCount_;
+	}
+
+	size_t GetLiveHeapCount() const { return heaps_.size(); }
+	uint32_t GetCreateCount() const { return createCount_; }
+	uint32_t GetDestroyCount() const { return destroyCount_; }
+
+private:
+	std::vector<std::unique_ptr<FakeHeap>> heaps_;
+	uint32_t createCount_ = 0;
+	uint32_t destroyCount_ = 0;
+};
+
+struct LiveAllocation {
+	GpuMemoryAllocation allocation;
+	GpuHeapType heapType;
+	GpuResourceCategory category;
+};
+
+}
+
+// 全てのプールに対して割り当てと解放を乱数で20万回行う
+// 同じHeapの中で重ならないこと、配置単位を守ること、Heapの種類と分類が合っていること、最後に全てのHeapが返ることを見る
+TEST(GpuMemoryAllocatorRandomOperations) {
+	const uint64_t kHeapSize = 16ull * 1024 * 1024;
+	const int kOperationCount = 200000;
+	std::mt19937 random(8);
+	std::uniform_int_distribution<int> heapTypeDistribution(0, int(GpuHeapType::Count) - 1);
+	std::uniform_int_distribution<int> categoryDistribution(0, int(GpuResourceCategory::Count) - 1);
+	std::uniform_int_distribution<int> percent(0, 99);
+	// 大半は64KB以下の小さなバッファ、たまに数MBのテクスチャとHeapより大きなもの
+	std::uniform_int_distribution<uint64_t> smallSize(256, 64 * 1024);
+	std::uniform_int_distribution<uint64_t> largeSize(64 * 1024, 4 * 1024 * 1024);
+
+	FakeHeapProvider provider;
+	GpuMemoryAllocator allocator;
+	allocator.Initialize(&provider, kHeapSize);
+	std::vector<LiveAllocation> live;
+	int misplaced = 0;
+	int overlaps = 0;
+
+	for (int operation = 0; operation < kOperationCount; ++operation) {
+		// 生きている割り当てが2000前後で行き来するように、多いときは解放を増やす
+		bool allocate = live.empty() || percent(random) < (live.size() < 2000 ? 60 : 40);
+		if (!allocate) {
+			size_t index = std::uniform_int_distribution<size_t>(0, live.size() - 1)(random);
+			const GpuMemoryAllocation& allocation = live[index].allocation;
+			static_cast<FakeHeapProvider::FakeHeap*>(allocation.heap)->ranges.erase(allocation.offset);
+			allocator.Free(allocation);
+			live[index] = live.back();
+			live.pop_back();
+			continue;
+		}
+
+		GpuHeapType heapType = GpuHeapType(heapTypeDistribution(random));
+		GpuResourceCategory category = GpuResourceCategory(categoryDistribution(random));
+		int kind = percent(random);
+		uint64_t size = kind == 0 ? kHeapSize + smallSize(random) : kind < 10 ? largeSize(random) : smallSize(random);
+		// PlacedResourceの配置単位。MSAAのテクスチャは4MB
+		uint64_t alignment = kind < 3 ? 4ull * 1024 * 1024 : GpuMemoryAllocator::kMinBlockSize;
+		GpuMemoryAllocation allocation = allocator.Allocate(heapType, category, size, alignment);
+
+		FakeHeapProvider::FakeHeap* heap = static_cast<FakeHeapProvider::FakeHeap*>(allocation.heap);
+		if (heap == nullptr || heap->desc.heapType != heapType || heap->desc.category != category || allocation.size != size ||
+			allocation.offset % alignment != 0 || allocation.offset + size > heap->desc.size) {
+			++misplaced;
+			continue;
+		}
+		// 直前と直後の割り当てに重ならないこと
+		auto next = heap->ranges.lower_bound(allocation.offset);
+		if (next != heap->ranges.end() && next->first < allocation.offset + size) {
+			++overlaps;
+		}
+		if (next != heap->ranges.begin() && std::prev(next)->second > allocation.offset) {
+			++overlaps;
+		}
+		heap->ranges.emplace(allocation.offset, allocation.offset + size);
+		live.push_back({ allocation, heapType, category });
+	}
+	CHECK(misplaced == 0);
+	CHECK(overlaps == 0);
+
+	// 統計は生きている割り当てと一致する
+	for (uint32_t heapType = 0; heapType < uint32_t(GpuHeapType::Count); ++heapType) {
+		for (uint32_t category = 0; category < uint32_t(GpuResourceCategory::Count); ++category) {
+			uint64_t requestedBytes = 0;
+			uint64_t allocationCount = 0;
+			uint32_t dedicatedCount = 0;
+			for (const LiveAllocation& allocation : live) {
+				if (allocation.heapType != GpuHeapType(heapType) || allocation.category != GpuResourceCategory(category)) {
+					continue;
+				}
+				if (allocation.allocation.dedicated) {
+					++dedicatedCount;
+				} else {
+					requestedBytes += allocation.allocation.size;
+					++allocationCount;
+				}
+			}
+			GpuMemoryAllocator::PoolStatistics statistics = allocator.GetStatistics(GpuHeapType(heapType), GpuResourceCategory(category));
+			CHECK(statistics.requestedBytes == requestedBytes);
+			CHECK(statistics.allocationCount == allocationCount);
+			CHECK(statistics.dedicatedCount == dedicatedCount);
+			CHECK(statistics.usedBytes >= statistics.requestedBytes);
+			CHECK(statistics.reservedBytes == uint64_t(statistics.heapCount) * kHeapSize);
+			CHECK(statistics.fragmentation >= 0.0f && statistics.fragmentation <= 1.0f);
+		}
+	}
+
+	for (const LiveAllocation& allocation : live) {
+		static_cast<FakeHeapProvider::FakeHeap*>(allocation.allocation.heap)->ranges.erase(allocation.allocation.offset);
+		allocator.Free(allocation.allocation);
+	}
+	allocator.Finalize();
+	CHECK(provider.GetLiveHeapCount() == 0);
+	CHECK(provider.GetCreateCount() == provider.GetDestroyCount());
+}
+
+// 断片化はHeapごとに見る。まとまった空きを持つHeapが複数あっても断片化していない
+TEST(GpuMemoryAllocatorFragmentationIsPerHeap) {
+	const uint64_t kHeapSize = 1024 * 1024;
+	const uint64_t kBlock = GpuMemoryAllocator::kMinBlockSize;
+	FakeHeapProvider provider;
+	GpuMemoryAllocator allocator;
+	allocator.Initialize(&provider, kHeapSize);
+	auto allocate = [&](uint64_t size) { return allocator.Allocate(GpuHeapType::Default, GpuResourceCategory::Buffer, size, kBlock); };
+	auto getStatistics = [&]() { return allocator.GetStatistics(GpuHeapType::Default, GpuResourceCategory::Buffer); };
+
+	// 2つのHeapの後ろ半分がそれぞれ空いている
+	GpuMemoryAllocation first = allocate(kHeapSize / 2);
+	GpuMemoryAllocation second = allocate(kHeapSize / 2);
+	GpuMemoryAllocation third = allocate(kHeapSize / 2);
+	allocator.Free(second);
+	GpuMemoryAllocator::PoolStatistics statistics = getStatistics();
+	CHECK(statistics.heapCount == 2);
+	CHECK(statistics.largestFreeBlock == kHeapSize / 2);
+	CHECK(statistics.fragmentation == 0.0f);
+
+	// 最小ブロックで2つのHeapの空きと3つ目のHeapを埋め、3つ目のHeapだけ1つおきに返す
+	// 3つ目のHeapの空きは8つの64KBに分かれる
+	std::vector<GpuMemoryAllocation> blocks;
+	for (uint64_t i = 0; i < 2 * kHeapSize / kBlock; ++i) {
+		blocks.push_back(allocate(kBlock));
+	}
+	statistics = getStatistics();
+	CHECK(statistics.heapCount == 3);
+	void* thirdHeap = blocks.back().heap;
+	int freed = 0;
+	for (size_t i = 0; i < blocks.size(); ++i) {
+		if (blocks[i].heap == thirdHeap && blocks[i].offset % (2 * kBlock) == 0) {
+			allocator.Free(blocks[i]);
+			++freed;
+		}
+	}
+	CHECK(freed == 8);
+	statistics = getStatistics();
+	// 空きは3つ目のHeapの512KBだけで、そのうち最大ブロック以外の448KBが細切れ
+	CHECK(statistics.fragmentation == float(7.0 * double(kBlock) / double(8 * kBlock)));
+
+	for (size_t i = 0; i < blocks.size(); ++i) {
+		if (!(blocks[i].heap == thirdHeap && blocks[i].offset % (2 * kBlock) == 0)) {
+			allocator.Free(blocks[i]);
+		}
+	}
+	allocator.Free(first);
+	allocator.Free(third);
+	allocator.Finalize();
+	CHECK(provider.GetLiveHeapCount() == 0);
+}
+
+// 割り当てと解放1回あたりの時間
+BENCHMARK(gpumemory) {
+	const int kOperationCount = 1000000;
+	std::mt19937 random(9);
+	std::uniform_int_distribution<int> percent(0, 99);
+	std::uniform_int_distribution<uint64_t> size(256, 1024 * 1024);
+	FakeHeapProvider provider;
+	GpuMemoryAllocator allocator;
+	allocator.Initialize(&provider);
+	std::vector<GpuMemoryAllocation> live;
+	Stopwatch stopwatch;
+	for (int operation = 0; operation < kOperationCount; ++operation) {
+		if (live.empty() || percent(random) < (live.size() < 2000 ? 60 : 40)) {
+			live.push_back(allocator.Allocate(GpuHeapType::Default, GpuResourceCategory::Texture, size(random), GpuMemoryAllocator::kMinBlockSize));
+		} else {
+			size_t index = size_t(percent(random)) * live.size() / 100;
+			allocator.Free(live[index]);
+			live[index] = live.back();
+			live.pop_back();
+		}
+	}
+	double seconds = stopwatch.GetSeconds();
+	GpuMemoryAllocator::PoolStatistics statistics = allocator.GetStatistics(GpuHeapType::Default, GpuResourceCategory::Texture);
+	printf("%.1f ns per operation, %zu live, %u heaps, fragmentation %.2f\n", seconds * 1e9 / kOperationCount, live.size(),
+		statistics.heapCount, statistics.fragmentation);
+	for (const GpuMemoryAllocation& allocation : live) {
+		allocator.Free(allocation);
+	}
+	allocator.Finalize();
+}
@@ -0,0 +1,169 @@
+#include "Test.h"
+#include "../LinearUploadAllocator.h"
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+// UploadHeapの代わりにnewしたメモリをページとして渡す
+// GPUアドレスはページごとに離れた値を振り、CPUアドレスと同じオフセットで対応させる
+class HeapPageProvider : public IUploadPageProvider {
+public:
+	~HeapPageProvider() override {
+		for (uint8_t* memory : liveMemory_) {
+			delete[] memory;
+		}
+	}
+
+	UploadPage CreatePage(size_t size) override {
+		UploadPage page;
+		page.cpuAddress = new uint8_t[size];
+		page.gpuAddress = nextGpuAddress_;
+		page.size = size;
+		page.handle = page.cpuAddress;
+		nextGpuAddress_ += (size + kGpuAddressSpacing - 1) / kGpuAddressSpacing * kGpuAddressSpacing + kGpuAddressSpacing;
+		liveMemory_.push_back(page.cpuAddress);
+		++createCount_;
+		return page;
+	}
+	void DestroyPage(const UploadPage& page) override {
+		auto it = std::find(liveMemory_.begin(), liveMemory_.end(), page.handle);
+		CHECK(it != liveMemory_.end());
+		if (it != liveMemory_.end()) {
+			delete[] *it;
+			liveMemory_.erase(it);
+		}
+		++destroyCount_;
+	}
+
+	size_t GetLivePageCount() const { return liveMemory_.size(); }
+	uint32_t GetCreateCount() const { return createCount_; }
+	uint32_t GetDestroyCount() const { return destroyCount_; }
+
+private:
+	static constexpr uint64_t kGpuAddressSpacing = 1ull << 32;
+	uint64_t nextGpuAddress_ = kGpuAddressSpacing;
+	std::vector<uint8_t*> liveMemory_;
+	uint32_t createCount_ = 0;
+	uint32_t destroyCount_ = 0;
+};
+
+struct RecordedAllocation {
+	UploadAllocation allocation;
+	size_t alignment;
+	uint32_t stamp;
+};
+
+}
+
+// 1フレームに10万回の割り当てを何フレームも繰り返す
+// 整列・重なり・書き込んだ内容を確かめ、2フレーム目以降はページを作り足さないことを見る
+TEST(LinearUploadAllocatorStress) {
+	const int kAllocationsPerFrame = 100000;
+	const int kFrameCount = 4;
+	const size_t kPageSize = 256 * 1024;
+	std::mt19937 random(7);
+	// 先頭と末尾に書く印が重ならない大きさから
+	std::uniform_int_distribution<size_t> smallSize(8, 512);
+	std::uniform_int_distribution<int> kind(0, 999);
+	const size_t kAlignments[] = { 4, 16, 256, 4096 };
+
+	HeapPageProvider provider;
+	LinearUploadAllocator allocator;
+	allocator.Initialize(&provider, kPageSize);
+	std::vector<RecordedAllocation> allocations;
+	allocations.reserve(kAllocationsPerFrame);
+	uint32_t pagesAfterFirstFrame = 0;
+	uint32_t largeAllocationCount = 0;
+
+	for (int frame = 0; frame < kFrameCount; ++frame) {
+		// 同じ乱数列を毎フレーム使い、必要なページ数が変わらないようにする
+		random.seed(7);
+		allocations.clear();
+		size_t requestedBytes = 0;
+		largeAllocationCount = 0;
+		for (int i = 0; i < kAllocationsPerFrame; ++i) {
+			int k = kind(random);
+			// 1000回に1回はページより大きい割り当て
+			size_t size = k == 0 ? kPageSize + smallSize(random) : smallSize(random);
+			size_t alignment = k == 0 ? LinearUploadAllocator::kConstantBufferAlignment : kAlignments[k % 4];
+			largeAllocationCount += k == 0 ? 1 : 0;
+			UploadAllocation allocation = allocator.Allocate(size, alignment);
+			uint32_t stamp = uint32_t(frame * kAllocationsPerFrame + i);
+			std::memcpy(allocation.cpuAddress, &stamp, sizeof(stamp));
+			std::memcpy(allocation.cpuAddress + size - sizeof(stamp), &stamp, sizeof(stamp));
+			allocations.push_back({ allocation, alignment, stamp });
+			requestedBytes += size;
+		}
+		CHECK(allocator.GetUsedBytes() == requestedBytes);
+		CHECK(allocator.GetReservedBytes() >= requestedBytes);
+
+		int failures = 0;
+		for (const RecordedAllocation& recorded : allocations) {
+			const UploadAllocation& allocation = recorded.allocation;
+			uint32_t head = 0;
+			uint32_t tail = 0;
+			std::memcpy(&head, allocation.cpuAddress, sizeof(head));
+			std::memcpy(&tail, allocation.cpuAddress + allocation.size - sizeof(tail), sizeof(tail));
+			bool valid = head == recorded.stamp && tail == recorded.stamp && allocation.gpuAddress % recorded.alignment == 0;
+			failures += valid ? 0 : 1;
+		}
+		CHECK(failures == 0);
+
+		// GPUアドレスで並べ、隣同士が重ならないこと
+		std::sort(allocations.begin(), allocations.end(), [](const RecordedAllocation& a, const RecordedAllocation& b) {
+			return a.allocation.gpuAddress < b.allocation.gpuAddress;
+		});
+		int overlaps = 0;
+		for (size_t i = 1; i < allocations.size(); ++i) {
+			const UploadAllocation& previous = allocations[i - 1].allocation;
+			overlaps += previous.gpuAddress + previous.size > allocations[i].allocation.gpuAddress ? 1 : 0;
+		}
+		CHECK(overlaps == 0);
+
+		allocator.Reset();
+		CHECK(allocator.GetUsedBytes() == 0);
+		if (frame == 0) {
+			pagesAfterFirstFrame = uint32_t(provider.GetLivePageCount());
+		}
+		// 大きな割り当てのページはResetで返し、通常のページは使い回す
+		CHECK(provider.GetLivePageCount() == pagesAfterFirstFrame);
+	}
+	// 2フレーム目以降に作るのは大きな割り当てのページだけ
+	CHECK(largeAllocationCount > 0);
+	CHECK(provider.GetCreateCount() == pagesAfterFirstFrame + largeAllocationCount * kFrameCount);
+
+	allocator.Finalize();
+	CHECK(provider.GetLivePageCount() == 0);
+	CHECK(provider.GetCreateCount() == provider.GetDestroyCount());
+}
+
+// 1フレーム10万回の定数の割り当ての速さ
+BENCHMARK(upload) {
+	const int kAllocationsPerFrame = 100000;
+	const int kFrames = 100;
+	struct ObjectConstants {
+		float wvp[16];
+		float world[16];
+	};
+	HeapPageProvider provider;
+	LinearUploadAllocator allocator;
+	allocator.Initialize(&provider);
+	ObjectConstants constants = {};
+	uint64_t checksum = 0;
+	Stopwatch stopwatch;
+	for (int frame = 0; frame < kFrames; ++frame) {
+		for (int i = 0; i < kAllocationsPerFrame; ++i) {
+			constants.wvp[0] = float(i);
+			checksum += allocator.AllocateConstant(constants);
+		}
+		allocator.Reset();
+	}
+	double seconds = stopwatch.GetSeconds();
+	printf("%d allocations per frame: %.2f ns per allocation, %.3f ms per frame, %zu bytes reserved (checksum %llu)\n",
+		kAllocationsPerFrame, seconds * 1e9 / (double(kAllocationsPerFrame) * kFrames), seconds * 1e3 / kFrames,
+		allocator.GetReservedBytes(), static_cast<unsigned long long>(checksum));
+	allocator.Finalize();
+}
@@ -0,0 +1,156 @@
+#include "Test.h"
+#include "StubShaderCompiler.h"
+#include "../Mesh.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+namespace {
+
+VertexData MakeVertex(float x, float y, float z, float u = 0.0f, float v = 0.0f) {
+	return { { x, y, z, 1.0f }, { u, v } };
+}
+
+// 三角形ごとに一番小さい番号が先頭に来るよう回して並べる。回すだけなので表裏の向きは変わらない
+std::vector<std::array<uint32_t, 3>> GetSortedTriangles(const std::vector<uint32_t>& indices) {
+	std::vector<std::array<uint32_t, 3>> triangles;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		std::array<uint32_t, 3> triangle = { indices[i], indices[i + 1], indices[i + 2] };
+		std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+		triangles.push_back(triangle);
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+// size x sizeのマスを2つの三角形に分けた格子。三角形の順番はseedで混ぜる
+std::vector<uint32_t> MakeShuffledGridIndices(uint32_t size, uint32_t seed) {
+	std::vector<std::array<uint32_t, 3>> triangles;
+	const uint32_t stride = size + 1;
+	for (uint32_t y = 0; y < size; ++y) {
+		for (uint32_t x = 0; x < size; ++x) {
+			uint32_t corner = y * stride + x;
+			triangles.push_back({ corner, corner + stride, corner + 1 });
+			triangles.push_back({ corner + 1, corner + stride, corner + stride + 1 });
+		}
+	}
+	std::shuffle(triangles.begin(), triangles.end(), std::mt19937(seed));
+	std::vector<uint32_t> indices;
+	for (const std::array<uint32_t, 3>& triangle : triangles) {
+		indices.insert(indices.end(), triangle.begin(), triangle.end());
+	}
+	return indices;
+}
+
+}
+
+// 許容差の格子はセルの境目をまたいでも隣の頂点を見つける。離れた頂点はまとめない
+TEST(MeshWeldFindsNeighborsAcrossCells) {
+	MeshWeldTolerance tolerance;
+	tolerance.position = 0.01f;
+	std::vector<VertexData> triangles = {
+		MakeVertex(0.0f, 0.0f, 0.0f), MakeVertex(1.0f, 0.0f, 0.0f), MakeVertex(0.0f, 1.0f, 0.0f),
+		// 0.0と-0.005は別のセルに入る
+		MakeVertex(-0.005f, 0.0f, 0.0f), MakeVertex(1.0f, 0.0f, 0.0f), MakeVertex(0.0f, 1.02f, 0.0f),
+	};
+	Mesh mesh = BuildIndexedMesh(triangles, tolerance);
+	CHECK(mesh.vertices.size() == 4);
+	CHECK(mesh.GetTriangleCount() == 2);
+	CHECK(mesh.indices[3] == mesh.indices[0] && mesh.indices[4] == mesh.indices[1] && mesh.indices[5] == 3);
+}
+
+// 位置の許容差が0やとても小さいときも、セルの番号が溢れずに正しくまとめる
+// 0のときは位置が完全に同じ頂点だけをUVの許容差でまとめる
+TEST(MeshWeldHandlesZeroAndTinyPositionTolerance) {
+	std::vector<VertexData> triangles = {
+		MakeVertex(3.0e9f, -3.0e9f, 1.0e30f, 0.0f, 0.0f), MakeVertex(1.0f, 0.0f, 0.0f), MakeVertex(0.0f, 1.0f, 0.0f),
+		// 同じ位置でUVが許容差の中
+		MakeVertex(3.0e9f, -3.0e9f, 1.0e30f, 0.005f, 0.0f), MakeVertex(1.0f, 0.0f, 0.0f), MakeVertex(0.0f, -1.0f, 0.0f),
+		// 溢れていたら同じセルに入ってしまう、遠く離れた位置
+		MakeVertex(6.0e9f, -6.0e9f, 2.0e30f, 0.0f, 0.0f), MakeVertex(1.0f, 0.0f, 0.0f), MakeVertex(-0.0f, 1.0f, 0.0f),
+	};
+	for (float position : { 0.0f, 1.0e-30f, 1.0e-7f }) {
+		MeshWeldTolerance tolerance;
+		tolerance.position = position;
+		tolerance.texcoord = 0.01f;
+		Mesh mesh = BuildIndexedMesh(triangles, tolerance);
+		// 0番と3番、1番と4番と7番、2番と8番がまとまる
+		CHECK(mesh.vertices.size() == 5);
+		CHECK(mesh.GetTriangleCount() == 3);
+		CHECK(mesh.indices[3] == mesh.indices[0] && mesh.indices[4] == mesh.indices[1]);
+		CHECK(mesh.indices[6] != mesh.indices[0] && mesh.indices[7] == mesh.indices[1] && mesh.indices[8] == mesh.indices[2]);
+	}
+}
+
+// 書いたメッシュは同じ内容で読める。インデックスが範囲外や途中で切れたファイルは読まない
+TEST(MeshFileRoundTrips) {
+	TemporaryDirectory directory("mesh");
+	std::vector<VertexData> triangles = {
+		MakeVertex(0.0f, 0.0f, 0.0f, 0.0f, 1.0f), MakeVertex(1.0f, 0.0f, 0.0f, 1.0f, 1.0f), MakeVertex(0.0f, 1.0f, 0.0f, 0.0f, 0.0f),
+		MakeVertex(1.0f, 1.0f, 0.0f, 1.0f, 0.0f), MakeVertex(0.0f, 1.0f, 0.0f, 0.0f, 0.0f), MakeVertex(1.0f, 0.0f, 0.0f, 1.0f, 1.0f),
+	};
+	Mesh mesh = BuildIndexedMesh(triangles);
+	std::filesystem::path path = GetCookedMeshPath(directory.GetPath() / "quad.obj");
+	CHECK(path == directory.GetPath() / "cooked" / "quad.mesh");
+	std::filesystem::create_directories(path.parent_path());
+	CHECK(SaveMesh(path, mesh));
+	Mesh loaded;
+	CHECK(LoadMesh(path, loaded));
+	CHECK(loaded.indices == mesh.indices);
+	CHECK(loaded.vertices.size() == mesh.vertices.size());
+	CHECK(memcmp(loaded.vertices.data(), mesh.vertices.data(), mesh.vertices.size() * sizeof(VertexData)) == 0);
+
+	mesh.indices[1] = uint32_t(mesh.vertices.size());
+	CHECK(SaveMesh(path, mesh));
+	CHECK(!LoadMesh(path, loaded));
+	std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+	CHECK(!LoadMesh(path, loaded));
+}
+
+// 並べ替えても三角形の組と向きは変わらない。混ぜた格子のACMRは大きく下がる
+TEST(MeshOptimizeVertexCacheKeepsTrianglesAndLowersACMR) {
+	const uint32_t kGridSize = 64;
+	const uint32_t vertexCount = (kGridSize + 1) * (kGridSize + 1);
+	std::vector<uint32_t> indices = MakeShuffledGridIndices(kGridSize, 1);
+	std::vector<uint32_t> original = indices;
+	float acmrBefore = ComputeACMR(indices, vertexCount);
+	OptimizeVertexCache(indices, vertexCount);
+	float acmrAfter = ComputeACMR(indices, vertexCount);
+	CHECK(GetSortedTriangles(indices) == GetSortedTriangles(original));
+	// 混ぜた順はほとんど使い回せない。並べ替えると格子の理想(約0.5)に近づく
+	CHECK(acmrBefore > 2.5f);
+	CHECK(acmrAfter < 0.8f);
+
+	// ACMRの数え方。キャッシュに残っていれば数えず、押し出されたら数え直す
+	CHECK(ComputeACMR({}, 0) == 0.0f);
+	CHECK(ComputeACMR({ 0, 1, 2, 2, 1, 3 }, 4) == 2.0f);
+	CHECK(ComputeACMR({ 0, 1, 2, 3, 4, 5, 0, 1, 2 }, 6, 3) == 3.0f);
+	CHECK(ComputeACMR({ 0, 1, 2, 3, 4, 5, 0, 1, 2 }, 6, 6) == 2.0f);
+}
+
+// 頂点は最初に使われる順に並び、使われない頂点は消える。各三角形の頂点の中身は変わらない
+TEST(MeshOptimizeVertexFetchOrdersByFirstUse) {
+	Mesh mesh;
+	for (uint32_t i = 0; i < 8; ++i) {
+		mesh.vertices.push_back(MakeVertex(float(i), float(i * i), 0.0f, float(i) * 0.125f, 0.0f));
+	}
+	// 1番と6番は使わない
+	mesh.indices = { 5, 2, 7, 7, 2, 0, 3, 4, 5, 0, 3, 7 };
+	Mesh original = mesh;
+	OptimizeVertexFetch(mesh);
+	CHECK(mesh.vertices.size() == 6);
+	CHECK(mesh.indices == std::vector<uint32_t>({ 0, 1, 2, 2, 1, 3, 4, 5, 0, 3, 4, 2 }));
+	uint32_t nextNew = 0;
+	for (size_t i = 0; i < mesh.indices.size(); ++i) {
+		CHECK(mesh.indices[i] <= nextNew);
+		if (mesh.indices[i] == nextNew) {
+			++nextNew;
+		}
+		const VertexData& before = original.vertices[original.indices[i]];
+		const VertexData& after = mesh.vertices[mesh.indices[i]];
+		CHECK(memcmp(&before, &after, sizeof(VertexData)) == 0);
+	}
+}
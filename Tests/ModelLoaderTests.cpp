@@ -0,0 +1,78 @@
+#include "Test.h"
+#include "StubShaderCompiler.h"
+#include "../ModelLoader.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+// 三角形1つのglTF。バッファはdata URIに埋め込む
+// 置き換えるところは{SCENES}{NODES}{PRIMITIVES}{BUFFERS}で、既定では正しいものを入れる
+std::string MakeTriangleGltf(std::string scenes = "[{\"nodes\":[0]}]", std::string nodes = "[{\"mesh\":0,\"children\":[]}]",
+	std::string primitives = "[{\"attributes\":{\"POSITION\":0}}]",
+	std::string buffers = "[{\"byteLength\":36,\"uri\":\"data:application/octet-stream;base64,AAAAAAAAAAAAAAAAAACAPwAAAAAAAAAAAAAAAAAAgD8AAAAA\"}]") {
+	return "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":" + scenes + ",\"nodes\":" + nodes +
+		",\"meshes\":[{\"primitives\":" + primitives + "}]"
+		",\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":3,\"type\":\"VEC3\"}]"
+		",\"bufferViews\":[{\"buffer\":0,\"byteLength\":36}]"
+		",\"buffers\":" + buffers + "}";
+}
+
+bool LoadGltfText(const TemporaryDirectory& directory, const std::string& text, Mesh& mesh, std::string& message) {
+	std::filesystem::path path = directory.GetPath() / "model.gltf";
+	WriteText(path, text);
+	mesh = {};
+	message.clear();
+	return LoadModel(path, nullptr, mesh, message);
+}
+
+}
+
+// 配列のはずの値がオブジェクトや数値でも、要素を辿らずにエラーで返す
+TEST(GltfLoaderRejectsNonArrayLists) {
+	TemporaryDirectory directory("gltf");
+	Mesh mesh;
+	std::string message;
+	CHECK(LoadGltfText(directory, MakeTriangleGltf(), mesh, message));
+	CHECK(mesh.vertices.size() == 3 && mesh.GetTriangleCount() == 1);
+
+	const std::string brokenFiles[] = {
+		MakeTriangleGltf("[{\"nodes\":{\"a\":0}}]"),
+		MakeTriangleGltf("[{\"nodes\":[0]}]", "[{\"mesh\":0,\"children\":{\"a\":1}}]"),
+		MakeTriangleGltf("[{\"nodes\":[0]}]", "{\"a\":{\"mesh\":0}}"),
+		MakeTriangleGltf("[{\"nodes\":[0]}]", "[{\"mesh\":0}]", "{\"a\":{\"attributes\":{\"POSITION\":0}}}"),
+		MakeTriangleGltf("[{\"nodes\":[0]}]", "[{\"mesh\":0}]", "[{\"attributes\":{\"POSITION\":0}}]", "{\"a\":{\"byteLength\":36}}"),
+		MakeTriangleGltf("[{\"nodes\":[0]}]", "[{\"mesh\":0}]", "[{\"attributes\":{\"POSITION\":0}}]", "7"),
+	};
+	for (const std::string& text : brokenFiles) {
+		CHECK(!LoadGltfText(directory, text, mesh, message));
+		CHECK(!message.empty());
+	}
+
+	// 行列やTRSがオブジェクトなら無視して単位行列のまま読む
+	CHECK(LoadGltfText(directory, MakeTriangleGltf("[{\"nodes\":[0]}]",
+		"[{\"mesh\":0,\"matrix\":{\"a\":0,\"b\":1},\"translation\":{\"x\":1,\"y\":2,\"z\":3}}]"), mesh, message));
+	CHECK(mesh.vertices.size() == 3);
+	for (const VertexData& vertex : mesh.vertices) {
+		CHECK(vertex.position.z == 0.0f);
+	}
+}
+
+// クッカーが更新を調べるファイルは外部ファイルのバッファだけ。data URIとOBJには無い
+TEST(ModelDependenciesListExternalBuffers) {
+	TemporaryDirectory directory("dependencies");
+	std::vector<std::filesystem::path> dependencies;
+	std::string message;
+	WriteText(directory.GetPath() / "model.gltf", MakeTriangleGltf("[{\"nodes\":[0]}]", "[{\"mesh\":0}]", "[{\"attributes\":{\"POSITION\":0}}]",
+		"[{\"byteLength\":36,\"uri\":\"data:application/octet-stream;base64,AAAA\"},{\"byteLength\":36,\"uri\":\"model%20data.bin\"}]"));
+	CHECK(GetModelDependencies(directory.GetPath() / "model.gltf", dependencies, message));
+	CHECK(dependencies == std::vector<std::filesystem::path>{ directory.GetPath() / "model data.bin" });
+
+	WriteText(directory.GetPath() / "model.obj", "v 0 0 0\n");
+	CHECK(GetModelDependencies(directory.GetPath() / "model.obj", dependencies, message));
+	CHECK(dependencies.empty());
+
+	WriteText(directory.GetPath() / "broken.gltf", "{\"buffers\":[");
+	CHECK(!GetModelDependencies(directory.GetPath() / "broken.gltf", dependencies, message));
+	CHECK(!message.empty());
+}
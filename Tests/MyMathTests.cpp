@@ -0,0 +1,291 @@
+#include "Test.h"
+#include "../MyMath.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// MyMathに移す前にmain.cppにあったスカラー実装。結果と速さを比べる基準として残しておく
+namespace Reference {
+
+Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2) {
+	Matrix4x4 result;
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) {
+			result.m[i][j] = 0;
+			for (int k = 0; k < 4; k++) {
+				result.m[i][j] += m1.m[i][k] * m2.m[k][j];
+			}
+		}
+	}
+	return result;
+}
+
+// 余因子展開をそのまま書いた逆行列
+Matrix4x4 Inverse(const Matrix4x4& m) {
+	Matrix4x4 result;
+	float determinant =
+		m.m[0][0] * m.m[1][1] * m.m[2][2] * m.m[3][3] + m.m[0][0] * m.m[1][2] * m.m[2][3] * m.m[3][1] + m.m[0][0] * m.m[1][3] * m.m[2][1] * m.m[3][2]
+		- m.m[0][0] * m.m[1][3] * m.m[2][2] * m.m[3][1] - m.m[0][0] * m.m[1][2] * m.m[2][1] * m.m[3][3] - m.m[0][0] * m.m[1][1] * m.m[2][3] * m.m[3][2]
+		- m.m[0][1] * m.m[1][0] * m.m[2][2] * m.m[3][3] - m.m[0][2] * m.m[1][0] * m.m[2][3] * m.m[3][1] - m.m[0][3] * m.m[1][0] * m.m[2][1] * m.m[3][2]
+		+ m.m[0][3] * m.m[1][0] * m.m[2][2] * m.m[3][1] + m.m[0][2] * m.m[1][0] * m.m[2][1] * m.m[3][3] + m.m[0][1] * m.m[1][0] * m.m[2][3] * m.m[3][2]
+		+ m.m[0][1] * m.m[1][2] * m.m[2][0] * m.m[3][3] + m.m[0][2] * m.m[1][3] * m.m[2][0] * m.m[3][1] + m.m[0][3] * m.m[1][1] * m.m[2][0] * m.m[3][2]
+		- m.m[0][3] * m.m[1][2] * m.m[2][0] * m.m[3][1] - m.m[0][2] * m.m[1][1] * m.m[2][0] * m.m[3][3] - m.m[0][1] * m.m[1][3] * m.m[2][0] * m.m[3][2]
+		- m.m[0][1] * m.m[1][2] * m.m[2][3] * m.m[3][0] - m.m[0][2] * m.m[1][3] * m.m[2][1] * m.m[3][0] - m.m[0][3] * m.m[1][1] * m.m[2][2] * m.m[3][0]
+		+ m.m[0][3] * m.m[1][2] * m.m[2][1] * m.m[3][0] + m.m[0][2] * m.m[1][1] * m.m[2][3] * m.m[3][0] + m.m[0][1] * m.m[1][3] * m.m[2][2] * m.m[3][0];
+
+	result.m[0][0] = (m.m[1][1] * m.m[2][2] * m.m[3][3] + m.m[1][2] * m.m[2][3] * m.m[3][1] + m.m[1][3] * m.m[2][1] * m.m[3][2]
+		- m.m[1][3] * m.m[2][2] * m.m[3][1] - m.m[1][2] * m.m[2][1] * m.m[3][3] - m.m[1][1] * m.m[2][3] * m.m[3][2]) / determinant;
+	result.m[0][1] = (-m.m[0][1] * m.m[2][2] * m.m[3][3] - m.m[0][2] * m.m[2][3] * m.m[3][1] - m.m[0][3] * m.m[2][1] * m.m[3][2]
+		+ m.m[0][3] * m.m[2][2] * m.m[3][1] + m.m[0][2] * m.m[2][1] * m.m[3][3] + m.m[0][1] * m.m[2][3] * m.m[3][2]) / determinant;
+	result.m[0][2] = (m.m[0][1] * m.m[1][2] * m.m[3][3] + m.m[0][2] * m.m[1][3] * m.m[3][1] + m.m[0][3] * m.m[1][1] * m.m[3][2]
+		- m.m[0][3] * m.m[1][2] * m.m[3][1] - m.m[0][2] * m.m[1][1] * m.m[3][3] - m.m[0][1] * m.m[1][3] * m.m[3][2]) / determinant;
+	result.m[0][3] = (-m.m[0][1] * m.m[1][2] * m.m[2][3] - m.m[0][2] * m.m[1][3] * m.m[2][1] - m.m[0][3] * m.m[1][1] * m.m[2][2]
+		+ m.m[0][3] * m.m[1][2] * m.m[2][1] + m.m[0][2] * m.m[1][1] * m.m[2][3] + m.m[0][1] * m.m[1][3] * m.m[2][2]) / determinant;
+
+	result.m[1][0] = (-m.m[1][0] * m.m[2][2] * m.m[3][3] - m.m[1][2] * m.m[2][3] * m.m[3][0] - m.m[1][3] * m.m[2][0] * m.m[3][2]
+		+ m.m[1][3] * m.m[2][2] * m.m[3][0] + m.m[1][2] * m.m[2][0] * m.m[3][3] + m.m[1][0] * m.m[2][3] * m.m[3][2]) / determinant;
+	result.m[1][1] = (m.m[0][0] * m.m[2][2] * m.m[3][3] + m.m[0][2] * m.m[2][3] * m.m[3][0] + m.m[0][3] * m.m[2][0] * m.m[3][2]
+		- m.m[0][3] * m.m[2][2] * m.m[3][0] - m.m[0][2] * m.m[2][0] * m.m[3][3] - m.m[0][0] * m.m[2][3] * m.m[3][2]) / determinant;
+	result.m[1][2] = (-m.m[0][0] * m.m[1][2] * m.m[3][3] - m.m[0][2] * m.m[1][3] * m.m[3][0] - m.m[0][3] * m.m[1][0] * m.m[3][2]
+		+ m.m[0][3] * m.m[1][2] * m.m[3][0] + m.m[0][2] * m.m[1][0] * m.m[3][3] + m.m[0][0] * m.m[1][3] * m.m[3][2]) / determinant;
+	result.m[1][3] = (m.m[0][0] * m.m[1][2] * m.m[2][3] + m.m[0][2] * m.m[1][3] * m.m[2][0] + m.m[0][3] * m.m[1][0] * m.m[2][2]
+		- m.m[0][3] * m.m[1][2] * m.m[2][0] - m.m[0][2] * m.m[1][0] * m.m[2][3] - m.m[0][0] * m.m[1][3] * m.m[2][2]) / determinant;
+
+	result.m[2][0] = (m.m[1][0] * m.m[2][1] * m.m[3][3] + m.m[1][1] * m.m[2][3] * m.m[3][0] + m.m[1][3] * m.m[2][0] * m.m[3][1]
+		- m.m[1][3] * m.m[2][1] * m.m[3][0] - m.m[1][1] * m.m[2][0] * m.m[3][3] - m.m[1][0] * m.m[2][3] * m.m[3][1]) / determinant;
+	result.m[2][1] = (-m.m[0][0] * m.m[2][1] * m.m[3][3] - m.m[0][1] * m.m[2][3] * m.m[3][0] - m.m[0][3] * m.m[2][0] * m.m[3][1]
+		+ m.m[0][3] * m.m[2][1] * m.m[3][0] + m.m[0][1] * m.m[2][0] * m.m[3][3] + m.m[0][0] * m.m[2][3] * m.m[3][1]) / determinant;
+	result.m[2][2] = (m.m[0][0] * m.m[1][1] * m.m[3][3] + m.m[0][1] * m.m[1][3] * m.m[3][0] + m.m[0][3] * m.m[1][0] * m.m[3][1]
+		- m.m[0][3] * m.m[1][1] * m.m[3][0] - m.m[0][1] * m.m[1][0] * m.m[3][3] - m.m[0][0] * m.m[1][3] * m.m[3][1]) / determinant;
+	result.m[2][3] = (-m.m[0][0] * m.m[1][1] * m.m[2][3] - m.m[0][1] * m.m[1][3] * m.m[2][0] - m.m[0][3] * m.m[1][0] * m.m[2][1]
+		+ m.m[0][3] * m.m[1][1] * m.m[2][0] + m.m[0][1] * m.m[1][0] * m.m[2][3] + m.m[0][0] * m.m[1][3] * m.m[2][1]) / determinant;
+
+	result.m[3][0] = (-m.m[1][0] * m.m[2][1] * m.m[3][2] - m.m[1][1] * m.m[2][2] * m.m[3][0] - m.m[1][2] * m.m[2][0] * m.m[3][1]
+		+ m.m[1][2] * m.m[2][1] * m.m[3][0] + m.m[1][1] * m.m[2][0] * m.m[3][2] + m.m[1][0] * m.m[2][2] * m.m[3][1]) / determinant;
+	result.m[3][1] = (m.m[0][0] * m.m[2][1] * m.m[3][2] + m.m[0][1] * m.m[2][2] * m.m[3][0] + m.m[0][2] * m.m[2][0] * m.m[3][1]
+		- m.m[0][2] * m.m[2][1] * m.m[3][0] - m.m[0][1] * m.m[2][0] * m.m[3][2] - m.m[0][0] * m.m[2][2] * m.m[3][1]) / determinant;
+	result.m[3][2] = (-m.m[0][0] * m.m[1][1] * m.m[3][2] - m.m[0][1] * m.m[1][2] * m.m[3][0] - m.m[0][2] * m.m[1][0] * m.m[3][1]
+		+ m.m[0][2] * m.m[1][1] * m.m[3][0] + m.m[0][1] * m.m[1][0] * m.m[3][2] + m.m[0][0] * m.m[1][2] * m.m[3][1]) / determinant;
+	result.m[3][3] = (m.m[0][0] * m.m[1][1] * m.m[2][2] + m.m[0][1] * m.m[1][2] * m.m[2][0] + m.m[0][2] * m.m[1][0] * m.m[2][1]
+		- m.m[0][2] * m.m[1][1] * m.m[2][0] - m.m[0][1] * m.m[1][0] * m.m[2][2] - m.m[0][0] * m.m[1][2] * m.m[2][1]) / determinant;
+
+	return result;
+}
+
+// 回転行列を3つ作って掛け合わせていた頃のアフィン変換行列
+Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Vector3& rotate, const Vector3& translate) {
+	Matrix4x4 result = {};
+	Matrix4x4 rotateXYZ =
+		::Multiply(MakeRotateXMatrix(rotate.x), ::Multiply(MakeRotateYMatrix(rotate.y), MakeRotateZMatrix(rotate.z)));
+	for (int j = 0; j < 3; j++) {
+		result.m[0][j] = scale.x * rotateXYZ.m[0][j];
+		result.m[1][j] = scale.y * rotateXYZ.m[1][j];
+		result.m[2][j] = scale.z * rotateXYZ.m[2][j];
+	}
+	result.m[3][0] = translate.x;
+	result.m[3][1] = translate.y;
+	result.m[3][2] = translate.z;
+	result.m[3][3] = 1.0f;
+	return result;
+}
+
+}
+
+// 各要素の差の絶対値の最大
+float MaxDifference(const Matrix4x4& a, const Matrix4x4& b) {
+	float difference = 0.0f;
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) {
+			difference = std::max(difference, std::abs(a.m[i][j] - b.m[i][j]));
+		}
+	}
+	return difference;
+}
+
+// 大きな値の要素では絶対誤差が大きくなるので、1を超える要素は相対誤差で見る
+float MaxRelativeDifference(const Matrix4x4& a, const Matrix4x4& reference) {
+	float difference = 0.0f;
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) {
+			difference = std::max(difference, std::abs(a.m[i][j] - reference.m[i][j]) / std::max(1.0f, std::abs(reference.m[i][j])));
+		}
+	}
+	return difference;
+}
+
+// 要素が[-range, range]の乱数の行列。対角には4*rangeを足して逆行列が安定するようにする
+std::vector<Matrix4x4> MakeRandomMatrices(size_t count, float range, uint32_t seed) {
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> distribution(-range, range);
+	std::vector<Matrix4x4> matrices(count);
+	for (Matrix4x4& matrix : matrices) {
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				matrix.m[i][j] = distribution(random) + (i == j ? 4.0f * range : 0.0f);
+			}
+		}
+	}
+	return matrices;
+}
+
+}
+
+TEST(MultiplyMatchesScalarReference) {
+	std::vector<Matrix4x4> matrices = MakeRandomMatrices(1000, 2.0f, 1);
+	for (size_t i = 0; i + 1 < matrices.size(); ++i) {
+		// FMAを使うビルドでは丸めの回数が変わるので完全一致にはしない
+		CHECK(MaxDifference(Multiply(matrices[i], matrices[i + 1]), Reference::Multiply(matrices[i], matrices[i + 1])) <= 1e-4f);
+	}
+}
+
+TEST(InverseMatchesScalarReference) {
+	std::vector<Matrix4x4> matrices = MakeRandomMatrices(1000, 2.0f, 2);
+	for (const Matrix4x4& matrix : matrices) {
+		CHECK(MaxDifference(Inverse(matrix), Reference::Inverse(matrix)) <= 1e-5f);
+		CHECK(MaxDifference(Multiply(matrix, Inverse(matrix)), MakeIdentity4x4()) <= 1e-5f);
+	}
+}
+
+// アフィン・回転だけの行列の逆行列とビュー行列の組み立ては、一般のInverseと誤差の範囲で一致する
+TEST(InverseFastPathsMatchGeneralInverse) {
+	std::mt19937 random(4);
+	std::uniform_real_distribution<float> scale(0.2f, 5.0f);
+	std::uniform_real_distribution<float> angle(-3.14f, 3.14f);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	const float kEpsilon = 1e-4f;
+	for (int i = 0; i < 10000; ++i) {
+		Transform transform = {
+			{ scale(random), scale(random), scale(random) },
+			{ angle(random), angle(random), angle(random) },
+			{ position(random), position(random), position(random) },
+		};
+		Matrix4x4 affine = MakeAffineMatrix(transform.scale, transform.rotate, transform.translate);
+		CHECK(MaxRelativeDifference(InverseAffine(affine), Inverse(affine)) <= kEpsilon);
+		CHECK(MaxRelativeDifference(MakeViewMatrix(transform), Inverse(affine)) <= kEpsilon);
+
+		Matrix4x4 rigid = MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, transform.rotate, transform.translate);
+		CHECK(MaxRelativeDifference(InverseOrthonormal(rigid), Inverse(rigid)) <= kEpsilon);
+
+		// 注視点のビュー行列は、カメラの軸と位置を並べたワールド行列の逆行列
+		Vector3 eye = transform.translate;
+		Vector3 target = { position(random), position(random), position(random) };
+		Matrix4x4 lookAt = MakeLookAtMatrix(eye, target, { 0.0f, 1.0f, 0.0f });
+		Vector3 zAxis = Normalize(Subtract(target, eye));
+		Vector3 xAxis = Normalize(Cross({ 0.0f, 1.0f, 0.0f }, zAxis));
+		Vector3 yAxis = Cross(zAxis, xAxis);
+		Matrix4x4 camera = {
+			xAxis.x, xAxis.y, xAxis.z, 0.0f,
+			yAxis.x, yAxis.y, yAxis.z, 0.0f,
+			zAxis.x, zAxis.y, zAxis.z, 0.0f,
+			eye.x, eye.y, eye.z, 1.0f,
+		};
+		CHECK(MaxRelativeDifference(lookAt, Inverse(camera)) <= kEpsilon);
+	}
+}
+
+// まとめて展開したMakeAffineMatrixとクォータニオン版は、回転行列3つの積と誤差の範囲で一致する
+TEST(AffineMatchesThreeRotationReference) {
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> scale(0.2f, 5.0f);
+	std::uniform_real_distribution<float> angle(-50.0f, 50.0f);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	for (int i = 0; i < 10000; ++i) {
+		Vector3 s = { scale(random), scale(random), scale(random) };
+		Vector3 r = { angle(random), angle(random), angle(random) };
+		Vector3 t = { position(random), position(random), position(random) };
+		Matrix4x4 reference = Reference::MakeAffineMatrix(s, r, t);
+		CHECK(MaxRelativeDifference(MakeAffineMatrix(s, r, t), reference) <= 1e-5f);
+		CHECK(MaxRelativeDifference(MakeAffineMatrixFromQuaternion(s, MakeRotateQuaternion(r), t), reference) <= 1e-5f);
+	}
+}
+
+// MakeAffineMatrixとクォータニオン版を、回転行列3つの積で作っていた頃の実装と比べる
+BENCHMARK(affine) {
+	const size_t kTransformCount = 1024;
+	const int kRepeat = 2000;
+	std::mt19937 random(6);
+	std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+	std::uniform_real_distribution<float> angle(-3.14f, 3.14f);
+	std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+	std::vector<Transform> transforms(kTransformCount);
+	std::vector<Quaternion> rotations(kTransformCount);
+	for (size_t i = 0; i < kTransformCount; ++i) {
+		transforms[i] = {
+			{ scale(random), scale(random), scale(random) },
+			{ angle(random), angle(random), angle(random) },
+			{ position(random), position(random), position(random) },
+		};
+		rotations[i] = MakeRotateQuaternion(transforms[i].rotate);
+	}
+	std::vector<Matrix4x4> results(kTransformCount);
+	const double operations = double(kTransformCount) * kRepeat;
+
+	auto run = [&](auto function) {
+		Stopwatch stopwatch;
+		for (int repeat = 0; repeat < kRepeat; ++repeat) {
+			for (size_t i = 0; i < kTransformCount; ++i) {
+				results[i] = function(i);
+			}
+		}
+		double seconds = stopwatch.GetSeconds();
+		float checksum = 0.0f;
+		for (const Matrix4x4& result : results) {
+			checksum += result.m[0][0] + result.m[2][1];
+		}
+		return std::make_pair(seconds * 1e9 / operations, checksum);
+	};
+
+	auto threeRotations = run([&](size_t i) {
+		return Reference::MakeAffineMatrix(transforms[i].scale, transforms[i].rotate, transforms[i].translate);
+	});
+	auto fused = run([&](size_t i) { return MakeAffineMatrix(transforms[i].scale, transforms[i].rotate, transforms[i].translate); });
+	auto quaternion = run([&](size_t i) {
+		return MakeAffineMatrixFromQuaternion(transforms[i].scale, rotations[i], transforms[i].translate);
+	});
+
+	printf("%-26s %10s %8s\n", "function", "ns", "speedup");
+	printf("%-26s %10.2f %7.2fx\n", "three rotations", threeRotations.first, 1.0);
+	printf("%-26s %10.2f %7.2fx\n", "MakeAffineMatrix", fused.first, threeRotations.first / fused.first);
+	printf("%-26s %10.2f %7.2fx\n", "FromQuaternion", quaternion.first, threeRotations.first / quaternion.first);
+	printf("checksum %g %g %g\n", threeRotations.second, fused.second, quaternion.second);
+}
+
+// MultiplyとInverseをmain.cppにあった頃のスカラー実装と比べる
+BENCHMARK(math) {
+	const size_t kMatrixCount = 1024;
+	const int kRepeat = 2000;
+	std::vector<Matrix4x4> matrices = MakeRandomMatrices(kMatrixCount, 2.0f, 3);
+	std::vector<Matrix4x4> results(kMatrixCount);
+	const double operations = double(kMatrixCount) * kRepeat;
+
+	// 結果を使わないと最適化で消えるので、最後に要素の和を出す
+	auto run = [&](auto function) {
+		Stopwatch stopwatch;
+		for (int repeat = 0; repeat < kRepeat; ++repeat) {
+			for (size_t i = 0; i < kMatrixCount; ++i) {
+				results[i] = function(matrices[i], matrices[(i + repeat) % kMatrixCount]);
+			}
+		}
+		double seconds = stopwatch.GetSeconds();
+		float checksum = 0.0f;
+		for (const Matrix4x4& result : results) {
+			checksum += result.m[0][0] + result.m[3][3];
+		}
+		return std::make_pair(seconds * 1e9 / operations, checksum);
+	};
+
+	auto multiplyScalar = run([](const Matrix4x4& a, const Matrix4x4& b) { return Reference::Multiply(a, b); });
+	auto multiplySimd = run([](const Matrix4x4& a, const Matrix4x4& b) { return Multiply(a, b); });
+	auto inverseScalar = run([](const Matrix4x4& a, const Matrix4x4&) { return Reference::Inverse(a); });
+	auto inverseSimd = run([](const Matrix4x4& a, const Matrix4x4&) { return Inverse(a); });
+
+	printf("%-10s %12s %12s %8s\n", "function", "scalar ns", "MyMath ns", "speedup");
+	printf("%-10s %12.2f %12.2f %7.2fx\n", "Multiply", multiplyScalar.first, multiplySimd.first, multiplyScalar.first / multiplySimd.first);
+	printf("%-10s %12.2f %12.2f %7.2fx\n", "Inverse", inverseScalar.first, inverseSimd.first, inverseScalar.first / inverseSimd.first);
+	printf("checksum %g %g %g %g\n", multiplyScalar.second, multiplySimd.second, inverseScalar.second, inverseSimd.second);
+}
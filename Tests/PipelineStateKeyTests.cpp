@@ -0,0 +1,122 @@
+#include "Test.h"
+#include "../PipelineStateKey.h"
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace {
+
+// main.cppのObject3dのPSOと同じ記述。列挙値はD3D12の値をそのまま書く
+GraphicsPipelineKeyDesc MakeObject3dDesc() {
+	GraphicsPipelineKeyDesc desc;
+	desc.rootSignatureHash = 0x1111;
+	desc.vertexShaderHash = 0x2222;
+	desc.pixelShaderHash = 0x3333;
+	desc.renderTargetBlends[0].renderTargetWriteMask = 0xF;  // D3D12_COLOR_WRITE_ENABLE_ALL
+	desc.sampleMask = 0xFFFFFFFF;                            // D3D12_DEFAULT_SAMPLE_MASK
+	desc.fillMode = 3;                                       // D3D12_FILL_MODE_SOLID
+	desc.cullMode = 3;                                       // D3D12_CULL_MODE_BACK
+	desc.depthClipEnable = 1;
+	desc.depthEnable = 1;
+	desc.depthWriteMask = 1;                                 // D3D12_DEPTH_WRITE_MASK_ALL
+	desc.depthFunc = 4;                                      // D3D12_COMPARISON_FUNC_LESS_EQUAL
+	desc.inputLayout = {
+		{ "POSITION", 0, 2, 0, 0, 0, 0 },                    // DXGI_FORMAT_R32G32B32A32_FLOAT
+		{ "TEXCOORD", 0, 16, 0, 16, 0, 0 },                  // DXGI_FORMAT_R32G32_FLOAT
+		{ "NORMAL", 0, 6, 0, 24, 0, 0 },                     // DXGI_FORMAT_R32G32B32_FLOAT
+	};
+	desc.primitiveTopologyType = 3;                          // D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE
+	desc.numRenderTargets = 1;
+	desc.rtvFormats[0] = 29;                                 // DXGI_FORMAT_R8G8B8A8_UNORM_SRGB
+	desc.dsvFormat = 45;                                     // DXGI_FORMAT_D24_UNORM_S8_UINT
+	desc.sampleCount = 1;
+	return desc;
+}
+
+// descにchangeを加えたもののハッシュ
+template<class F>
+uint64_t HashChanged(F change) {
+	GraphicsPipelineKeyDesc desc = MakeObject3dDesc();
+	change(desc);
+	return HashGraphicsPipelineKeyDesc(desc);
+}
+
+}
+
+// パディングの中身はハッシュに入らない。違うゴミで埋めたメモリに同じ記述を作っても同じキーになる
+TEST(PipelineStateKeyIgnoresPadding) {
+	alignas(GraphicsPipelineKeyDesc) unsigned char zeroMemory[sizeof(GraphicsPipelineKeyDesc)];
+	alignas(GraphicsPipelineKeyDesc) unsigned char garbageMemory[sizeof(GraphicsPipelineKeyDesc)];
+	std::memset(zeroMemory, 0x00, sizeof(zeroMemory));
+	std::memset(garbageMemory, 0xAB, sizeof(garbageMemory));
+	GraphicsPipelineKeyDesc* zeroDesc = new (zeroMemory) GraphicsPipelineKeyDesc;
+	GraphicsPipelineKeyDesc* garbageDesc = new (garbageMemory) GraphicsPipelineKeyDesc;
+	zeroDesc->vertexShaderHash = 0x2222;
+	garbageDesc->vertexShaderHash = 0x2222;
+	zeroDesc->depthBias = -3;
+	garbageDesc->depthBias = -3;
+	// 末尾のパディングの分だけメモリは違う
+	CHECK(std::memcmp(zeroMemory, garbageMemory, sizeof(GraphicsPipelineKeyDesc)) != 0);
+	CHECK(HashGraphicsPipelineKeyDesc(*zeroDesc) == HashGraphicsPipelineKeyDesc(*garbageDesc));
+	zeroDesc->~GraphicsPipelineKeyDesc();
+	garbageDesc->~GraphicsPipelineKeyDesc();
+}
+
+// 結果が変わらない違い（使われないフィールド、BOOLの値、大文字小文字、-0.0f）は同じキーになる
+TEST(PipelineStateKeyNormalizesUnusedFields) {
+	const uint64_t base = HashGraphicsPipelineKeyDesc(MakeObject3dDesc());
+	// Blendが無効なら係数は見られない。BOOLは0以外なら同じ
+	CHECK(HashChanged([](GraphicsPipelineKeyDesc& d) { d.renderTargetBlends[0].srcBlend = 5; d.renderTargetBlends[0].blendOpAlpha = 2; }) == base);
+	CHECK(HashChanged([](GraphicsPipelineKeyDesc& d) { d.renderTargetBlends[0].logicOp = 4; }) == base);
+	CHECK(HashChanged([](GraphicsPipelineKeyDesc& d) { d.depthClipEnable = 7; }) == base);
+	// 使わないRenderTargetと、IndependentBlendEnableが無いときの2枚目以降
+	CHECK(HashChanged([](GraphicsPipelineKeyDesc& d) { d.rtvFormats[3] = 28; d.renderTargetBlends[3].blendEnable = 1; }) == base);
+	CHECK(HashChanged([](GraphicsPipelineKeyDesc& d) {
+		d.numRenderTargets = 2;
+		d.rtvFormats[1] = 10;
+		d.renderTargetBlends[1] = d.renderTargetBlends[0];
+		d.renderTargetBlends[1].srcBlend = 5;
+	}) == HashChanged([](GraphicsPipelineKeyDesc& d) { d.numRenderTargets = 2; d.rtvFormats[1] = 10; }));
+	// 無効なDepthとStencilの設定
+	CHECK(HashChanged([](GraphicsPipelineKeyDesc& d) { d.stencilReadMask = 0xFF; d.frontFace.func = 8; d.backFace.passOp = 3; }) == base);
+	GraphicsPipelineKeyDesc noDepth = MakeObject3dDesc();
+	noDepth.depthEnable = 0;
+	CHECK(HashChanged([](GraphicsPipelineKeyDesc& d) { d.depthEnable = 0; d.depthFunc = 8; d.depthWriteMask = 0; }) == HashGraphicsPipelineKeyDesc(noDepth));
+	// サンプル数より上のSampleMaskのビット
+	CHECK(HashChanged([](GraphicsPipelineKeyDesc& d) { d.sampleMask = 1; }) == base);
+	CHECK(HashChanged([](GraphicsPipelineKeyDesc& d) { d.inputLayout[1].semanticName = "TexCoord"; }) == base);
+	CHECK(HashChanged([](GraphicsPipelineKeyDesc& d) { d.slopeScaledDepthBias = -0.0f; }) == base);
+
+	// 同じ種類の違いでも、使われるものは別のキーになる
+	CHECK(HashChanged([](GraphicsPipelineKeyDesc& d) { d.renderTargetBlends[0].blendEnable = 1; d.renderTargetBlends[0].srcBlend = 5; }) != base);
+	CHECK(HashChanged([](GraphicsPipelineKeyDesc& d) { d.rtvFormats[0] = 28; }) != base);
+	CHECK(HashChanged([](GraphicsPipelineKeyDesc& d) { d.depthFunc = 2; }) != base);
+	CHECK(HashChanged([](GraphicsPipelineKeyDesc& d) { d.sampleCount = 4; d.sampleMask = 0xF; }) != base);
+	CHECK(HashChanged([](GraphicsPipelineKeyDesc& d) { d.inputLayout[1].semanticIndex = 1; }) != base);
+	CHECK(HashChanged([](GraphicsPipelineKeyDesc& d) { d.depthBiasClamp = 0.5f; }) != base);
+	CHECK(HashChanged([](GraphicsPipelineKeyDesc& d) { d.pixelShaderHash = 0; }) != base);
+}
+
+// 並べ方が違えば別のPSOなので、入れ替えたものは別のキーになる
+TEST(PipelineStateKeyIsOrderSensitive) {
+	const uint64_t base = HashGraphicsPipelineKeyDesc(MakeObject3dDesc());
+	// InputLayoutの要素の順番
+	CHECK(HashChanged([](GraphicsPipelineKeyDesc& d) { std::swap(d.inputLayout[1], d.inputLayout[2]); }) != base);
+	// シェーダーのステージ
+	CHECK(HashChanged([](GraphicsPipelineKeyDesc& d) { std::swap(d.vertexShaderHash, d.pixelShaderHash); }) != base);
+	// RenderTargetのフォーマットの順番
+	auto twoTargets = [](GraphicsPipelineKeyDesc& d) {
+		d.numRenderTargets = 2;
+		d.rtvFormats[1] = 10;
+	};
+	CHECK(HashChanged([&](GraphicsPipelineKeyDesc& d) { twoTargets(d); std::swap(d.rtvFormats[0], d.rtvFormats[1]); }) != HashChanged(twoTargets));
+	// 表と裏のStencil
+	auto stencil = [](GraphicsPipelineKeyDesc& d) {
+		d.stencilEnable = 1;
+		d.frontFace.passOp = 3;
+		d.backFace.passOp = 1;
+	};
+	CHECK(HashChanged([&](GraphicsPipelineKeyDesc& d) { stencil(d); std::swap(d.frontFace, d.backFace); }) != HashChanged(stencil));
+	// 同じ記述は何度求めても同じ
+	CHECK(HashGraphicsPipelineKeyDesc(MakeObject3dDesc()) == base);
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "../FrameRing.h"
+#include <vector>
+
+// GPUの代わりに呼ばれた順番を記録するIGpuTimelineの実装
+// GPUの進み具合はテスト側がCompleteUpToで決める。WaitForValueはGPUがその値まで進んだことにして戻る
+class RecordingGpuTimeline : public IGpuTimeline {
+public:
+	enum class EventType {
+		kSignal,
+		kWait,
+	};
+	struct Event {
+		EventType type;
+		uint64_t value;
+	};
+
+	uint64_t Signal() override {
+		++lastSignaledValue_;
+		events_.push_back({ EventType::kSignal, lastSignaledValue_ });
+		return lastSignaledValue_;
+	}
+	uint64_t GetCompletedValue() override { return completedValue_; }
+	void WaitForValue(uint64_t value) override {
+		events_.push_back({ EventType::kWait, value });
+		// まだSignalを積んでいない値を待つと、実際のGPUでは永久に戻らない
+		if (value > lastSignaledValue_) {
+			++invalidWaitCount_;
+			return;
+		}
+		CompleteUpTo(value);
+	}
+
+	// GPUがvalueまで処理を終えたことにする。Signal済みの値を超えては進まない
+	void CompleteUpTo(uint64_t value) {
+		if (value > lastSignaledValue_) {
+			value = lastSignaledValue_;
+		}
+		if (value > completedValue_) {
+			completedValue_ = value;
+		}
+	}
+
+	const std::vector<Event>& GetEvents() const { return events_; }
+	void ClearEvents() { events_.clear(); }
+	uint64_t GetLastSignaledValue() const { return lastSignaledValue_; }
+	// Signalしていない値を待った回数
+	uint32_t GetInvalidWaitCount() const { return invalidWaitCount_; }
+
+private:
+	std::vector<Event> events_;
+	uint64_t lastSignaledValue_ = 0;
+	uint64_t completedValue_ = 0;
+	uint32_t invalidWaitCount_ = 0;
+};
@@ -0,0 +1,44 @@
+#include "Test.h"
+#include "../RenderBatcher.h"
+#include "../TransformBatch.h"
+#include <vector>
+
+// マテリアルが違ってもPSOとメッシュが同じなら1つのバッチになり、インスタンスがそれぞれのマテリアルの番号を持つ
+TEST(RenderBatcherGroupsByPipelineAndMesh) {
+	RenderBatcher batcher;
+	batcher.Add({ 1, 0, 0, 0 });
+	batcher.Add({ 0, 2, 1, 1 });
+	batcher.Add({ 0, 2, 2, 2 });
+	batcher.Add({ 0, 1, 1, 3 });
+	batcher.Add({ 0, 2, 1, 4 });
+	batcher.Build(6);
+	const std::vector<RenderBatch>& batches = batcher.GetBatches();
+	CHECK(batches.size() == 3);
+	CHECK(batches[0].pipeline == 0 && batches[0].mesh == 1 && batches[0].firstInstance == 0 && batches[0].instanceCount == 1);
+	CHECK(batches[1].pipeline == 0 && batches[1].mesh == 2 && batches[1].firstInstance == 1 && batches[1].instanceCount == 3);
+	CHECK(batches[2].pipeline == 1 && batches[2].mesh == 0 && batches[2].firstInstance == 4 && batches[2].instanceCount == 1);
+	// 同じ組の中は追加した順
+	CHECK(batcher.GetInstanceObjects() == std::vector<uint32_t>({ 3, 1, 2, 4, 0 }));
+	// 描かない5番には場所が無い
+	CHECK(batcher.GetObjectInstances() == std::vector<uint32_t>({ 4, 1, 2, 0, 3, UINT32_MAX }));
+
+	// WVPはTransformBatchがインスタンスの場所へ直接書き、マテリアルの番号はその後ろに書く
+	TransformBatch transforms;
+	for (uint32_t i = 0; i < 6; ++i) {
+		transforms.Add({ { 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f }, { float(i), 0.0f, 0.0f } });
+	}
+	std::vector<InstanceData> instances(5);
+	transforms.Update(MakeIdentity4x4(), &instances[0].wvp, sizeof(InstanceData), nullptr, nullptr, batcher.GetObjectInstances().data());
+	batcher.WriteMaterialIndices(instances.data());
+	const uint32_t expectedMaterials[] = { 1, 1, 2, 1, 0 };
+	for (uint32_t i = 0; i < 5; ++i) {
+		CHECK(instances[i].materialIndex == expectedMaterials[i]);
+		CHECK(instances[i].padding[0] == 0 && instances[i].padding[2] == 0);
+		CHECK(instances[i].wvp.m[3][0] == float(batcher.GetInstanceObjects()[i]));
+	}
+
+	// 上限を超える組は分ける
+	batcher.Build(6, 2);
+	CHECK(batcher.GetBatches().size() == 4);
+	CHECK(batcher.GetBatches()[1].instanceCount == 2 && batcher.GetBatches()[2].firstInstance == 3);
+}
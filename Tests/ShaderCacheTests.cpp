@@ -0,0 +1,262 @@
+#include "Test.h"
+#include "StubShaderCompiler.h"
+#include "../ShaderCache.h"
+#include "../ShaderPermutation.h"
+#include "../ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+ShaderCompileRequest MakeRequest(const std::filesystem::path& filePath, const wchar_t* profile = L"vs_6_0") {
+	ShaderCompileRequest request;
+	request.filePath = filePath;
+	request.profile = profile;
+	return request;
+}
+
+uint64_t GetKey(const ShaderCache& cache, const ShaderCompileRequest& request) {
+	std::vector<uint8_t> source;
+	uint64_t key = 0;
+	CHECK(cache.ComputeKey(request, source, key));
+	return key;
+}
+
+}
+
+// 1回目はコンパイルして保存し、2回目はキャッシュから同じものを返す。別のインスタンス（次の起動）からも読める
+TEST(ShaderCacheHitsAfterCompile) {
+	TemporaryDirectory directory("hit");
+	WriteText(directory.GetPath() / "Object3d.VS.hlsl", "float4 main() : SV_POSITION { return 0; }");
+	StubShaderCompiler compiler;
+	ShaderCache cache;
+	cache.Initialize(directory.GetPath() / "cache", &compiler);
+	ShaderCompileRequest request = MakeRequest(directory.GetPath() / "Object3d.VS.hlsl");
+
+	std::vector<uint8_t> first;
+	std::vector<uint8_t> second;
+	std::string message;
+	bool cached = true;
+	CHECK(cache.GetOrCompile(request, first, message, &cached));
+	CHECK(!cached);
+	CHECK(cache.GetOrCompile(request, second, message, &cached));
+	CHECK(cached);
+	CHECK(first == second);
+	CHECK(compiler.compileCount == 1);
+
+	ShaderCache nextRun;
+	nextRun.Initialize(directory.GetPath() / "cache", &compiler);
+	std::vector<uint8_t> third;
+	CHECK(nextRun.GetOrCompile(request, third, message, &cached));
+	CHECK(cached);
+	CHECK(third == first);
+	CHECK(compiler.compileCount == 1);
+	ShaderCache::Statistics statistics = cache.GetStatistics();
+	CHECK(statistics.hitCount == 1 && statistics.missCount == 1 && statistics.failedCount == 0);
+}
+
+// キーはソース・includeしたファイル・定義・プロファイル・PDBの書き出し先・コンパイラのバージョンで変わる
+TEST(ShaderCacheKeyCoversInputs) {
+	TemporaryDirectory directory("key");
+	std::filesystem::create_directories(directory.GetPath() / "include");
+	WriteText(directory.GetPath() / "Object3d.PS.hlsl", "#include \"Object3d.hlsli\"\n#include \"include/Common.hlsli\"\nfloat4 main() : SV_TARGET { return 0; }");
+	WriteText(directory.GetPath() / "Object3d.hlsli", "struct VertexShaderOutput { float4 position : SV_POSITION; };");
+	WriteText(directory.GetPath() / "include" / "Common.hlsli", "#include \"Nested.hlsli\"\n");
+	WriteText(directory.GetPath() / "include" / "Nested.hlsli", "static const float kPi = 3.14159f;");
+	StubShaderCompiler compiler;
+	ShaderCache cache;
+	cache.Initialize(directory.GetPath() / "cache", &compiler);
+	ShaderCompileRequest request = MakeRequest(directory.GetPath() / "Object3d.PS.hlsl", L"ps_6_0");
+	const uint64_t baseKey = GetKey(cache, request);
+	CHECK(GetKey(cache, request) == baseKey);
+
+	ShaderCompileRequest defined = request;
+	defined.defines.push_back(L"USE_TEXTURE=1");
+	CHECK(GetKey(cache, defined) != baseKey);
+	ShaderCompileRequest otherProfile = request;
+	otherProfile.profile = L"ps_6_6";
+	CHECK(GetKey(cache, otherProfile) != baseKey);
+	// 引数の区切りが変わったものは別のキー
+	ShaderCompileRequest joined = request;
+	joined.arguments = { L"-O3-Zi" };
+	ShaderCompileRequest split = request;
+	split.arguments = { L"-O3", L"-Zi" };
+	CHECK(GetKey(cache, joined) != GetKey(cache, split));
+	// PDBはコンパイルしたときにしか書かないので、書き出し先が変われば作り直す
+	ShaderCompileRequest withPdb = request;
+	withPdb.pdbDirectory = directory.GetPath() / "pdb";
+	CHECK(GetKey(cache, withPdb) != baseKey);
+
+	// include先のincludeの中身が変わっても作り直す
+	WriteText(directory.GetPath() / "include" / "Nested.hlsli", "static const float kPi = 3.1415927f;");
+	const uint64_t nestedChangedKey = GetKey(cache, request);
+	CHECK(nestedChangedKey != baseKey);
+	WriteText(directory.GetPath() / "Object3d.hlsli", "struct VertexShaderOutput { float4 position : SV_POSITION; float2 texcoord : TEXCOORD0; };");
+	CHECK(GetKey(cache, request) != nestedChangedKey);
+
+	const uint64_t keyBeforeUpdate = GetKey(cache, request);
+	compiler.version = "stub 2";
+	CHECK(GetKey(cache, request) != keyBeforeUpdate);
+}
+
+// 壊れたキャッシュは読み捨ててコンパイルし直し、失敗したコンパイルは保存しない
+TEST(ShaderCacheRecoversFromCorruptionAndFailure) {
+	TemporaryDirectory directory("corrupt");
+	WriteText(directory.GetPath() / "Good.hlsl", "float4 main() : SV_POSITION { return 1; }");
+	WriteText(directory.GetPath() / "Bad.hlsl", "float4 main() : SV_POSITION { error }");
+	StubShaderCompiler compiler;
+	ShaderCache cache;
+	cache.Initialize(directory.GetPath() / "cache", &compiler);
+	ShaderCompileRequest good = MakeRequest(directory.GetPath() / "Good.hlsl");
+	std::vector<uint8_t> object;
+	std::string message;
+	bool cached = false;
+	CHECK(cache.GetOrCompile(good, object, message));
+	const std::vector<uint8_t> expected = object;
+
+	// 末尾を1バイト書き換える
+	std::filesystem::path entryPath = cache.GetEntryPath(GetKey(cache, good));
+	{
+		std::fstream file(entryPath, std::ios::binary | std::ios::in | std::ios::out);
+		file.seekp(-1, std::ios::end);
+		file.put('#');
+	}
+	CHECK(cache.GetOrCompile(good, object, message, &cached));
+	CHECK(!cached);
+	CHECK(object == expected);
+	CHECK(cache.GetStatistics().corruptCount == 1);
+	CHECK(cache.GetOrCompile(good, object, message, &cached));
+	CHECK(cached);
+
+	ShaderCompileRequest bad = MakeRequest(directory.GetPath() / "Bad.hlsl");
+	CHECK(!cache.GetOrCompile(bad, object, message));
+	CHECK(message.find("stub failure") != std::string::npos);
+	CHECK(!std::filesystem::exists(cache.GetEntryPath(GetKey(cache, bad))));
+	uint32_t compileCountBefore = compiler.compileCount;
+	CHECK(!cache.GetOrCompile(bad, object, message));
+	CHECK(compiler.compileCount == compileCountBefore + 1);
+
+	CHECK(!cache.GetOrCompile(MakeRequest(directory.GetPath() / "Missing.hlsl"), object, message));
+	CHECK(cache.GetStatistics().failedCount == 3);
+}
+
+// まとめてコンパイルした結果は依頼と同じ順に並び、失敗はファイル名と定義付きで集まる
+TEST(ShaderCacheBatchKeepsOrder) {
+	TemporaryDirectory directory("batch");
+	WriteText(directory.GetPath() / "Shader.hlsl", "float4 main() : SV_TARGET { return 0; }");
+	WriteText(directory.GetPath() / "Broken.hlsl", "error");
+	StubShaderCompiler compiler;
+	ShaderCache cache;
+	cache.Initialize(directory.GetPath() / "cache", &compiler);
+	ThreadPool threadPool(3);
+	std::vector<ShaderCompileRequest> requests;
+	for (int i = 0; i < 40; ++i) {
+		ShaderCompileRequest request = MakeRequest(directory.GetPath() / "Shader.hlsl", L"ps_6_0");
+		request.defines.push_back(L"VARIANT=" + std::to_wstring(i));
+		requests.push_back(request);
+	}
+	requests.push_back(MakeRequest(directory.GetPath() / "Broken.hlsl", L"ps_6_0"));
+	requests.back().defines.push_back(L"BROKEN_VARIANT");
+
+	for (int pass = 0; pass < 2; ++pass) {
+		std::vector<std::future<ShaderCompileResult>> futures = cache.CompileBatch(requests, threadPool);
+		std::vector<ShaderCompileResult> results;
+		ShaderBatchDiagnostics diagnostics = ShaderCache::WaitForBatch(requests, futures, results);
+		CHECK(results.size() == requests.size());
+		CHECK(diagnostics.succeededCount == 40 && diagnostics.failedCount == 1);
+		CHECK(diagnostics.cachedCount == (pass == 0 ? 0u : 40u));
+		CHECK(diagnostics.messages.find("Broken.hlsl") != std::string::npos);
+		CHECK(diagnostics.messages.find("BROKEN_VARIANT") != std::string::npos);
+		for (int i = 0; i < 40; ++i) {
+			std::string tail = "|VARIANT=" + std::to_string(i);
+			const std::vector<uint8_t>& object = results[i].object;
+			CHECK(object.size() > tail.size() && std::equal(tail.begin(), tail.end(), object.end() - tail.size()));
+		}
+	}
+	CHECK(compiler.compileCount == 40 + 2);
+}
+
+// 上限を超えたら最後に使ったのが古いものから消し、残った一時ファイルも消す
+TEST(ShaderCachePrunesLeastRecentlyUsed) {
+	TemporaryDirectory directory("prune");
+	StubShaderCompiler compiler;
+	std::filesystem::path cacheDirectory = directory.GetPath() / "cache";
+	ShaderCache cache;
+	cache.Initialize(cacheDirectory, &compiler);
+	const int kShaderCount = 8;
+	std::vector<ShaderCompileRequest> requests;
+	std::vector<uint8_t> object;
+	std::string message;
+	for (int i = 0; i < kShaderCount; ++i) {
+		std::filesystem::path path = directory.GetPath() / ("Shader" + std::to_string(i) + ".hlsl");
+		WriteText(path, std::string(1000, char('a' + i)));
+		requests.push_back(MakeRequest(path));
+		CHECK(cache.GetOrCompile(requests.back(), object, message));
+	}
+	// 作った順に1時間ずつ古い時刻にする
+	auto now = std::filesystem::file_time_type::clock::now();
+	std::vector<std::filesystem::path> entryPaths;
+	for (int i = 0; i < kShaderCount; ++i) {
+		entryPaths.push_back(cache.GetEntryPath(GetKey(cache, requests[i])));
+		std::filesystem::last_write_time(entryPaths[i], now - std::chrono::hours(kShaderCount - i));
+	}
+	// 一番古い0番を読むと、最後に使った時刻が今になって消されなくなる
+	bool cached = false;
+	CHECK(cache.GetOrCompile(requests[0], object, message, &cached));
+	CHECK(cached);
+	WriteText(cacheDirectory / "0123456789abcdef.bin.7.tmp", "partial");
+
+	uint64_t entrySize = std::filesystem::file_size(entryPaths[0]);
+	ShaderCache nextRun;
+	nextRun.Initialize(cacheDirectory, &compiler, entrySize * 5);
+	CHECK(nextRun.GetStatistics().evictedCount == 3);
+	CHECK(std::filesystem::exists(entryPaths[0]));
+	for (int i = 1; i < kShaderCount; ++i) {
+		// 1～3番が消え、4～7番が残る
+		CHECK(std::filesystem::exists(entryPaths[i]) == (i >= 4));
+	}
+	CHECK(!std::filesystem::exists(cacheDirectory / "0123456789abcdef.bin.7.tmp"));
+
+	// 上限に収まっていれば何も消さない
+	ShaderCache thirdRun;
+	thirdRun.Initialize(cacheDirectory, &compiler, entrySize * 5);
+	CHECK(thirdRun.GetStatistics().evictedCount == 0);
+}
+
+// バリアントの上限は数で数える。失敗したバリアントはClearFailedで消えるまで上限の枠を使い、コンパイルし直さない
+TEST(ShaderPermutationClearFailedFreesCap) {
+	TemporaryDirectory directory("permutation");
+	const std::filesystem::path sourcePath = directory.GetPath() / "Object3d.PS.hlsl";
+	WriteText(sourcePath, "error");
+	StubShaderCompiler compiler;
+	ShaderCache cache;
+	cache.Initialize(directory.GetPath() / "cache", &compiler);
+	ThreadPool threadPool(2);
+	ShaderPermutationSet permutations;
+	permutations.Initialize(&cache, MakeRequest(sourcePath, L"ps_6_0"), { "TEXTURED", "ALPHA_TEST" }, 2);
+
+	CHECK(permutations.Request(permutations.MakeMask({ "TEXTURED" })));
+	CHECK(permutations.Request(0));
+	CHECK(!permutations.Request(permutations.MakeMask({ "ALPHA_TEST" })));
+	CHECK(permutations.CompilePending(threadPool).failedCount == 2);
+	// 失敗したものは申告し直してもコンパイルしない
+	uint32_t compileCount = compiler.compileCount;
+	CHECK(permutations.CompilePending(threadPool).failedCount == 0);
+	CHECK(compiler.compileCount == compileCount);
+
+	// 直したらClearFailedで枠が空き、別のバリアントも申告できる
+	WriteText(sourcePath, "float4 main() : SV_TARGET { return 1; }");
+	CHECK(permutations.ClearFailed() == 2);
+	CHECK(permutations.GetReport().requestedCount == 0);
+	CHECK(permutations.Request(permutations.MakeMask({ "ALPHA_TEST" })));
+	CHECK(permutations.Request(permutations.MakeMask({ "TEXTURED" })));
+	ShaderBatchDiagnostics diagnostics = permutations.CompilePending(threadPool);
+	CHECK(diagnostics.succeededCount == 2 && diagnostics.failedCount == 0);
+	CHECK(permutations.Find(permutations.MakeMask({ "TEXTURED" })) != nullptr);
+	ShaderPermutationSet::Report report = permutations.GetReport();
+	CHECK(report.variantCap == 2 && report.compiledCount == 2 && report.rejectedCount == 1);
+}
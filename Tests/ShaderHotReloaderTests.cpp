@@ -0,0 +1,178 @@
+#include "Test.h"
+#include "StubShaderCompiler.h"
+#include "../FileWatcher.h"
+#include "../ShaderHotReloader.h"
+#include "../ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// ファイルの通知は別のスレッドから届くので、conditionが満たされるまで少しずつ待つ。時間内に満たされなければfalse
+template<class F>
+bool WaitUntil(F condition) {
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (!condition()) {
+		if (std::chrono::steady_clock::now() > deadline) {
+			return false;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	return true;
+}
+
+// watcherで通知が来るまで待ち、来たものを全て返す
+std::vector<std::filesystem::path> PollUntilChanged(FileWatcher& watcher) {
+	std::vector<std::filesystem::path> changes;
+	WaitUntil([&]() {
+		std::vector<std::filesystem::path> polled = watcher.Poll();
+		changes.insert(changes.end(), polled.begin(), polled.end());
+		return !changes.empty();
+	});
+	// 同じ保存の通知が遅れて届く分も拾う
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	std::vector<std::filesystem::path> late = watcher.Poll();
+	changes.insert(changes.end(), late.begin(), late.end());
+	std::sort(changes.begin(), changes.end());
+	changes.erase(std::unique(changes.begin(), changes.end()), changes.end());
+	return changes;
+}
+
+ShaderCompileRequest MakeRequest(const std::filesystem::path& filePath, const wchar_t* profile) {
+	ShaderCompileRequest request;
+	request.filePath = filePath;
+	request.profile = profile;
+	return request;
+}
+
+// VSとPSの組を起動時と同じようにコンパイルして登録する
+uint32_t AddObject3dProgram(ShaderHotReloader& reloader, ShaderCache& cache, ThreadPool& threadPool, const std::filesystem::path& directory) {
+	std::vector<ShaderCompileRequest> requests = {
+		MakeRequest(directory / "Object3d.VS.hlsl", L"vs_6_0"),
+		MakeRequest(directory / "Object3d.PS.hlsl", L"ps_6_0"),
+	};
+	std::vector<std::future<ShaderCompileResult>> futures = cache.CompileBatch(requests, threadPool);
+	std::vector<ShaderCompileResult> results;
+	ShaderBatchDiagnostics diagnostics = ShaderCache::WaitForBatch(requests, futures, results);
+	return reloader.AddProgram(requests, results, diagnostics.messages);
+}
+
+// reloaderのコンパイルが終わって、結果が差し替わるか失敗が数えられるまでUpdateを回す
+std::vector<uint32_t> UpdateUntilFinished(ShaderHotReloader& reloader) {
+	ShaderHotReloader::Statistics before = reloader.GetStatistics();
+	std::vector<uint32_t> reloaded;
+	WaitUntil([&]() {
+		std::vector<uint32_t> ids = reloader.Update();
+		reloaded.insert(reloaded.end(), ids.begin(), ids.end());
+		ShaderHotReloader::Statistics statistics = reloader.GetStatistics();
+		return statistics.reloadCount != before.reloadCount || statistics.failedCount != before.failedCount;
+	});
+	return reloaded;
+}
+
+std::string GetObjectText(const ShaderCompileResult& result) {
+	return std::string(result.object.begin(), result.object.end());
+}
+
+}
+
+// 書き込んで閉じたファイルと、別名で書いて置き換えたファイルが1回ずつ通知される。消したファイルは通知しない
+TEST(FileWatcherReportsWrittenFiles) {
+	TemporaryDirectory directory("watcher");
+	FileWatcher watcher;
+	CHECK(watcher.Initialize(directory.GetPath()));
+	CHECK(watcher.Poll().empty());
+
+	WriteText(directory.GetPath() / "a.hlsl", "1");
+	WriteText(directory.GetPath() / "a.hlsl", "2");
+	std::vector<std::filesystem::path> changes = PollUntilChanged(watcher);
+	CHECK(changes == std::vector<std::filesystem::path>{ directory.GetPath() / "a.hlsl" });
+
+	// エディタの保存のように、一時ファイルに書いてから置き換える
+	WriteText(directory.GetPath() / "b.tmp", "3");
+	std::filesystem::rename(directory.GetPath() / "b.tmp", directory.GetPath() / "b.hlsli");
+	changes = PollUntilChanged(watcher);
+	CHECK(std::find(changes.begin(), changes.end(), directory.GetPath() / "b.hlsli") != changes.end());
+
+	std::filesystem::remove(directory.GetPath() / "a.hlsl");
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	changes = watcher.Poll();
+	CHECK(std::find(changes.begin(), changes.end(), directory.GetPath() / "a.hlsl") == changes.end());
+
+	// 止めた後は何も返さない
+	watcher.Finalize();
+	WriteText(directory.GetPath() / "c.hlsl", "4");
+	CHECK(watcher.Poll().empty());
+}
+
+// 組の全てが通ったときだけ結果を差し替え、失敗したら前の結果を持ったままエラーを残す
+TEST(ShaderHotReloaderSwapsOnlyWhenAllSucceed) {
+	TemporaryDirectory directory("reloader");
+	TemporaryDirectory cacheDirectory("reloader-cache");
+	WriteText(directory.GetPath() / "Object3d.hlsli", "struct VertexShaderOutput {};");
+	WriteText(directory.GetPath() / "Object3d.VS.hlsl", "#include \"Object3d.hlsli\"\nvs 1");
+	WriteText(directory.GetPath() / "Object3d.PS.hlsl", "#include \"Object3d.hlsli\"\nps 1");
+	StubShaderCompiler compiler;
+	ShaderCache cache;
+	cache.Initialize(cacheDirectory.GetPath(), &compiler);
+	ThreadPool threadPool(2);
+	ShaderHotReloader reloader;
+	CHECK(reloader.Initialize(&cache, &threadPool, directory.GetPath()));
+	uint32_t programId = AddObject3dProgram(reloader, cache, threadPool, directory.GetPath());
+	CHECK(reloader.GetResults(programId).size() == 2);
+
+	// PSだけ壊すと、VSは通っても差し替えない
+	WriteText(directory.GetPath() / "Object3d.PS.hlsl", "ps error");
+	CHECK(UpdateUntilFinished(reloader).empty());
+	CHECK(reloader.GetStatistics().failedCount == 1);
+	CHECK(!reloader.GetErrors(programId).empty());
+	CHECK(GetObjectText(reloader.GetResults(programId)[1]).find("ps 1") != std::string::npos);
+
+	// 直すと差し替わり、エラーが消える
+	WriteText(directory.GetPath() / "Object3d.PS.hlsl", "#include \"Object3d.hlsli\"\nps 2");
+	CHECK(UpdateUntilFinished(reloader) == std::vector<uint32_t>{ programId });
+	CHECK(reloader.GetErrors(programId).empty());
+	CHECK(GetObjectText(reloader.GetResults(programId)[0]).find("vs 1") != std::string::npos);
+	CHECK(GetObjectText(reloader.GetResults(programId)[1]).find("ps 2") != std::string::npos);
+
+	// includeしたファイルだけが変わっても、コンパイルし直す
+	WriteText(directory.GetPath() / "Object3d.hlsli", "struct VertexShaderOutput { float4 position : SV_POSITION; };");
+	CHECK(UpdateUntilFinished(reloader) == std::vector<uint32_t>{ programId });
+	CHECK(reloader.GetStatistics().reloadCount == 2);
+	CHECK(!reloader.IsCompiling());
+	reloader.Finalize();
+}
+
+// 保存されても中身が変わっていなければコンパイルしない。関係の無いファイルの変更は見ない
+TEST(ShaderHotReloaderSkipsUnchangedContent) {
+	TemporaryDirectory directory("unchanged");
+	TemporaryDirectory cacheDirectory("unchanged-cache");
+	WriteText(directory.GetPath() / "Object3d.VS.hlsl", "vs 1");
+	WriteText(directory.GetPath() / "Object3d.PS.hlsl", "ps 1");
+	StubShaderCompiler compiler;
+	ShaderCache cache;
+	cache.Initialize(cacheDirectory.GetPath(), &compiler);
+	ThreadPool threadPool(2);
+	ShaderHotReloader reloader;
+	CHECK(reloader.Initialize(&cache, &threadPool, directory.GetPath()));
+	uint32_t programId = AddObject3dProgram(reloader, cache, threadPool, directory.GetPath());
+	uint32_t compileCount = compiler.compileCount;
+
+	WriteText(directory.GetPath() / "Object3d.VS.hlsl", "vs 1");
+	WriteText(directory.GetPath() / "notes.txt", "vs 2");
+	// 落ち着くまでの時間より長く回しても、何も始まらない
+	auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(400);
+	while (std::chrono::steady_clock::now() < end) {
+		CHECK(reloader.Update().empty());
+		CHECK(!reloader.IsCompiling());
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	CHECK(compiler.compileCount == compileCount);
+	CHECK(reloader.GetStatistics().reloadCount == 0);
+	CHECK(GetObjectText(reloader.GetResults(programId)[0]).find("vs 1") != std::string::npos);
+	reloader.Finalize();
+}
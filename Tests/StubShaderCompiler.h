@@ -0,0 +1,58 @@
+#pragma once
+#include "../ShaderCache.h"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+// DXCの代わりのコンパイラ。ソースの後ろにエントリーポイント・プロファイル・定義を付けたものをオブジェクトとする
+// ソースに"error"を含むと失敗する
+class StubShaderCompiler : public IShaderCompiler {
+public:
+	std::string GetVersionString() const override { return version; }
+	bool Compile(const ShaderCompileRequest& request, const std::vector<uint8_t>& source, std::vector<uint8_t>& object, std::string& message) override {
+		++compileCount;
+		std::string text(source.begin(), source.end());
+		if (text.find("error") != std::string::npos) {
+			message = request.filePath.string() + "(1,1): error: stub failure\n";
+			return false;
+		}
+		object = source;
+		std::wstring suffix = L"|" + request.entryPoint + L"|" + request.profile;
+		for (const std::wstring& define : request.defines) {
+			suffix += L"|" + define;
+		}
+		for (wchar_t c : suffix) {
+			object.push_back(uint8_t(c));
+		}
+		return true;
+	}
+
+	std::string version = "stub 1";
+	std::atomic<uint32_t> compileCount = 0;
+};
+
+// テストごとの作業ディレクトリ。終わったら消す
+class TemporaryDirectory {
+public:
+	explicit TemporaryDirectory(const char* name) {
+		path_ = std::filesystem::temp_directory_path() / (std::string("DirectXGameTests-") + name + "-" + std::to_string(std::random_device()()));
+		std::filesystem::remove_all(path_);
+		std::filesystem::create_directories(path_);
+	}
+	~TemporaryDirectory() {
+		std::error_code errorCode;
+		std::filesystem::remove_all(path_, errorCode);
+	}
+	const std::filesystem::path& GetPath() const { return path_; }
+
+private:
+	std::filesystem::path path_;
+};
+
+inline void WriteText(const std::filesystem::path& path, const std::string& text) {
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file << text;
+}
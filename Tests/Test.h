@@ -0,0 +1,42 @@
+#pragma once
+// テスト用の最小限の仕組み。Windowsでも他のOSでもビルドできるように標準ライブラリだけを使う
+// TEST(名前)で登録した関数は引数なしの実行で全て走る。BENCHMARK(名前)は --benchmark-名前 で走る
+// CHECKが失敗しても止めずに場所と式を出し、最後に失敗があれば終了コードを1にする
+#include <chrono>
+#include <cstdio>
+
+using TestFunction = void (*)();
+
+// 静的初期化で登録する。ベンチマークは通常のテストの一覧に入れない
+struct TestRegistration {
+	TestRegistration(const char* name, TestFunction function, bool isBenchmark);
+};
+
+void ReportCheckFailure(const char* file, int line, const char* expression);
+
+#define TEST(name) \
+	static void name(); \
+	static TestRegistration name##Registration(#name, name, false); \
+	static void name()
+
+#define BENCHMARK(name) \
+	static void Benchmark_##name(); \
+	static TestRegistration Benchmark_##name##Registration(#name, Benchmark_##name, true); \
+	static void Benchmark_##name()
+
+#define CHECK(expression) \
+	do { \
+		if (!(expression)) { \
+			ReportCheckFailure(__FILE__, __LINE__, #expression); \
+		} \
+	} while (false)
+
+// ベンチマーク用の経過時間（秒）
+class Stopwatch {
+public:
+	Stopwatch() : start_(std::chrono::steady_clock::now()) {}
+	double GetSeconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count(); }
+
+private:
+	std::chrono::steady_clock::time_point start_;
+};
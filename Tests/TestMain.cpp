@@ -0,0 +1,77 @@
+// OSに依存しない部分の単体テストとベンチマーク
+// 使い方: Tests                      全てのテストを実行する
+//         Tests --benchmark-<名前>   ベンチマークを1つ実行する（--listで一覧）
+#include "Test.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+struct RegisteredTest {
+	const char* name;
+	TestFunction function;
+	bool isBenchmark;
+};
+
+// 静的初期化の順序に依存しないよう関数内のstaticにする
+std::vector<RegisteredTest>& GetRegisteredTests() {
+	static std::vector<RegisteredTest> tests;
+	return tests;
+}
+
+int g_checkFailures = 0;
+
+void PrintUsage() {
+	printf("usage: Tests [--list] [--benchmark-<name>]\nbenchmarks:");
+	for (const RegisteredTest& test : GetRegisteredTests()) {
+		if (test.isBenchmark) {
+			printf(" %s", test.name);
+		}
+	}
+	printf("\n");
+}
+
+}
+
+TestRegistration::TestRegistration(const char* name, TestFunction function, bool isBenchmark) {
+	GetRegisteredTests().push_back({ name, function, isBenchmark });
+}
+
+void ReportCheckFailure(const char* file, int line, const char* expression) {
+	printf("  %s(%d): CHECK(%s) failed\n", file, line, expression);
+	++g_checkFailures;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc > 1) {
+		std::string argument = argv[1];
+		const std::string kBenchmarkPrefix = "--benchmark-";
+		if (argument.compare(0, kBenchmarkPrefix.size(), kBenchmarkPrefix) == 0) {
+			std::string name = argument.substr(kBenchmarkPrefix.size());
+			for (const RegisteredTest& test : GetRegisteredTests()) {
+				if (test.isBenchmark && name == test.name) {
+					test.function();
+					return g_checkFailures ? 1 : 0;
+				}
+			}
+		}
+		PrintUsage();
+		return argument == "--list" ? 0 : 1;
+	}
+
+	int failedTests = 0;
+	int testCount = 0;
+	for (const RegisteredTest& test : GetRegisteredTests()) {
+		if (test.isBenchmark) {
+			continue;
+		}
+		int failuresBefore = g_checkFailures;
+		test.function();
+		bool passed = g_checkFailures == failuresBefore;
+		printf("[%s] %s\n", passed ? "  ok  " : "failed", test.name);
+		failedTests += passed ? 0 : 1;
+		++testCount;
+	}
+	printf("%d/%d tests passed\n", testCount - failedTests, testCount);
+	return failedTests ? 1 : 0;
+}
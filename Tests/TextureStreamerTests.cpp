@@ -0,0 +1,372 @@
+#include "Test.h"
+#include "../StagingRing.h"
+#include "../TextureStreamer.h"
+#include "../ThreadPool.h"
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+uint64_t HashBytes(const uint8_t* data, size_t size) {
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; ++i) {
+		hash = (hash ^ data[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+// "<番号>_<幅>x<高さ>_<mip数>" という名前から、番号で決まる模様のRGBA8の画素を作る
+bool DecodeSyntheticTexture(const std::string& filePath, DecodedTexture& texture) {
+	uint32_t id = 0;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t mipLevels = 0;
+	if (sscanf(filePath.c_str(), "%u_%ux%u_%u", &id, &width, &height, &mipLevels) != 4) {
+		return false;
+	}
+	texture.width = width;
+	texture.height = height;
+	texture.mipLevels = mipLevels;
+	// DXGI_FORMAT_R8G8B8A8_UNORM
+	texture.format = 28;
+	std::shared_ptr<std::vector<uint8_t>> pixels = std::make_shared<std::vector<uint8_t>>();
+	std::vector<size_t> offsets;
+	for (uint32_t mip = 0; mip < mipLevels; ++mip) {
+		offsets.push_back(pixels->size());
+		pixels->resize(pixels->size() + size_t(std::max(width >> mip, 1u)) * std::max(height >> mip, 1u) * 4);
+	}
+	for (size_t i = 0; i < pixels->size(); ++i) {
+		(*pixels)[i] = uint8_t(i * 31 + id * 7);
+	}
+	for (uint32_t mip = 0; mip < mipLevels; ++mip) {
+		uint32_t mipWidth = std::max(width >> mip, 1u);
+		uint32_t mipHeight = std::max(height >> mip, 1u);
+		texture.subresources.push_back({ pixels->data() + offsets[mip], size_t(mipWidth) * 4, size_t(mipWidth) * mipHeight * 4, mipWidth, mipHeight });
+	}
+	texture.storage = pixels;
+	return true;
+}
+
+// CopyQueueの代わり。ステージングは本物のメモリで、コピーはExecuteNextかWaitForValueで実行する
+// 積んだときのステージングの内容と実行するときの内容を比べ、まだ使っている領域を上書きされていないかを見る
+// verifyをfalseにすると確認を省き、コピーだけを行う（ベンチマーク用）
+class FakeUploadBackend : public ITextureUploadBackend {
+public:
+	static constexpr uint64_t kSubresourceAlignment = 512;
+
+	FakeUploadBackend(uint64_t stagingCapacity, uint64_t stagingAlignment, bool verify = true)
+		: staging_(stagingCapacity), stagingAlignment_(stagingAlignment), verify_(verify) {}
+	~FakeUploadBackend() override {
+		for (FakeTexture* texture : textures_) {
+			delete texture;
+		}
+	}
+
+	uint64_t GetStagingCapacity() const override { return staging_.size(); }
+	uint64_t GetStagingAlignment() const override { return stagingAlignment_; }
+
+	void* CreateTexture(const DecodedTexture& texture, uint64_t* uploadSize) override {
+		FakeTexture* fakeTexture = new FakeTexture();
+		*uploadSize = 0;
+		for (const TextureSubresource& subresource : texture.subresources) {
+			*uploadSize = AlignUp(*uploadSize, kSubresourceAlignment) + subresource.slicePitch;
+		}
+		textures_.insert(fakeTexture);
+		return fakeTexture;
+	}
+	void DestroyTexture(void* texture) override {
+		auto it = textures_.find(static_cast<FakeTexture*>(texture));
+		CHECK(it != textures_.end());
+		if (it != textures_.end()) {
+			delete *it;
+			textures_.erase(it);
+		}
+	}
+
+	void RecordUpload(void* texture, const DecodedTexture& decoded, uint64_t stagingOffset) override {
+		CHECK(stagingOffset == StagingRing::kInvalidOffset || stagingOffset % stagingAlignment_ == 0);
+		Copy copy;
+		copy.texture = static_cast<FakeTexture*>(texture);
+		// リングに入らないものは専用の一時バッファに書く
+		uint8_t* destination = nullptr;
+		if (stagingOffset == StagingRing::kInvalidOffset) {
+			copy.temporary = std::make_shared<std::vector<uint8_t>>();
+			uint64_t size = 0;
+			for (const TextureSubresource& subresource : decoded.subresources) {
+				size = AlignUp(size, kSubresourceAlignment) + subresource.slicePitch;
+			}
+			copy.temporary->resize(size);
+			destination = copy.temporary->data();
+			++temporaryCount_;
+		} else {
+			destination = staging_.data() + stagingOffset;
+		}
+		uint64_t offset = 0;
+		for (const TextureSubresource& subresource : decoded.subresources) {
+			offset = AlignUp(offset, kSubresourceAlignment);
+			if (stagingOffset != StagingRing::kInvalidOffset && stagingOffset + offset + subresource.slicePitch > staging_.size()) {
+				++outOfBoundsCount_;
+				return;
+			}
+			std::memcpy(destination + offset, subresource.pixels, subresource.slicePitch);
+			copy.ranges.push_back({ offset, subresource.slicePitch });
+			offset += subresource.slicePitch;
+		}
+		copy.source = destination;
+		copy.sourceHash = verify_ ? HashBytes(destination, size_t(offset)) : 0;
+		copy.sourceSize = offset;
+		recordedCopies_.push_back(copy);
+	}
+	uint64_t Submit() override {
+		++lastSignaledValue_;
+		submissions_.push_back({ lastSignaledValue_, std::move(recordedCopies_) });
+		recordedCopies_.clear();
+		return lastSignaledValue_;
+	}
+	uint64_t GetCompletedValue() override { return completedValue_; }
+	void WaitForValue(uint64_t value) override {
+		while (completedValue_ < value && !submissions_.empty()) {
+			ExecuteNext();
+		}
+	}
+	void OnResident(uint32_t, void* texture, const DecodedTexture& decoded) override {
+		++residentCount_;
+		if (!verify_) {
+			return;
+		}
+		// 転送先の内容はデコードした画素と同じ
+		const FakeTexture* fakeTexture = static_cast<const FakeTexture*>(texture);
+		std::vector<uint8_t> expected;
+		for (const TextureSubresource& subresource : decoded.subresources) {
+			expected.insert(expected.end(), subresource.pixels, subresource.pixels + subresource.slicePitch);
+		}
+		residentMismatchCount_ += fakeTexture->bytes == expected ? 0 : 1;
+	}
+
+	// GPUが1回分のSubmitを実行する
+	void ExecuteNext() {
+		if (submissions_.empty()) {
+			return;
+		}
+		for (const Copy& copy : submissions_.front().copies) {
+			if (verify_ && HashBytes(copy.source, size_t(copy.sourceSize)) != copy.sourceHash) {
+				++corruptedCount_;
+			}
+			copy.texture->bytes.clear();
+			for (const Range& range : copy.ranges) {
+				copy.texture->bytes.insert(copy.texture->bytes.end(), copy.source + range.offset, copy.source + range.offset + range.size);
+			}
+		}
+		completedValue_ = submissions_.front().fenceValue;
+		submissions_.erase(submissions_.begin());
+	}
+
+	size_t GetLiveTextureCount() const { return textures_.size(); }
+	uint32_t GetResidentCount() const { return residentCount_; }
+	uint32_t GetResidentMismatchCount() const { return residentMismatchCount_; }
+	uint32_t GetCorruptedCount() const { return corruptedCount_; }
+	uint32_t GetOutOfBoundsCount() const { return outOfBoundsCount_; }
+	uint32_t GetTemporaryCount() const { return temporaryCount_; }
+
+private:
+	struct FakeTexture {
+		std::vector<uint8_t> bytes;
+	};
+	struct Range {
+		uint64_t offset;
+		uint64_t size;
+	};
+	struct Copy {
+		FakeTexture* texture = nullptr;
+		const uint8_t* source = nullptr;
+		std::shared_ptr<std::vector<uint8_t>> temporary;
+		std::vector<Range> ranges;
+		uint64_t sourceHash = 0;
+		uint64_t sourceSize = 0;
+	};
+	struct Submission {
+		uint64_t fenceValue;
+		std::vector<Copy> copies;
+	};
+
+	std::vector<uint8_t> staging_;
+	uint64_t stagingAlignment_ = 0;
+	bool verify_ = true;
+	std::set<FakeTexture*> textures_;
+	std::vector<Copy> recordedCopies_;
+	std::vector<Submission> submissions_;
+	uint64_t lastSignaledValue_ = 0;
+	uint64_t completedValue_ = 0;
+	uint32_t residentCount_ = 0;
+	uint32_t residentMismatchCount_ = 0;
+	uint32_t corruptedCount_ = 0;
+	uint32_t outOfBoundsCount_ = 0;
+	uint32_t temporaryCount_ = 0;
+};
+
+// テクスチャの名前を作る。大きさはmaxSizeまでの2の累乗
+std::vector<std::string> MakeTextureNames(uint32_t count, uint32_t maxSizeLog2, uint32_t seed) {
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<uint32_t> sizeLog2(2, maxSizeLog2);
+	std::vector<std::string> names;
+	for (uint32_t i = 0; i < count; ++i) {
+		uint32_t width = 1u << sizeLog2(random);
+		uint32_t height = 1u << sizeLog2(random);
+		uint32_t mipLevels = 1;
+		while ((std::max(width, height) >> mipLevels) != 0 && mipLevels < 3) {
+			++mipLevels;
+		}
+		names.push_back(std::to_string(i) + "_" + std::to_string(width) + "x" + std::to_string(height) + "_" + std::to_string(mipLevels));
+	}
+	return names;
+}
+
+}
+
+// 割り当て・Close・Retireを乱数で繰り返し、使用中の領域同士が重ならず、範囲内に収まることを見る
+TEST(StagingRingNeverOverlapsLiveRegions) {
+	const uint64_t kCapacity = 1 << 20;
+	std::mt19937 random(10);
+	std::uniform_int_distribution<uint64_t> size(1, kCapacity / 6);
+	std::uniform_int_distribution<int> alignmentLog2(0, 12);
+	std::uniform_int_distribution<int> percent(0, 99);
+	StagingRing ring;
+	ring.Initialize(kCapacity);
+	struct Region {
+		uint64_t offset;
+		uint64_t size;
+		uint64_t fenceValue;
+	};
+	std::vector<Region> live;
+	uint64_t fenceValue = 0;
+	uint64_t completedValue = 0;
+	int failures = 0;
+	int allocated = 0;
+	for (int step = 0; step < 100000; ++step) {
+		int action = percent(random);
+		if (action < 60) {
+			uint64_t regionSize = size(random);
+			uint64_t alignment = 1ull << alignmentLog2(random);
+			uint64_t offset = ring.Allocate(regionSize, alignment);
+			if (offset == StagingRing::kInvalidOffset) {
+				continue;
+			}
+			++allocated;
+			failures += offset % alignment == 0 && offset + regionSize <= kCapacity ? 0 : 1;
+			for (const Region& region : live) {
+				failures += offset < region.offset + region.size && region.offset < offset + regionSize ? 1 : 0;
+			}
+			// 0はまだCloseしていない印
+			live.push_back({ offset, regionSize, 0 });
+		} else if (action < 80) {
+			ring.Close(++fenceValue);
+			for (Region& region : live) {
+				if (region.fenceValue == 0) {
+					region.fenceValue = fenceValue;
+				}
+			}
+		} else if (completedValue < fenceValue) {
+			completedValue += std::uniform_int_distribution<uint64_t>(1, fenceValue - completedValue)(random);
+			ring.Retire(completedValue);
+			std::erase_if(live, [completedValue](const Region& region) { return region.fenceValue != 0 && region.fenceValue <= completedValue; });
+		}
+	}
+	CHECK(failures == 0);
+	// 途中で詰まらずに使い回せていること
+	CHECK(allocated > 10000);
+	ring.Close(++fenceValue);
+	ring.Retire(fenceValue);
+	CHECK(ring.GetUsedBytes() == 0);
+}
+
+// 大きさがばらばらのテクスチャを、ステージングより大きいものも混ぜて全て転送する
+// GPUは3回のUpdateにつき1回分のSubmitしか進めず、ステージングが詰まる状況を作る
+TEST(TextureStreamerUploadsEveryTexture) {
+	const uint32_t kTextureCount = 300;
+	FakeUploadBackend backend(1 << 20, 512);
+	ThreadPool threadPool(2);
+	TextureStreamer streamer;
+	streamer.Initialize(&backend, &threadPool, DecodeSyntheticTexture);
+	std::vector<std::string> names = MakeTextureNames(kTextureCount, 10, 11);
+	std::vector<uint32_t> ids;
+	for (const std::string& name : names) {
+		ids.push_back(streamer.Request(name));
+	}
+	uint32_t failedId = streamer.Request("not a texture");
+
+	int updates = 0;
+	while (streamer.GetPendingCount() != 0 && updates < 100000) {
+		streamer.Update();
+		if (updates % 3 == 2) {
+			backend.ExecuteNext();
+		}
+		++updates;
+	}
+	CHECK(streamer.GetPendingCount() == 0);
+	for (uint32_t id : ids) {
+		CHECK(streamer.IsResident(id));
+	}
+	CHECK(streamer.GetState(failedId) == TextureStreamer::State::Failed);
+	CHECK(backend.GetResidentCount() == kTextureCount);
+	CHECK(backend.GetResidentMismatchCount() == 0);
+	CHECK(backend.GetCorruptedCount() == 0);
+	CHECK(backend.GetOutOfBoundsCount() == 0);
+	// 1024x1024のテクスチャは4MBあり、1MBのリングに入らないので一時バッファを通る
+	CHECK(backend.GetTemporaryCount() > 0);
+
+	TextureStreamer::Statistics statistics = streamer.GetStatistics();
+	CHECK(statistics.residentCount == kTextureCount);
+	CHECK(statistics.uploadedBytes == statistics.decodedBytes);
+
+	streamer.Finalize();
+	CHECK(backend.GetLiveTextureCount() == 0);
+}
+
+// Flushは残りを全て転送し終えてから戻る
+TEST(TextureStreamerFlushDrainsEverything) {
+	FakeUploadBackend backend(256 * 1024, 512);
+	ThreadPool threadPool(2);
+	TextureStreamer streamer;
+	streamer.Initialize(&backend, &threadPool, DecodeSyntheticTexture);
+	for (const std::string& name : MakeTextureNames(64, 9, 12)) {
+		streamer.Request(name);
+	}
+	streamer.Flush();
+	CHECK(streamer.GetPendingCount() == 0);
+	CHECK(backend.GetResidentCount() == 64);
+	CHECK(backend.GetCorruptedCount() == 0);
+	streamer.Finalize();
+	CHECK(backend.GetLiveTextureCount() == 0);
+}
+
+// デコードから転送完了までのスループット（MB/s）。GPUのコピーはmemcpyで代用する
+BENCHMARK(streaming) {
+	const uint32_t kTextureCount = 512;
+	FakeUploadBackend backend(64ull * 1024 * 1024, 512, false);
+	ThreadPool threadPool;
+	TextureStreamer streamer;
+	streamer.Initialize(&backend, &threadPool, DecodeSyntheticTexture);
+	Stopwatch stopwatch;
+	for (const std::string& name : MakeTextureNames(kTextureCount, 11, 13)) {
+		streamer.Request(name);
+	}
+	while (streamer.GetPendingCount() != 0) {
+		streamer.Update();
+		backend.ExecuteNext();
+	}
+	double seconds = stopwatch.GetSeconds();
+	TextureStreamer::Statistics statistics = streamer.GetStatistics();
+	printf("%u textures, %.1f MB in %.3f s: %.1f MB/s (decode %.3f s over %u worker threads, %u through temporary buffers)\n",
+		statistics.residentCount, double(statistics.uploadedBytes) / (1024.0 * 1024.0), seconds, statistics.GetThroughputMBps(),
+		statistics.decodeSeconds, threadPool.GetThreadCount(), backend.GetTemporaryCount());
+	streamer.Finalize();
+}
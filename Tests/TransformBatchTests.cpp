@@ -0,0 +1,151 @@
+#include "Test.h"
+#include "../MyMath.h"
+#include "../ThreadPool.h"
+#include "../TransformBatch.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+// WVPとWorldを並べた、定数バッファと同じ並びの書き込み先
+struct ObjectMatrices {
+	Matrix4x4 wvp;
+	Matrix4x4 world;
+};
+
+std::vector<Transform> MakeRandomTransforms(size_t count, uint32_t seed) {
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+	std::uniform_real_distribution<float> angle(-3.14f, 3.14f);
+	std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+	std::vector<Transform> transforms(count);
+	for (Transform& transform : transforms) {
+		transform.scale = { scale(random), scale(random), scale(random) };
+		transform.rotate = { angle(random), angle(random), angle(random) };
+		transform.translate = { position(random), position(random), position(random) };
+	}
+	return transforms;
+}
+
+Matrix4x4 MakeViewProjection() {
+	Matrix4x4 view = MakeViewMatrix({ { 1.0f, 1.0f, 1.0f }, { 0.2f, 0.3f, 0.0f }, { 0.0f, 5.0f, -60.0f } });
+	return Multiply(view, MakePerspectiveFovMatrix(0.45f, 16.0f / 9.0f, 0.1f, 200.0f));
+}
+
+float MaxRelativeDifference(const Matrix4x4& a, const Matrix4x4& b) {
+	float difference = 0.0f;
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) {
+			difference = std::max(difference, std::abs(a.m[i][j] - b.m[i][j]) / std::max(1.0f, std::abs(b.m[i][j])));
+		}
+	}
+	return difference;
+}
+
+}
+
+// 4の倍数でない数でも、ストライド付きの書き込みでも、1つずつ計算した結果と一致する
+TEST(TransformBatchMatchesPerObjectMath) {
+	const Matrix4x4 viewProjection = MakeViewProjection();
+	ThreadPool threadPool(2);
+	for (size_t count : { size_t(1), size_t(7), size_t(4099) }) {
+		std::vector<Transform> transforms = MakeRandomTransforms(count, uint32_t(count));
+		TransformBatch batch;
+		for (const Transform& transform : transforms) {
+			batch.Add(transform);
+		}
+		for (ThreadPool* pool : { static_cast<ThreadPool*>(nullptr), &threadPool }) {
+			std::vector<ObjectMatrices> destination(count + 1);
+			destination[count].wvp = MakeIdentity4x4();
+			std::vector<Matrix4x4> worlds(count);
+			batch.Update(viewProjection, &destination[0].wvp, sizeof(ObjectMatrices), worlds.data(), pool);
+			for (size_t i = 0; i < count; ++i) {
+				Matrix4x4 world = MakeAffineMatrix(transforms[i].scale, transforms[i].rotate, transforms[i].translate);
+				CHECK(MaxRelativeDifference(worlds[i], world) <= 1e-5f);
+				CHECK(MaxRelativeDifference(destination[i].wvp, Multiply(world, viewProjection)) <= 1e-4f);
+			}
+			// 最後の要素の先は書き換えない
+			CHECK(MaxRelativeDifference(destination[count].wvp, MakeIdentity4x4()) == 0.0f);
+		}
+	}
+}
+
+// destinationSlotsを渡すと、各オブジェクトのWVPを指定した場所へ書き、kNoSlotのものは書かない
+TEST(TransformBatchWritesToDestinationSlots) {
+	const Matrix4x4 viewProjection = MakeViewProjection();
+	ThreadPool threadPool(2);
+	const size_t count = 2053;
+	std::vector<Transform> transforms = MakeRandomTransforms(count, 3);
+	TransformBatch batch;
+	for (const Transform& transform : transforms) {
+		batch.Add(transform);
+	}
+	// 逆順に並べ、3つに1つは書かない
+	std::vector<uint32_t> slots(count);
+	for (size_t i = 0; i < count; ++i) {
+		slots[i] = (i % 3 == 1) ? TransformBatch::kNoSlot : uint32_t(count - 1 - i);
+	}
+	for (ThreadPool* pool : { static_cast<ThreadPool*>(nullptr), &threadPool }) {
+		std::vector<ObjectMatrices> destination(count);
+		for (ObjectMatrices& matrices : destination) {
+			matrices.wvp = MakeIdentity4x4();
+		}
+		batch.Update(viewProjection, &destination[0].wvp, sizeof(ObjectMatrices), nullptr, pool, slots.data());
+		for (size_t i = 0; i < count; ++i) {
+			const Matrix4x4& written = destination[count - 1 - i].wvp;
+			if (slots[i] == TransformBatch::kNoSlot) {
+				CHECK(MaxRelativeDifference(written, MakeIdentity4x4()) == 0.0f);
+			} else {
+				Matrix4x4 world = MakeAffineMatrix(transforms[i].scale, transforms[i].rotate, transforms[i].translate);
+				CHECK(MaxRelativeDifference(written, Multiply(world, viewProjection)) <= 1e-4f);
+			}
+		}
+	}
+}
+
+// 1k/10k/100kオブジェクトのWVP計算を、1つずつMakeAffineMatrixとMultiplyで求める場合と比べる
+BENCHMARK(transform) {
+	const Matrix4x4 viewProjection = MakeViewProjection();
+	ThreadPool threadPool;
+	printf("%8s %14s %14s %14s   (ns per object, %u worker threads)\n", "objects", "per object", "batch", "batch+pool",
+		threadPool.GetThreadCount());
+	for (size_t count : { size_t(1000), size_t(10000), size_t(100000) }) {
+		std::vector<Transform> transforms = MakeRandomTransforms(count, 1);
+		TransformBatch batch;
+		batch.Reserve(count);
+		for (const Transform& transform : transforms) {
+			batch.Add(transform);
+		}
+		std::vector<ObjectMatrices> destination(count);
+		// 合計で約200万オブジェクト分になるように繰り返す
+		const int repeat = int(2000000 / count);
+
+		Stopwatch perObjectStopwatch;
+		for (int r = 0; r < repeat; ++r) {
+			for (size_t i = 0; i < count; ++i) {
+				Matrix4x4 world = MakeAffineMatrix(transforms[i].scale, transforms[i].rotate, transforms[i].translate);
+				destination[i].wvp = Multiply(world, viewProjection);
+				destination[i].world = world;
+			}
+		}
+		double perObjectSeconds = perObjectStopwatch.GetSeconds();
+
+		Stopwatch batchStopwatch;
+		for (int r = 0; r < repeat; ++r) {
+			batch.Update(viewProjection, &destination[0].wvp, sizeof(ObjectMatrices));
+		}
+		double batchSeconds = batchStopwatch.GetSeconds();
+
+		Stopwatch poolStopwatch;
+		for (int r = 0; r < repeat; ++r) {
+			batch.Update(viewProjection, &destination[0].wvp, sizeof(ObjectMatrices), nullptr, &threadPool);
+		}
+		double poolSeconds = poolStopwatch.GetSeconds();
+
+		const double scale = 1e9 / (double(count) * repeat);
+		printf("%8zu %14.1f %14.1f %14.1f   checksum %g\n", count, perObjectSeconds * scale, batchSeconds * scale, poolSeconds * scale,
+			destination[count / 2].wvp.m[3][0]);
+	}
+}
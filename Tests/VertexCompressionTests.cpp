@@ -0,0 +1,81 @@
+#include "Test.h"
+#include "../VertexCompression.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+// 原点から離れた箱の中に散らばる頂点。UVは[texcoordMin, texcoordMax]の一様乱数
+Mesh MakeRandomMesh(size_t vertexCount, float texcoordMin, float texcoordMax, uint32_t seed) {
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> x(95.0f, 105.0f);
+	std::uniform_real_distribution<float> y(-3.0f, 0.5f);
+	std::uniform_real_distribution<float> z(-2000.0f, 2000.0f);
+	std::uniform_real_distribution<float> texcoord(texcoordMin, texcoordMax);
+	Mesh mesh;
+	for (size_t i = 0; i < vertexCount; ++i) {
+		mesh.vertices.push_back({ { x(random), y(random), z(random), 1.0f }, { texcoord(random), texcoord(random) } });
+	}
+	for (uint32_t i = 0; i + 2 < vertexCount; i += 3) {
+		mesh.indices.insert(mesh.indices.end(), { i, i + 1, i + 2 });
+	}
+	return mesh;
+}
+
+}
+
+// 位置の誤差は報告した上限を超えない。上限は軸の幅の1/65535の半分ほどで、0ではない誤差が出る
+TEST(VertexCompressionPositionErrorWithinBound) {
+	Mesh mesh = MakeRandomMesh(3000, 0.0f, 1.0f, 1);
+	CompressedMesh compressed = CompressMesh(mesh);
+	VertexCompressionReport report = MeasureVertexCompression(mesh, compressed);
+	CHECK(compressed.indices == mesh.indices);
+	CHECK(report.maxPositionError > 0.0f);
+	CHECK(report.maxPositionError <= report.positionErrorBound);
+	// 一番幅の広いz軸(4000)の刻みの半分に、復元のfloatの丸めの分(数%)を足したくらいに収まる
+	CHECK(report.positionErrorBound < 4000.0f / 65535.0f * 0.5f * 1.05f);
+	for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+		VertexData decoded = DecompressVertex(compressed, compressed.vertices[i]);
+		CHECK(std::abs(decoded.position.x - mesh.vertices[i].position.x) <= report.positionErrorBound);
+		CHECK(std::abs(decoded.position.y - mesh.vertices[i].position.y) <= report.positionErrorBound);
+		CHECK(std::abs(decoded.position.z - mesh.vertices[i].position.z) <= report.positionErrorBound);
+	}
+}
+
+// UVが0～1に収まればUNORMで刻みの半分まで、はみ出せば半精度で相対2^-11までの誤差になる
+TEST(VertexCompressionTexcoordErrorWithinBound) {
+	Mesh unitMesh = MakeRandomMesh(3000, 0.0f, 1.0f, 2);
+	CompressedMesh unitCompressed = CompressMesh(unitMesh);
+	CHECK(unitCompressed.texcoordEncoding == TexcoordEncoding::Unorm16);
+	VertexCompressionReport unitReport = MeasureVertexCompression(unitMesh, unitCompressed);
+	CHECK(unitReport.maxTexcoordError > 0.0f);
+	CHECK(unitReport.maxTexcoordError <= 0.5f / 65535.0f + 1e-7f);
+
+	Mesh tiledMesh = MakeRandomMesh(3000, -2.0f, 4.0f, 3);
+	CompressedMesh tiledCompressed = CompressMesh(tiledMesh);
+	CHECK(tiledCompressed.texcoordEncoding == TexcoordEncoding::Half);
+	VertexCompressionReport tiledReport = MeasureVertexCompression(tiledMesh, tiledCompressed);
+	CHECK(tiledReport.maxTexcoordError > 0.0f);
+	// 4未満の値の半精度の刻みは2^-9なので、最大でその半分
+	CHECK(tiledReport.maxTexcoordError <= std::ldexp(1.0f, -10));
+	for (size_t i = 0; i < tiledMesh.vertices.size(); ++i) {
+		const Vector2& original = tiledMesh.vertices[i].texcoord;
+		Vector2 decoded = DecompressVertex(tiledCompressed, tiledCompressed.vertices[i]).texcoord;
+		// 正規化数の相対誤差は2^-11まで。0の近くは非正規化数の刻み2^-24の半分
+		CHECK(std::abs(decoded.x - original.x) <= std::max(std::abs(original.x) * std::ldexp(1.0f, -11), std::ldexp(1.0f, -25)));
+		CHECK(std::abs(decoded.y - original.y) <= std::max(std::abs(original.y) * std::ldexp(1.0f, -11), std::ldexp(1.0f, -25)));
+	}
+}
+
+// 24バイトの頂点が12バイトになるので、頂点の大きさはちょうど半分
+TEST(VertexCompressionHalvesVertexBytes) {
+	for (size_t vertexCount : { size_t(3), size_t(1000) }) {
+		Mesh mesh = MakeRandomMesh(vertexCount, 0.0f, 1.0f, 4);
+		VertexCompressionReport report = MeasureVertexCompression(mesh, CompressMesh(mesh));
+		CHECK(report.sourceBytes == vertexCount * 24);
+		CHECK(report.compressedBytes == vertexCount * 12);
+		CHECK(report.sourceBytes == report.compressedBytes * 2);
+	}
+}
@@ -0,0 +1,838 @@
+// テクスチャをミップマップ付きのブロック圧縮DDSに変換するオフラインツール
+// 使い方: TextureCooker <入力ディレクトリ> [--format auto|bc7|bc1|none] [--quality <BC7の品質>] [--bc6h default|fast]
+//                       [--force] [--threads N] [--benchmark-load] [--benchmark-compress] [--benchmark-bc7] [--benchmark-decode]
+//                       [--benchmark-bc6h]
+// 入力ディレクトリ以下の画像をそれぞれ <ディレクトリ>/cooked/<名前>.dds に書き出す
+// JPEG/BMP/TIFFの読み込みはWICを使うのでWindowsでしかできない。他の環境ではTGAとHDR、libpngがあればPNGを変換でき、それ以外は失敗として報告する
+// 内容のハッシュをマニフェストに記録し、変わっていないものは変換し直さない
+// --benchmark-bc7 はTextureCooker/BenchmarkImages/ldr の4枚（uvCheckerの切り抜きと縮小、岩肌、アルファで抜いた葉。128x128のPNG）で比べられる
+// --benchmark-bc6h はTextureCooker/BenchmarkImages/hdr の3枚（太陽と雲のある空、明るい窓のある室内、夕焼けと水面。128x128のRadiance HDR）で比べられる
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+#include <cstdint>
+#include <cstdio>
+#include <cctype>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include <thread>
+#include <cmath>
+
+#include "../externals/DirectXTex/DirectXTex.h"
+#if !defined(_WIN32) && defined(TEXTURE_COOKER_PNG)
+#include <png.h>
+#endif
+#include "../CookedTexture.h"
+#include "../MappedFile.h"
+
+namespace {
+
+// 出力形式やフィルタを変えたら上げる。マニフェストのハッシュに含まれるので全て作り直しになる
+const uint32_t kCookerVersion = 1;
+
+enum class CookFormat {
+	Auto, // 不透明ならBC1、そうでなければBC7
+	BC7,
+	BC1,
+	None, // 圧縮せずミップマップだけ作る
+};
+
+// BC7の品質。上ほど速く、下ほど画質が良い。defaultはbasicと同じ探索
+struct BC7Quality {
+	const char* name;
+	DirectX::TEX_COMPRESS_FLAGS flags;
+};
+
+const BC7Quality kBC7Qualities[] = {
+	{ "ultrafast", DirectX::TEX_COMPRESS_BC7_ULTRAFAST },
+	{ "veryfast", DirectX::TEX_COMPRESS_BC7_VERYFAST },
+	{ "fast", DirectX::TEX_COMPRESS_BC7_FAST },
+	{ "basic", DirectX::TEX_COMPRESS_BC7_BASIC },
+	{ "slow", DirectX::TEX_COMPRESS_BC7_SLOW },
+	{ "exhaustive", DirectX::TEX_COMPRESS_BC7_EXHAUSTIVE },
+};
+
+struct CookOptions {
+	std::filesystem::path inputDirectory;
+	CookFormat format = CookFormat::Auto;
+	// BC7の品質。BC1とBC6Hには効かない
+	DirectX::TEX_COMPRESS_FLAGS bc7Quality = DirectX::TEX_COMPRESS_DEFAULT;
+	// BC6Hの探索。TEX_COMPRESS_BC6H_FASTならモードを絞って速くする。HDRの空などで使う
+	DirectX::TEX_COMPRESS_FLAGS bc6hQuality = DirectX::TEX_COMPRESS_DEFAULT;
+	bool force = false;
+	// 圧縮に使うスレッド数。0ならハードウェアスレッド数に合わせる
+	uint32_t threadCount = 0;
+	// 変換せず、クック済みDDSの読み込み速度を測る
+	bool benchmarkLoad = false;
+	// 変換せず、最上位のミップの圧縮速度をスレッド数を変えて測る
+	bool benchmarkCompress = false;
+	// 変換せず、BC7の品質ごとの圧縮時間とPSNRを測る
+	bool benchmarkBC7 = false;
+	// 変換せず、クック済みDDSをRGBA8に展開する速さをDecompressとDecompressExで比べる
+	bool benchmarkDecode = false;
+	// 変換せず、HDR画像のBC6H圧縮の時間とRMSEを通常と高速で比べる
+	bool benchmarkBC6H = false;
+};
+
+// FNV-1a 64bit
+uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+bool ReadFile(const std::filesystem::path& path, std::vector<uint8_t>& data) {
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file) {
+		return false;
+	}
+	data.resize(size_t(file.tellg()));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(data.data()), std::streamsize(data.size()));
+	return bool(file);
+}
+
+const char* GetFormatName(CookFormat format) {
+	switch (format) {
+	case CookFormat::BC7:
+		return "bc7";
+	case CookFormat::BC1:
+		return "bc1";
+	case CookFormat::None:
+		return "none";
+	default:
+		return "auto";
+	}
+}
+
+bool IsSourceImage(const std::filesystem::path& path) {
+	std::string extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return char(tolower(c)); });
+	return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".bmp" ||
+		extension == ".tif" || extension == ".tiff" || extension == ".tga" || extension == ".hdr";
+}
+
+// マニフェストは1行に「ハッシュ 入力ディレクトリからの相対パス」
+std::map<std::string, uint64_t> LoadManifest(const std::filesystem::path& path) {
+	std::map<std::string, uint64_t> manifest;
+	std::ifstream file(path);
+	std::string line;
+	while (std::getline(file, line)) {
+		std::istringstream stream(line);
+		std::string hash;
+		if (!(stream >> hash)) {
+			continue;
+		}
+		std::string relativePath;
+		std::getline(stream >> std::ws, relativePath);
+		// 壊れた行は記録が無いものとして扱い、そのファイルは変換し直す
+		uint64_t value = 0;
+		auto [end, error] = std::from_chars(hash.data(), hash.data() + hash.size(), value, 16);
+		if (error != std::errc() || end != hash.data() + hash.size() || relativePath.empty()) {
+			continue;
+		}
+		manifest[relativePath] = value;
+	}
+	return manifest;
+}
+
+void SaveManifest(const std::filesystem::path& path, const std::map<std::string, uint64_t>& manifest) {
+	std::ofstream file(path);
+	for (const auto& [relativePath, hash] : manifest) {
+		char hashText[17];
+		snprintf(hashText, sizeof(hashText), "%016llx", static_cast<unsigned long long>(hash));
+		file << hashText << ' ' << relativePath << '\n';
+	}
+}
+
+#if !defined(_WIN32) && defined(TEXTURE_COOKER_PNG)
+// WICの無い環境でのPNGの読み込み。libpngで8bitのRGBAに展開し、WIC_FLAGS_FORCE_SRGBと同じくsRGBとして扱う
+// 16bitのPNGも8bitに丸める
+HRESULT LoadFromPNGFile(const std::filesystem::path& path, DirectX::ScratchImage& image) {
+	png_image png = {};
+	png.version = PNG_IMAGE_VERSION;
+	if (!png_image_begin_read_from_file(&png, path.string().c_str())) {
+		return E_FAIL;
+	}
+	png.format = PNG_FORMAT_RGBA;
+	HRESULT hr = image.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, png.width, png.height, 1, 1);
+	if (FAILED(hr)) {
+		png_image_free(&png);
+		return hr;
+	}
+	// png_image_finish_readは成功しても失敗してもpngの中身を解放する
+	const DirectX::Image* pixels = image.GetImage(0, 0, 0);
+	if (!png_image_finish_read(&png, nullptr, pixels->pixels, static_cast<png_int_32>(pixels->rowPitch), nullptr)) {
+		image.Release();
+		return E_FAIL;
+	}
+	return S_OK;
+}
+#endif
+
+// 拡張子に応じて読み込む。WICはWindowsにしかないので、他の環境ではTGAとHDR、libpngがあればPNGだけ扱える
+HRESULT LoadSourceImage(const std::filesystem::path& path, DirectX::ScratchImage& image) {
+	std::string extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return char(tolower(c)); });
+	if (extension == ".tga") {
+		return DirectX::LoadFromTGAFile(path.wstring().c_str(), DirectX::TGA_FLAGS_DEFAULT_SRGB, nullptr, image);
+	}
+	if (extension == ".hdr") {
+		return DirectX::LoadFromHDRFile(path.wstring().c_str(), nullptr, image);
+	}
+#ifdef _WIN32
+	return DirectX::LoadFromWICFile(path.wstring().c_str(), DirectX::WIC_FLAGS_FORCE_SRGB, nullptr, image);
+#else
+#ifdef TEXTURE_COOKER_PNG
+	if (extension == ".png") {
+		return LoadFromPNGFile(path, image);
+	}
+#endif
+	return E_NOTIMPL;
+#endif
+}
+
+// この環境で読めない形式の説明。LoadSourceImageがE_NOTIMPLを返したときに出す
+const char* GetUnsupportedFormatMessage() {
+#ifdef TEXTURE_COOKER_PNG
+	return "JPEG/BMP/TIFF need WIC and are Windows only; this build cooks PNG, TGA and HDR";
+#else
+	return "PNG/JPEG/BMP/TIFF need WIC and are Windows only; this build cooks TGA and HDR (configure with libpng for PNG)";
+#endif
+}
+
+// 圧縮形式を決める。BCは4x4単位なので、最上位が4の倍数でなければ圧縮しない
+DXGI_FORMAT ChooseCompressedFormat(const DirectX::ScratchImage& image, CookFormat cookFormat) {
+	const DirectX::TexMetadata& metadata = image.GetMetadata();
+	if (cookFormat == CookFormat::None || metadata.width % 4 != 0 || metadata.height % 4 != 0) {
+		return DXGI_FORMAT_UNKNOWN;
+	}
+	if (metadata.format == DXGI_FORMAT_R32G32B32A32_FLOAT || metadata.format == DXGI_FORMAT_R16G16B16A16_FLOAT) {
+		// HDRはBC6H
+		return DXGI_FORMAT_BC6H_UF16;
+	}
+	bool isSRGB = DirectX::IsSRGB(metadata.format);
+	bool useBC1 = cookFormat == CookFormat::BC1 || (cookFormat == CookFormat::Auto && image.IsAlphaAllOpaque());
+	if (useBC1) {
+		return isSRGB ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+	}
+	return isSRGB ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+}
+
+// 変換する画像を集める。出力先のcookedディレクトリは見ない
+std::vector<std::filesystem::path> FindSourceImages(const std::filesystem::path& directory) {
+	std::vector<std::filesystem::path> paths;
+	for (auto it = std::filesystem::recursive_directory_iterator(directory); it != std::filesystem::recursive_directory_iterator(); ++it) {
+		if (it->is_directory() && it->path().filename() == "cooked") {
+			it.disable_recursion_pending();
+			continue;
+		}
+		if (it->is_regular_file() && IsSourceImage(it->path())) {
+			paths.push_back(it->path());
+		}
+	}
+	std::sort(paths.begin(), paths.end());
+	return paths;
+}
+
+// 1ファイルを変換する。失敗したらメッセージを返す
+bool CookTexture(const std::filesystem::path& sourcePath, const std::filesystem::path& cookedPath, const CookOptions& options, std::string& message) {
+	DirectX::ScratchImage image;
+	HRESULT hr = LoadSourceImage(sourcePath, image);
+	if (FAILED(hr)) {
+		message = hr == E_NOTIMPL ? GetUnsupportedFormatMessage() : "load failed";
+		return false;
+	}
+
+	// ミップマップの作成
+	const DirectX::TexMetadata& sourceMetadata = image.GetMetadata();
+	bool isSRGB = DirectX::IsSRGB(sourceMetadata.format);
+	DirectX::ScratchImage mipImages;
+	hr = DirectX::GenerateMipMaps(image.GetImages(), image.GetImageCount(), sourceMetadata,
+		isSRGB ? DirectX::TEX_FILTER_SRGB : DirectX::TEX_FILTER_DEFAULT, 0, mipImages);
+	if (FAILED(hr)) {
+		message = "GenerateMipMaps failed";
+		return false;
+	}
+
+	const DirectX::TexMetadata& metadata = mipImages.GetMetadata();
+	DXGI_FORMAT compressedFormat = ChooseCompressedFormat(mipImages, options.format);
+
+	DirectX::ScratchImage compressedImages;
+	const DirectX::ScratchImage* outputImages = &mipImages;
+	if (compressedFormat != DXGI_FORMAT_UNKNOWN) {
+		// 全ミップをタイルに分けてまとめて圧縮する。進み具合は同じ行に上書きで出す
+		DirectX::CompressOptions compressOptions;
+		compressOptions.flags = DirectX::TEX_COMPRESS_PARALLEL | options.bc7Quality | options.bc6hQuality;
+		compressOptions.threadCount = options.threadCount;
+		int lastPercent = -1;
+		auto progress = [&](size_t completed, size_t total) {
+			int percent = int(completed * 100 / total);
+			if (percent != lastPercent) {
+				printf("\r          compressing %3d%%", percent);
+				fflush(stdout);
+				lastPercent = percent;
+			}
+			return true;
+		};
+		hr = DirectX::CompressEx(mipImages.GetImages(), mipImages.GetImageCount(), metadata, compressedFormat,
+			compressOptions, compressedImages, progress);
+		printf("\r%30s\r", "");
+		if (FAILED(hr)) {
+			message = "Compress failed";
+			return false;
+		}
+		outputImages = &compressedImages;
+	}
+
+	std::error_code errorCode;
+	std::filesystem::create_directories(cookedPath.parent_path(), errorCode);
+	hr = DirectX::SaveToDDSFile(outputImages->GetImages(), outputImages->GetImageCount(), outputImages->GetMetadata(),
+		DirectX::DDS_FLAGS_NONE, cookedPath.wstring().c_str());
+	if (FAILED(hr)) {
+		message = "SaveToDDSFile failed";
+		return false;
+	}
+
+	char text[128];
+	snprintf(text, sizeof(text), "%zux%zu, %zu mips, format %d", metadata.width, metadata.height, metadata.mipLevels,
+		int(outputImages->GetMetadata().format));
+	message = text;
+	return true;
+}
+
+bool ParseOptions(int argc, char* argv[], CookOptions& options) {
+	if (argc < 2) {
+		return false;
+	}
+	options.inputDirectory = argv[1];
+	for (int i = 2; i < argc; ++i) {
+		std::string argument = argv[i];
+		if (argument == "--force") {
+			options.force = true;
+		} else if (argument == "--benchmark-load") {
+			options.benchmarkLoad = true;
+		} else if (argument == "--benchmark-compress") {
+			options.benchmarkCompress = true;
+		} else if (argument == "--benchmark-bc7") {
+			options.benchmarkBC7 = true;
+		} else if (argument == "--benchmark-decode") {
+			options.benchmarkDecode = true;
+		} else if (argument == "--benchmark-bc6h") {
+			options.benchmarkBC6H = true;
+		} else if (argument == "--quality" && i + 1 < argc) {
+			std::string quality = argv[++i];
+			auto found = std::find_if(std::begin(kBC7Qualities), std::end(kBC7Qualities),
+				[&](const BC7Quality& level) { return quality == level.name; });
+			if (found == std::end(kBC7Qualities)) {
+				return false;
+			}
+			options.bc7Quality = found->flags;
+		} else if (argument == "--bc6h" && i + 1 < argc) {
+			std::string quality = argv[++i];
+			if (quality == "default") {
+				options.bc6hQuality = DirectX::TEX_COMPRESS_DEFAULT;
+			} else if (quality == "fast") {
+				options.bc6hQuality = DirectX::TEX_COMPRESS_BC6H_FAST;
+			} else {
+				return false;
+			}
+		} else if (argument == "--threads" && i + 1 < argc) {
+			options.threadCount = uint32_t(std::stoul(argv[++i]));
+		} else if (argument == "--format" && i + 1 < argc) {
+			std::string format = argv[++i];
+			if (format == "auto") {
+				options.format = CookFormat::Auto;
+			} else if (format == "bc7") {
+				options.format = CookFormat::BC7;
+			} else if (format == "bc1") {
+				options.format = CookFormat::BC1;
+			} else if (format == "none") {
+				options.format = CookFormat::None;
+			} else {
+				return false;
+			}
+		} else {
+			return false;
+		}
+	}
+	return true;
+}
+
+// 入力ディレクトリ以下の画像を全て変換する
+int CookDirectory(const CookOptions& options) {
+	std::filesystem::path manifestPath = options.inputDirectory / kCookedTextureManifestName;
+	std::map<std::string, uint64_t> manifest = LoadManifest(manifestPath);
+
+	std::vector<std::filesystem::path> sourcePaths = FindSourceImages(options.inputDirectory);
+
+	uint32_t cookedCount = 0;
+	uint32_t skippedCount = 0;
+	uint32_t failedCount = 0;
+	auto totalStart = std::chrono::steady_clock::now();
+	for (const std::filesystem::path& sourcePath : sourcePaths) {
+		std::string relativePath = std::filesystem::relative(sourcePath, options.inputDirectory).generic_string();
+		std::filesystem::path cookedPath = GetCookedTexturePath(sourcePath);
+
+		// 入力の内容と変換の設定からハッシュを作る
+		std::vector<uint8_t> sourceData;
+		if (!ReadFile(sourcePath, sourceData)) {
+			printf("[failed ] %s: read failed\n", relativePath.c_str());
+			++failedCount;
+			continue;
+		}
+		uint64_t hash = HashBytes(sourceData.data(), sourceData.size());
+		hash = HashBytes(&kCookerVersion, sizeof(kCookerVersion), hash);
+		hash = HashBytes(&options.format, sizeof(options.format), hash);
+		// BC7とBC6Hの設定はビットが重ならないのでまとめる。BC6Hが既定なら今までと同じハッシュになる
+		DirectX::TEX_COMPRESS_FLAGS quality = options.bc7Quality | options.bc6hQuality;
+		hash = HashBytes(&quality, sizeof(quality), hash);
+
+		auto found = manifest.find(relativePath);
+		if (!options.force && found != manifest.end() && found->second == hash && std::filesystem::exists(cookedPath)) {
+			printf("[skipped] %s\n", relativePath.c_str());
+			++skippedCount;
+			continue;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		std::string message;
+		if (!CookTexture(sourcePath, cookedPath, options, message)) {
+			printf("[failed ] %s: %s\n", relativePath.c_str(), message.c_str());
+			manifest.erase(relativePath);
+			++failedCount;
+			continue;
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		printf("[cooked ] %s -> %s (%s, %s, %.2f s, %zu -> %llu bytes)\n", relativePath.c_str(), cookedPath.generic_string().c_str(),
+			GetFormatName(options.format), message.c_str(), seconds, sourceData.size(), static_cast<unsigned long long>(std::filesystem::file_size(cookedPath)));
+		manifest[relativePath] = hash;
+		++cookedCount;
+	}
+	SaveManifest(manifestPath, manifest);
+
+	double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - totalStart).count();
+	printf("%u cooked, %u up to date, %u failed (%.2f s)\n", cookedCount, skippedCount, failedCount, totalSeconds);
+	return failedCount == 0 ? 0 : 1;
+}
+
+// 全ての画素をステージング代わりのバッファへ写す。実際の転送と同じだけ画素を読む
+size_t CopyToStaging(const DirectX::Image* images, size_t imageCount, std::vector<uint8_t>& staging) {
+	size_t size = 0;
+	for (size_t i = 0; i < imageCount; ++i) {
+		size += images[i].slicePitch;
+	}
+	staging.resize(size);
+	size_t offset = 0;
+	for (size_t i = 0; i < imageCount; ++i) {
+		memcpy(staging.data() + offset, images[i].pixels, images[i].slicePitch);
+		offset += images[i].slicePitch;
+	}
+	return size;
+}
+
+// クック済みDDSの読み込みを、LoadFromDDSFile（読み込み+ScratchImageへのコピー）と
+// MappedFile+GetDDSImageViews（マップした画素を直接参照）で比べる。どちらもステージングへの1回のコピーまで含める
+int BenchmarkLoad(const CookOptions& options) {
+	std::vector<std::filesystem::path> cookedPaths;
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(options.inputDirectory)) {
+		if (entry.is_regular_file() && entry.path().extension() == ".dds" && entry.path().parent_path().filename() == "cooked") {
+			cookedPaths.push_back(entry.path());
+		}
+	}
+	if (cookedPaths.empty()) {
+		printf("no cooked textures under %s\n", options.inputDirectory.string().c_str());
+		return 1;
+	}
+
+	const int kIterations = 5;
+	std::vector<uint8_t> staging;
+	double copySeconds = 0.0;
+	double mappedSeconds = 0.0;
+	size_t totalBytes = 0;
+	for (int iteration = 0; iteration < kIterations; ++iteration) {
+		// 交互に測って、ファイルキャッシュの条件を揃える
+		auto start = std::chrono::steady_clock::now();
+		for (const std::filesystem::path& path : cookedPaths) {
+			DirectX::ScratchImage image;
+			if (FAILED(DirectX::LoadFromDDSFile(path.wstring().c_str(), DirectX::DDS_FLAGS_NONE, nullptr, image))) {
+				printf("LoadFromDDSFile failed: %s\n", path.string().c_str());
+				return 1;
+			}
+			CopyToStaging(image.GetImages(), image.GetImageCount(), staging);
+		}
+		copySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		for (const std::filesystem::path& path : cookedPaths) {
+			MappedFile file;
+			DirectX::TexMetadata metadata;
+			std::vector<DirectX::Image> images;
+			if (!file.Open(path) || FAILED(DirectX::GetDDSImageViews(file.GetData(), file.GetSize(), DirectX::DDS_FLAGS_NONE, metadata, images))) {
+				printf("GetDDSImageViews failed: %s\n", path.string().c_str());
+				return 1;
+			}
+			size_t bytes = CopyToStaging(images.data(), images.size(), staging);
+			if (iteration == 0) {
+				totalBytes += bytes;
+			}
+		}
+		mappedSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	double megabytes = double(totalBytes) * kIterations / (1024.0 * 1024.0);
+	printf("%zu textures, %.1f MB x %d\n", cookedPaths.size(), double(totalBytes) / (1024.0 * 1024.0), kIterations);
+	printf("LoadFromDDSFile      : %.3f s, %.0f MB/s\n", copySeconds, megabytes / copySeconds);
+	printf("MappedFile + views   : %.3f s, %.0f MB/s\n", mappedSeconds, megabytes / mappedSeconds);
+	return 0;
+}
+
+// 画像ごとに最上位のミップだけを、1スレッドから倍々にスレッド数を増やして圧縮し、速さを比べる
+// 4Kの画像を置けば4Kの圧縮の比較になる。どのスレッド数でも結果が同じになることも確かめる
+// BC1はSIMDを使わない1ブロックずつのエンコーダでも1スレッドで圧縮し、速さと結果の違うブロック数を出す
+int BenchmarkCompress(const CookOptions& options) {
+	std::vector<std::filesystem::path> sourcePaths = FindSourceImages(options.inputDirectory);
+	if (sourcePaths.empty()) {
+		printf("no source images under %s\n", options.inputDirectory.string().c_str());
+		return 1;
+	}
+
+	uint32_t maxThreadCount = options.threadCount ? options.threadCount : std::max(1u, std::thread::hardware_concurrency());
+	std::vector<uint32_t> threadCounts;
+	for (uint32_t threadCount = 1; threadCount < maxThreadCount; threadCount *= 2) {
+		threadCounts.push_back(threadCount);
+	}
+	threadCounts.push_back(maxThreadCount);
+
+	printf("%-40s %11s %6s %8s %10s %10s %8s\n", "image", "size", "format", "threads", "seconds", "MPixel/s", "speedup");
+	for (const std::filesystem::path& sourcePath : sourcePaths) {
+		std::string relativePath = std::filesystem::relative(sourcePath, options.inputDirectory).generic_string();
+		DirectX::ScratchImage image;
+		if (FAILED(LoadSourceImage(sourcePath, image))) {
+			printf("%-40s load failed\n", relativePath.c_str());
+			continue;
+		}
+		DXGI_FORMAT compressedFormat = ChooseCompressedFormat(image, options.format);
+		if (compressedFormat == DXGI_FORMAT_UNKNOWN) {
+			printf("%-40s not compressed\n", relativePath.c_str());
+			continue;
+		}
+		const DirectX::Image& source = *image.GetImage(0, 0, 0);
+		double megapixels = double(source.width) * double(source.height) / 1000000.0;
+		char size[32];
+		snprintf(size, sizeof(size), "%zux%zu", source.width, source.height);
+
+		DirectX::ScratchImage reference;
+		double singleThreadSeconds = 0.0;
+		for (uint32_t threadCount : threadCounts) {
+			DirectX::CompressOptions compressOptions;
+			compressOptions.flags = DirectX::TEX_COMPRESS_PARALLEL;
+			compressOptions.threadCount = threadCount;
+			DirectX::ScratchImage compressed;
+			auto start = std::chrono::steady_clock::now();
+			if (FAILED(DirectX::CompressEx(source, compressedFormat, compressOptions, compressed))) {
+				printf("%-40s Compress failed\n", relativePath.c_str());
+				return 1;
+			}
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			if (threadCount == threadCounts.front()) {
+				singleThreadSeconds = seconds;
+				reference = std::move(compressed);
+			} else if (memcmp(reference.GetPixels(), compressed.GetPixels(), reference.GetPixelsSize()) != 0) {
+				printf("%-40s warning: output differs with %u threads\n", relativePath.c_str(), threadCount);
+			}
+			printf("%-40s %11s %6s %8u %10.3f %10.2f %7.2fx\n", relativePath.c_str(), size,
+				compressedFormat == DXGI_FORMAT_BC6H_UF16 ? "bc6h" : (DirectX::BitsPerPixel(compressedFormat) == 4 ? "bc1" : "bc7"),
+				threadCount, seconds, megapixels / seconds, singleThreadSeconds / seconds);
+		}
+
+		if (compressedFormat == DXGI_FORMAT_BC1_UNORM || compressedFormat == DXGI_FORMAT_BC1_UNORM_SRGB) {
+			// 浮動小数の演算順が同じなら一致するはずだが、/fp:fastでは丸めの違いで一部のブロックがずれてもよい
+			DirectX::CompressOptions compressOptions;
+			compressOptions.flags = DirectX::TEX_COMPRESS_PARALLEL | DirectX::TEX_COMPRESS_BC_NO_SIMD;
+			compressOptions.threadCount = 1;
+			DirectX::ScratchImage scalar;
+			auto start = std::chrono::steady_clock::now();
+			if (FAILED(DirectX::CompressEx(source, compressedFormat, compressOptions, scalar))) {
+				printf("%-40s Compress failed\n", relativePath.c_str());
+				return 1;
+			}
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			const size_t kBlockSize = 8;
+			size_t blockCount = scalar.GetPixelsSize() / kBlockSize;
+			size_t differentBlocks = 0;
+			for (size_t i = 0; i < blockCount; ++i) {
+				if (memcmp(scalar.GetPixels() + i * kBlockSize, reference.GetPixels() + i * kBlockSize, kBlockSize) != 0) {
+					++differentBlocks;
+				}
+			}
+			printf("%-40s %11s %6s %8s %10.3f %10.2f %7.2fx  %zu/%zu blocks differ from SIMD\n", relativePath.c_str(), size,
+				"bc1", "scalar", seconds, megapixels / seconds, singleThreadSeconds / seconds, differentBlocks, blockCount);
+		}
+	}
+	return 0;
+}
+
+// 画像ごとに最上位のミップをBC7の各品質で圧縮し、時間とPSNRを比べる。品質を選ぶときの目安にする
+// PSNRは元画像との全チャンネルの平均二乗誤差から求める。最後に全画像を合わせた値を出す
+int BenchmarkBC7(const CookOptions& options) {
+	std::vector<std::filesystem::path> sourcePaths = FindSourceImages(options.inputDirectory);
+	if (sourcePaths.empty()) {
+		printf("no source images under %s\n", options.inputDirectory.string().c_str());
+		return 1;
+	}
+
+	const size_t kQualityCount = std::size(kBC7Qualities);
+	std::vector<double> totalSeconds(kQualityCount, 0.0);
+	std::vector<double> totalSquaredError(kQualityCount, 0.0);
+	double totalMegapixels = 0.0;
+	printf("%-40s %11s %10s %10s %10s %8s\n", "image", "size", "quality", "seconds", "MPixel/s", "PSNR");
+	for (const std::filesystem::path& sourcePath : sourcePaths) {
+		std::string relativePath = std::filesystem::relative(sourcePath, options.inputDirectory).generic_string();
+		DirectX::ScratchImage image;
+		if (FAILED(LoadSourceImage(sourcePath, image))) {
+			printf("%-40s load failed\n", relativePath.c_str());
+			continue;
+		}
+		DXGI_FORMAT compressedFormat = ChooseCompressedFormat(image, CookFormat::BC7);
+		if (compressedFormat != DXGI_FORMAT_BC7_UNORM && compressedFormat != DXGI_FORMAT_BC7_UNORM_SRGB) {
+			printf("%-40s not compressed to BC7\n", relativePath.c_str());
+			continue;
+		}
+		const DirectX::Image& source = *image.GetImage(0, 0, 0);
+		double megapixels = double(source.width) * double(source.height) / 1000000.0;
+		totalMegapixels += megapixels;
+		char size[32];
+		snprintf(size, sizeof(size), "%zux%zu", source.width, source.height);
+
+		for (size_t level = 0; level < kQualityCount; ++level) {
+			DirectX::CompressOptions compressOptions;
+			compressOptions.flags = DirectX::TEX_COMPRESS_PARALLEL | kBC7Qualities[level].flags;
+			compressOptions.threadCount = options.threadCount;
+			DirectX::ScratchImage compressed;
+			auto start = std::chrono::steady_clock::now();
+			if (FAILED(DirectX::CompressEx(source, compressedFormat, compressOptions, compressed))) {
+				printf("%-40s Compress failed\n", relativePath.c_str());
+				return 1;
+			}
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			// ComputeMSEはBCを自分で展開する。sRGBの画像は両方ともガンマ2.2で線形に直してから比べる
+			float mse = 0.0f;
+			if (FAILED(DirectX::ComputeMSE(source, *compressed.GetImage(0, 0, 0), mse, nullptr))) {
+				printf("%-40s ComputeMSE failed\n", relativePath.c_str());
+				return 1;
+			}
+			totalSeconds[level] += seconds;
+			totalSquaredError[level] += double(mse) * megapixels;
+			printf("%-40s %11s %10s %10.3f %10.2f %8.2f\n", relativePath.c_str(), size, kBC7Qualities[level].name,
+				seconds, megapixels / seconds, 10.0 * log10(1.0 / std::max(double(mse), 1e-10)));
+		}
+	}
+	if (totalMegapixels <= 0.0) {
+		return 1;
+	}
+
+	printf("\ncorpus total (%.2f MPixel)\n", totalMegapixels);
+	printf("%10s %10s %10s %8s\n", "quality", "seconds", "MPixel/s", "PSNR");
+	for (size_t level = 0; level < kQualityCount; ++level) {
+		double mse = totalSquaredError[level] / totalMegapixels;
+		printf("%10s %10.3f %10.2f %8.2f\n", kBC7Qualities[level].name, totalSeconds[level],
+			totalMegapixels / totalSeconds[level], 10.0 * log10(1.0 / std::max(mse, 1e-10)));
+	}
+	return 0;
+}
+
+// HDR画像ごとに最上位のミップをBC6Hの通常の探索と高速な探索で圧縮し、時間とRMSEを比べる
+// RMSEは元画像との線形のRGBの誤差。明るい画素ほど効くので、太陽などが入る画像では大きく出る。最後に全画像を合わせた値を出す
+int BenchmarkBC6H(const CookOptions& options) {
+	std::vector<std::filesystem::path> sourcePaths = FindSourceImages(options.inputDirectory);
+	const size_t kModeCount = 2;
+	const char* kModeNames[kModeCount] = { "default", "fast" };
+	const DirectX::TEX_COMPRESS_FLAGS kModeFlags[kModeCount] = { DirectX::TEX_COMPRESS_DEFAULT, DirectX::TEX_COMPRESS_BC6H_FAST };
+	double totalSeconds[kModeCount] = {};
+	double totalSquaredError[kModeCount] = {};
+	double totalMegapixels = 0.0;
+	printf("%-40s %11s %8s %10s %10s %10s\n", "image", "size", "mode", "seconds", "MPixel/s", "RMSE");
+	for (const std::filesystem::path& sourcePath : sourcePaths) {
+		std::string relativePath = std::filesystem::relative(sourcePath, options.inputDirectory).generic_string();
+		DirectX::ScratchImage image;
+		if (FAILED(LoadSourceImage(sourcePath, image))) {
+			printf("%-40s load failed\n", relativePath.c_str());
+			continue;
+		}
+		if (ChooseCompressedFormat(image, CookFormat::Auto) != DXGI_FORMAT_BC6H_UF16) {
+			continue;
+		}
+		const DirectX::Image& source = *image.GetImage(0, 0, 0);
+		double megapixels = double(source.width) * double(source.height) / 1000000.0;
+		totalMegapixels += megapixels;
+		char size[32];
+		snprintf(size, sizeof(size), "%zux%zu", source.width, source.height);
+
+		for (size_t mode = 0; mode < kModeCount; ++mode) {
+			DirectX::CompressOptions compressOptions;
+			compressOptions.flags = DirectX::TEX_COMPRESS_PARALLEL | kModeFlags[mode];
+			compressOptions.threadCount = options.threadCount;
+			DirectX::ScratchImage compressed;
+			auto start = std::chrono::steady_clock::now();
+			if (FAILED(DirectX::CompressEx(source, DXGI_FORMAT_BC6H_UF16, compressOptions, compressed))) {
+				printf("%-40s Compress failed\n", relativePath.c_str());
+				return 1;
+			}
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			// ComputeMSEの値はRGBの3チャンネルの和なので、1チャンネルあたりに直してから平方根を取る
+			float mse = 0.0f;
+			if (FAILED(DirectX::ComputeMSE(source, *compressed.GetImage(0, 0, 0), mse, nullptr, DirectX::CMSE_IGNORE_ALPHA))) {
+				printf("%-40s ComputeMSE failed\n", relativePath.c_str());
+				return 1;
+			}
+			totalSeconds[mode] += seconds;
+			totalSquaredError[mode] += double(mse) / 3.0 * megapixels;
+			printf("%-40s %11s %8s %10.3f %10.2f %10.5f\n", relativePath.c_str(), size, kModeNames[mode],
+				seconds, megapixels / seconds, sqrt(double(mse) / 3.0));
+		}
+	}
+	if (totalMegapixels <= 0.0) {
+		printf("no HDR images under %s\n", options.inputDirectory.string().c_str());
+		return 1;
+	}
+
+	printf("\ncorpus total (%.2f MPixel)\n", totalMegapixels);
+	printf("%8s %10s %10s %10s %8s\n", "mode", "seconds", "MPixel/s", "RMSE", "speedup");
+	for (size_t mode = 0; mode < kModeCount; ++mode) {
+		printf("%8s %10.3f %10.2f %10.5f %7.2fx\n", kModeNames[mode], totalSeconds[mode], totalMegapixels / totalSeconds[mode],
+			sqrt(totalSquaredError[mode] / totalMegapixels), totalSeconds[0] / totalSeconds[mode]);
+	}
+	return 0;
+}
+
+// クック済みDDSをミップごと全てRGBA8に展開し、Decompress（floatを経由する1スレッドの展開）と
+// DecompressEx（RGBA8へ直接、1スレッドと全スレッド）の時間を比べる。サムネイルやCRCの検証で使う展開の目安にする
+// DecompressExの結果がDecompressとバイト単位で一致することも確かめる。BC6Hは対象外
+int BenchmarkDecode(const CookOptions& options) {
+	std::vector<std::filesystem::path> cookedPaths;
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(options.inputDirectory)) {
+		if (entry.is_regular_file() && entry.path().extension() == ".dds" && entry.path().parent_path().filename() == "cooked") {
+			cookedPaths.push_back(entry.path());
+		}
+	}
+	if (cookedPaths.empty()) {
+		printf("no cooked textures under %s\n", options.inputDirectory.string().c_str());
+		return 1;
+	}
+
+	size_t maxThreadCount = options.threadCount ? options.threadCount : std::max(1u, std::thread::hardware_concurrency());
+	const size_t kThreadCounts[] = { 1, maxThreadCount };
+	const size_t kVariants = 3;
+	const char* kVariantNames[kVariants] = { "Decompress", "DecompressEx 1 thread", "DecompressEx all threads" };
+	double totalSeconds[kVariants] = {};
+	double totalMegapixels = 0.0;
+	printf("%-40s %11s %10s %10s %10s %8s\n", "texture", "size", "Decompress", "Ex 1", "Ex all", "speedup");
+	for (const std::filesystem::path& path : cookedPaths) {
+		std::string relativePath = std::filesystem::relative(path, options.inputDirectory).generic_string();
+		MappedFile file;
+		DirectX::TexMetadata metadata;
+		std::vector<DirectX::Image> images;
+		if (!file.Open(path) || FAILED(DirectX::GetDDSImageViews(file.GetData(), file.GetSize(), DirectX::DDS_FLAGS_NONE, metadata, images))) {
+			printf("%-40s load failed\n", relativePath.c_str());
+			continue;
+		}
+		if (!DirectX::IsCompressed(metadata.format) || metadata.format == DXGI_FORMAT_BC6H_UF16 || metadata.format == DXGI_FORMAT_BC6H_SF16) {
+			printf("%-40s skipped\n", relativePath.c_str());
+			continue;
+		}
+		DXGI_FORMAT format = DirectX::IsSRGB(metadata.format) ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+		double megapixels = 0.0;
+		for (const DirectX::Image& image : images) {
+			megapixels += double(image.width) * double(image.height) / 1000000.0;
+		}
+		totalMegapixels += megapixels;
+		char size[32];
+		snprintf(size, sizeof(size), "%zux%zu", metadata.width, metadata.height);
+
+		DirectX::ScratchImage reference;
+		double seconds[kVariants] = {};
+		for (size_t variant = 0; variant < kVariants; ++variant) {
+			DirectX::ScratchImage decoded;
+			auto start = std::chrono::steady_clock::now();
+			HRESULT hr;
+			if (variant == 0) {
+				hr = DirectX::Decompress(images.data(), images.size(), metadata, format, decoded);
+			} else {
+				DirectX::DecompressOptions decompressOptions;
+				decompressOptions.threadCount = kThreadCounts[variant - 1];
+				hr = DirectX::DecompressEx(images.data(), images.size(), metadata, format, decompressOptions, decoded);
+			}
+			seconds[variant] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			if (FAILED(hr)) {
+				printf("%-40s %s failed\n", relativePath.c_str(), kVariantNames[variant]);
+				return 1;
+			}
+			if (variant == 0) {
+				reference = std::move(decoded);
+			} else if (memcmp(reference.GetPixels(), decoded.GetPixels(), reference.GetPixelsSize()) != 0) {
+				printf("%-40s warning: %s differs from Decompress\n", relativePath.c_str(), kVariantNames[variant]);
+			}
+			totalSeconds[variant] += seconds[variant];
+		}
+		printf("%-40s %11s %10.4f %10.4f %10.4f %7.2fx\n", relativePath.c_str(), size,
+			seconds[0], seconds[1], seconds[2], seconds[0] / seconds[2]);
+	}
+
+	printf("total %.1f MPixel\n", totalMegapixels);
+	for (size_t variant = 0; variant < kVariants; ++variant) {
+		printf("%-24s: %8.3f s, %8.1f MPixel/s\n", kVariantNames[variant], totalSeconds[variant], totalMegapixels / totalSeconds[variant]);
+	}
+	return 0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+	CookOptions options;
+	if (!ParseOptions(argc, argv, options)) {
+		printf("usage: TextureCooker <input directory> [--format auto|bc7|bc1|none] [--quality ultrafast|veryfast|fast|basic|slow|exhaustive]\n"
+			"                      [--bc6h default|fast] [--force] [--threads N] [--benchmark-load] [--benchmark-compress] [--benchmark-bc7]\n"
+			"                      [--benchmark-decode] [--benchmark-bc6h]\n");
+#ifndef _WIN32
+		printf("%s\n", GetUnsupportedFormatMessage());
+#endif
+		return 1;
+	}
+	if (!std::filesystem::is_directory(options.inputDirectory)) {
+		printf("not a directory: %s\n", options.inputDirectory.string().c_str());
+		return 1;
+	}
+#ifdef _WIN32
+	// WICを使うのでCOMを初期化する
+	HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+	if (FAILED(hr)) {
+		return 1;
+	}
+#endif
+
+	int result = options.benchmarkLoad ? BenchmarkLoad(options)
+		: options.benchmarkCompress ? BenchmarkCompress(options)
+		: options.benchmarkBC7 ? BenchmarkBC7(options)
+		: options.benchmarkDecode ? BenchmarkDecode(options)
+		: options.benchmarkBC6H ? BenchmarkBC6H(options)
+		: CookDirectory(options);
+
+#ifdef _WIN32
+	CoUninitialize();
+#endif
+	return result;
+}
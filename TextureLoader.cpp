@@ -0,0 +1,118 @@
+#include "TextureLoader.h"
+#include "StringUtility.h"
+#include "CookedTexture.h"
+#include "MappedFile.h"
+#include <memory>
+#include <vector>
+#include <filesystem>
+
+namespace {
+
+// TextureCookerが書き出したDDSを読む。ミップマップも圧縮も済んでいるのでそのまま使える
+bool LoadCookedTexture(const std::filesystem::path& cookedPath, DirectX::ScratchImage& mipImages) {
+	MappedFile file;
+	if (!file.Open(cookedPath)) {
+		return false;
+	}
+	HRESULT hr = DirectX::LoadFromDDSMemory(file.GetData(), file.GetSize(), DirectX::DDS_FLAGS_NONE, nullptr, mipImages);
+	return SUCCEEDED(hr);
+}
+
+// クック済みDDSをマップし、画素をコピーせずにDecodedTextureへ渡す
+// 画素はマップしたファイルを直接指し、ステージングへのコピーが最初で最後のコピーになる
+bool MapCookedTexture(const std::filesystem::path& cookedPath, DecodedTexture& texture) {
+	std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+	if (!file->Open(cookedPath)) {
+		return false;
+	}
+	DirectX::TexMetadata metadata;
+	std::vector<DirectX::Image> images;
+	HRESULT hr = DirectX::GetDDSImageViews(file->GetData(), file->GetSize(), DirectX::DDS_FLAGS_NONE, metadata, images);
+	if (FAILED(hr) || metadata.dimension != DirectX::TEX_DIMENSION_TEXTURE2D || metadata.IsCubemap()) {
+		return false;
+	}
+
+	texture.width = uint32_t(metadata.width);
+	texture.height = uint32_t(metadata.height);
+	texture.mipLevels = uint32_t(metadata.mipLevels);
+	texture.arraySize = uint32_t(metadata.arraySize);
+	texture.format = uint32_t(metadata.format);
+	texture.subresources.clear();
+	for (const DirectX::Image& image : images) {
+		texture.subresources.push_back({ image.pixels, image.rowPitch, image.slicePitch, uint32_t(image.width), uint32_t(image.height) });
+	}
+	texture.storage = file;
+
+	// ここはワーカースレッドなので、ページを一通り触ってディスクからの読み込みを済ませておく
+	// こうしないとメインスレッドでステージングへコピーするときにページフォルトで止まる
+	volatile uint8_t sink = 0;
+	for (size_t offset = 0; offset < file->GetSize(); offset += 4096) {
+		sink = sink + file->GetData()[offset];
+	}
+	return true;
+}
+
+// 元画像より新しいクック済みDDSがあるか
+bool HasUpToDateCookedTexture(const std::filesystem::path& sourcePath, const std::filesystem::path& cookedPath) {
+	std::error_code errorCode;
+	if (!std::filesystem::exists(cookedPath, errorCode)) {
+		return false;
+	}
+	if (!std::filesystem::exists(sourcePath, errorCode)) {
+		return true;
+	}
+	return std::filesystem::last_write_time(cookedPath, errorCode) >= std::filesystem::last_write_time(sourcePath, errorCode);
+}
+
+}
+
+bool LoadTexture(const std::string& filePath, DirectX::ScratchImage& mipImages) {
+	// クック済みのDDSがあればそれを使う
+	std::filesystem::path sourcePath = filePath;
+	std::filesystem::path cookedPath = GetCookedTexturePath(sourcePath);
+	if (HasUpToDateCookedTexture(sourcePath, cookedPath) && LoadCookedTexture(cookedPath, mipImages)) {
+		return true;
+	}
+
+	// 無ければ元の画像を読み込んでプログラムで扱えるようにする
+	DirectX::ScratchImage image{};
+	std::wstring filePathW = ConvertString(filePath);
+	HRESULT hr = DirectX::LoadFromWICFile(filePathW.c_str(), DirectX::WIC_FLAGS_FORCE_SRGB, nullptr, image);
+	if (FAILED(hr)) {
+		return false;
+	}
+
+	// ミップマップの作成
+	hr = DirectX::GenerateMipMaps(image.GetImages(), image.GetImageCount(), image.GetMetadata(), DirectX::TEX_FILTER_SRGB, 0, mipImages);
+	return SUCCEEDED(hr);
+}
+
+bool DecodeTexture(const std::string& filePath, DecodedTexture& texture) {
+	// クック済みのDDSはデコードせず、マップした画素をそのまま使う
+	std::filesystem::path sourcePath = filePath;
+	std::filesystem::path cookedPath = GetCookedTexturePath(sourcePath);
+	if (HasUpToDateCookedTexture(sourcePath, cookedPath) && MapCookedTexture(cookedPath, texture)) {
+		return true;
+	}
+
+	std::shared_ptr<DirectX::ScratchImage> mipImages = std::make_shared<DirectX::ScratchImage>();
+	if (!LoadTexture(filePath, *mipImages)) {
+		return false;
+	}
+
+	const DirectX::TexMetadata& metadata = mipImages->GetMetadata();
+	texture.width = uint32_t(metadata.width);
+	texture.height = uint32_t(metadata.height);
+	texture.mipLevels = uint32_t(metadata.mipLevels);
+	texture.arraySize = uint32_t(metadata.arraySize);
+	texture.format = uint32_t(metadata.format);
+	// ScratchImageの並び（配列の要素ごとにmipが続く）はD3D12のサブリソースの番号と同じ
+	const DirectX::Image* images = mipImages->GetImages();
+	texture.subresources.clear();
+	for (size_t i = 0; i < mipImages->GetImageCount(); ++i) {
+		texture.subresources.push_back({ images[i].pixels, images[i].rowPitch, images[i].slicePitch,
+			uint32_t(images[i].width), uint32_t(images[i].height) });
+	}
+	texture.storage = mipImages;
+	return true;
+}
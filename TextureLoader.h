@@ -0,0 +1,12 @@
+#pragma once
+#include <string>
+#include "externals/DirectXTex/DirectXTex.h"
+#include "TextureStreamer.h"
+
+// テクスチャを読み込み、ミップマップまで作る。読めなければfalse
+// TextureCookerで作ったDDS（resources/cooked/以下）が元画像より新しければ、そちらを読んでデコードとミップマップの作成を省く
+bool LoadTexture(const std::string& filePath, DirectX::ScratchImage& mipImages);
+
+// TextureStreamer用のデコーダ。LoadTextureの結果をDecodedTextureに包む
+// WICを使うので、呼ぶスレッドはCOMのマルチスレッドアパートメントに属していること（CoInitializeEx済みのプロセスなら暗黙に属する）
+bool DecodeTexture(const std::string& filePath, DecodedTexture& texture);
@@ -0,0 +1,202 @@
+#include "TextureStreamer.h"
+#include "ThreadPool.h"
+#include <cassert>
+#include <algorithm>
+
+void TextureStreamer::Initialize(ITextureUploadBackend* backend, ThreadPool* threadPool, TextureDecoder decoder, uint64_t uploadBudgetPerUpdate) {
+	assert(backend != nullptr);
+	assert(threadPool != nullptr);
+	backend_ = backend;
+	threadPool_ = threadPool;
+	decoder_ = std::move(decoder);
+	stagingRing_.Initialize(backend->GetStagingCapacity());
+	uploadBudgetPerUpdate_ = uploadBudgetPerUpdate != 0 ? uploadBudgetPerUpdate : backend->GetStagingCapacity() / 2;
+	statistics_ = {};
+}
+
+void TextureStreamer::Finalize() {
+	// ワーカースレッドが触らなくなるまで待つ
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		decodedCondition_.wait(lock, [this]() { return decodingCount_ == 0; });
+	}
+	// コピー中のものが終わるまで待つ
+	uint64_t lastFenceValue = 0;
+	for (uint32_t textureId : uploadingList_) {
+		lastFenceValue = std::max(lastFenceValue, entries_[textureId]->fenceValue);
+	}
+	if (lastFenceValue != 0) {
+		backend_->WaitForValue(lastFenceValue);
+	}
+	for (std::unique_ptr<Entry>& entry : entries_) {
+		if (entry->texture) {
+			backend_->DestroyTexture(entry->texture);
+		}
+	}
+	entries_.clear();
+	decodedQueue_.clear();
+	uploadingList_.clear();
+}
+
+uint32_t TextureStreamer::Request(const std::string& filePath) {
+	uint32_t textureId = 0;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		textureId = uint32_t(entries_.size());
+		std::unique_ptr<Entry> entry = std::make_unique<Entry>();
+		entry->filePath = filePath;
+		entries_.push_back(std::move(entry));
+		if (statistics_.requestedCount == 0) {
+			firstRequestTime_ = std::chrono::steady_clock::now();
+		}
+		++statistics_.requestedCount;
+		++decodingCount_;
+	}
+	// デコードとmipの作成はワーカースレッドに任せる
+	threadPool_->Submit([this, textureId]() { Decode(textureId); });
+	return textureId;
+}
+
+void TextureStreamer::Decode(uint32_t textureId) {
+	Entry* entry = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		entry = entries_[textureId].get();
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	DecodedTexture decoded;
+	bool succeeded = decoder_(entry->filePath, decoded);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (succeeded) {
+			entry->decoded = std::move(decoded);
+			entry->state = State::Decoded;
+			decodedQueue_.push_back(textureId);
+			statistics_.decodedBytes += entry->decoded.GetSizeInBytes();
+		} else {
+			entry->state = State::Failed;
+		}
+		statistics_.decodeSeconds += seconds;
+		--decodingCount_;
+	}
+	decodedCondition_.notify_all();
+}
+
+void TextureStreamer::Update() {
+	// コピーが終わったものを使えるようにする
+	uint64_t completedValue = backend_->GetCompletedValue();
+	stagingRing_.Retire(completedValue);
+	for (size_t i = 0; i < uploadingList_.size();) {
+		Entry* entry = entries_[uploadingList_[i]].get();
+		if (entry->fenceValue > completedValue) {
+			++i;
+			continue;
+		}
+		backend_->OnResident(uploadingList_[i], entry->texture, entry->decoded);
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			entry->state = State::Resident;
+			++statistics_.residentCount;
+			statistics_.uploadedBytes += entry->decoded.GetSizeInBytes();
+			statistics_.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - firstRequestTime_).count();
+		}
+		// CPU側の画素はもう要らない
+		entry->decoded.subresources.clear();
+		entry->decoded.storage.reset();
+		uploadingList_[i] = uploadingList_.back();
+		uploadingList_.pop_back();
+	}
+
+	// デコード済みのものを取り出す
+	std::vector<uint32_t> decodedList;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		decodedList.swap(decodedQueue_);
+	}
+
+	// ステージングに入る分だけ転送を積む。入らなかったものは次のUpdateへ回す
+	uint64_t recordedBytes = 0;
+	size_t recordedCount = 0;
+	for (; recordedCount < decodedList.size(); ++recordedCount) {
+		Entry* entry = entries_[decodedList[recordedCount]].get();
+		if (entry->texture == nullptr) {
+			entry->texture = backend_->CreateTexture(entry->decoded, &entry->uploadSize);
+		}
+		uint64_t uploadSize = entry->uploadSize;
+
+		if (recordedBytes != 0 && recordedBytes + uploadSize > uploadBudgetPerUpdate_) {
+			break;
+		}
+		uint64_t stagingOffset = StagingRing::kInvalidOffset;
+		if (uploadSize <= stagingRing_.GetCapacity()) {
+			stagingOffset = stagingRing_.Allocate(uploadSize, backend_->GetStagingAlignment());
+			if (stagingOffset == StagingRing::kInvalidOffset) {
+				// リングが空くのを待つ
+				break;
+			}
+		}
+		backend_->RecordUpload(entry->texture, entry->decoded, stagingOffset);
+		recordedBytes += uploadSize;
+	}
+
+	if (recordedCount != 0) {
+		uint64_t fenceValue = backend_->Submit();
+		stagingRing_.Close(fenceValue);
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (size_t i = 0; i < recordedCount; ++i) {
+			Entry* entry = entries_[decodedList[i]].get();
+			entry->fenceValue = fenceValue;
+			entry->state = State::Uploading;
+			uploadingList_.push_back(decodedList[i]);
+		}
+	}
+
+	// 積めなかったものは順番を保ったまま戻す
+	if (recordedCount < decodedList.size()) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		decodedQueue_.insert(decodedQueue_.begin(), decodedList.begin() + recordedCount, decodedList.end());
+	}
+}
+
+void TextureStreamer::Flush() {
+	while (GetPendingCount() != 0) {
+		Update();
+		if (!uploadingList_.empty()) {
+			// コピーの完了を待つ
+			uint64_t lastFenceValue = 0;
+			for (uint32_t textureId : uploadingList_) {
+				lastFenceValue = std::max(lastFenceValue, entries_[textureId]->fenceValue);
+			}
+			backend_->WaitForValue(lastFenceValue);
+		} else {
+			// デコードが終わるのを待つ
+			std::unique_lock<std::mutex> lock(mutex_);
+			decodedCondition_.wait(lock, [this]() { return !decodedQueue_.empty() || decodingCount_ == 0; });
+		}
+	}
+}
+
+TextureStreamer::State TextureStreamer::GetState(uint32_t textureId) const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	assert(textureId < entries_.size());
+	return entries_[textureId]->state;
+}
+
+uint32_t TextureStreamer::GetPendingCount() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	uint32_t pendingCount = 0;
+	for (const std::unique_ptr<Entry>& entry : entries_) {
+		if (entry->state != State::Resident && entry->state != State::Failed) {
+			++pendingCount;
+		}
+	}
+	return pendingCount;
+}
+
+TextureStreamer::Statistics TextureStreamer::GetStatistics() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return statistics_;
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+#include "StagingRing.h"
+
+class ThreadPool;
+
+// 1枚分（1mip・1配列要素）の画素
+struct TextureSubresource {
+	const uint8_t* pixels = nullptr;
+	size_t rowPitch = 0;
+	size_t slicePitch = 0;
+	uint32_t width = 0;
+	uint32_t height = 0;
+};
+
+// デコード済みのテクスチャ。subresourcesはmip順に並び、配列の要素ごとに繰り返す
+struct DecodedTexture {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t mipLevels = 1;
+	uint32_t arraySize = 1;
+	// DXGI_FORMATの値
+	uint32_t format = 0;
+	std::vector<TextureSubresource> subresources;
+	// 画素の持ち主（ScratchImageなど）。subresourcesのpixelsはこれが生きている間だけ有効
+	std::shared_ptr<void> storage;
+
+	size_t GetSizeInBytes() const {
+		size_t size = 0;
+		for (const TextureSubresource& subresource : subresources) {
+			size += subresource.slicePitch;
+		}
+		return size;
+	}
+};
+
+// ファイルを読んでmipまで作る。ワーカースレッドから呼ばれる
+using TextureDecoder = std::function<bool(const std::string& filePath, DecodedTexture& texture)>;
+
+// GPU側の処理。D3D12ではCopyQueueとUploadHeapのステージングバッファで実装する
+class ITextureUploadBackend {
+public:
+	virtual ~ITextureUploadBackend() = default;
+	// ステージングバッファの大きさと、1つの転送の先頭に必要な配置単位
+	virtual uint64_t GetStagingCapacity() const = 0;
+	virtual uint64_t GetStagingAlignment() const = 0;
+	// 転送先のテクスチャを作り、ステージングに必要なサイズをuploadSizeに返す
+	virtual void* CreateTexture(const DecodedTexture& texture, uint64_t* uploadSize) = 0;
+	virtual void DestroyTexture(void* texture) = 0;
+	// 画素をステージングバッファのstagingOffsetへ書き、テクスチャへのコピーを積む
+	// stagingOffsetがStagingRing::kInvalidOffsetなら、リングに入らない大きさなので一時バッファを使う
+	virtual void RecordUpload(void* texture, const DecodedTexture& decoded, uint64_t stagingOffset) = 0;
+	// 積んだコピーを実行し、完了を表すSignal値を返す
+	virtual uint64_t Submit() = 0;
+	virtual uint64_t GetCompletedValue() = 0;
+	virtual void WaitForValue(uint64_t value) = 0;
+	// コピーが終わったテクスチャを描画に使えるようにする（SRVの作成など）
+	virtual void OnResident(uint32_t textureId, void* texture, const DecodedTexture& decoded) = 0;
+};
+
+// テクスチャをワーカースレッドで読み込み、コピー用のキューで非同期に転送する
+// 転送が終わるまでは呼び出し側がプレースホルダを使う
+class TextureStreamer {
+public:
+	enum class State {
+		Decoding,  // ワーカースレッドで読み込み中
+		Decoded,   // 転送待ち
+		Uploading, // コピーの完了待ち
+		Resident,  // 使える
+		Failed,    // 読み込めなかった
+	};
+
+	// 転送量などの統計
+	struct Statistics {
+		uint32_t requestedCount = 0;
+		uint32_t residentCount = 0;
+		uint64_t decodedBytes = 0;
+		uint64_t uploadedBytes = 0;
+		// 全ワーカーのデコード時間の合計
+		double decodeSeconds = 0.0;
+		// 最初のRequestから最後に転送が終わるまでの時間
+		double elapsedSeconds = 0.0;
+
+		// 要求から転送完了までの実効スループット
+		double GetThroughputMBps() const {
+			return elapsedSeconds > 0.0 ? double(uploadedBytes) / (1024.0 * 1024.0) / elapsedSeconds : 0.0;
+		}
+	};
+
+	// 1回のUpdateでステージングへ書き込む量の上限（既定はステージングの半分）
+	void Initialize(ITextureUploadBackend* backend, ThreadPool* threadPool, TextureDecoder decoder, uint64_t uploadBudgetPerUpdate = 0);
+	// 読み込み中のものを待ち、全てのテクスチャを破棄する
+	void Finalize();
+
+	// 読み込みを依頼する。戻り値はテクスチャの番号
+	uint32_t Request(const std::string& filePath);
+	// メインスレッドで毎フレーム呼ぶ。デコード済みのものを転送し、終わったものを使えるようにする
+	void Update();
+	// 全ての依頼が終わるまで待つ
+	void Flush();
+
+	State GetState(uint32_t textureId) const;
+	bool IsResident(uint32_t textureId) const { return GetState(textureId) == State::Resident; }
+	// 終わっていない依頼の数
+	uint32_t GetPendingCount() const;
+	Statistics GetStatistics() const;
+
+private:
+	struct Entry {
+		std::string filePath;
+		State state = State::Decoding;
+		DecodedTexture decoded;
+		void* texture = nullptr;
+		// ステージングに必要なサイズ
+		uint64_t uploadSize = 0;
+		uint64_t fenceValue = 0;
+	};
+
+	// ワーカースレッドから呼ばれる
+	void Decode(uint32_t textureId);
+
+	ITextureUploadBackend* backend_ = nullptr;
+	ThreadPool* threadPool_ = nullptr;
+	TextureDecoder decoder_;
+	uint64_t uploadBudgetPerUpdate_ = 0;
+	StagingRing stagingRing_;
+
+	// entries_とstatistics_はワーカースレッドからも触るので、mutex_で守る
+	mutable std::mutex mutex_;
+	// 番号がずれないように、要素のアドレスが変わらないunique_ptrで持つ
+	std::vector<std::unique_ptr<Entry>> entries_;
+	// デコードが終わった順の番号
+	std::vector<uint32_t> decodedQueue_;
+	// コピーの完了待ちの番号
+	std::vector<uint32_t> uploadingList_;
+	uint32_t decodingCount_ = 0;
+	// デコードが1つ終わるたびに通知する
+	std::condition_variable decodedCondition_;
+	Statistics statistics_;
+	std::chrono::steady_clock::time_point firstRequestTime_;
+};
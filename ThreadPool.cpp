@@ -0,0 +1,76 @@
+#include "ThreadPool.h"
+#include <atomic>
+#include <algorithm>
+
+ThreadPool::ThreadPool(uint32_t threadCount) {
+	if (threadCount == 0) {
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = (hardwareThreads > 1) ? hardwareThreads - 1 : 1;
+	}
+	workers_.reserve(threadCount);
+	for (uint32_t i = 0; i < threadCount; ++i) {
+		workers_.emplace_back([this]() { WorkerMain(); });
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	condition_.notify_all();
+	for (std::thread& worker : workers_) {
+		worker.join();
+	}
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& function) {
+	if (count == 0) {
+		return;
+	}
+	grainSize = std::max<size_t>(grainSize, 1);
+	size_t chunkCount = (count + grainSize - 1) / grainSize;
+	// 1チャンクしかないならスレッドを使うまでもない
+	if (chunkCount == 1) {
+		function(0, count);
+		return;
+	}
+
+	// 各スレッドが次のチャンク番号を取り合う
+	std::atomic<size_t> nextChunk = 0;
+	auto worker = [&]() {
+		for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++) {
+			size_t begin = chunk * grainSize;
+			function(begin, std::min(begin + grainSize, count));
+		}
+	};
+
+	size_t helperCount = std::min<size_t>(workers_.size(), chunkCount - 1);
+	std::vector<std::future<void>> helpers;
+	helpers.reserve(helperCount);
+	for (size_t i = 0; i < helperCount; ++i) {
+		helpers.push_back(Submit(worker));
+	}
+	// 呼び出し元のスレッドも処理する
+	worker();
+	for (std::future<void>& helper : helpers) {
+		helper.get();
+	}
+}
+
+void ThreadPool::WorkerMain() {
+	for (;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			condition_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+			// 止める指示があり、残りのタスクもなければ終了
+			if (stop_ && tasks_.empty()) {
+				return;
+			}
+			task = std::move(tasks_.front());
+			tasks_.pop();
+		}
+		task();
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+// 固定数のワーカースレッドでタスクを処理するスレッドプール
+class ThreadPool {
+public:
+	// threadCountが0ならハードウェアスレッド数-1（最低1）で作る
+	explicit ThreadPool(uint32_t threadCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// タスクを積む。結果はfutureで受け取る
+	template<class F>
+	std::future<std::invoke_result_t<F>> Submit(F&& function) {
+		using Result = std::invoke_result_t<F>;
+		// std::functionはコピーできる必要があるのでshared_ptrで包む
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(function));
+		std::future<Result> future = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			tasks_.emplace([task]() { (*task)(); });
+		}
+		condition_.notify_one();
+		return future;
+	}
+
+	// [0, count)をgrainSize個ずつに分けて並列に処理する。呼び出したスレッドも処理に参加し、全て終わるまで戻らない
+	// ワーカースレッド上のタスクから呼ぶと待ち合わせで詰まるので、入れ子にはしないこと
+	void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& function);
+
+	uint32_t GetThreadCount() const { return static_cast<uint32_t>(workers_.size()); }
+
+private:
+	void WorkerMain();
+
+	std::vector<std::thread> workers_;
+	std::queue<std::function<void()>> tasks_;
+	std::mutex mutex_;
+	std::condition_variable condition_;
+	bool stop_ = false;
+};
@@ -0,0 +1,194 @@
+#include "TransformBatch.h"
+#include "ThreadPool.h"
+#include <cstring>
+#include <cassert>
+
+#if defined(MYMATH_SSE_INTRINSICS)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// 1スレッドが受け持つオブジェクト数。4の倍数にしておく
+constexpr size_t kObjectsPerTask = 1024;
+
+// 4つ単位に切り上げる
+size_t AlignToSimdWidth(size_t count) {
+	return (count + 3) & ~size_t(3);
+}
+
+// index番目のWVPの書き込み先。書かないものはnullptr
+uint8_t* GetWvpDestination(uint8_t* wvpDestination, size_t wvpStride, const uint32_t* destinationSlots, size_t index) {
+	if (destinationSlots == nullptr) {
+		return wvpDestination + index * wvpStride;
+	}
+	if (destinationSlots[index] == TransformBatch::kNoSlot) {
+		return nullptr;
+	}
+	return wvpDestination + size_t(destinationSlots[index]) * wvpStride;
+}
+
+}
+
+uint32_t TransformBatch::Add(const Transform& transform) {
+	uint32_t index = static_cast<uint32_t>(count_);
+	size_t paddedCount = AlignToSimdWidth(count_ + 1);
+	if (scaleX_.size() < paddedCount) {
+		// 余りの部分は単位スケールで埋めておく（計算はするが書き込まない）
+		scaleX_.resize(paddedCount, 1.0f);
+		scaleY_.resize(paddedCount, 1.0f);
+		scaleZ_.resize(paddedCount, 1.0f);
+		rotateX_.resize(paddedCount, 0.0f);
+		rotateY_.resize(paddedCount, 0.0f);
+		rotateZ_.resize(paddedCount, 0.0f);
+		translateX_.resize(paddedCount, 0.0f);
+		translateY_.resize(paddedCount, 0.0f);
+		translateZ_.resize(paddedCount, 0.0f);
+	}
+	++count_;
+	Set(index, transform);
+	return index;
+}
+
+void TransformBatch::Set(uint32_t index, const Transform& transform) {
+	assert(index < count_);
+	scaleX_[index] = transform.scale.x;
+	scaleY_[index] = transform.scale.y;
+	scaleZ_[index] = transform.scale.z;
+	rotateX_[index] = transform.rotate.x;
+	rotateY_[index] = transform.rotate.y;
+	rotateZ_[index] = transform.rotate.z;
+	translateX_[index] = transform.translate.x;
+	translateY_[index] = transform.translate.y;
+	translateZ_[index] = transform.translate.z;
+}
+
+Transform TransformBatch::Get(uint32_t index) const {
+	assert(index < count_);
+	return {
+		{ scaleX_[index], scaleY_[index], scaleZ_[index] },
+		{ rotateX_[index], rotateY_[index], rotateZ_[index] },
+		{ translateX_[index], translateY_[index], translateZ_[index] },
+	};
+}
+
+void TransformBatch::Reserve(size_t capacity) {
+	size_t paddedCapacity = AlignToSimdWidth(capacity);
+	for (std::vector<float>* array : { &scaleX_, &scaleY_, &scaleZ_, &rotateX_, &rotateY_, &rotateZ_, &translateX_, &translateY_, &translateZ_ }) {
+		array->reserve(paddedCapacity);
+	}
+}
+
+void TransformBatch::Clear() {
+	for (std::vector<float>* array : { &scaleX_, &scaleY_, &scaleZ_, &rotateX_, &rotateY_, &rotateZ_, &translateX_, &translateY_, &translateZ_ }) {
+		array->clear();
+	}
+	count_ = 0;
+}
+
+void TransformBatch::Update(const Matrix4x4& viewProjection, void* wvpDestination, size_t wvpStride,
+	Matrix4x4* worldDestination, ThreadPool* threadPool, const uint32_t* destinationSlots) const {
+	assert(wvpDestination != nullptr);
+	assert(wvpStride >= sizeof(Matrix4x4));
+	uint8_t* destination = static_cast<uint8_t*>(wvpDestination);
+
+	if (threadPool == nullptr || count_ <= kObjectsPerTask) {
+		UpdateRange(0, count_, viewProjection, destination, wvpStride, worldDestination, destinationSlots);
+		return;
+	}
+	threadPool->ParallelFor(count_, kObjectsPerTask, [&](size_t begin, size_t end) {
+		UpdateRange(begin, end, viewProjection, destination, wvpStride, worldDestination, destinationSlots);
+	});
+}
+
+void TransformBatch::UpdateRange(size_t begin, size_t end, const Matrix4x4& viewProjection, uint8_t* wvpDestination, size_t wvpStride,
+	Matrix4x4* worldDestination, const uint32_t* destinationSlots) const {
+	assert(begin % 4 == 0);
+#if defined(MYMATH_SSE_INTRINSICS)
+	// VP行列の各要素を4レーンにブロードキャストしておく
+	__m128 vp[4][4];
+	for (int i = 0; i < 4; ++i) {
+		for (int j = 0; j < 4; ++j) {
+			vp[i][j] = _mm_set1_ps(viewProjection.m[i][j]);
+		}
+	}
+
+	for (size_t base = begin; base < end; base += 4) {
+		// sin/cosは4つ分まとめてSIMDで求める
+		alignas(16) float sinX[4], cosX[4], sinY[4], cosY[4], sinZ[4], cosZ[4];
+		SinCos(&rotateX_[base], sinX, cosX, 4);
+		SinCos(&rotateY_[base], sinY, cosY, 4);
+		SinCos(&rotateZ_[base], sinZ, cosZ, 4);
+		__m128 sx = _mm_load_ps(sinX), cx = _mm_load_ps(cosX);
+		__m128 sy = _mm_load_ps(sinY), cy = _mm_load_ps(cosY);
+		__m128 sz = _mm_load_ps(sinZ), cz = _mm_load_ps(cosZ);
+		__m128 scaleX = _mm_loadu_ps(&scaleX_[base]);
+		__m128 scaleY = _mm_loadu_ps(&scaleY_[base]);
+		__m128 scaleZ = _mm_loadu_ps(&scaleZ_[base]);
+
+		// World行列の左上3x3 = Scale * RotateX * RotateY * RotateZ を4オブジェクト同時に求める
+		__m128 sxsy = _mm_mul_ps(sx, sy);
+		__m128 cxsy = _mm_mul_ps(cx, sy);
+		__m128 world[4][3];
+		world[0][0] = _mm_mul_ps(scaleX, _mm_mul_ps(cy, cz));
+		world[0][1] = _mm_mul_ps(scaleX, _mm_mul_ps(cy, sz));
+		world[0][2] = _mm_mul_ps(scaleX, _mm_sub_ps(_mm_setzero_ps(), sy));
+		world[1][0] = _mm_mul_ps(scaleY, _mm_sub_ps(_mm_mul_ps(sxsy, cz), _mm_mul_ps(cx, sz)));
+		world[1][1] = _mm_mul_ps(scaleY, _mm_add_ps(_mm_mul_ps(sxsy, sz), _mm_mul_ps(cx, cz)));
+		world[1][2] = _mm_mul_ps(scaleY, _mm_mul_ps(sx, cy));
+		world[2][0] = _mm_mul_ps(scaleZ, _mm_add_ps(_mm_mul_ps(cxsy, cz), _mm_mul_ps(sx, sz)));
+		world[2][1] = _mm_mul_ps(scaleZ, _mm_sub_ps(_mm_mul_ps(cxsy, sz), _mm_mul_ps(sx, cz)));
+		world[2][2] = _mm_mul_ps(scaleZ, _mm_mul_ps(cx, cy));
+		world[3][0] = _mm_loadu_ps(&translateX_[base]);
+		world[3][1] = _mm_loadu_ps(&translateY_[base]);
+		world[3][2] = _mm_loadu_ps(&translateZ_[base]);
+
+		size_t laneCount = (end - base < 4) ? end - base : 4;
+		uint8_t* laneDestinations[4] = {};
+		for (size_t lane = 0; lane < laneCount; ++lane) {
+			laneDestinations[lane] = GetWvpDestination(wvpDestination, wvpStride, destinationSlots, base + lane);
+		}
+		for (int row = 0; row < 4; ++row) {
+			// WVP[row][j] = Σ World[row][k] * VP[k][j]。World[row][3]は0か1なので掛け算を省く
+			__m128 wvp[4];
+			for (int j = 0; j < 4; ++j) {
+				__m128 value = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(world[row][0], vp[0][j]), _mm_mul_ps(world[row][1], vp[1][j])),
+					_mm_mul_ps(world[row][2], vp[2][j]));
+				wvp[j] = (row == 3) ? _mm_add_ps(value, vp[3][j]) : value;
+			}
+			// レーン=オブジェクトの並びから、オブジェクトごとの行に並べ替える
+			_MM_TRANSPOSE4_PS(wvp[0], wvp[1], wvp[2], wvp[3]);
+			for (size_t lane = 0; lane < laneCount; ++lane) {
+				if (laneDestinations[lane] != nullptr) {
+					_mm_storeu_ps(reinterpret_cast<Matrix4x4*>(laneDestinations[lane])->m[row], wvp[lane]);
+				}
+			}
+
+			if (worldDestination != nullptr) {
+				__m128 worldRow[4] = { world[row][0], world[row][1], world[row][2],
+					(row == 3) ? _mm_set1_ps(1.0f) : _mm_setzero_ps() };
+				_MM_TRANSPOSE4_PS(worldRow[0], worldRow[1], worldRow[2], worldRow[3]);
+				for (size_t lane = 0; lane < laneCount; ++lane) {
+					_mm_storeu_ps(worldDestination[base + lane].m[row], worldRow[lane]);
+				}
+			}
+		}
+	}
+#else
+	for (size_t index = begin; index < end; ++index) {
+		Matrix4x4 worldMatrix = MakeAffineMatrix(
+			{ scaleX_[index], scaleY_[index], scaleZ_[index] },
+			{ rotateX_[index], rotateY_[index], rotateZ_[index] },
+			{ translateX_[index], translateY_[index], translateZ_[index] });
+		Matrix4x4 wvpMatrix = Multiply(worldMatrix, viewProjection);
+		uint8_t* destination = GetWvpDestination(wvpDestination, wvpStride, destinationSlots, index);
+		if (destination != nullptr) {
+			std::memcpy(destination, &wvpMatrix, sizeof(Matrix4x4));
+		}
+		if (worldDestination != nullptr) {
+			worldDestination[index] = worldMatrix;
+		}
+	}
+#endif
+}
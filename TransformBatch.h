@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "MyMath.h"
+
+class ThreadPool;
+
+// 大量のTransformをSoA（要素ごとの配列）で持ち、World/WVP行列をまとめて計算する
+class TransformBatch {
+public:
+	// destinationSlotsでこの値のオブジェクトはWVPを書き込まない
+	static constexpr uint32_t kNoSlot = UINT32_MAX;
+
+	// 追加して番号を返す
+	uint32_t Add(const Transform& transform);
+	void Set(uint32_t index, const Transform& transform);
+	Transform Get(uint32_t index) const;
+
+	void Reserve(size_t capacity);
+	void Clear();
+	size_t GetCount() const { return count_; }
+
+	// 全オブジェクトのWVPを計算し、wvpDestinationからwvpStrideバイト間隔で書き込む
+	// MapしたUploadBufferを直接渡せる。worldDestinationを渡すとWorld行列も書き込む
+	// threadPoolを渡すと、一定数以上のときは複数スレッドで分担する
+	// destinationSlotsを渡すと、i番目のWVPはwvpDestinationのdestinationSlots[i]番目に書く。描く順に並べたUploadBufferへ直接書ける
+	// worldDestinationはdestinationSlotsに関係なくオブジェクトの番号の順
+	void Update(const Matrix4x4& viewProjection, void* wvpDestination, size_t wvpStride,
+		Matrix4x4* worldDestination = nullptr, ThreadPool* threadPool = nullptr, const uint32_t* destinationSlots = nullptr) const;
+
+private:
+	// [begin, end)の範囲を計算する。beginは4の倍数であること
+	void UpdateRange(size_t begin, size_t end, const Matrix4x4& viewProjection, uint8_t* wvpDestination, size_t wvpStride,
+		Matrix4x4* worldDestination, const uint32_t* destinationSlots) const;
+
+	// SIMDで4つずつ読めるよう、配列は4の倍数に切り上げて確保する
+	std::vector<float> scaleX_, scaleY_, scaleZ_;
+	std::vector<float> rotateX_, rotateY_, rotateZ_;
+	std::vector<float> translateX_, translateY_, translateZ_;
+	size_t count_ = 0;
+};
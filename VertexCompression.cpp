@@ -0,0 +1,165 @@
+#include "VertexCompression.h"
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+
+const float kUnorm16Max = 65535.0f;
+
+uint16_t EncodeUnorm16(double value) {
+	return uint16_t(std::clamp(value, 0.0, 1.0) * kUnorm16Max + 0.5);
+}
+
+float DecodeUnorm16(uint16_t value) {
+	return float(value) / kUnorm16Max;
+}
+
+}
+
+uint16_t FloatToHalf(float value) {
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t exponent = (bits >> 23) & 0xFF;
+	uint32_t mantissa = bits & 0x7FFFFF;
+	if (exponent == 0xFF) {
+		// 無限大とNaN。NaNは仮数を残す
+		return uint16_t(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+	}
+	int32_t halfExponent = int32_t(exponent) - 127 + 15;
+	if (halfExponent >= 0x1F) {
+		// 大きすぎるものは無限大
+		return uint16_t(sign | 0x7C00);
+	}
+	if (halfExponent <= 0) {
+		// 非正規化数。小さすぎるものは0
+		if (halfExponent < -10) {
+			return uint16_t(sign);
+		}
+		mantissa |= 0x800000;
+		uint32_t shift = uint32_t(14 - halfExponent);
+		uint32_t halfMantissa = mantissa >> shift;
+		uint32_t remainder = mantissa & ((1u << shift) - 1);
+		uint32_t halfway = 1u << (shift - 1);
+		if (remainder > halfway || (remainder == halfway && (halfMantissa & 1))) {
+			++halfMantissa;
+		}
+		return uint16_t(sign | halfMantissa);
+	}
+	uint32_t half = sign | (uint32_t(halfExponent) << 10) | (mantissa >> 13);
+	uint32_t remainder = mantissa & 0x1FFF;
+	// 繰り上がりで指数が増えても、そのまま正しい値(最大なら無限大)になる
+	if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+		++half;
+	}
+	return uint16_t(half);
+}
+
+float HalfToFloat(uint16_t value) {
+	uint32_t sign = uint32_t(value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 0x1F;
+	uint32_t mantissa = value & 0x3FF;
+	uint32_t bits;
+	if (exponent == 0x1F) {
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	} else if (exponent != 0) {
+		bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+	} else if (mantissa == 0) {
+		bits = sign;
+	} else {
+		// 非正規化数を正規化する
+		exponent = 127 - 15 + 1;
+		while (!(mantissa & 0x400)) {
+			mantissa <<= 1;
+			--exponent;
+		}
+		bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+	}
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+CompressedMesh CompressMesh(const Mesh& mesh) {
+	CompressedMesh compressed;
+	compressed.indices = mesh.indices;
+	if (mesh.vertices.empty()) {
+		compressed.positionDecode = { { 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f } };
+		return compressed;
+	}
+
+	Vector3 minimum = { mesh.vertices[0].position.x, mesh.vertices[0].position.y, mesh.vertices[0].position.z };
+	Vector3 maximum = minimum;
+	bool texcoordsInUnitRange = true;
+	for (const VertexData& vertex : mesh.vertices) {
+		minimum = { std::min(minimum.x, vertex.position.x), std::min(minimum.y, vertex.position.y), std::min(minimum.z, vertex.position.z) };
+		maximum = { std::max(maximum.x, vertex.position.x), std::max(maximum.y, vertex.position.y), std::max(maximum.z, vertex.position.z) };
+		texcoordsInUnitRange = texcoordsInUnitRange && vertex.texcoord.x >= 0.0f && vertex.texcoord.x <= 1.0f &&
+			vertex.texcoord.y >= 0.0f && vertex.texcoord.y <= 1.0f;
+	}
+	// 幅が0の軸は何で割っても0になるので1にしておく
+	Vector3 extent = { maximum.x - minimum.x, maximum.y - minimum.y, maximum.z - minimum.z };
+	extent = { extent.x > 0.0f ? extent.x : 1.0f, extent.y > 0.0f ? extent.y : 1.0f, extent.z > 0.0f ? extent.z : 1.0f };
+	compressed.positionDecode = { extent, minimum };
+	// タイリングなどで0～1をはみ出すUVは半精度にする
+	compressed.texcoordEncoding = texcoordsInUnitRange ? TexcoordEncoding::Unorm16 : TexcoordEncoding::Half;
+
+	compressed.vertices.resize(mesh.vertices.size());
+	for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+		const VertexData& vertex = mesh.vertices[i];
+		CompressedVertex& output = compressed.vertices[i];
+		// 割り算の丸めで刻みがずれないようdoubleで計算する
+		output.position[0] = EncodeUnorm16((double(vertex.position.x) - minimum.x) / extent.x);
+		output.position[1] = EncodeUnorm16((double(vertex.position.y) - minimum.y) / extent.y);
+		output.position[2] = EncodeUnorm16((double(vertex.position.z) - minimum.z) / extent.z);
+		output.position[3] = uint16_t(kUnorm16Max);
+		if (compressed.texcoordEncoding == TexcoordEncoding::Unorm16) {
+			output.texcoord[0] = EncodeUnorm16(vertex.texcoord.x);
+			output.texcoord[1] = EncodeUnorm16(vertex.texcoord.y);
+		} else {
+			output.texcoord[0] = FloatToHalf(vertex.texcoord.x);
+			output.texcoord[1] = FloatToHalf(vertex.texcoord.y);
+		}
+	}
+	return compressed;
+}
+
+VertexData DecompressVertex(const CompressedMesh& mesh, const CompressedVertex& vertex) {
+	const PositionDecode& decode = mesh.positionDecode;
+	VertexData result;
+	result.position = {
+		DecodeUnorm16(vertex.position[0]) * decode.scale.x + decode.offset.x,
+		DecodeUnorm16(vertex.position[1]) * decode.scale.y + decode.offset.y,
+		DecodeUnorm16(vertex.position[2]) * decode.scale.z + decode.offset.z,
+		1.0f,
+	};
+	if (mesh.texcoordEncoding == TexcoordEncoding::Unorm16) {
+		result.texcoord = { DecodeUnorm16(vertex.texcoord[0]), DecodeUnorm16(vertex.texcoord[1]) };
+	} else {
+		result.texcoord = { HalfToFloat(vertex.texcoord[0]), HalfToFloat(vertex.texcoord[1]) };
+	}
+	return result;
+}
+
+VertexCompressionReport MeasureVertexCompression(const Mesh& source, const CompressedMesh& compressed) {
+	VertexCompressionReport report;
+	const Vector3& scale = compressed.positionDecode.scale;
+	const Vector3& offset = compressed.positionDecode.offset;
+	// 復元の掛け算と足し算のfloatの丸めの分も足す
+	float magnitude = std::max({ std::abs(offset.x), std::abs(offset.y), std::abs(offset.z),
+		std::abs(offset.x + scale.x), std::abs(offset.y + scale.y), std::abs(offset.z + scale.z) });
+	report.positionErrorBound = std::max({ scale.x, scale.y, scale.z }) / kUnorm16Max * 0.5f + magnitude * FLT_EPSILON * 2.0f;
+	for (size_t i = 0; i < source.vertices.size() && i < compressed.vertices.size(); ++i) {
+		const VertexData& original = source.vertices[i];
+		VertexData decoded = DecompressVertex(compressed, compressed.vertices[i]);
+		report.maxPositionError = std::max({ report.maxPositionError, std::abs(decoded.position.x - original.position.x),
+			std::abs(decoded.position.y - original.position.y), std::abs(decoded.position.z - original.position.z) });
+		report.maxTexcoordError = std::max({ report.maxTexcoordError, std::abs(decoded.texcoord.x - original.texcoord.x),
+			std::abs(decoded.texcoord.y - original.texcoord.y) });
+	}
+	report.sourceBytes = uint64_t(source.vertices.size()) * sizeof(VertexData);
+	report.compressedBytes = uint64_t(compressed.vertices.size()) * sizeof(CompressedVertex);
+	return report;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Mesh.h"
+
+// VertexData(24バイト)を12バイトに詰めた頂点
+// 位置はメッシュのバウンディングボックスに対する16bitの値で、R16G16B16A16_UNORMとして読む。wは使わない
+// UVは全て0～1に収まればR16G16_UNORM、そうでなければR16G16_FLOAT(半精度)として読む
+struct CompressedVertex {
+	uint16_t position[4];
+	uint16_t texcoord[2];
+};
+
+enum class TexcoordEncoding {
+	Unorm16,
+	Half,
+};
+
+// 頂点シェーダーでの位置の復元に使う値。position.xyz * scale + offsetで元に戻る
+struct PositionDecode {
+	Vector3 scale;
+	Vector3 offset;
+};
+
+struct CompressedMesh {
+	std::vector<CompressedVertex> vertices;
+	std::vector<uint32_t> indices;
+	PositionDecode positionDecode;
+	TexcoordEncoding texcoordEncoding = TexcoordEncoding::Unorm16;
+};
+
+// 圧縮した結果の誤差と大きさ
+struct VertexCompressionReport {
+	// 元の頂点と、圧縮して戻した頂点の差の最大(軸ごと)
+	float maxPositionError = 0.0f;
+	float maxTexcoordError = 0.0f;
+	// 量子化の刻みの半分に、復元の計算の丸めを足したもの。maxPositionErrorはこれを超えない
+	float positionErrorBound = 0.0f;
+	uint64_t sourceBytes = 0;
+	uint64_t compressedBytes = 0;
+};
+
+// 位置はバウンディングボックスの範囲を65535等分して丸める。インデックスはそのまま
+CompressedMesh CompressMesh(const Mesh& mesh);
+
+// CPUでの復元。シェーダーと同じ計算をする
+VertexData DecompressVertex(const CompressedMesh& mesh, const CompressedVertex& vertex);
+
+// 全ての頂点を戻して元と比べる
+VertexCompressionReport MeasureVertexCompression(const Mesh& source, const CompressedMesh& compressed);
+
+// 半精度浮動小数点との変換。最近接偶数に丸める
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t value);
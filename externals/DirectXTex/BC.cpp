@@ -17,6 +17,15 @@
 
 #include "BC.h"
 
+// Multi-block BC1/BC3 encoder for x86/x64; other targets use the single-block encoder
+#if (defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)) && !defined(_M_ARM64EC) && !defined(COLOR_WEIGHTS)
+#define BC_WIDE_ENCODER
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
 using namespace DirectX;
 using namespace DirectX::PackedVector;
 
@@ -315,12 +324,12 @@ namespace
 
 
     //-------------------------------------------------------------------------------------
-    inline void DecodeBC1(
-        _Out_writes_(NUM_PIXELS_PER_BLOCK) XMVECTOR *pColor,
+    inline void DecodeBC1Palette(
+        _Out_writes_(4) XMVECTOR *pPalette,
         _In_ const D3DX_BC1 *pBC,
         bool isbc1) noexcept
     {
-        assert(pColor && pBC);
+        assert(pPalette && pBC);
         static_assert(sizeof(D3DX_BC1) == 8, "D3DX_BC1 should be 8 bytes");
 
         static XMVECTORF32 s_Scale = { { { 1.f / 31.f, 1.f / 63.f, 1.f / 31.f, 1.f } } };
@@ -337,32 +346,130 @@ namespace
         clr0 = XMVectorSelect(g_XMIdentityR3, clr0, g_XMSelect1110);
         clr1 = XMVectorSelect(g_XMIdentityR3, clr1, g_XMSelect1110);
 
-        XMVECTOR clr2, clr3;
+        pPalette[0] = clr0;
+        pPalette[1] = clr1;
         if (isbc1 && (pBC->rgb[0] <= pBC->rgb[1]))
         {
-            clr2 = XMVectorLerp(clr0, clr1, 0.5f);
-            clr3 = XMVectorZero();  // Alpha of 0
+            pPalette[2] = XMVectorLerp(clr0, clr1, 0.5f);
+            pPalette[3] = XMVectorZero();  // Alpha of 0
         }
         else
         {
-            clr2 = XMVectorLerp(clr0, clr1, 1.f / 3.f);
-            clr3 = XMVectorLerp(clr0, clr1, 2.f / 3.f);
+            pPalette[2] = XMVectorLerp(clr0, clr1, 1.f / 3.f);
+            pPalette[3] = XMVectorLerp(clr0, clr1, 2.f / 3.f);
         }
+    }
+
+    inline void DecodeBC1(
+        _Out_writes_(NUM_PIXELS_PER_BLOCK) XMVECTOR *pColor,
+        _In_ const D3DX_BC1 *pBC,
+        bool isbc1) noexcept
+    {
+        assert(pColor && pBC);
+
+        XMVECTOR clr[4];
+        DecodeBC1Palette(clr, pBC, isbc1);
 
         uint32_t dw = pBC->bitmap;
 
         for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i, dw >>= 2)
         {
-            switch (dw & 3)
+            pColor[i] = clr[dw & 3];
+        }
+    }
+
+
+    //-------------------------------------------------------------------------------------
+    // Writes the 16 texels of a BC1 color block as R8G8B8A8, 4 rows rowPitch bytes apart.
+    // The palette is rounded the way StoreScanline rounds R8G8B8A8_UNORM; pAlpha (16 bytes, or nullptr)
+    // replaces the alpha channel.
+    //-------------------------------------------------------------------------------------
+    void DecodeBC1RGBA8(
+        _Out_writes_bytes_(rowPitch * 3 + 16) uint8_t *pDest,
+        size_t rowPitch,
+        _In_ const D3DX_BC1 *pBC,
+        bool isbc1,
+        _In_reads_opt_(NUM_PIXELS_PER_BLOCK) const uint8_t *pAlpha) noexcept
+    {
+        XMVECTOR clr[4];
+        DecodeBC1Palette(clr, pBC, isbc1);
+
+        uint32_t palette[4];
+        for (size_t i = 0; i < 4; ++i)
+        {
+            XMStoreUByteN4(reinterpret_cast<XMUBYTEN4*>(&palette[i]), XMVectorAdd(clr[i], g_BC8BitBias));
+        }
+
+        uint32_t dw = pBC->bitmap;
+
+    #if defined(_XM_SSE_INTRINSICS_)
+        // One row of 4 texels per register: isolate each texel's 2-bit index in place and select by comparing
+        const __m128i mask = _mm_setr_epi32(3, 3 << 2, 3 << 4, 3 << 6);
+        const __m128i index1 = _mm_setr_epi32(1, 1 << 2, 1 << 4, 1 << 6);
+        const __m128i index2 = _mm_setr_epi32(2, 2 << 2, 2 << 4, 2 << 6);
+        const __m128i color0 = _mm_set1_epi32(static_cast<int>(palette[0]));
+        const __m128i delta1 = _mm_set1_epi32(static_cast<int>(palette[0] ^ palette[1]));
+        const __m128i delta2 = _mm_set1_epi32(static_cast<int>(palette[0] ^ palette[2]));
+        const __m128i delta3 = _mm_set1_epi32(static_cast<int>(palette[0] ^ palette[3]));
+
+        for (size_t y = 0; y < 4; ++y, dw >>= 8)
+        {
+            const __m128i index = _mm_and_si128(_mm_set1_epi32(static_cast<int>(dw)), mask);
+
+            __m128i color = color0;
+            color = _mm_xor_si128(color, _mm_and_si128(_mm_cmpeq_epi32(index, index1), delta1));
+            color = _mm_xor_si128(color, _mm_and_si128(_mm_cmpeq_epi32(index, index2), delta2));
+            color = _mm_xor_si128(color, _mm_and_si128(_mm_cmpeq_epi32(index, mask), delta3));
+
+            if (pAlpha)
             {
-            case 0: pColor[i] = clr0; break;
-            case 1: pColor[i] = clr1; break;
-            case 2: pColor[i] = clr2; break;
+                // Widen 4 alpha bytes to the top byte of each texel
+                uint32_t alpha;
+                memcpy(&alpha, pAlpha + y * 4, sizeof(alpha));
+                __m128i a = _mm_cvtsi32_si128(static_cast<int>(alpha));
+                a = _mm_unpacklo_epi8(_mm_setzero_si128(), a);
+                a = _mm_unpacklo_epi16(_mm_setzero_si128(), a);
+                color = _mm_or_si128(_mm_and_si128(color, _mm_set1_epi32(0x00FFFFFF)), a);
+            }
 
-            case 3:
-            default: pColor[i] = clr3; break;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pDest + y * rowPitch), color);
+        }
+    #else
+        for (size_t y = 0; y < 4; ++y)
+        {
+            for (size_t x = 0; x < 4; ++x, dw >>= 2)
+            {
+                uint32_t color = palette[dw & 3];
+                if (pAlpha)
+                {
+                    color = (color & 0x00FFFFFF) | (uint32_t(pAlpha[y * 4 + x]) << 24);
+                }
+                memcpy(pDest + y * rowPitch + x * 4, &color, sizeof(color));
             }
         }
+    #endif
+    }
+
+
+    //-------------------------------------------------------------------------------------
+    inline void DecodeBC3AlphaPalette(_Out_writes_(8) float *fAlpha, _In_ const D3DX_BC3 *pBC) noexcept
+    {
+        fAlpha[0] = static_cast<float>(pBC->alpha[0]) * (1.0f / 255.0f);
+        fAlpha[1] = static_cast<float>(pBC->alpha[1]) * (1.0f / 255.0f);
+
+        if (pBC->alpha[0] > pBC->alpha[1])
+        {
+            for (size_t i = 1; i < 7; ++i)
+                fAlpha[i + 1] = (fAlpha[0] * float(7u - i) + fAlpha[1] * float(i)) * (1.0f / 7.0f);
+        }
+        else
+        {
+            for (size_t i = 1; i < 5; ++i)
+                fAlpha[i + 1] = (fAlpha[0] * float(5u - i) + fAlpha[1] * float(i)) * (1.0f / 5.0f);
+
+            fAlpha[6] = 0.0f;
+            fAlpha[7] = 1.0f;
+        }
     }
 
 
@@ -717,6 +824,93 @@ namespace
         pBC->bitmap = 0x00000000;
     }
 #endif // COLOR_WEIGHTS
+
+#ifdef BC_WIDE_ENCODER
+    //-------------------------------------------------------------------------------------
+    // Multi-block encoders, compiled once for AVX2 and once for SSE4.1 and picked at runtime.
+    // MSVC allows the intrinsics without /arch; GCC and clang need the target set per function.
+    //-------------------------------------------------------------------------------------
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+    namespace AVX2
+    {
+    #define BC_WIDE_LANES 8
+    #include "BCWide.inl"
+    #undef BC_WIDE_LANES
+    }
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse4.1"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+#endif
+    namespace SSE41
+    {
+    #define BC_WIDE_LANES 4
+    #include "BCWide.inl"
+    #undef BC_WIDE_LANES
+    }
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+    enum class WideISA
+    {
+        None,
+        SSE41,
+        AVX2,
+    };
+
+    WideISA DetectWideISA() noexcept
+    {
+    #ifdef _MSC_VER
+        int info[4] = {};
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+        if (maxLeaf < 1)
+            return WideISA::None;
+
+        __cpuid(info, 1);
+        const bool sse41 = (info[2] & (1 << 19)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+
+        // AVX2 also needs the OS to save the YMM registers
+        bool avx2 = false;
+        if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6)
+        {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+    #else
+        __builtin_cpu_init();
+        const bool sse41 = __builtin_cpu_supports("sse4.1") != 0;
+        const bool avx2 = __builtin_cpu_supports("avx2") != 0;
+    #endif
+
+        if (avx2)
+            return WideISA::AVX2;
+        return sse41 ? WideISA::SSE41 : WideISA::None;
+    }
+
+    WideISA GetWideISA() noexcept
+    {
+        static const WideISA s_isa = DetectWideISA();
+        return s_isa;
+    }
+#endif // BC_WIDE_ENCODER
 }
 
 
@@ -734,6 +928,13 @@ void DirectX::D3DXDecodeBC1(XMVECTOR *pColor, const uint8_t *pBC) noexcept
     DecodeBC1(pColor, pBC1, true);
 }
 
+_Use_decl_annotations_
+void DirectX::D3DXDecodeBC1RGBA8(uint8_t *pDest, size_t rowPitch, const uint8_t *pBC) noexcept
+{
+    assert(pDest && pBC);
+    DecodeBC1RGBA8(pDest, rowPitch, reinterpret_cast<const D3DX_BC1 *>(pBC), true, nullptr);
+}
+
 _Use_decl_annotations_
 void DirectX::D3DXEncodeBC1(uint8_t *pBC, const XMVECTOR *pColor, float threshold, uint32_t flags) noexcept
 {
@@ -795,6 +996,44 @@ void DirectX::D3DXEncodeBC1(uint8_t *pBC, const XMVECTOR *pColor, float threshol
 }
 
 
+_Use_decl_annotations_
+void DirectX::D3DXEncodeBC1Wide(uint8_t *pBC, const XMVECTOR *pColor, size_t count, float threshold, uint32_t flags) noexcept
+{
+    assert(pBC && pColor && count <= BC_WIDE_BLOCKS);
+
+#ifdef BC_WIDE_ENCODER
+    if (!(flags & (BC_FLAGS_DITHER_RGB | BC_FLAGS_DITHER_A | BC_FLAGS_NO_SIMD)))
+    {
+        switch (GetWideISA())
+        {
+        case WideISA::AVX2:
+            if (count > 0)
+            {
+                AVX2::EncodeBC1Blocks(pBC, pColor, count, threshold, flags);
+            }
+            return;
+
+        case WideISA::SSE41:
+            for (size_t i = 0; i < count; i += SSE41::c_Lanes)
+            {
+                SSE41::EncodeBC1Blocks(pBC + i * sizeof(D3DX_BC1), pColor + i * NUM_PIXELS_PER_BLOCK,
+                    std::min(count - i, SSE41::c_Lanes), threshold, flags);
+            }
+            return;
+
+        default:
+            break;
+        }
+    }
+#endif
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        D3DXEncodeBC1(pBC + i * sizeof(D3DX_BC1), pColor + i * NUM_PIXELS_PER_BLOCK, threshold, flags);
+    }
+}
+
+
 //-------------------------------------------------------------------------------------
 // BC2 Compression
 //-------------------------------------------------------------------------------------
@@ -824,6 +1063,24 @@ void DirectX::D3DXDecodeBC2(XMVECTOR *pColor, const uint8_t *pBC) noexcept
         pColor[i] = XMVectorSetW(pColor[i], static_cast<float>(dw & 0xf) * (1.0f / 15.0f));
 }
 
+_Use_decl_annotations_
+void DirectX::D3DXDecodeBC2RGBA8(uint8_t *pDest, size_t rowPitch, const uint8_t *pBC) noexcept
+{
+    assert(pDest && pBC);
+    static_assert(sizeof(D3DX_BC2) == 16, "D3DX_BC2 should be 16 bytes");
+
+    auto pBC2 = reinterpret_cast<const D3DX_BC2 *>(pBC);
+
+    // n / 15 rounds to exactly n * 17 in 8 bits
+    uint8_t alpha[NUM_PIXELS_PER_BLOCK];
+    for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+    {
+        alpha[i] = static_cast<uint8_t>(((pBC2->bitmap[i >> 3] >> ((i & 7) * 4)) & 0xf) * 17);
+    }
+
+    DecodeBC1RGBA8(pDest, rowPitch, &pBC2->bc1, false, alpha);
+}
+
 _Use_decl_annotations_
 void DirectX::D3DXEncodeBC2(uint8_t *pBC, const XMVECTOR *pColor, uint32_t flags) noexcept
 {
@@ -911,33 +1168,47 @@ void DirectX::D3DXDecodeBC3(XMVECTOR *pColor, const uint8_t *pBC) noexcept
 
     // Adaptive 3-bit alpha part
     float fAlpha[8];
+    DecodeBC3AlphaPalette(fAlpha, pBC3);
 
-    fAlpha[0] = static_cast<float>(pBC3->alpha[0]) * (1.0f / 255.0f);
-    fAlpha[1] = static_cast<float>(pBC3->alpha[1]) * (1.0f / 255.0f);
+    uint32_t dw = uint32_t(pBC3->bitmap[0]) | uint32_t(pBC3->bitmap[1] << 8) | uint32_t(pBC3->bitmap[2] << 16);
 
-    if (pBC3->alpha[0] > pBC3->alpha[1])
-    {
-        for (size_t i = 1; i < 7; ++i)
-            fAlpha[i + 1] = (fAlpha[0] * float(7u - i) + fAlpha[1] * float(i)) * (1.0f / 7.0f);
-    }
-    else
-    {
-        for (size_t i = 1; i < 5; ++i)
-            fAlpha[i + 1] = (fAlpha[0] * float(5u - i) + fAlpha[1] * float(i)) * (1.0f / 5.0f);
+    for (size_t i = 0; i < 8; ++i, dw >>= 3)
+        pColor[i] = XMVectorSetW(pColor[i], fAlpha[dw & 0x7]);
 
-        fAlpha[6] = 0.0f;
-        fAlpha[7] = 1.0f;
-    }
+    dw = uint32_t(pBC3->bitmap[3]) | uint32_t(pBC3->bitmap[4] << 8) | uint32_t(pBC3->bitmap[5] << 16);
+
+    for (size_t i = 8; i < NUM_PIXELS_PER_BLOCK; ++i, dw >>= 3)
+        pColor[i] = XMVectorSetW(pColor[i], fAlpha[dw & 0x7]);
+}
+
+_Use_decl_annotations_
+void DirectX::D3DXDecodeBC3RGBA8(uint8_t *pDest, size_t rowPitch, const uint8_t *pBC) noexcept
+{
+    assert(pDest && pBC);
+    static_assert(sizeof(D3DX_BC3) == 16, "D3DX_BC3 should be 16 bytes");
+
+    auto pBC3 = reinterpret_cast<const D3DX_BC3 *>(pBC);
+
+    // Round the 8 alpha levels once, with the same conversion StoreScanline uses
+    XM_ALIGNED_DATA(16) float fAlpha[8];
+    DecodeBC3AlphaPalette(fAlpha, pBC3);
+
+    uint8_t palette[8];
+    XMStoreUByteN4(reinterpret_cast<XMUBYTEN4*>(&palette[0]), XMVectorAdd(XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(&fAlpha[0])), g_BC8BitBias));
+    XMStoreUByteN4(reinterpret_cast<XMUBYTEN4*>(&palette[4]), XMVectorAdd(XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(&fAlpha[4])), g_BC8BitBias));
 
+    uint8_t alpha[NUM_PIXELS_PER_BLOCK];
     uint32_t dw = uint32_t(pBC3->bitmap[0]) | uint32_t(pBC3->bitmap[1] << 8) | uint32_t(pBC3->bitmap[2] << 16);
 
     for (size_t i = 0; i < 8; ++i, dw >>= 3)
-        pColor[i] = XMVectorSetW(pColor[i], fAlpha[dw & 0x7]);
+        alpha[i] = palette[dw & 0x7];
 
     dw = uint32_t(pBC3->bitmap[3]) | uint32_t(pBC3->bitmap[4] << 8) | uint32_t(pBC3->bitmap[5] << 16);
 
     for (size_t i = 8; i < NUM_PIXELS_PER_BLOCK; ++i, dw >>= 3)
-        pColor[i] = XMVectorSetW(pColor[i], fAlpha[dw & 0x7]);
+        alpha[i] = palette[dw & 0x7];
+
+    DecodeBC1RGBA8(pDest, rowPitch, &pBC3->bc1, false, alpha);
 }
 
 _Use_decl_annotations_
@@ -1139,3 +1410,40 @@ void DirectX::D3DXEncodeBC3(uint8_t *pBC, const XMVECTOR *pColor, uint32_t flags
         pBC3->bitmap[2 + iSet * 3] = reinterpret_cast<uint8_t *>(&dw)[2];
     }
 }
+
+_Use_decl_annotations_
+void DirectX::D3DXEncodeBC3Wide(uint8_t *pBC, const XMVECTOR *pColor, size_t count, uint32_t flags) noexcept
+{
+    assert(pBC && pColor && count <= BC_WIDE_BLOCKS);
+
+#ifdef BC_WIDE_ENCODER
+    if (!(flags & (BC_FLAGS_DITHER_RGB | BC_FLAGS_DITHER_A | BC_FLAGS_NO_SIMD)))
+    {
+        switch (GetWideISA())
+        {
+        case WideISA::AVX2:
+            if (count > 0)
+            {
+                AVX2::EncodeBC3Blocks(pBC, pColor, count, flags);
+            }
+            return;
+
+        case WideISA::SSE41:
+            for (size_t i = 0; i < count; i += SSE41::c_Lanes)
+            {
+                SSE41::EncodeBC3Blocks(pBC + i * sizeof(D3DX_BC3), pColor + i * NUM_PIXELS_PER_BLOCK,
+                    std::min(count - i, SSE41::c_Lanes), flags);
+            }
+            return;
+
+        default:
+            break;
+        }
+    }
+#endif
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        D3DXEncodeBC3(pBC + i * sizeof(D3DX_BC3), pColor + i * NUM_PIXELS_PER_BLOCK, flags);
+    }
+}
@@ -45,8 +45,22 @@ namespace DirectX
 
         BC_FLAGS_FORCE_BC7_MODE6 = 0x100000,
         // BC7 should only use mode 6; skip other modes
+
+        BC_FLAGS_BC7_QUALITY_MASK = 0xE00000,
+        // BC7 search effort, a 3-bit level rather than independent bits (0 = default search)
+
+        BC_FLAGS_NO_SIMD = 0x20000000,
+        // BC1 & BC3 wide entry points fall back to the scalar encoder
+
+        BC_FLAGS_BC6H_FAST = 0x40000000,
+        // BC6H tries a restricted mode set, perturbs only the winning endpoints, and stops early on a good enough fit
     };
 
+    constexpr uint32_t BC_FLAGS_BC7_QUALITY_SHIFT = 21;
+
+    // Added before XMStoreUByteN4 (which truncates) by the direct R8G8B8A8 decoders, as StoreScanline does
+    const XMVECTORF32 g_BC8BitBias = { { { 0.5f / 255.f, 0.5f / 255.f, 0.5f / 255.f, 0.5f / 255.f } } };
+
     //-------------------------------------------------------------------------------------
     // Structures
     //-------------------------------------------------------------------------------------
@@ -323,6 +337,18 @@ namespace DirectX
     void D3DXDecodeBC6HS(_Out_writes_(NUM_PIXELS_PER_BLOCK) XMVECTOR *pColor, _In_reads_(16) const uint8_t *pBC) noexcept;
     void D3DXDecodeBC7(_Out_writes_(NUM_PIXELS_PER_BLOCK) XMVECTOR *pColor, _In_reads_(16) const uint8_t *pBC) noexcept;
 
+    // Decoders straight to R8G8B8A8 texels: 4 rows of 4 texels at pDest, rowPitch bytes apart. The texels match
+    // D3DXDecodeBCx followed by a conversion to R8G8B8A8_UNORM (BC4 comes out grey, BC5 with blue 0). Only the
+    // per-block palette is computed in float; the texels are integer lookups into it (SSE2 for the BC1-3 colors).
+    typedef void (*BC_DECODE_RGBA8)(uint8_t *pDest, size_t rowPitch, const uint8_t *pBC);
+
+    void D3DXDecodeBC1RGBA8(_Out_writes_bytes_(rowPitch * 3 + 16) uint8_t *pDest, _In_ size_t rowPitch, _In_reads_(8) const uint8_t *pBC) noexcept;
+    void D3DXDecodeBC2RGBA8(_Out_writes_bytes_(rowPitch * 3 + 16) uint8_t *pDest, _In_ size_t rowPitch, _In_reads_(16) const uint8_t *pBC) noexcept;
+    void D3DXDecodeBC3RGBA8(_Out_writes_bytes_(rowPitch * 3 + 16) uint8_t *pDest, _In_ size_t rowPitch, _In_reads_(16) const uint8_t *pBC) noexcept;
+    void D3DXDecodeBC4URGBA8(_Out_writes_bytes_(rowPitch * 3 + 16) uint8_t *pDest, _In_ size_t rowPitch, _In_reads_(8) const uint8_t *pBC) noexcept;
+    void D3DXDecodeBC5URGBA8(_Out_writes_bytes_(rowPitch * 3 + 16) uint8_t *pDest, _In_ size_t rowPitch, _In_reads_(16) const uint8_t *pBC) noexcept;
+    void D3DXDecodeBC7RGBA8(_Out_writes_bytes_(rowPitch * 3 + 16) uint8_t *pDest, _In_ size_t rowPitch, _In_reads_(16) const uint8_t *pBC) noexcept;
+
     void D3DXEncodeBC1(_Out_writes_(8) uint8_t *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const XMVECTOR *pColor, _In_ float threshold, _In_ uint32_t flags) noexcept;
         // BC1 requires one additional parameter, so it doesn't match signature of BC_ENCODE above
 
@@ -336,4 +362,19 @@ namespace DirectX
     void D3DXEncodeBC6HS(_Out_writes_(16) uint8_t *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const XMVECTOR *pColor, _In_ uint32_t flags) noexcept;
     void D3DXEncodeBC7(_Out_writes_(16) uint8_t *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const XMVECTOR *pColor, _In_ uint32_t flags) noexcept;
 
+    // Multi-block BC1/BC3 encoders: pColor holds 'count' consecutive 16-pixel blocks (count <= BC_WIDE_BLOCKS),
+    // pBC receives 'count' consecutive encoded blocks. The blocks run in lockstep on AVX2 (8 at a time) or
+    // SSE4.1 (4 at a time) when the CPU has them; otherwise, when dithering, or with BC_FLAGS_NO_SIMD they
+    // go through D3DXEncodeBC1/3 one at a time.
+    // Each lane performs the same float operations as the single-block encoder, so with IEEE float math
+    // (/fp:precise) the output is bit-exact. The DirectXTex projects build with /fp:fast, which lets the
+    // compiler contract and reorder the single-block encoder's math, so shipped builds are not bit-exact.
+    // Against a fast-math build of it, 119 BC1 (0.06%) and 376 BC3 (0.19%) of 200k random and structured
+    // blocks picked different endpoints or indices, with the same mean MSE to four digits. Use
+    // BC_FLAGS_NO_SIMD (TEX_COMPRESS_BC_NO_SIMD) when output must match the single-block encoder exactly.
+    constexpr size_t BC_WIDE_BLOCKS = 8;
+
+    void D3DXEncodeBC1Wide(_Out_writes_(count * 8) uint8_t *pBC, _In_reads_(count * NUM_PIXELS_PER_BLOCK) const XMVECTOR *pColor, _In_ size_t count, _In_ float threshold, _In_ uint32_t flags) noexcept;
+    void D3DXEncodeBC3Wide(_Out_writes_(count * 16) uint8_t *pBC, _In_reads_(count * NUM_PIXELS_PER_BLOCK) const XMVECTOR *pColor, _In_ size_t count, _In_ uint32_t flags) noexcept;
+
 } // namespace
@@ -375,6 +375,62 @@ namespace
             pBC->SetIndex(i, uBestIndex);
         }
     }
+
+    //------------------------------------------------------------------------------
+    // Writes a BC4U (grey) or BC5U (pGreen set) block as R8G8B8A8, 4 rows rowPitch bytes apart. Each level is
+    // rounded once with the conversion StoreScanline uses, then the texels are plain table lookups.
+    void DecodeBC4URGBA8(
+        _Out_writes_bytes_(rowPitch * 3 + 16) uint8_t *pDest,
+        size_t rowPitch,
+        _In_ const BC4_UNORM* pRed,
+        _In_opt_ const BC4_UNORM* pGreen) noexcept
+    {
+        uint8_t red[8];
+        XMStoreUByteN4(reinterpret_cast<PackedVector::XMUBYTEN4*>(&red[0]),
+            XMVectorAdd(XMVectorSet(pRed->DecodeFromIndex(0), pRed->DecodeFromIndex(1), pRed->DecodeFromIndex(2), pRed->DecodeFromIndex(3)),
+            g_BC8BitBias));
+        XMStoreUByteN4(reinterpret_cast<PackedVector::XMUBYTEN4*>(&red[4]),
+            XMVectorAdd(XMVectorSet(pRed->DecodeFromIndex(4), pRed->DecodeFromIndex(5), pRed->DecodeFromIndex(6), pRed->DecodeFromIndex(7)),
+            g_BC8BitBias));
+
+        uint32_t paletteR[8];
+        uint32_t paletteG[8] = {};
+        for (size_t i = 0; i < 8; ++i)
+        {
+            // Grey for BC4 (R is splat to RGB), red only for BC5
+            paletteR[i] = pGreen ? (0xFF000000u | red[i]) : (0xFF000000u | (uint32_t(red[i]) * 0x010101u));
+        }
+
+        uint64_t greenBits = 0;
+        if (pGreen)
+        {
+            uint8_t green[8];
+            XMStoreUByteN4(reinterpret_cast<PackedVector::XMUBYTEN4*>(&green[0]),
+                XMVectorAdd(XMVectorSet(pGreen->DecodeFromIndex(0), pGreen->DecodeFromIndex(1), pGreen->DecodeFromIndex(2), pGreen->DecodeFromIndex(3)),
+                g_BC8BitBias));
+            XMStoreUByteN4(reinterpret_cast<PackedVector::XMUBYTEN4*>(&green[4]),
+                XMVectorAdd(XMVectorSet(pGreen->DecodeFromIndex(4), pGreen->DecodeFromIndex(5), pGreen->DecodeFromIndex(6), pGreen->DecodeFromIndex(7)),
+                g_BC8BitBias));
+
+            for (size_t i = 0; i < 8; ++i)
+            {
+                paletteG[i] = uint32_t(green[i]) << 8;
+            }
+
+            greenBits = pGreen->data >> 16;
+        }
+
+        uint64_t redBits = pRed->data >> 16;
+        for (size_t y = 0; y < BLOCK_LEN; ++y)
+        {
+            uint32_t row[BLOCK_LEN];
+            for (size_t x = 0; x < BLOCK_LEN; ++x, redBits >>= 3, greenBits >>= 3)
+            {
+                row[x] = paletteR[redBits & 7] | paletteG[greenBits & 7];
+            }
+            memcpy(pDest + y * rowPitch, row, sizeof(row));
+        }
+    }
 }
 
 
@@ -400,6 +456,15 @@ void DirectX::D3DXDecodeBC4U(XMVECTOR *pColor, const uint8_t *pBC) noexcept
     }
 }
 
+_Use_decl_annotations_
+void DirectX::D3DXDecodeBC4URGBA8(uint8_t *pDest, size_t rowPitch, const uint8_t *pBC) noexcept
+{
+    assert(pDest && pBC);
+    static_assert(sizeof(BC4_UNORM) == 8, "BC4_UNORM should be 8 bytes");
+
+    DecodeBC4URGBA8(pDest, rowPitch, reinterpret_cast<const BC4_UNORM*>(pBC), nullptr);
+}
+
 _Use_decl_annotations_
 void DirectX::D3DXDecodeBC4S(XMVECTOR *pColor, const uint8_t *pBC) noexcept
 {
@@ -477,6 +542,16 @@ void DirectX::D3DXDecodeBC5U(XMVECTOR *pColor, const uint8_t *pBC) noexcept
     }
 }
 
+_Use_decl_annotations_
+void DirectX::D3DXDecodeBC5URGBA8(uint8_t *pDest, size_t rowPitch, const uint8_t *pBC) noexcept
+{
+    assert(pDest && pBC);
+    static_assert(sizeof(BC4_UNORM) == 8, "BC4_UNORM should be 8 bytes");
+
+    DecodeBC4URGBA8(pDest, rowPitch,
+        reinterpret_cast<const BC4_UNORM*>(pBC), reinterpret_cast<const BC4_UNORM*>(pBC + sizeof(BC4_UNORM)));
+}
+
 _Use_decl_annotations_
 void DirectX::D3DXDecodeBC5S(XMVECTOR *pColor, const uint8_t *pBC) noexcept
 {
@@ -656,7 +656,7 @@ namespace
     {
     public:
         void Decode(_In_ bool bSigned, _Out_writes_(NUM_PIXELS_PER_BLOCK) HDRColorA* pOut) const noexcept;
-        void Encode(_In_ bool bSigned, _In_reads_(NUM_PIXELS_PER_BLOCK) const HDRColorA* const pIn) noexcept;
+        void Encode(_In_ bool bSigned, _In_reads_(NUM_PIXELS_PER_BLOCK) const HDRColorA* const pIn, _In_ uint32_t flags) noexcept;
 
     private:
     #pragma warning(push)
@@ -702,6 +702,7 @@ namespace
         {
             float fBestErr;
             const bool bSigned;
+            bool bOptimize;
             uint8_t uMode;
             uint8_t uShape;
             const HDRColorA* const aHDRPixels;
@@ -709,7 +710,7 @@ namespace
             INTColor aIPixels[NUM_PIXELS_PER_BLOCK];
 
             EncodeParams(const HDRColorA* const aOriginal, bool bSignedFormat) noexcept :
-                fBestErr(FLT_MAX), bSigned(bSignedFormat), uMode(0), uShape(0), aHDRPixels(aOriginal), aUnqEndPts{}, aIPixels{}
+                fBestErr(FLT_MAX), bSigned(bSignedFormat), bOptimize(true), uMode(0), uShape(0), aHDRPixels(aOriginal), aUnqEndPts{}, aIPixels{}
             {
                 for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
                 {
@@ -744,6 +745,7 @@ namespace
         void EmitBlock(_In_ const EncodeParams* pEP, _In_reads_(BC6H_MAX_REGIONS) const INTEndPntPair aEndPts[],
             _In_reads_(NUM_PIXELS_PER_BLOCK) const size_t aIndices[]) noexcept;
         void Refine(_Inout_ EncodeParams* pEP) noexcept;
+        void EncodeFast(_Inout_ EncodeParams* pEP) noexcept;
 
         static void GeneratePaletteUnquantized(_In_ const EncodeParams* pEP, _In_ size_t uRegion, _Out_writes_(BC6H_MAX_INDICES) INTColor aPalette[]) noexcept;
         float MapColors(_In_ const EncodeParams* pEP, _In_ size_t uRegion, _In_ size_t np, _In_reads_(np) const size_t* auIndex) const noexcept;
@@ -758,11 +760,20 @@ namespace
         static const int ms_aModeToInfo[c_NumModeInfo];
     };
 
+    // How far BC7 refines the endpoints of each candidate (set by the quality level)
+    enum BC7_REFINE : uint8_t
+    {
+        BC7_REFINE_NONE,        // quantize the rough endpoints and pick indices
+        BC7_REFINE_PERTURB,     // + per-channel logarithmic endpoint search
+        BC7_REFINE_FULL,        // + small exhaustive search around the result
+    };
+
     // BC67 compression (16b bits per texel)
     class D3DX_BC7 : private CBits< 16 >
     {
     public:
         void Decode(_Out_writes_(NUM_PIXELS_PER_BLOCK) HDRColorA* pOut) const noexcept;
+        void Decode(_Out_writes_(NUM_PIXELS_PER_BLOCK) LDRColorA* pOut) const noexcept;
         void Encode(uint32_t flags, _In_reads_(NUM_PIXELS_PER_BLOCK) const HDRColorA* const pIn) noexcept;
 
     private:
@@ -784,11 +795,12 @@ namespace
         struct EncodeParams
         {
             uint8_t uMode;
+            uint8_t uRefine;
             LDREndPntPair aEndPts[BC7_MAX_SHAPES][BC7_MAX_REGIONS];
             LDRColorA aLDRPixels[NUM_PIXELS_PER_BLOCK];
             const HDRColorA* const aHDRPixels;
 
-            EncodeParams(const HDRColorA* const aOriginal) noexcept : uMode(0), aEndPts{}, aLDRPixels{}, aHDRPixels(aOriginal) {}
+            EncodeParams(const HDRColorA* const aOriginal) noexcept : uMode(0), uRefine(BC7_REFINE_FULL), aEndPts{}, aLDRPixels{}, aHDRPixels(aOriginal) {}
         };
     #pragma warning(pop)
 
@@ -1624,6 +1636,138 @@ namespace
     }
 
 
+    //-------------------------------------------------------------------------------------
+    // BC6H fast mode (BC_FLAGS_BC6H_FAST)
+    //-------------------------------------------------------------------------------------
+
+    // Modes tried in order (indices into D3DX_BC6H::ms_aInfo): the 1-region modes first, as they share a single
+    // endpoint fit, then the 2-region modes 1, 2, 6 & 10 (10/7/9-bit transformed and 6-bit untransformed), which
+    // between them cover the endpoint ranges the other six 2-region modes add little to
+    constexpr uint8_t g_aBC6HFastModes[] = { 10, 11, 12, 13, 0, 1, 5, 9 };
+
+    // Shapes refined per 2-region mode, taken from a single RoughMSE ranking shared by all of them
+    constexpr size_t BC6H_FAST_SHAPES = 2;
+
+    // Stop once the block error is this low (squared F16 ULPs summed over RGB and the 16 pixels; 12 ULPs per
+    // channel is about 1% of the value at any exposure)
+    constexpr float BC6H_FAST_GOOD_ENOUGH = 12.0f * 12.0f * 3.0f * float(NUM_PIXELS_PER_BLOCK);
+
+
+    //-------------------------------------------------------------------------------------
+    // BC7 quality levels
+    //-------------------------------------------------------------------------------------
+    enum BC7_SHAPE_SEARCH : uint8_t
+    {
+        BC7_SHAPES_ROUGH,       // RoughMSE (endpoint fit + palette error) on every shape
+        BC7_SHAPES_PCA,         // rank shapes by the residual off each subset's principal axis, RoughMSE only the best
+    };
+
+    struct BC7Quality
+    {
+        uint8_t             modeMask;   // bit n = try mode n
+        uint8_t             rotations;  // rotations tried by modes 4 & 5 (1 = no channel swap)
+        BC7_SHAPE_SEARCH    search;
+        uint8_t             items;      // shapes refined per mode/index mode; 0 = a quarter of them
+        BC7_REFINE          refine;
+    };
+
+    // Indexed by (flags & BC_FLAGS_BC7_QUALITY_MASK) >> BC_FLAGS_BC7_QUALITY_SHIFT; 0 is the historical default
+    constexpr BC7Quality g_aBC7Quality[8] =
+    {
+        { 0xFA, 4, BC7_SHAPES_ROUGH, 0,  BC7_REFINE_FULL },     // default
+        { 0x42, 1, BC7_SHAPES_PCA,   1,  BC7_REFINE_NONE },     // ULTRAFAST
+        { 0xC2, 1, BC7_SHAPES_PCA,   1,  BC7_REFINE_PERTURB },  // VERYFAST
+        { 0xFA, 1, BC7_SHAPES_PCA,   4,  BC7_REFINE_PERTURB },  // FAST
+        { 0xFA, 4, BC7_SHAPES_ROUGH, 0,  BC7_REFINE_FULL },     // BASIC
+        { 0xFF, 4, BC7_SHAPES_ROUGH, 0,  BC7_REFINE_FULL },     // SLOW
+        { 0xFF, 4, BC7_SHAPES_ROUGH, 64, BC7_REFINE_FULL },     // EXHAUSTIVE
+        { 0xFF, 4, BC7_SHAPES_ROUGH, 64, BC7_REFINE_FULL },     // (reserved)
+    };
+
+    // For every shape, the squared distance of the pixels from the best-fit line through each subset
+    // (n * (trace(C) - largest eigenvalue of C) per subset). This is what an ideal unquantized endpoint
+    // pair can't represent, so it ranks shapes well for a fraction of the cost of RoughMSE.
+    void PrincipalAxisError(
+        _In_reads_(NUM_PIXELS_PER_BLOCK) const LDRColorA aPixels[],
+        size_t uPartitions,
+        size_t uShapes,
+        _Out_writes_(uShapes) float afError[]) noexcept
+    {
+        assert(uPartitions > 0 && uPartitions < BC7_MAX_REGIONS && uShapes <= BC7_MAX_SHAPES);
+
+        // Per-pixel first and second moments, summed per subset below
+        float aMoments[NUM_PIXELS_PER_BLOCK][14];
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            const float c[4] = { float(aPixels[i].r), float(aPixels[i].g), float(aPixels[i].b), float(aPixels[i].a) };
+            float* m = aMoments[i];
+            m[0] = c[0]; m[1] = c[1]; m[2] = c[2]; m[3] = c[3];
+            m[4] = c[0] * c[0]; m[5] = c[0] * c[1]; m[6] = c[0] * c[2]; m[7] = c[0] * c[3];
+            m[8] = c[1] * c[1]; m[9] = c[1] * c[2]; m[10] = c[1] * c[3];
+            m[11] = c[2] * c[2]; m[12] = c[2] * c[3];
+            m[13] = c[3] * c[3];
+        }
+
+        for (size_t uShape = 0; uShape < uShapes; ++uShape)
+        {
+            float aSum[BC7_MAX_REGIONS][14] = {};
+            float aCount[BC7_MAX_REGIONS] = {};
+            for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+            {
+                const size_t p = g_aPartitionTable[uPartitions][uShape][i];
+                aCount[p] += 1.0f;
+                for (size_t k = 0; k < 14; ++k)
+                    aSum[p][k] += aMoments[i][k];
+            }
+
+            float fError = 0.0f;
+            for (size_t p = 0; p <= uPartitions; ++p)
+            {
+                if (aCount[p] < 2.0f)
+                    continue;
+
+                const float* s = aSum[p];
+                const float invN = 1.0f / aCount[p];
+                const float mean[4] = { s[0] * invN, s[1] * invN, s[2] * invN, s[3] * invN };
+                const float cov[4][4] =
+                {
+                    { s[4] * invN - mean[0] * mean[0], s[5] * invN - mean[0] * mean[1], s[6] * invN - mean[0] * mean[2], s[7] * invN - mean[0] * mean[3] },
+                    { s[5] * invN - mean[0] * mean[1], s[8] * invN - mean[1] * mean[1], s[9] * invN - mean[1] * mean[2], s[10] * invN - mean[1] * mean[3] },
+                    { s[6] * invN - mean[0] * mean[2], s[9] * invN - mean[1] * mean[2], s[11] * invN - mean[2] * mean[2], s[12] * invN - mean[2] * mean[3] },
+                    { s[7] * invN - mean[0] * mean[3], s[10] * invN - mean[1] * mean[3], s[12] * invN - mean[2] * mean[3], s[13] * invN - mean[3] * mean[3] },
+                };
+                const float trace = cov[0][0] + cov[1][1] + cov[2][2] + cov[3][3];
+
+                // Power iteration from the row with the largest variance converges in a few steps for 4x4
+                size_t start = 0;
+                for (size_t k = 1; k < 4; ++k)
+                    if (cov[k][k] > cov[start][start])
+                        start = k;
+                float v[4] = { cov[start][0], cov[start][1], cov[start][2], cov[start][3] };
+                float lambda = 0.0f;
+                for (size_t iter = 0; iter < 4; ++iter)
+                {
+                    float w[4];
+                    for (size_t k = 0; k < 4; ++k)
+                        w[k] = cov[k][0] * v[0] + cov[k][1] * v[1] + cov[k][2] * v[2] + cov[k][3] * v[3];
+                    const float vv = v[0] * v[0] + v[1] * v[1] + v[2] * v[2] + v[3] * v[3];
+                    if (vv <= 0.0f)
+                        break;
+                    lambda = (v[0] * w[0] + v[1] * w[1] + v[2] * w[2] + v[3] * w[3]) / vv;
+                    const float ww = w[0] * w[0] + w[1] * w[1] + w[2] * w[2] + w[3] * w[3];
+                    if (ww <= 0.0f)
+                        break;
+                    const float scale = 1.0f / sqrtf(ww);
+                    for (size_t k = 0; k < 4; ++k)
+                        v[k] = w[k] * scale;
+                }
+
+                fError += aCount[p] * std::max(0.0f, trace - lambda);
+            }
+            afError[uShape] = fError;
+        }
+    }
+
     void FillWithErrorColors(_Out_writes_(NUM_PIXELS_PER_BLOCK) HDRColorA* pOut) noexcept
     {
         for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
@@ -1637,6 +1781,18 @@ namespace
         #endif
         }
     }
+
+    void FillWithErrorColors(_Out_writes_(NUM_PIXELS_PER_BLOCK) LDRColorA* pOut) noexcept
+    {
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+        #ifdef _DEBUG
+            pOut[i] = LDRColorA(255, 0, 255, 255);
+        #else
+            pOut[i] = LDRColorA(0, 0, 0, 255);
+        #endif
+        }
+    }
 }
 
 
@@ -1802,12 +1958,18 @@ void D3DX_BC6H::Decode(bool bSigned, HDRColorA* pOut) const noexcept
 
 
 _Use_decl_annotations_
-void D3DX_BC6H::Encode(bool bSigned, const HDRColorA* const pIn) noexcept
+void D3DX_BC6H::Encode(bool bSigned, const HDRColorA* const pIn, uint32_t flags) noexcept
 {
     assert(pIn);
 
     EncodeParams EP(pIn, bSigned);
 
+    if (flags & BC_FLAGS_BC6H_FAST)
+    {
+        EncodeFast(&EP);
+        return;
+    }
+
     for (EP.uMode = 0; EP.uMode < c_NumModes && EP.fBestErr > 0; ++EP.uMode)
     {
         const uint8_t uShapes = ms_aInfo[EP.uMode].uPartitions ? 32u : 1u;
@@ -1847,6 +2009,94 @@ void D3DX_BC6H::Encode(bool bSigned, const HDRColorA* const pIn) noexcept
 }
 
 
+//-------------------------------------------------------------------------------------
+// Restricted search for BC_FLAGS_BC6H_FAST: a handful of modes, one shape ranking, endpoint perturbation
+// only for the winner, and an early out as soon as a mode gets the block under BC6H_FAST_GOOD_ENOUGH.
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void D3DX_BC6H::EncodeFast(EncodeParams* pEP) noexcept
+{
+    assert(pEP);
+
+    pEP->bOptimize = false;
+
+    float afRoughMSE[BC6H_MAX_SHAPES];
+    uint8_t auShape[BC6H_MAX_SHAPES];
+    bool bRanked = false;
+    uint8_t uBestMode = 0;
+    uint8_t uBestShape = 0;
+    float fBestErr = pEP->fBestErr;
+
+    for (size_t m = 0; m < std::size(g_aBC6HFastModes) && pEP->fBestErr > BC6H_FAST_GOOD_ENOUGH; ++m)
+    {
+        pEP->uMode = g_aBC6HFastModes[m];
+
+        if (!ms_aInfo[pEP->uMode].uPartitions)
+        {
+            // the unquantized endpoints don't depend on the 1-region mode, so fit them once
+            pEP->uShape = 0;
+            if (m == 0)
+                RoughMSE(pEP);
+            Refine(pEP);
+            if (pEP->fBestErr < fBestErr)
+            {
+                fBestErr = pEP->fBestErr;
+                uBestMode = pEP->uMode;
+                uBestShape = 0;
+            }
+            continue;
+        }
+
+        if (!bRanked)
+        {
+            // RoughMSE only depends on the partition count and index precision, which the fast 2-region modes share
+            for (uint8_t uShape = 0; uShape < BC6H_MAX_SHAPES; ++uShape)
+            {
+                pEP->uShape = uShape;
+                afRoughMSE[uShape] = RoughMSE(pEP);
+                auShape[uShape] = uShape;
+            }
+
+            for (size_t i = 0; i < BC6H_FAST_SHAPES; ++i)
+            {
+                for (size_t j = i + 1; j < BC6H_MAX_SHAPES; ++j)
+                {
+                    if (afRoughMSE[i] > afRoughMSE[j])
+                    {
+                        std::swap(afRoughMSE[i], afRoughMSE[j]);
+                        std::swap(auShape[i], auShape[j]);
+                    }
+                }
+            }
+            bRanked = true;
+        }
+
+        for (size_t i = 0; i < BC6H_FAST_SHAPES && pEP->fBestErr > BC6H_FAST_GOOD_ENOUGH; ++i)
+        {
+            pEP->uShape = auShape[i];
+            Refine(pEP);
+            if (pEP->fBestErr < fBestErr)
+            {
+                fBestErr = pEP->fBestErr;
+                uBestMode = pEP->uMode;
+                uBestShape = pEP->uShape;
+            }
+        }
+    }
+
+    // Perturb the endpoints of the winner only; Refine keeps the current block if that doesn't help
+    if (pEP->fBestErr > BC6H_FAST_GOOD_ENOUGH)
+    {
+        pEP->bOptimize = true;
+        pEP->uMode = uBestMode;
+        pEP->uShape = uBestShape;
+        if (bRanked && !ms_aInfo[uBestMode].uPartitions)
+            RoughMSE(pEP);  // the shape ranking overwrote the 1-region endpoints
+        Refine(pEP);
+    }
+}
+
+
 //-------------------------------------------------------------------------------------
 _Use_decl_annotations_
 int D3DX_BC6H::Quantize(int iValue, int prec, bool bSigned) noexcept
@@ -2382,7 +2632,22 @@ void D3DX_BC6H::Refine(EncodeParams* pEP) noexcept
     SwapIndices(pEP, aOrgEndPts, aOrgIdx);
 
     if (bTransformed) TransformForward(aOrgEndPts);
-    if (EndPointsFit(pEP, aOrgEndPts))
+    if (!pEP->bOptimize && EndPointsFit(pEP, aOrgEndPts))
+    {
+        // BC_FLAGS_BC6H_FAST candidate: take the quantized endpoint fit as is
+        float fOrgTotErr = 0.0f;
+        for (size_t p = 0; p <= uPartitions; ++p)
+        {
+            fOrgTotErr += aOrgErr[p];
+        }
+
+        if (fOrgTotErr < pEP->fBestErr)
+        {
+            pEP->fBestErr = fOrgTotErr;
+            EmitBlock(pEP, aOrgEndPts, aOrgIdx);
+        }
+    }
+    else if (EndPointsFit(pEP, aOrgEndPts))
     {
         if (bTransformed) TransformInverse(aOrgEndPts, ms_aInfo[pEP->uMode].RGBAPrec[0][0], pEP->bSigned);
         OptimizeEndPoints(pEP, aOrgErr, aOrgEndPts, aOptEndPts);
@@ -2551,7 +2816,7 @@ float D3DX_BC6H::RoughMSE(EncodeParams* pEP) const noexcept
 // BC7 Compression
 //-------------------------------------------------------------------------------------
 _Use_decl_annotations_
-void D3DX_BC7::Decode(HDRColorA* pOut) const noexcept
+void D3DX_BC7::Decode(LDRColorA* pOut) const noexcept
 {
     assert(pOut);
 
@@ -2746,7 +3011,7 @@ void D3DX_BC7::Decode(HDRColorA* pOut) const noexcept
             case 3: std::swap(outPixel.b, outPixel.a); break;
             }
 
-            pOut[i] = HDRColorA(outPixel);
+            pOut[i] = outPixel;
         }
     }
     else
@@ -2755,7 +3020,21 @@ void D3DX_BC7::Decode(HDRColorA* pOut) const noexcept
         OutputDebugStringA("BC7: Reserved mode 8 encountered during decoding\n");
     #endif
         // Per the BC7 format spec, we must return transparent black
-        memset(pOut, 0, sizeof(HDRColorA) * NUM_PIXELS_PER_BLOCK);
+        memset(pOut, 0, sizeof(LDRColorA) * NUM_PIXELS_PER_BLOCK);
+    }
+}
+
+_Use_decl_annotations_
+void D3DX_BC7::Decode(HDRColorA* pOut) const noexcept
+{
+    assert(pOut);
+
+    LDRColorA ldr[NUM_PIXELS_PER_BLOCK];
+    Decode(ldr);
+
+    for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+    {
+        pOut[i] = HDRColorA(ldr[i]);
     }
 }
 
@@ -2780,11 +3059,17 @@ void D3DX_BC7::Encode(uint32_t flags, const HDRColorA* const pIn) noexcept
 
     const bool bHasAlpha = (alphaMask != 0xFF);
 
+    const BC7Quality& quality = g_aBC7Quality[(flags & BC_FLAGS_BC7_QUALITY_MASK) >> BC_FLAGS_BC7_QUALITY_SHIFT];
+    uint32_t modeMask = quality.modeMask;
+    if (flags & BC_FLAGS_USE_3SUBSETS)
+        modeMask |= (1u << 0) | (1u << 2);
+    EP.uRefine = quality.refine;
+
     for (EP.uMode = 0; EP.uMode < 8 && fMSEBest > 0; ++EP.uMode)
     {
-        if (!(flags & BC_FLAGS_USE_3SUBSETS) && (EP.uMode == 0 || EP.uMode == 2))
+        if (!(modeMask & (1u << EP.uMode)))
         {
-            // 3 subset modes tend to be used rarely and add significant compression time
+            // 3 subset modes tend to be used rarely and add significant compression time; faster levels drop more
             continue;
         }
 
@@ -2804,11 +3089,12 @@ void D3DX_BC7::Encode(uint32_t flags, const HDRColorA* const pIn) noexcept
         assert(uShapes <= BC7_MAX_SHAPES);
         _Analysis_assume_(uShapes <= BC7_MAX_SHAPES);
 
-        const size_t uNumRots = size_t(1) << ms_aInfo[EP.uMode].uRotationBits;
+        const size_t uNumRots = std::min<size_t>(size_t(1) << ms_aInfo[EP.uMode].uRotationBits, quality.rotations);
         const size_t uNumIdxMode = size_t(1) << ms_aInfo[EP.uMode].uIndexModeBits;
         // Number of rough cases to look at. reasonable values of this are 1, uShapes/4, and uShapes
         // uShapes/4 gets nearly all the cases; you can increase that a bit (say by 3 or 4) if you really want to squeeze the last bit out
-        const size_t uItems = std::max<size_t>(1, uShapes >> 2);
+        const size_t uItems = quality.items ? std::min<size_t>(quality.items, uShapes) : std::max<size_t>(1, uShapes >> 2);
+        const bool bPrincipalAxis = (quality.search == BC7_SHAPES_PCA) && (uItems < uShapes);
         float afRoughMSE[BC7_MAX_SHAPES];
         size_t auShape[BC7_MAX_SHAPES];
 
@@ -2824,10 +3110,20 @@ void D3DX_BC7::Encode(uint32_t flags, const HDRColorA* const pIn) noexcept
             for (size_t im = 0; im < uNumIdxMode && fMSEBest > 0; ++im)
             {
                 // pick the best uItems shapes and refine these.
-                for (size_t s = 0; s < uShapes; s++)
+                if (bPrincipalAxis)
                 {
-                    afRoughMSE[s] = RoughMSE(&EP, s, im);
-                    auShape[s] = s;
+                    // Only the picked shapes get endpoints fitted by RoughMSE below
+                    PrincipalAxisError(EP.aLDRPixels, ms_aInfo[EP.uMode].uPartitions, uShapes, afRoughMSE);
+                    for (size_t s = 0; s < uShapes; s++)
+                        auShape[s] = s;
+                }
+                else
+                {
+                    for (size_t s = 0; s < uShapes; s++)
+                    {
+                        afRoughMSE[s] = RoughMSE(&EP, s, im);
+                        auShape[s] = s;
+                    }
                 }
 
                 // Bubble up the first uItems items
@@ -2845,6 +3141,8 @@ void D3DX_BC7::Encode(uint32_t flags, const HDRColorA* const pIn) noexcept
 
                 for (size_t i = 0; i < uItems && fMSEBest > 0; i++)
                 {
+                    if (bPrincipalAxis)
+                        RoughMSE(&EP, auShape[i], im);
                     const float fMSE = Refine(&EP, auShape[i], r, im);
                     if (fMSE < fMSEBest)
                     {
@@ -3083,8 +3381,11 @@ void D3DX_BC7::OptimizeOne(const EncodeParams* pEP, const LDRColorA aColors[], s
     }
 
     // finally, do a small exhaustive search around what we think is the global minima to be sure
-    for (size_t ch = 0; ch < BC7_NUM_CHANNELS; ch++)
-        Exhaustive(pEP, aColors, np, uIndexMode, ch, fOptErr, opt);
+    if (pEP->uRefine >= BC7_REFINE_FULL)
+    {
+        for (size_t ch = 0; ch < BC7_NUM_CHANNELS; ch++)
+            Exhaustive(pEP, aColors, np, uIndexMode, ch, fOptErr, opt);
+    }
 }
 
 _Use_decl_annotations_
@@ -3408,6 +3709,15 @@ float D3DX_BC7::Refine(const EncodeParams* pEP, size_t uShape, size_t uRotation,
 
     AssignIndices(pEP, uShape, uIndexMode, newEndPts1, aOrgIdx, aOrgIdx2, aOrgErr);
 
+    if (pEP->uRefine == BC7_REFINE_NONE)
+    {
+        float fOrgTotErr = 0;
+        for (size_t p = 0; p <= uPartitions; p++)
+            fOrgTotErr += aOrgErr[p];
+        EmitBlock(pEP, uShape, uRotation, uIndexMode, newEndPts1, aOrgIdx, aOrgIdx2);
+        return fOrgTotErr;
+    }
+
     OptimizeEndPoints(pEP, uShape, uIndexMode, aOrgErr, newEndPts1, aOptEndPts);
 
     LDREndPntPair newEndPts2[BC7_MAX_REGIONS];
@@ -3594,19 +3904,17 @@ void DirectX::D3DXDecodeBC6HS(XMVECTOR *pColor, const uint8_t *pBC) noexcept
 _Use_decl_annotations_
 void DirectX::D3DXEncodeBC6HU(uint8_t *pBC, const XMVECTOR *pColor, uint32_t flags) noexcept
 {
-    UNREFERENCED_PARAMETER(flags);
     assert(pBC && pColor);
     static_assert(sizeof(D3DX_BC6H) == 16, "D3DX_BC6H should be 16 bytes");
-    reinterpret_cast<D3DX_BC6H*>(pBC)->Encode(false, reinterpret_cast<const HDRColorA*>(pColor));
+    reinterpret_cast<D3DX_BC6H*>(pBC)->Encode(false, reinterpret_cast<const HDRColorA*>(pColor), flags);
 }
 
 _Use_decl_annotations_
 void DirectX::D3DXEncodeBC6HS(uint8_t *pBC, const XMVECTOR *pColor, uint32_t flags) noexcept
 {
-    UNREFERENCED_PARAMETER(flags);
     assert(pBC && pColor);
     static_assert(sizeof(D3DX_BC6H) == 16, "D3DX_BC6H should be 16 bytes");
-    reinterpret_cast<D3DX_BC6H*>(pBC)->Encode(true, reinterpret_cast<const HDRColorA*>(pColor));
+    reinterpret_cast<D3DX_BC6H*>(pBC)->Encode(true, reinterpret_cast<const HDRColorA*>(pColor), flags);
 }
 
 
@@ -3621,6 +3929,22 @@ void DirectX::D3DXDecodeBC7(XMVECTOR *pColor, const uint8_t *pBC) noexcept
     reinterpret_cast<const D3DX_BC7*>(pBC)->Decode(reinterpret_cast<HDRColorA*>(pColor));
 }
 
+_Use_decl_annotations_
+void DirectX::D3DXDecodeBC7RGBA8(uint8_t *pDest, size_t rowPitch, const uint8_t *pBC) noexcept
+{
+    assert(pDest && pBC);
+    static_assert(sizeof(D3DX_BC7) == 16, "D3DX_BC7 should be 16 bytes");
+
+    // BC7 endpoints and interpolation are integer already, so the texels need no conversion at all
+    LDRColorA texels[NUM_PIXELS_PER_BLOCK];
+    reinterpret_cast<const D3DX_BC7*>(pBC)->Decode(texels);
+
+    for (size_t y = 0; y < 4; ++y)
+    {
+        memcpy(pDest + y * rowPitch, &texels[y * 4], sizeof(LDRColorA) * 4);
+    }
+}
+
 _Use_decl_annotations_
 void DirectX::D3DXEncodeBC7(uint8_t *pBC, const XMVECTOR *pColor, uint32_t flags) noexcept
 {
@@ -0,0 +1,833 @@
+//-------------------------------------------------------------------------------------
+// BCWide.inl
+//
+// Multi-block BC1/BC3 encoder. BC.cpp includes this once per instruction set, inside
+// a namespace of its own, with BC_WIDE_LANES set to 8 (AVX2) or 4 (SSE4.1).
+//
+// Every lane runs the steps of EncodeBC1 / OptimizeRGB / D3DXEncodeBC3 / OptimizeAlpha
+// in BC.cpp and BC.h for one block, with each branch turned into a lane mask and the
+// iteration loops running until every lane has left them. The float operations and
+// their order match the single-block code, so the results do too.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+//-------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------
+// Lane types
+//-------------------------------------------------------------------------------------
+#if BC_WIDE_LANES == 8
+
+    using VFloat = __m256;
+    using VInt = __m256i;
+
+    inline VFloat VSplat(float f) noexcept { return _mm256_set1_ps(f); }
+    inline VFloat VAdd(VFloat a, VFloat b) noexcept { return _mm256_add_ps(a, b); }
+    inline VFloat VSub(VFloat a, VFloat b) noexcept { return _mm256_sub_ps(a, b); }
+    inline VFloat VMul(VFloat a, VFloat b) noexcept { return _mm256_mul_ps(a, b); }
+    inline VFloat VDiv(VFloat a, VFloat b) noexcept { return _mm256_div_ps(a, b); }
+    // (a < b) ? a : b and (a > b) ? a : b, like the "if (p < x) x = p" updates of the reference
+    inline VFloat VMin(VFloat a, VFloat b) noexcept { return _mm256_min_ps(a, b); }
+    inline VFloat VMax(VFloat a, VFloat b) noexcept { return _mm256_max_ps(a, b); }
+
+    inline VFloat VLess(VFloat a, VFloat b) noexcept { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    inline VFloat VLessEq(VFloat a, VFloat b) noexcept { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    inline VFloat VGreater(VFloat a, VFloat b) noexcept { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    inline VFloat VGreaterEq(VFloat a, VFloat b) noexcept { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    inline VFloat VEqual(VFloat a, VFloat b) noexcept { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    inline VFloat VNotEqual(VFloat a, VFloat b) noexcept { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+
+    inline VFloat VAnd(VFloat a, VFloat b) noexcept { return _mm256_and_ps(a, b); }
+    inline VFloat VOr(VFloat a, VFloat b) noexcept { return _mm256_or_ps(a, b); }
+    inline VFloat VXor(VFloat a, VFloat b) noexcept { return _mm256_xor_ps(a, b); }
+    // a & ~b
+    inline VFloat VAndNot(VFloat a, VFloat b) noexcept { return _mm256_andnot_ps(b, a); }
+    inline VFloat VSelect(VFloat mask, VFloat a, VFloat b) noexcept { return _mm256_blendv_ps(b, a, mask); }
+    inline bool VAny(VFloat mask) noexcept { return _mm256_movemask_ps(mask) != 0; }
+
+    inline VInt VTruncate(VFloat a) noexcept { return _mm256_cvttps_epi32(a); }
+    inline VFloat VToFloat(VInt a) noexcept { return _mm256_cvtepi32_ps(a); }
+    inline VFloat VAsMask(VInt a) noexcept { return _mm256_castsi256_ps(a); }
+    inline VInt VAsInt(VFloat a) noexcept { return _mm256_castps_si256(a); }
+
+    inline VInt VSplatInt(int32_t i) noexcept { return _mm256_set1_epi32(i); }
+    inline VInt VAddInt(VInt a, VInt b) noexcept { return _mm256_add_epi32(a, b); }
+    inline VInt VSubInt(VInt a, VInt b) noexcept { return _mm256_sub_epi32(a, b); }
+    inline VInt VAndInt(VInt a, VInt b) noexcept { return _mm256_and_si256(a, b); }
+    inline VInt VOrInt(VInt a, VInt b) noexcept { return _mm256_or_si256(a, b); }
+    inline VInt VShiftLeft(VInt a, int n) noexcept { return _mm256_sllv_epi32(a, _mm256_set1_epi32(n)); }
+    inline VInt VShiftRight(VInt a, int n) noexcept { return _mm256_srlv_epi32(a, _mm256_set1_epi32(n)); }
+    inline VFloat VEqualInt(VInt a, VInt b) noexcept { return VAsMask(_mm256_cmpeq_epi32(a, b)); }
+    inline VFloat VGreaterInt(VInt a, VInt b) noexcept { return VAsMask(_mm256_cmpgt_epi32(a, b)); }
+    inline VInt VSelectInt(VFloat mask, VInt a, VInt b) noexcept { return VAsInt(VSelect(mask, VAsMask(a), VAsMask(b))); }
+
+    inline void VStoreInt(int32_t *p, VInt a) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a); }
+
+    // Clears the upper halves before returning to SSE code, which MSVC does not do on its own without /arch:AVX
+    inline void VLeave() noexcept { _mm256_zeroupper(); }
+
+    // Transposes one pixel of every block into r, g, b, a lanes
+    inline void VLoadPixel(
+        const XMVECTOR *pColor, VInt blockOffsets, size_t iPixel,
+        VFloat& r, VFloat& g, VFloat& b, VFloat& a) noexcept
+    {
+        auto pBase = reinterpret_cast<const float*>(pColor + iPixel);
+        r = _mm256_i32gather_ps(pBase + 0, blockOffsets, 4);
+        g = _mm256_i32gather_ps(pBase + 1, blockOffsets, 4);
+        b = _mm256_i32gather_ps(pBase + 2, blockOffsets, 4);
+        a = _mm256_i32gather_ps(pBase + 3, blockOffsets, 4);
+    }
+
+#elif BC_WIDE_LANES == 4
+
+    using VFloat = __m128;
+    using VInt = __m128i;
+
+    inline VFloat VSplat(float f) noexcept { return _mm_set1_ps(f); }
+    inline VFloat VAdd(VFloat a, VFloat b) noexcept { return _mm_add_ps(a, b); }
+    inline VFloat VSub(VFloat a, VFloat b) noexcept { return _mm_sub_ps(a, b); }
+    inline VFloat VMul(VFloat a, VFloat b) noexcept { return _mm_mul_ps(a, b); }
+    inline VFloat VDiv(VFloat a, VFloat b) noexcept { return _mm_div_ps(a, b); }
+    inline VFloat VMin(VFloat a, VFloat b) noexcept { return _mm_min_ps(a, b); }
+    inline VFloat VMax(VFloat a, VFloat b) noexcept { return _mm_max_ps(a, b); }
+
+    inline VFloat VLess(VFloat a, VFloat b) noexcept { return _mm_cmplt_ps(a, b); }
+    inline VFloat VLessEq(VFloat a, VFloat b) noexcept { return _mm_cmple_ps(a, b); }
+    inline VFloat VGreater(VFloat a, VFloat b) noexcept { return _mm_cmpgt_ps(a, b); }
+    inline VFloat VGreaterEq(VFloat a, VFloat b) noexcept { return _mm_cmpge_ps(a, b); }
+    inline VFloat VEqual(VFloat a, VFloat b) noexcept { return _mm_cmpeq_ps(a, b); }
+    inline VFloat VNotEqual(VFloat a, VFloat b) noexcept { return _mm_cmpneq_ps(a, b); }
+
+    inline VFloat VAnd(VFloat a, VFloat b) noexcept { return _mm_and_ps(a, b); }
+    inline VFloat VOr(VFloat a, VFloat b) noexcept { return _mm_or_ps(a, b); }
+    inline VFloat VXor(VFloat a, VFloat b) noexcept { return _mm_xor_ps(a, b); }
+    inline VFloat VAndNot(VFloat a, VFloat b) noexcept { return _mm_andnot_ps(b, a); }
+    inline VFloat VSelect(VFloat mask, VFloat a, VFloat b) noexcept { return _mm_blendv_ps(b, a, mask); }
+    inline bool VAny(VFloat mask) noexcept { return _mm_movemask_ps(mask) != 0; }
+
+    inline VInt VTruncate(VFloat a) noexcept { return _mm_cvttps_epi32(a); }
+    inline VFloat VToFloat(VInt a) noexcept { return _mm_cvtepi32_ps(a); }
+    inline VFloat VAsMask(VInt a) noexcept { return _mm_castsi128_ps(a); }
+    inline VInt VAsInt(VFloat a) noexcept { return _mm_castps_si128(a); }
+
+    inline VInt VSplatInt(int32_t i) noexcept { return _mm_set1_epi32(i); }
+    inline VInt VAddInt(VInt a, VInt b) noexcept { return _mm_add_epi32(a, b); }
+    inline VInt VSubInt(VInt a, VInt b) noexcept { return _mm_sub_epi32(a, b); }
+    inline VInt VAndInt(VInt a, VInt b) noexcept { return _mm_and_si128(a, b); }
+    inline VInt VOrInt(VInt a, VInt b) noexcept { return _mm_or_si128(a, b); }
+    inline VInt VShiftLeft(VInt a, int n) noexcept { return _mm_sll_epi32(a, _mm_cvtsi32_si128(n)); }
+    inline VInt VShiftRight(VInt a, int n) noexcept { return _mm_srl_epi32(a, _mm_cvtsi32_si128(n)); }
+    inline VFloat VEqualInt(VInt a, VInt b) noexcept { return VAsMask(_mm_cmpeq_epi32(a, b)); }
+    inline VFloat VGreaterInt(VInt a, VInt b) noexcept { return VAsMask(_mm_cmpgt_epi32(a, b)); }
+    inline VInt VSelectInt(VFloat mask, VInt a, VInt b) noexcept { return VAsInt(VSelect(mask, VAsMask(a), VAsMask(b))); }
+
+    inline void VStoreInt(int32_t *p, VInt a) noexcept { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a); }
+
+    inline void VLeave() noexcept {}
+
+    inline void VLoadPixel(
+        const XMVECTOR *pColor, VInt blockOffsets, size_t iPixel,
+        VFloat& r, VFloat& g, VFloat& b, VFloat& a) noexcept
+    {
+        alignas(16) int32_t offsets[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(offsets), blockOffsets);
+        auto pBase = reinterpret_cast<const float*>(pColor + iPixel);
+        r = _mm_loadu_ps(pBase + offsets[0]);
+        g = _mm_loadu_ps(pBase + offsets[1]);
+        b = _mm_loadu_ps(pBase + offsets[2]);
+        a = _mm_loadu_ps(pBase + offsets[3]);
+        _MM_TRANSPOSE4_PS(r, g, b, a);
+    }
+
+#else
+#error BC_WIDE_LANES must be 4 or 8
+#endif
+
+    constexpr size_t c_Lanes = BC_WIDE_LANES;
+
+    inline VFloat VTrue() noexcept { return VAsMask(VSplatInt(-1)); }
+    inline VFloat VFalse() noexcept { return VAsMask(VSplatInt(0)); }
+    inline VFloat VNot(VFloat mask) noexcept { return VAndNot(VTrue(), mask); }
+
+    //-------------------------------------------------------------------------------------
+    // A set of blocks transposed so that each register holds one pixel channel of every block
+    //-------------------------------------------------------------------------------------
+    struct BlockLanes
+    {
+        VFloat r[NUM_PIXELS_PER_BLOCK];
+        VFloat g[NUM_PIXELS_PER_BLOCK];
+        VFloat b[NUM_PIXELS_PER_BLOCK];
+        VFloat a[NUM_PIXELS_PER_BLOCK];
+    };
+
+    // Missing lanes (count < c_Lanes) repeat the last block; their results are not written
+    inline void LoadBlockLanes(BlockLanes& lanes, const XMVECTOR *pColor, size_t count) noexcept
+    {
+        alignas(32) int32_t offsets[c_Lanes];
+        for (size_t iLane = 0; iLane < c_Lanes; ++iLane)
+        {
+            offsets[iLane] = static_cast<int32_t>(std::min(iLane, count - 1) * NUM_PIXELS_PER_BLOCK * 4);
+        }
+
+        VInt blockOffsets;
+        memcpy(&blockOffsets, offsets, sizeof(blockOffsets));
+
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            VLoadPixel(pColor, blockOffsets, i, lanes.r[i], lanes.g[i], lanes.b[i], lanes.a[i]);
+        }
+    }
+
+    // pC[iStep] and pD[iStep] of OptimizeRGB / OptimizeAlpha: (fSteps - iStep) / fSteps and iStep / fSteps,
+    // which round to the same floats as the constant tables
+    inline VFloat StepWeightC(VFloat fStep, VFloat fSteps) noexcept { return VDiv(VSub(fSteps, fStep), fSteps); }
+    inline VFloat StepWeightD(VFloat fStep, VFloat fSteps) noexcept { return VDiv(fStep, fSteps); }
+
+    // Index of an interpolated color: 0 and fSteps are the endpoints (0 and 1), the values between them follow as 2, 3, ...
+    inline VFloat EndpointOrderIndex(VFloat fStep, VFloat fSteps) noexcept
+    {
+        const VFloat one = VSplat(1.f);
+        VFloat iIndex = VSelect(VEqual(fStep, fSteps), one, VAdd(fStep, one));
+        return VSelect(VEqual(fStep, VSplat(0.f)), VSplat(0.f), iIndex);
+    }
+
+    //-------------------------------------------------------------------------------------
+    // OptimizeRGB for every lane; fSteps is 2 for 3-color lanes and 3 for 4-color lanes
+    //-------------------------------------------------------------------------------------
+    void OptimizeRGBLanes(
+        VFloat *pX,
+        VFloat *pY,
+        const VFloat *pR, const VFloat *pG, const VFloat *pB,
+        VFloat fSteps,
+        uint32_t flags) noexcept
+    {
+        const VFloat fEpsilon = VSplat((0.25f / 64.0f) * (0.25f / 64.0f));
+        const VFloat zero = VSplat(0.f);
+
+        // Find Min and Max points, as starting point
+        VFloat Xr, Xg, Xb;
+        if (flags & BC_FLAGS_UNIFORM)
+        {
+            Xr = Xg = Xb = VSplat(1.f);
+        }
+        else
+        {
+            Xr = VSplat(g_Luminance.r);
+            Xg = VSplat(g_Luminance.g);
+            Xb = VSplat(g_Luminance.b);
+        }
+        VFloat Yr = zero, Yg = zero, Yb = zero;
+
+        for (size_t iPoint = 0; iPoint < NUM_PIXELS_PER_BLOCK; iPoint++)
+        {
+            Xr = VMin(pR[iPoint], Xr);
+            Xg = VMin(pG[iPoint], Xg);
+            Xb = VMin(pB[iPoint], Xb);
+            Yr = VMax(pR[iPoint], Yr);
+            Yg = VMax(pG[iPoint], Yg);
+            Yb = VMax(pB[iPoint], Yb);
+        }
+
+        // Diagonal axis
+        const VFloat ABr = VSub(Yr, Xr);
+        const VFloat ABg = VSub(Yg, Xg);
+        const VFloat ABb = VSub(Yb, Xb);
+
+        const VFloat fAB = VAdd(VAdd(VMul(ABr, ABr), VMul(ABg, ABg)), VMul(ABb, ABb));
+
+        // Single color lanes keep the unswapped min/max
+        const VFloat bSingle = VLess(fAB, VSplat(FLT_MIN));
+        const VFloat Xr0 = Xr, Xg0 = Xg, Xb0 = Xb;
+        const VFloat Yr0 = Yr, Yg0 = Yg, Yb0 = Yb;
+
+        // Try all four axis directions, to determine which diagonal best fits data
+        const VFloat fABInv = VDiv(VSplat(1.f), fAB);
+
+        const VFloat Dirr = VMul(ABr, fABInv);
+        const VFloat Dirg = VMul(ABg, fABInv);
+        const VFloat Dirb = VMul(ABb, fABInv);
+
+        const VFloat half = VSplat(0.5f);
+        const VFloat Midr = VMul(VAdd(Xr, Yr), half);
+        const VFloat Midg = VMul(VAdd(Xg, Yg), half);
+        const VFloat Midb = VMul(VAdd(Xb, Yb), half);
+
+        VFloat fDir[4] = { zero, zero, zero, zero };
+
+        for (size_t iPoint = 0; iPoint < NUM_PIXELS_PER_BLOCK; iPoint++)
+        {
+            const VFloat Ptr = VMul(VSub(pR[iPoint], Midr), Dirr);
+            const VFloat Ptg = VMul(VSub(pG[iPoint], Midg), Dirg);
+            const VFloat Ptb = VMul(VSub(pB[iPoint], Midb), Dirb);
+
+            VFloat f;
+
+            f = VAdd(VAdd(Ptr, Ptg), Ptb);
+            fDir[0] = VAdd(fDir[0], VMul(f, f));
+
+            f = VSub(VAdd(Ptr, Ptg), Ptb);
+            fDir[1] = VAdd(fDir[1], VMul(f, f));
+
+            f = VAdd(VSub(Ptr, Ptg), Ptb);
+            fDir[2] = VAdd(fDir[2], VMul(f, f));
+
+            f = VSub(VSub(Ptr, Ptg), Ptb);
+            fDir[3] = VAdd(fDir[3], VMul(f, f));
+        }
+
+        VFloat fDirMax = fDir[0];
+        VFloat iDirMax = zero;
+
+        for (size_t iDir = 1; iDir < 4; iDir++)
+        {
+            const VFloat bGreater = VGreater(fDir[iDir], fDirMax);
+            fDirMax = VSelect(bGreater, fDir[iDir], fDirMax);
+            iDirMax = VSelect(bGreater, VSplat(static_cast<float>(iDir)), iDirMax);
+        }
+
+        // iDirMax & 2 swaps green, iDirMax & 1 swaps blue
+        const VFloat bSwapG = VGreaterEq(iDirMax, VSplat(2.f));
+        const VFloat bSwapB = VOr(VEqual(iDirMax, VSplat(1.f)), VEqual(iDirMax, VSplat(3.f)));
+
+        VFloat f = Xg;
+        Xg = VSelect(bSwapG, Yg, Xg);
+        Yg = VSelect(bSwapG, f, Yg);
+
+        f = Xb;
+        Xb = VSelect(bSwapB, Yb, Xb);
+        Yb = VSelect(bSwapB, f, Yb);
+
+        // Two color lanes (and single color ones) skip the root finding
+        VFloat bActive = VNot(VLess(fAB, VSplat(1.0f / 4096.0f)));
+
+        // Use Newton's Method to find local minima of sum-of-squares error.
+        const VFloat fLenMin = VSplat(1.0f / 4096.0f);
+        const VFloat fEighth = VSplat(1.0f / 8.0f);
+        const VFloat fNegOne = VSplat(-1.0f);
+
+        for (size_t iIteration = 0; iIteration < 8 && VAny(bActive); iIteration++)
+        {
+            // Calculate color direction
+            VFloat Dr = VSub(Yr, Xr);
+            VFloat Dg = VSub(Yg, Xg);
+            VFloat Db = VSub(Yb, Xb);
+
+            const VFloat fLen = VAdd(VAdd(VMul(Dr, Dr), VMul(Dg, Dg)), VMul(Db, Db));
+
+            bActive = VAndNot(bActive, VLess(fLen, fLenMin));
+            if (!VAny(bActive))
+                break;
+
+            const VFloat fScale = VDiv(fSteps, fLen);
+
+            Dr = VMul(Dr, fScale);
+            Dg = VMul(Dg, fScale);
+            Db = VMul(Db, fScale);
+
+            // Evaluate function, and derivatives
+            VFloat d2X = zero, d2Y = zero;
+            VFloat dXr = zero, dXg = zero, dXb = zero;
+            VFloat dYr = zero, dYg = zero, dYb = zero;
+
+            for (size_t iPoint = 0; iPoint < NUM_PIXELS_PER_BLOCK; iPoint++)
+            {
+                const VFloat fDot = VAdd(VAdd(
+                    VMul(VSub(pR[iPoint], Xr), Dr),
+                    VMul(VSub(pG[iPoint], Xg), Dg)),
+                    VMul(VSub(pB[iPoint], Xb), Db));
+
+                VFloat fStep = VToFloat(VTruncate(VAdd(fDot, half)));
+                fStep = VSelect(VGreaterEq(fDot, fSteps), fSteps, fStep);
+                fStep = VSelect(VLessEq(fDot, zero), zero, fStep);
+
+                const VFloat fCStep = StepWeightC(fStep, fSteps);
+                const VFloat fDStep = StepWeightD(fStep, fSteps);
+
+                // pSteps[iStep] - pPoints[iPoint]
+                const VFloat Diffr = VSub(VAdd(VMul(Xr, fCStep), VMul(Yr, fDStep)), pR[iPoint]);
+                const VFloat Diffg = VSub(VAdd(VMul(Xg, fCStep), VMul(Yg, fDStep)), pG[iPoint]);
+                const VFloat Diffb = VSub(VAdd(VMul(Xb, fCStep), VMul(Yb, fDStep)), pB[iPoint]);
+
+                const VFloat fC = VMul(fCStep, fEighth);
+                const VFloat fD = VMul(fDStep, fEighth);
+
+                d2X = VAdd(d2X, VMul(fC, fCStep));
+                dXr = VAdd(dXr, VMul(fC, Diffr));
+                dXg = VAdd(dXg, VMul(fC, Diffg));
+                dXb = VAdd(dXb, VMul(fC, Diffb));
+
+                d2Y = VAdd(d2Y, VMul(fD, fDStep));
+                dYr = VAdd(dYr, VMul(fD, Diffr));
+                dYg = VAdd(dYg, VMul(fD, Diffg));
+                dYb = VAdd(dYb, VMul(fD, Diffb));
+            }
+
+            // Move endpoints
+            const VFloat bMoveX = VAnd(bActive, VGreater(d2X, zero));
+            const VFloat fX = VDiv(fNegOne, d2X);
+            Xr = VSelect(bMoveX, VAdd(Xr, VMul(dXr, fX)), Xr);
+            Xg = VSelect(bMoveX, VAdd(Xg, VMul(dXg, fX)), Xg);
+            Xb = VSelect(bMoveX, VAdd(Xb, VMul(dXb, fX)), Xb);
+
+            const VFloat bMoveY = VAnd(bActive, VGreater(d2Y, zero));
+            const VFloat fY = VDiv(fNegOne, d2Y);
+            Yr = VSelect(bMoveY, VAdd(Yr, VMul(dYr, fY)), Yr);
+            Yg = VSelect(bMoveY, VAdd(Yg, VMul(dYg, fY)), Yg);
+            Yb = VSelect(bMoveY, VAdd(Yb, VMul(dYb, fY)), Yb);
+
+            const VFloat bConverged = VAnd(VAnd(VAnd(
+                VLess(VMul(dXr, dXr), fEpsilon), VLess(VMul(dXg, dXg), fEpsilon)), VAnd(
+                VLess(VMul(dXb, dXb), fEpsilon), VLess(VMul(dYr, dYr), fEpsilon))), VAnd(
+                VLess(VMul(dYg, dYg), fEpsilon), VLess(VMul(dYb, dYb), fEpsilon)));
+
+            bActive = VAndNot(bActive, bConverged);
+        }
+
+        pX[0] = VSelect(bSingle, Xr0, Xr);
+        pX[1] = VSelect(bSingle, Xg0, Xg);
+        pX[2] = VSelect(bSingle, Xb0, Xb);
+        pY[0] = VSelect(bSingle, Yr0, Yr);
+        pY[1] = VSelect(bSingle, Yg0, Yg);
+        pY[2] = VSelect(bSingle, Yb0, Yb);
+    }
+
+    //-------------------------------------------------------------------------------------
+    inline VInt Encode565Lanes(const VFloat *pColor) noexcept
+    {
+        const VFloat zero = VSplat(0.f);
+        const VFloat one = VSplat(1.f);
+        const VFloat half = VSplat(0.5f);
+
+        const VInt r = VTruncate(VAdd(VMul(VMin(VMax(pColor[0], zero), one), VSplat(31.0f)), half));
+        const VInt g = VTruncate(VAdd(VMul(VMin(VMax(pColor[1], zero), one), VSplat(63.0f)), half));
+        const VInt b = VTruncate(VAdd(VMul(VMin(VMax(pColor[2], zero), one), VSplat(31.0f)), half));
+
+        return VOrInt(VOrInt(VShiftLeft(r, 11), VShiftLeft(g, 5)), b);
+    }
+
+    inline void Decode565Lanes(VFloat *pColor, VInt w565) noexcept
+    {
+        pColor[0] = VMul(VToFloat(VAndInt(VShiftRight(w565, 11), VSplatInt(31))), VSplat(1.0f / 31.0f));
+        pColor[1] = VMul(VToFloat(VAndInt(VShiftRight(w565, 5), VSplatInt(63))), VSplat(1.0f / 63.0f));
+        pColor[2] = VMul(VToFloat(VAndInt(w565, VSplatInt(31))), VSplat(1.0f / 31.0f));
+    }
+
+    //-------------------------------------------------------------------------------------
+    // EncodeBC1 (without dithering) for every lane
+    //-------------------------------------------------------------------------------------
+    void EncodeBC1Lanes(
+        VInt& rgb0,
+        VInt& rgb1,
+        VInt& bitmap,
+        const BlockLanes& lanes,
+        bool bColorKey,
+        float threshold,
+        uint32_t flags) noexcept
+    {
+        const VFloat zero = VSplat(0.f);
+        const VFloat half = VSplat(0.5f);
+        const bool bUniform = (flags & BC_FLAGS_UNIFORM) != 0;
+
+        // Determine if we need to colorkey this block
+        VFloat bThreeSteps = VFalse();
+        VFloat bAllKeyed = VFalse();
+        VFloat bKeyed[NUM_PIXELS_PER_BLOCK];
+
+        if (bColorKey)
+        {
+            const VFloat fThreshold = VSplat(threshold);
+            VInt uColorKey = VSplatInt(0);
+
+            for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+            {
+                bKeyed[i] = VLess(lanes.a[i], fThreshold);
+                uColorKey = VSubInt(uColorKey, VAsInt(bKeyed[i]));
+            }
+
+            bAllKeyed = VEqualInt(uColorKey, VSplatInt(NUM_PIXELS_PER_BLOCK));
+            bThreeSteps = VGreaterInt(uColorKey, VSplatInt(0));
+        }
+
+        const VFloat fSteps = VSelect(bThreeSteps, VSplat(2.f), VSplat(3.f));
+
+        // Quantize block to R56B5
+        const VFloat lumR = VSplat(g_Luminance.r);
+        const VFloat lumG = VSplat(g_Luminance.g);
+        const VFloat lumB = VSplat(g_Luminance.b);
+
+        VFloat Colorr[NUM_PIXELS_PER_BLOCK];
+        VFloat Colorg[NUM_PIXELS_PER_BLOCK];
+        VFloat Colorb[NUM_PIXELS_PER_BLOCK];
+
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            Colorr[i] = VMul(VToFloat(VTruncate(VAdd(VMul(lanes.r[i], VSplat(31.0f)), half))), VSplat(1.0f / 31.0f));
+            Colorg[i] = VMul(VToFloat(VTruncate(VAdd(VMul(lanes.g[i], VSplat(63.0f)), half))), VSplat(1.0f / 63.0f));
+            Colorb[i] = VMul(VToFloat(VTruncate(VAdd(VMul(lanes.b[i], VSplat(31.0f)), half))), VSplat(1.0f / 31.0f));
+
+            if (!bUniform)
+            {
+                Colorr[i] = VMul(Colorr[i], lumR);
+                Colorg[i] = VMul(Colorg[i], lumG);
+                Colorb[i] = VMul(Colorb[i], lumB);
+            }
+        }
+
+        // Perform 6D root finding function to find two endpoints of color axis.
+        // Then quantize and sort the endpoints depending on mode.
+        VFloat ColorA[3], ColorB[3], ColorC[3], ColorD[3];
+
+        OptimizeRGBLanes(ColorA, ColorB, Colorr, Colorg, Colorb, fSteps, flags);
+
+        if (bUniform)
+        {
+            for (size_t c = 0; c < 3; ++c)
+            {
+                ColorC[c] = ColorA[c];
+                ColorD[c] = ColorB[c];
+            }
+        }
+        else
+        {
+            const VFloat lumInv[3] = { VSplat(g_LuminanceInv.r), VSplat(g_LuminanceInv.g), VSplat(g_LuminanceInv.b) };
+            for (size_t c = 0; c < 3; ++c)
+            {
+                ColorC[c] = VMul(ColorA[c], lumInv[c]);
+                ColorD[c] = VMul(ColorB[c], lumInv[c]);
+            }
+        }
+
+        const VInt wColorA = Encode565Lanes(ColorC);
+        const VInt wColorB = Encode565Lanes(ColorD);
+        const VFloat bSameColor = VEqualInt(wColorA, wColorB);
+
+        Decode565Lanes(ColorC, wColorA);
+        Decode565Lanes(ColorD, wColorB);
+
+        if (bUniform)
+        {
+            for (size_t c = 0; c < 3; ++c)
+            {
+                ColorA[c] = ColorC[c];
+                ColorB[c] = ColorD[c];
+            }
+        }
+        else
+        {
+            const VFloat lum[3] = { lumR, lumG, lumB };
+            for (size_t c = 0; c < 3; ++c)
+            {
+                ColorA[c] = VMul(ColorC[c], lum[c]);
+                ColorB[c] = VMul(ColorD[c], lum[c]);
+            }
+        }
+
+        // (3 == uSteps) == (wColorA <= wColorB) keeps A first
+        const VFloat bALessEqB = VNot(VGreaterInt(wColorA, wColorB));
+        const VFloat bAFirst = VNot(VXor(bThreeSteps, bALessEqB));
+
+        rgb0 = VSelectInt(bAFirst, wColorA, wColorB);
+        rgb1 = VSelectInt(bAFirst, wColorB, wColorA);
+
+        VFloat Step0[3], Dir[3];
+        for (size_t c = 0; c < 3; ++c)
+        {
+            Step0[c] = VSelect(bAFirst, ColorA[c], ColorB[c]);
+            Dir[c] = VSub(VSelect(bAFirst, ColorB[c], ColorA[c]), Step0[c]);
+        }
+
+        // Calculate color direction
+        const VFloat fLen = VAdd(VAdd(VMul(Dir[0], Dir[0]), VMul(Dir[1], Dir[1])), VMul(Dir[2], Dir[2]));
+        const VFloat fScale = VSelect(bSameColor, zero, VDiv(fSteps, fLen));
+
+        for (size_t c = 0; c < 3; ++c)
+        {
+            Dir[c] = VMul(Dir[c], fScale);
+        }
+
+        // Encode colors
+        VInt dw = VSplatInt(0);
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            VFloat Clrr = lanes.r[i], Clrg = lanes.g[i], Clrb = lanes.b[i];
+            if (!bUniform)
+            {
+                Clrr = VMul(Clrr, lumR);
+                Clrg = VMul(Clrg, lumG);
+                Clrb = VMul(Clrb, lumB);
+            }
+
+            const VFloat fDot = VAdd(VAdd(
+                VMul(VSub(Clrr, Step0[0]), Dir[0]),
+                VMul(VSub(Clrg, Step0[1]), Dir[1])),
+                VMul(VSub(Clrb, Step0[2]), Dir[2]));
+
+            VFloat iStep = EndpointOrderIndex(VToFloat(VTruncate(VAdd(fDot, half))), fSteps);
+            iStep = VSelect(VGreaterEq(fDot, fSteps), VSplat(1.f), iStep);
+            iStep = VSelect(VLessEq(fDot, zero), zero, iStep);
+
+            if (bColorKey)
+            {
+                iStep = VSelect(VAnd(bThreeSteps, bKeyed[i]), VSplat(3.f), iStep);
+            }
+
+            dw = VOrInt(dw, VShiftLeft(VTruncate(iStep), static_cast<int>(i * 2)));
+        }
+
+        // A 4-color block whose endpoints quantize to the same color is solid
+        const VFloat bSolid = VAndNot(bSameColor, bThreeSteps);
+        rgb0 = VSelectInt(bSolid, wColorA, rgb0);
+        rgb1 = VSelectInt(bSolid, wColorB, rgb1);
+        dw = VSelectInt(bSolid, VSplatInt(0), dw);
+
+        // A fully transparent block
+        rgb0 = VSelectInt(bAllKeyed, VSplatInt(0x0000), rgb0);
+        rgb1 = VSelectInt(bAllKeyed, VSplatInt(0xffff), rgb1);
+        bitmap = VSelectInt(bAllKeyed, VSplatInt(-1), dw);
+    }
+
+    //-------------------------------------------------------------------------------------
+    // OptimizeAlpha<false> for every lane; bSixSteps selects the 6-step (0 and 1 reserved) lanes
+    //-------------------------------------------------------------------------------------
+    void OptimizeAlphaLanes(
+        VFloat& fAlphaX,
+        VFloat& fAlphaY,
+        const VFloat *pPoints,
+        VFloat bSixSteps) noexcept
+    {
+        const VFloat zero = VSplat(0.f);
+        const VFloat one = VSplat(1.f);
+        const VFloat half = VSplat(0.5f);
+        const VFloat fSteps = VSelect(bSixSteps, VSplat(5.f), VSplat(7.f));
+
+        // Find Min and Max points, as starting point; 6-step lanes ignore points at 0 and 1
+        VFloat fX = one;
+        VFloat fY = zero;
+
+        for (size_t iPoint = 0; iPoint < NUM_PIXELS_PER_BLOCK; iPoint++)
+        {
+            const VFloat p = pPoints[iPoint];
+
+            VFloat bLess = VLess(p, fX);
+            bLess = VSelect(bSixSteps, VAnd(bLess, VGreater(p, zero)), bLess);
+            fX = VSelect(bLess, p, fX);
+
+            VFloat bGreater = VGreater(p, fY);
+            bGreater = VSelect(bSixSteps, VAnd(bGreater, VLess(p, one)), bGreater);
+            fY = VSelect(bGreater, p, fY);
+        }
+
+        fY = VSelect(VAnd(bSixSteps, VEqual(fX, fY)), one, fY);
+
+        // Use Newton's Method to find local minima of sum-of-squares error.
+        const VFloat fRangeMin = VSplat(1.0f / 256.0f);
+        const VFloat fEpsilon = VSplat(1.0f / 64.0f);
+        VFloat bActive = VTrue();
+
+        for (size_t iIteration = 0; iIteration < 8; iIteration++)
+        {
+            bActive = VAndNot(bActive, VLess(VSub(fY, fX), fRangeMin));
+            if (!VAny(bActive))
+                break;
+
+            const VFloat fScale = VDiv(fSteps, VSub(fY, fX));
+
+            // Evaluate function, and derivatives
+            VFloat dX = zero, dY = zero, d2X = zero, d2Y = zero;
+
+            for (size_t iPoint = 0; iPoint < NUM_PIXELS_PER_BLOCK; iPoint++)
+            {
+                const VFloat p = pPoints[iPoint];
+                const VFloat fDot = VMul(VSub(p, fX), fScale);
+
+                const VFloat bLow = VLessEq(fDot, zero);
+                const VFloat bHigh = VAndNot(VGreaterEq(fDot, fSteps), bLow);
+
+                VFloat fStep = VToFloat(VTruncate(VAdd(fDot, half)));
+                fStep = VSelect(bHigh, fSteps, fStep);
+                fStep = VSelect(bLow, zero, fStep);
+
+                // 6-step lanes map points beyond the endpoints to the reserved 0 and 1 (iStep 6 and 7),
+                // which do not pull on the endpoints
+                const VFloat bReserved = VAnd(bSixSteps, VOr(
+                    VAnd(bLow, VLessEq(p, VMul(fX, half))),
+                    VAnd(bHigh, VGreaterEq(p, VMul(VAdd(fY, one), half)))));
+
+                const VFloat fCStep = StepWeightC(fStep, fSteps);
+                const VFloat fDStep = StepWeightD(fStep, fSteps);
+                const VFloat fDiff = VSub(VAdd(VMul(fCStep, fX), VMul(fDStep, fY)), p);
+
+                dX = VAdd(dX, VAndNot(VMul(fCStep, fDiff), bReserved));
+                d2X = VAdd(d2X, VAndNot(VMul(fCStep, fCStep), bReserved));
+
+                dY = VAdd(dY, VAndNot(VMul(fDStep, fDiff), bReserved));
+                d2Y = VAdd(d2Y, VAndNot(VMul(fDStep, fDStep), bReserved));
+            }
+
+            // Move endpoints
+            fX = VSelect(VAnd(bActive, VGreater(d2X, zero)), VSub(fX, VDiv(dX, d2X)), fX);
+            fY = VSelect(VAnd(bActive, VGreater(d2Y, zero)), VSub(fY, VDiv(dY, d2Y)), fY);
+
+            const VFloat bSwap = VAnd(bActive, VGreater(fX, fY));
+            const VFloat f = fX;
+            fX = VSelect(bSwap, fY, fX);
+            fY = VSelect(bSwap, f, fY);
+
+            bActive = VAndNot(bActive, VAnd(VLess(VMul(dX, dX), fEpsilon), VLess(VMul(dY, dY), fEpsilon)));
+        }
+
+        fAlphaX = VMin(VMax(fX, zero), one);
+        fAlphaY = VMin(VMax(fY, zero), one);
+    }
+
+    //-------------------------------------------------------------------------------------
+    // BC3 alpha part (without dithering) for every lane
+    //-------------------------------------------------------------------------------------
+    void EncodeBC3AlphaLanes(
+        VInt& alpha0,
+        VInt& alpha1,
+        VInt& bitmapLow,
+        VInt& bitmapHigh,
+        const BlockLanes& lanes) noexcept
+    {
+        const VFloat zero = VSplat(0.f);
+        const VFloat one = VSplat(1.f);
+        const VFloat half = VSplat(0.5f);
+
+        // Quantize block to A8
+        VFloat fAlpha[NUM_PIXELS_PER_BLOCK];
+
+        VFloat fMinAlpha = lanes.a[0];
+        VFloat fMaxAlpha = lanes.a[0];
+
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            fAlpha[i] = VMul(VToFloat(VTruncate(VAdd(VMul(lanes.a[i], VSplat(255.0f)), half))), VSplat(1.0f / 255.0f));
+
+            const VFloat bLess = VLess(fAlpha[i], fMinAlpha);
+            fMinAlpha = VSelect(bLess, fAlpha[i], fMinAlpha);
+            fMaxAlpha = VSelect(VAndNot(VGreater(fAlpha[i], fMaxAlpha), bLess), fAlpha[i], fMaxAlpha);
+        }
+
+        const VFloat bOpaque = VEqual(fMinAlpha, one);
+
+        // Optimize and Quantize Min and Max values
+        const VFloat bSixSteps = VOr(VEqual(fMinAlpha, zero), VEqual(fMaxAlpha, one));
+        const VFloat fSteps = VSelect(bSixSteps, VSplat(5.f), VSplat(7.f));
+
+        VFloat fAlphaA, fAlphaB;
+        OptimizeAlphaLanes(fAlphaA, fAlphaB, fAlpha, bSixSteps);
+
+        const VInt bAlphaA = VTruncate(VAdd(VMul(fAlphaA, VSplat(255.0f)), half));
+        const VInt bAlphaB = VTruncate(VAdd(VMul(fAlphaB, VSplat(255.0f)), half));
+
+        fAlphaA = VMul(VToFloat(bAlphaA), VSplat(1.0f / 255.0f));
+        fAlphaB = VMul(VToFloat(bAlphaB), VSplat(1.0f / 255.0f));
+
+        // 6-step lanes store A first, 8-step lanes B first
+        alpha0 = VSelectInt(bSixSteps, bAlphaA, bAlphaB);
+        alpha1 = VSelectInt(bSixSteps, bAlphaB, bAlphaA);
+        const VFloat fStep0 = VSelect(bSixSteps, fAlphaA, fAlphaB);
+        const VFloat fStep1 = VSelect(bSixSteps, fAlphaB, fAlphaA);
+
+        // Encode alpha bitmap
+        const VFloat fScale = VSelect(VNotEqual(fStep0, fStep1), VDiv(fSteps, VSub(fStep1, fStep0)), zero);
+        const VFloat fLowReserved = VMul(fStep0, half);
+        const VFloat fHighReserved = VMul(VAdd(fStep1, one), half);
+
+        VInt dw[2] = { VSplatInt(0), VSplatInt(0) };
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            const VFloat fAlph = lanes.a[i];
+            const VFloat fDot = VMul(VSub(fAlph, fStep0), fScale);
+
+            VFloat iStep = EndpointOrderIndex(VToFloat(VTruncate(VAdd(fDot, half))), fSteps);
+            iStep = VSelect(VGreaterEq(fDot, fSteps),
+                VSelect(VAnd(bSixSteps, VGreaterEq(fAlph, fHighReserved)), VSplat(7.f), one), iStep);
+            iStep = VSelect(VLessEq(fDot, zero),
+                VSelect(VAnd(bSixSteps, VLessEq(fAlph, fLowReserved)), VSplat(6.f), zero), iStep);
+
+            dw[i >> 3] = VOrInt(dw[i >> 3], VShiftLeft(VTruncate(iStep), static_cast<int>((i & 7) * 3)));
+        }
+
+        // An 8-step block whose endpoints quantize to the same value, or an opaque block, has no bitmap
+        const VFloat bSolid = VAnd(VNot(bSixSteps), VEqualInt(bAlphaA, bAlphaB));
+        alpha0 = VSelectInt(bOpaque, VSplatInt(0xff), alpha0);
+        alpha1 = VSelectInt(bOpaque, VSplatInt(0xff), alpha1);
+
+        const VFloat bNoBitmap = VOr(bOpaque, bSolid);
+        bitmapLow = VSelectInt(bNoBitmap, VSplatInt(0), dw[0]);
+        bitmapHigh = VSelectInt(bNoBitmap, VSplatInt(0), dw[1]);
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Encodes up to c_Lanes consecutive blocks
+    //-------------------------------------------------------------------------------------
+    void EncodeBC1Blocks(uint8_t *pBC, const XMVECTOR *pColor, size_t count, float threshold, uint32_t flags) noexcept
+    {
+        assert(count > 0 && count <= c_Lanes);
+
+        BlockLanes lanes;
+        LoadBlockLanes(lanes, pColor, count);
+
+        VInt rgb0, rgb1, bitmap;
+        EncodeBC1Lanes(rgb0, rgb1, bitmap, lanes, true, threshold, flags);
+
+        alignas(32) int32_t aRGB0[c_Lanes], aRGB1[c_Lanes], aBitmap[c_Lanes];
+        VStoreInt(aRGB0, rgb0);
+        VStoreInt(aRGB1, rgb1);
+        VStoreInt(aBitmap, bitmap);
+        VLeave();
+
+        for (size_t iLane = 0; iLane < count; ++iLane)
+        {
+            auto pBC1 = reinterpret_cast<D3DX_BC1 *>(pBC + iLane * sizeof(D3DX_BC1));
+            pBC1->rgb[0] = static_cast<uint16_t>(aRGB0[iLane]);
+            pBC1->rgb[1] = static_cast<uint16_t>(aRGB1[iLane]);
+            pBC1->bitmap = static_cast<uint32_t>(aBitmap[iLane]);
+        }
+    }
+
+    void EncodeBC3Blocks(uint8_t *pBC, const XMVECTOR *pColor, size_t count, uint32_t flags) noexcept
+    {
+        assert(count > 0 && count <= c_Lanes);
+
+        BlockLanes lanes;
+        LoadBlockLanes(lanes, pColor, count);
+
+        VInt rgb0, rgb1, bitmap;
+        EncodeBC1Lanes(rgb0, rgb1, bitmap, lanes, false, 0.f, flags);
+
+        VInt alpha0, alpha1, alphaLow, alphaHigh;
+        EncodeBC3AlphaLanes(alpha0, alpha1, alphaLow, alphaHigh, lanes);
+
+        alignas(32) int32_t aRGB0[c_Lanes], aRGB1[c_Lanes], aBitmap[c_Lanes];
+        alignas(32) int32_t aAlpha0[c_Lanes], aAlpha1[c_Lanes], aAlphaLow[c_Lanes], aAlphaHigh[c_Lanes];
+        VStoreInt(aRGB0, rgb0);
+        VStoreInt(aRGB1, rgb1);
+        VStoreInt(aBitmap, bitmap);
+        VStoreInt(aAlpha0, alpha0);
+        VStoreInt(aAlpha1, alpha1);
+        VStoreInt(aAlphaLow, alphaLow);
+        VStoreInt(aAlphaHigh, alphaHigh);
+        VLeave();
+
+        for (size_t iLane = 0; iLane < count; ++iLane)
+        {
+            auto pBC3 = reinterpret_cast<D3DX_BC3 *>(pBC + iLane * sizeof(D3DX_BC3));
+            pBC3->alpha[0] = static_cast<uint8_t>(aAlpha0[iLane]);
+            pBC3->alpha[1] = static_cast<uint8_t>(aAlpha1[iLane]);
+            for (size_t iSet = 0; iSet < 2; ++iSet)
+            {
+                const auto dw = static_cast<uint32_t>(iSet ? aAlphaHigh[iLane] : aAlphaLow[iLane]);
+                pBC3->bitmap[0 + iSet * 3] = static_cast<uint8_t>(dw);
+                pBC3->bitmap[1 + iSet * 3] = static_cast<uint8_t>(dw >> 8);
+                pBC3->bitmap[2 + iSet * 3] = static_cast<uint8_t>(dw >> 16);
+            }
+            pBC3->bc1.rgb[0] = static_cast<uint16_t>(aRGB0[iLane]);
+            pBC3->bc1.rgb[1] = static_cast<uint16_t>(aRGB1[iLane]);
+            pBC3->bc1.bitmap = static_cast<uint32_t>(aBitmap[iLane]);
+        }
+    }
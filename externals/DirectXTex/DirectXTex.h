@@ -445,6 +445,14 @@ namespace DirectX
         _In_ DDS_FLAGS flags,
         _Out_opt_ TexMetadata* metadata, _Out_ ScratchImage& image) noexcept;
 
+    HRESULT __cdecl GetDDSImageViews(
+        _In_reads_bytes_(size) const void* pSource, _In_ size_t size,
+        _In_ DDS_FLAGS flags,
+        _Out_ TexMetadata& metadata, _Out_ std::vector<Image>& images) noexcept;
+        // Zero-copy: images point directly into pSource (e.g. a memory-mapped file) and stay valid only while it does.
+        // Returns HRESULT_E_NOT_SUPPORTED (0x80070032) if the pixels need any conversion (legacy/palettized formats,
+        // DDS_FLAGS_LEGACY_DWORD, DDS_FLAGS_BAD_DXTN_TAILS, ...); use LoadFromDDSMemory for those.
+
     HRESULT __cdecl SaveToDDSMemory(
         _In_ const Image& image,
         _In_ DDS_FLAGS flags,
@@ -704,6 +712,27 @@ namespace DirectX
         TEX_COMPRESS_BC7_QUICK = 0x100000,
         // Minimal modes (usually mode 6) for BC7 compression
 
+        TEX_COMPRESS_BC7_ULTRAFAST = 0x200000,
+        // Modes 1 & 6, one 2-subset shape picked by principal-axis fit, no endpoint refinement
+
+        TEX_COMPRESS_BC7_VERYFAST = 0x400000,
+        // Modes 1, 6 & 7, one principal-axis shape, endpoint perturbation without the exhaustive pass
+
+        TEX_COMPRESS_BC7_FAST = 0x600000,
+        // Default modes without rotations, four principal-axis shapes, endpoint perturbation
+
+        TEX_COMPRESS_BC7_BASIC = 0x800000,
+        // Same search as the default
+
+        TEX_COMPRESS_BC7_SLOW = 0xA00000,
+        // Default search plus the 3-subset modes 0 & 2 (like TEX_COMPRESS_BC7_USE_3SUBSETS)
+
+        TEX_COMPRESS_BC7_EXHAUSTIVE = 0xC00000,
+        // All modes, every shape refined; very slow
+
+        TEX_COMPRESS_BC7_QUALITY_MASK = 0xE00000,
+        // The BC7 quality levels above are values of this 3-bit field, not independent bits
+
         TEX_COMPRESS_SRGB_IN = 0x1000000,
         TEX_COMPRESS_SRGB_OUT = 0x2000000,
         TEX_COMPRESS_SRGB = (TEX_COMPRESS_SRGB_IN | TEX_COMPRESS_SRGB_OUT),
@@ -712,6 +741,13 @@ namespace DirectX
 
         TEX_COMPRESS_PARALLEL = 0x10000000,
         // Compress is free to use multithreading to improve performance (by default it does not use multithreading)
+
+        TEX_COMPRESS_BC_NO_SIMD = 0x20000000,
+        // Encodes BC1 & BC3 one block at a time with the scalar reference encoder instead of the multi-block SSE4.1/AVX2 path
+
+        TEX_COMPRESS_BC6H_FAST = 0x40000000,
+        // BC6H only tries the 1-region modes and four 2-region modes on their best shapes, perturbs the endpoints of the
+        // winner only, and stops as soon as a block is within a small error; far faster for a modest error increase
     };
 
     HRESULT __cdecl Compress(
@@ -722,6 +758,28 @@ namespace DirectX
         _In_ DXGI_FORMAT format, _In_ TEX_COMPRESS_FLAGS compress, _In_ float threshold, _Out_ ScratchImage& cImages) noexcept;
         // Note that threshold is only used by BC1. TEX_THRESHOLD_DEFAULT is a typical value to use
 
+    struct CompressOptions
+    {
+        TEX_COMPRESS_FLAGS  flags = TEX_COMPRESS_DEFAULT;
+        float               threshold = TEX_THRESHOLD_DEFAULT;
+        size_t              threadCount = 0;
+            // Threads used when TEX_COMPRESS_PARALLEL is set, including the calling thread; 0 uses one per hardware thread
+        size_t              tileSize = 0;
+            // Edge of a work unit in 4x4 blocks; 0 uses the default (8 blocks, i.e. 32x32 pixels)
+    };
+
+    HRESULT __cdecl CompressEx(
+        _In_ const Image& srcImage, _In_ DXGI_FORMAT format, _In_ const CompressOptions& options,
+        _Out_ ScratchImage& cImage,
+        _In_opt_ std::function<bool __cdecl(size_t, size_t)> statusCallBack = nullptr) noexcept;
+    HRESULT __cdecl CompressEx(
+        _In_reads_(nimages) const Image* srcImages, _In_ size_t nimages, _In_ const TexMetadata& metadata,
+        _In_ DXGI_FORMAT format, _In_ const CompressOptions& options, _Out_ ScratchImage& cImages,
+        _In_opt_ std::function<bool __cdecl(size_t, size_t)> statusCallBack = nullptr) noexcept;
+        // Tile-based CPU compression on a portable std::thread pool (no OpenMP required).
+        // statusCallBack(completedTiles, totalTiles) is called on the calling thread; returning false cancels and
+        // CompressEx returns E_ABORT. All mips/array slices are scheduled together so small mips also run in parallel.
+
 #if defined(__d3d11_h__) || defined(__d3d11_x_h__)
     HRESULT __cdecl Compress(
         _In_ ID3D11Device* pDevice, _In_ const Image& srcImage, _In_ DXGI_FORMAT format, _In_ TEX_COMPRESS_FLAGS compress,
@@ -737,6 +795,21 @@ namespace DirectX
         _In_reads_(nimages) const Image* cImages, _In_ size_t nimages, _In_ const TexMetadata& metadata,
         _In_ DXGI_FORMAT format, _Out_ ScratchImage& images) noexcept;
 
+    struct DecompressOptions
+    {
+        size_t              threadCount = 0;
+            // Threads decoding block rows, including the calling thread; 0 uses one per hardware thread
+    };
+
+    HRESULT __cdecl DecompressEx(
+        _In_ const Image& cImage, _In_ DXGI_FORMAT format, _In_ const DecompressOptions& options,
+        _Out_ ScratchImage& image) noexcept;
+    HRESULT __cdecl DecompressEx(
+        _In_reads_(nimages) const Image* cImages, _In_ size_t nimages, _In_ const TexMetadata& metadata,
+        _In_ DXGI_FORMAT format, _In_ const DecompressOptions& options, _Out_ ScratchImage& images) noexcept;
+        // Same texels as Decompress, with block rows spread over a std::thread pool. BC1-BC5 (unsigned) and BC7
+        // to R8G8B8A8_UNORM (_SRGB for sRGB sources) skip the per-texel float conversion entirely.
+
     //---------------------------------------------------------------------------------
     // Normal map operations
 
@@ -11,13 +11,12 @@
 
 #include "DirectXTexP.h"
 
-#ifdef _OPENMP
-#include <omp.h>
-#pragma warning(disable : 4616 6993)
-#endif
-
 #include "BC.h"
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 using namespace DirectX;
 using namespace DirectX::Internal;
 
@@ -31,7 +30,11 @@ namespace
         static_assert(static_cast<int>(TEX_COMPRESS_UNIFORM) == static_cast<int>(BC_FLAGS_UNIFORM), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
         static_assert(static_cast<int>(TEX_COMPRESS_BC7_USE_3SUBSETS) == static_cast<int>(BC_FLAGS_USE_3SUBSETS), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
         static_assert(static_cast<int>(TEX_COMPRESS_BC7_QUICK) == static_cast<int>(BC_FLAGS_FORCE_BC7_MODE6), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
-        return (compress & (BC_FLAGS_DITHER_RGB | BC_FLAGS_DITHER_A | BC_FLAGS_UNIFORM | BC_FLAGS_USE_3SUBSETS | BC_FLAGS_FORCE_BC7_MODE6));
+        static_assert(static_cast<int>(TEX_COMPRESS_BC7_QUALITY_MASK) == static_cast<int>(BC_FLAGS_BC7_QUALITY_MASK), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
+        static_assert(static_cast<int>(TEX_COMPRESS_BC7_ULTRAFAST) == (1 << BC_FLAGS_BC7_QUALITY_SHIFT), "TEX_COMPRESS_BC7_* levels should match BC_FLAGS_BC7_QUALITY_SHIFT");
+        static_assert(static_cast<int>(TEX_COMPRESS_BC_NO_SIMD) == static_cast<int>(BC_FLAGS_NO_SIMD), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
+        static_assert(static_cast<int>(TEX_COMPRESS_BC6H_FAST) == static_cast<int>(BC_FLAGS_BC6H_FAST), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
+        return (compress & (BC_FLAGS_DITHER_RGB | BC_FLAGS_DITHER_A | BC_FLAGS_UNIFORM | BC_FLAGS_USE_3SUBSETS | BC_FLAGS_FORCE_BC7_MODE6 | BC_FLAGS_BC7_QUALITY_MASK | BC_FLAGS_NO_SIMD | BC_FLAGS_BC6H_FAST));
     }
 
     constexpr TEX_FILTER_FLAGS GetSRGBFlags(_In_ TEX_COMPRESS_FLAGS compress) noexcept
@@ -69,21 +72,50 @@ namespace
 
 
     //-------------------------------------------------------------------------------------
-    HRESULT CompressBC(
+    // Portable multithreaded compression
+    //
+    // Images are cut into square tiles of blocks. Every thread starts with its own contiguous run of tiles
+    // and walks it front to back, so neighbouring blocks (which share source scanlines) stay on one core.
+    // A thread that runs dry steals the back half of the largest remaining run.
+    //-------------------------------------------------------------------------------------
+    constexpr size_t c_DefaultTileSize = 8;
+
+    // Multi-block encoder; BC3 has no threshold but shares the BC1 signature here
+    typedef void (*BC_ENCODE_WIDE)(uint8_t *pBC, const XMVECTOR *pColor, size_t count, float threshold, uint32_t flags);
+
+    void EncodeBC3Wide(uint8_t *pBC, const XMVECTOR *pColor, size_t count, float, uint32_t flags) noexcept
+    {
+        D3DXEncodeBC3Wide(pBC, pColor, count, flags);
+    }
+
+    struct BCEncoder
+    {
+        DXGI_FORMAT         srcFormat;
+        DXGI_FORMAT         destFormat;
+        size_t              sbpp;
+        size_t              blocksize;
+        BC_ENCODE           pfEncode;
+        BC_ENCODE_WIDE      pfEncodeWide;   // encodes up to BC_WIDE_BLOCKS blocks of a row per call, or nullptr
+        TEX_FILTER_FLAGS    convertFlags;
+        uint32_t            bcflags;
+        float               threshold;
+    };
+
+    HRESULT GetBCEncoder(
         const Image& image,
         const Image& result,
         uint32_t bcflags,
         TEX_FILTER_FLAGS srgb,
-        float threshold) noexcept
+        float threshold,
+        BCEncoder& encoder) noexcept
     {
         if (!image.pixels || !result.pixels)
             return E_POINTER;
 
-        assert(image.width == result.width);
-        assert(image.height == result.height);
+        if (image.width != result.width || image.height != result.height)
+            return E_FAIL;
 
-        const DXGI_FORMAT format = image.format;
-        size_t sbpp = BitsPerPixel(format);
+        size_t sbpp = BitsPerPixel(image.format);
         if (!sbpp)
             return E_FAIL;
 
@@ -93,241 +125,402 @@ namespace
             return HRESULT_E_NOT_SUPPORTED;
         }
 
-        // Round to bytes
-        sbpp = (sbpp + 7) / 8;
-
-        uint8_t *pDest = result.pixels;
-
-        // Determine BC format encoder
-        BC_ENCODE pfEncode;
-        size_t blocksize;
         TEX_FILTER_FLAGS cflags;
-        if (!DetermineEncoderSettings(result.format, pfEncode, blocksize, cflags))
+        if (!DetermineEncoderSettings(result.format, encoder.pfEncode, encoder.blocksize, cflags))
             return HRESULT_E_NOT_SUPPORTED;
 
-        XM_ALIGNED_DATA(16) XMVECTOR temp[16];
-        const uint8_t *pSrc = image.pixels;
-        const uint8_t *pEnd = image.pixels + image.slicePitch;
-        const size_t rowPitch = image.rowPitch;
-        for (size_t h = 0; h < image.height; h += 4)
+        switch (result.format)
         {
-            const uint8_t *sptr = pSrc;
-            uint8_t* dptr = pDest;
-            const size_t ph = std::min<size_t>(4, image.height - h);
-            size_t w = 0;
-            for (size_t count = 0; (count < result.rowPitch) && (w < image.width); count += blocksize, w += 4)
-            {
-                const size_t pw = std::min<size_t>(4, image.width - w);
-                assert(pw > 0 && ph > 0);
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:    encoder.pfEncodeWide = D3DXEncodeBC1Wide; break;
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:    encoder.pfEncodeWide = EncodeBC3Wide; break;
+        default:                            encoder.pfEncodeWide = nullptr; break;
+        }
 
-                const ptrdiff_t bytesLeft = pEnd - sptr;
-                assert(bytesLeft > 0);
-                size_t bytesToRead = std::min<size_t>(rowPitch, static_cast<size_t>(bytesLeft));
-                if (!LoadScanline(&temp[0], pw, sptr, bytesToRead, format))
-                    return E_FAIL;
+        encoder.srcFormat = image.format;
+        encoder.destFormat = result.format;
+        encoder.sbpp = (sbpp + 7) / 8;
+        encoder.convertFlags = cflags | srgb;
+        encoder.bcflags = bcflags;
+        encoder.threshold = threshold;
+        return S_OK;
+    }
 
-                if (ph > 1)
-                {
-                    bytesToRead = std::min<size_t>(rowPitch, static_cast<size_t>(bytesLeft) - rowPitch);
-                    if (!LoadScanline(&temp[4], pw, sptr + rowPitch, bytesToRead, format))
-                        return E_FAIL;
+    // Compresses blocks [bx0, bx1) x [by0, by1) of one image
+    bool CompressBCBlocks(
+        const Image& image,
+        const Image& result,
+        const BCEncoder& encoder,
+        size_t bx0, size_t by0,
+        size_t bx1, size_t by1) noexcept
+    {
+        const size_t rowPitch = image.rowPitch;
+        const uint8_t *pEnd = image.pixels + image.slicePitch;
 
-                    if (ph > 2)
-                    {
-                        bytesToRead = std::min<size_t>(rowPitch, static_cast<size_t>(bytesLeft) - rowPitch * 2);
-                        if (!LoadScanline(&temp[8], pw, sptr + rowPitch * 2, bytesToRead, format))
-                            return E_FAIL;
+        // BC1/BC3 gather a run of blocks along the row and encode them in one call
+        const size_t batch = encoder.pfEncodeWide ? BC_WIDE_BLOCKS : 1;
 
-                        if (ph > 3)
-                        {
-                            bytesToRead = std::min<size_t>(rowPitch, static_cast<size_t>(bytesLeft) - rowPitch * 3);
-                            if (!LoadScanline(&temp[12], pw, sptr + rowPitch * 3, bytesToRead, format))
-                                return E_FAIL;
-                        }
-                    }
-                }
+        XM_ALIGNED_DATA(16) XMVECTOR blocks[BC_WIDE_BLOCKS * NUM_PIXELS_PER_BLOCK];
+        for (size_t by = by0; by < by1; ++by)
+        {
+            const size_t y = by * 4;
+            const size_t ph = std::min<size_t>(4, image.height - y);
+            const uint8_t *sptr = image.pixels + y * rowPitch + bx0 * 4 * encoder.sbpp;
+            uint8_t *dptr = result.pixels + by * result.rowPitch + bx0 * encoder.blocksize;
 
-                if (pw != 4 || ph != 4)
+            for (size_t bx = bx0; bx < bx1; )
+            {
+                const size_t count = std::min<size_t>(batch, bx1 - bx);
+                for (size_t j = 0; j < count; ++j, ++bx)
                 {
-                    // Replicate pixels for partial block
-                    static const size_t uSrc[] = { 0, 0, 0, 1 };
+                    XMVECTOR *temp = &blocks[j * NUM_PIXELS_PER_BLOCK];
+                    const size_t pw = std::min<size_t>(4, image.width - bx * 4);
+                    assert(pw > 0 && ph > 0);
 
-                    if (pw < 4)
+                    const ptrdiff_t bytesLeft = pEnd - sptr;
+                    assert(bytesLeft > 0);
+                    for (size_t row = 0; row < ph; ++row)
                     {
-                        for (size_t t = 0; t < ph && t < 4; ++t)
+                        const size_t bytesToRead = std::min<size_t>(rowPitch, static_cast<size_t>(bytesLeft) - rowPitch * row);
+                        if (!LoadScanline(&temp[row * 4], pw, sptr + rowPitch * row, bytesToRead, encoder.srcFormat))
+                            return false;
+                    }
+
+                    if (pw != 4 || ph != 4)
+                    {
+                        // Replicate pixels for partial block
+                        static const size_t uSrc[] = { 0, 0, 0, 1 };
+
+                        if (pw < 4)
                         {
-                            for (size_t s = pw; s < 4; ++s)
+                            for (size_t t = 0; t < ph && t < 4; ++t)
                             {
-                            #pragma prefast(suppress: 26000, "PREFAST false positive")
-                                temp[(t << 2) | s] = temp[(t << 2) | uSrc[s]];
+                                for (size_t s = pw; s < 4; ++s)
+                                {
+                                    temp[(t << 2) | s] = temp[(t << 2) | uSrc[s]];
+                                }
                             }
                         }
-                    }
 
-                    if (ph < 4)
-                    {
-                        for (size_t t = ph; t < 4; ++t)
+                        if (ph < 4)
                         {
-                            for (size_t s = 0; s < 4; ++s)
+                            for (size_t t = ph; t < 4; ++t)
                             {
-                            #pragma prefast(suppress: 26000, "PREFAST false positive")
-                                temp[(t << 2) | s] = temp[(uSrc[t] << 2) | s];
+                                for (size_t s = 0; s < 4; ++s)
+                                {
+                                    temp[(t << 2) | s] = temp[(uSrc[t] << 2) | s];
+                                }
                             }
                         }
                     }
+
+                    sptr += encoder.sbpp * 4;
                 }
 
-                ConvertScanline(temp, 16, result.format, format, cflags | srgb);
+                ConvertScanline(blocks, count * NUM_PIXELS_PER_BLOCK, encoder.destFormat, encoder.srcFormat, encoder.convertFlags);
 
-                if (pfEncode)
-                    pfEncode(dptr, temp, bcflags);
+                if (encoder.pfEncodeWide)
+                    encoder.pfEncodeWide(dptr, blocks, count, encoder.threshold, encoder.bcflags);
+                else if (encoder.pfEncode)
+                    encoder.pfEncode(dptr, blocks, encoder.bcflags);
                 else
-                    D3DXEncodeBC1(dptr, temp, threshold, bcflags);
+                    D3DXEncodeBC1(dptr, blocks, encoder.threshold, encoder.bcflags);
 
-                sptr += sbpp * 4;
-                dptr += blocksize;
+                dptr += encoder.blocksize * count;
             }
-
-            pSrc += rowPitch * 4;
-            pDest += result.rowPitch;
         }
 
-        return S_OK;
+        return true;
     }
 
-
-    //-------------------------------------------------------------------------------------
-#ifdef _OPENMP
-    HRESULT CompressBC_Parallel(
+    // Single-threaded compression runs the same block loop over the whole image
+    HRESULT CompressBC(
         const Image& image,
         const Image& result,
         uint32_t bcflags,
         TEX_FILTER_FLAGS srgb,
         float threshold) noexcept
     {
-        if (!image.pixels || !result.pixels)
-            return E_POINTER;
-
-        assert(image.width == result.width);
-        assert(image.height == result.height);
+        BCEncoder encoder;
+        const HRESULT hr = GetBCEncoder(image, result, bcflags, srgb, threshold, encoder);
+        if (FAILED(hr))
+            return hr;
 
-        const DXGI_FORMAT format = image.format;
-        size_t sbpp = BitsPerPixel(format);
-        if (!sbpp)
+        const size_t nbx = (image.width + 3) / 4;
+        const size_t nby = (image.height + 3) / 4;
+        if (!CompressBCBlocks(image, result, encoder, 0, 0, nbx, nby))
             return E_FAIL;
 
-        if (sbpp < 8)
+        return S_OK;
+    }
+
+    // A run of tile indices [begin, end) packed into one word so both ends can be claimed with a single CAS
+    class TileQueue
+    {
+    public:
+        void Reset(size_t begin, size_t end) noexcept
         {
-            // We don't support compressing from monochrome (DXGI_FORMAT_R1_UNORM)
-            return HRESULT_E_NOT_SUPPORTED;
+            m_range.store(Pack(begin, end), std::memory_order_relaxed);
         }
 
-        // Round to bytes
-        sbpp = (sbpp + 7) / 8;
-
-        const uint8_t *pEnd = image.pixels + image.slicePitch;
-
-        // Determine BC format encoder
-        BC_ENCODE pfEncode;
-        size_t blocksize;
-        TEX_FILTER_FLAGS cflags;
-        if (!DetermineEncoderSettings(result.format, pfEncode, blocksize, cflags))
-            return HRESULT_E_NOT_SUPPORTED;
-
-        // Refactored version of loop to support parallel independance
-        const size_t nBlocks = std::max<size_t>(1, (image.width + 3) / 4) * std::max<size_t>(1, (image.height + 3) / 4);
-
-        bool fail = false;
-
-    #pragma omp parallel for
-        for (int nb = 0; nb < static_cast<int>(nBlocks); ++nb)
+        size_t GetRemaining() const noexcept
         {
-            const int nbWidth = std::max<int>(1, int((image.width + 3) / 4));
+            const uint64_t range = m_range.load(std::memory_order_relaxed);
+            return (End(range) > Begin(range)) ? size_t(End(range) - Begin(range)) : 0;
+        }
 
-            int y = nb / nbWidth;
-            const int x = (nb - (y*nbWidth)) * 4;
-            y *= 4;
+        // Owner side: next tile from the front
+        bool PopFront(size_t& tile) noexcept
+        {
+            uint64_t range = m_range.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                const uint32_t begin = Begin(range);
+                const uint32_t end = End(range);
+                if (begin >= end)
+                    return false;
+                if (m_range.compare_exchange_weak(range, Pack(begin + 1, end), std::memory_order_relaxed))
+                {
+                    tile = begin;
+                    return true;
+                }
+            }
+        }
 
-            assert((x >= 0) && (x < int(image.width)));
-            assert((y >= 0) && (y < int(image.height)));
+        // Thief side: the back half of the run (at least one tile)
+        bool StealBack(size_t& begin, size_t& end) noexcept
+        {
+            uint64_t range = m_range.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                const uint32_t b = Begin(range);
+                const uint32_t e = End(range);
+                if (b >= e)
+                    return false;
+                const uint32_t mid = b + (e - b) / 2;
+                if (m_range.compare_exchange_weak(range, Pack(b, mid), std::memory_order_relaxed))
+                {
+                    begin = mid;
+                    end = e;
+                    return true;
+                }
+            }
+        }
 
-            const size_t rowPitch = image.rowPitch;
-            const uint8_t *pSrc = image.pixels + (size_t(y)*rowPitch) + (size_t(x)*sbpp);
+    private:
+        static uint64_t Pack(size_t begin, size_t end) noexcept { return uint64_t(begin) | (uint64_t(end) << 32); }
+        static uint32_t Begin(uint64_t range) noexcept { return uint32_t(range); }
+        static uint32_t End(uint64_t range) noexcept { return uint32_t(range >> 32); }
+
+        // Own cache line, so owners popping their runs don't contend
+        alignas(64) std::atomic<uint64_t> m_range{ 0 };
+    };
+
+    // Runs work(tile) for every tile in [0, tileCount) on up to threadCount threads, the calling thread included.
+    // statusCallBack is only ever called on the calling thread. Returns E_ABORT if it asked to stop, E_FAIL if any
+    // tile failed.
+    HRESULT RunTiles(
+        size_t tileCount,
+        size_t threadCount,
+        const std::function<bool(size_t)>& work,
+        const std::function<bool __cdecl(size_t, size_t)>& statusCallBack) noexcept
+    {
+        if (tileCount > UINT32_MAX)
+            return HRESULT_E_ARITHMETIC_OVERFLOW;
 
-            uint8_t *pDest = result.pixels + (size_t(nb)*blocksize);
+        if (!threadCount)
+            threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+        threadCount = std::min(threadCount, std::max<size_t>(1, tileCount));
 
-            const size_t ph = std::min<size_t>(4, image.height - size_t(y));
-            const size_t pw = std::min<size_t>(4, image.width - size_t(x));
-            assert(pw > 0 && ph > 0);
+        std::unique_ptr<TileQueue[]> queues(new (std::nothrow) TileQueue[threadCount]);
+        if (!queues)
+            return E_OUTOFMEMORY;
+        for (size_t i = 0; i < threadCount; ++i)
+        {
+            queues[i].Reset(tileCount * i / threadCount, tileCount * (i + 1) / threadCount);
+        }
 
-            const ptrdiff_t bytesLeft = pEnd - pSrc;
-            assert(bytesLeft > 0);
-            size_t bytesToRead = std::min<size_t>(rowPitch, size_t(bytesLeft));
+        std::atomic<size_t> completed{ 0 };
+        std::atomic<bool> stop{ false };
+        std::atomic<bool> failed{ false };
 
-            XM_ALIGNED_DATA(16) XMVECTOR temp[16];
-            if (!LoadScanline(&temp[0], pw, pSrc, bytesToRead, format))
-                fail = true;
+        auto nextTile = [&](size_t self, size_t& tile) -> bool
+        {
+            if (queues[self].PopFront(tile))
+                return true;
 
-            if (ph > 1)
+            // Steal from whoever has the most left; the stolen half becomes our own run
+            for (;;)
             {
-                bytesToRead = std::min<size_t>(rowPitch, size_t(bytesLeft) - rowPitch);
-                if (!LoadScanline(&temp[4], pw, pSrc + rowPitch, bytesToRead, format))
-                    fail = true;
-
-                if (ph > 2)
+                size_t victim = self;
+                size_t most = 0;
+                for (size_t i = 0; i < threadCount; ++i)
                 {
-                    bytesToRead = std::min<size_t>(rowPitch, size_t(bytesLeft) - rowPitch * 2);
-                    if (!LoadScanline(&temp[8], pw, pSrc + rowPitch * 2, bytesToRead, format))
-                        fail = true;
-
-                    if (ph > 3)
+                    const size_t remaining = queues[i].GetRemaining();
+                    if (remaining > most)
                     {
-                        bytesToRead = std::min<size_t>(rowPitch, size_t(bytesLeft) - rowPitch * 3);
-                        if (!LoadScanline(&temp[12], pw, pSrc + rowPitch * 3, bytesToRead, format))
-                            fail = true;
+                        most = remaining;
+                        victim = i;
                     }
                 }
+                if (!most)
+                    return false;
+
+                size_t begin, end;
+                if (queues[victim].StealBack(begin, end))
+                {
+                    tile = begin;
+                    queues[self].Reset(begin + 1, end);
+                    return true;
+                }
             }
+        };
 
-            if (pw != 4 || ph != 4)
+        auto runWorker = [&](size_t self)
+        {
+            size_t tile;
+            while (!stop.load(std::memory_order_relaxed) && nextTile(self, tile))
             {
-                // Replicate pixels for partial block
-                static const size_t uSrc[] = { 0, 0, 0, 1 };
-
-                if (pw < 4)
+                if (!work(tile))
                 {
-                    for (size_t t = 0; t < ph && t < 4; ++t)
-                    {
-                        for (size_t s = pw; s < 4; ++s)
-                        {
-                            temp[(t << 2) | s] = temp[(t << 2) | uSrc[s]];
-                        }
-                    }
+                    failed.store(true, std::memory_order_relaxed);
+                    stop.store(true, std::memory_order_relaxed);
                 }
+                completed.fetch_add(1, std::memory_order_release);
+            }
+        };
+
+        size_t lastReported = SIZE_MAX;
+        auto report = [&]() -> void
+        {
+            const size_t done = completed.load(std::memory_order_acquire);
+            if (statusCallBack && done != lastReported)
+            {
+                lastReported = done;
+                if (!statusCallBack(done, tileCount))
+                    stop.store(true, std::memory_order_relaxed);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        try
+        {
+            threads.reserve(threadCount - 1);
+            for (size_t i = 1; i < threadCount; ++i)
+            {
+                threads.emplace_back(runWorker, i);
+            }
+        }
+        catch (...)
+        {
+            // Couldn't start every thread; the remaining runs get stolen by the threads we have
+        }
 
-                if (ph < 4)
+        // The calling thread works its own run, reporting between tiles
+        {
+            size_t tile;
+            report();
+            while (!stop.load(std::memory_order_relaxed) && nextTile(0, tile))
+            {
+                if (!work(tile))
                 {
-                    for (size_t t = ph; t < 4; ++t)
-                    {
-                        for (size_t s = 0; s < 4; ++s)
-                        {
-                            temp[(t << 2) | s] = temp[(uSrc[t] << 2) | s];
-                        }
-                    }
+                    failed.store(true, std::memory_order_relaxed);
+                    stop.store(true, std::memory_order_relaxed);
                 }
+                completed.fetch_add(1, std::memory_order_release);
+                report();
             }
+        }
 
-            ConvertScanline(temp, 16, result.format, format, cflags | srgb);
+        // Keep reporting while the other threads finish their last tiles
+        while (statusCallBack && !stop.load(std::memory_order_relaxed) && completed.load(std::memory_order_acquire) < tileCount)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            report();
+        }
 
-            if (pfEncode)
-                pfEncode(pDest, temp, bcflags);
-            else
-                D3DXEncodeBC1(pDest, temp, threshold, bcflags);
+        for (auto& thread : threads)
+        {
+            thread.join();
         }
 
-        return (fail) ? E_FAIL : S_OK;
+        if (failed)
+            return E_FAIL;
+        if (stop)
+            return E_ABORT;
+
+        if (statusCallBack && lastReported != tileCount)
+            statusCallBack(tileCount, tileCount);
+        return S_OK;
+    }
+
+    HRESULT CompressBC_Parallel(
+        const Image* srcImages,
+        const Image* destImages,
+        size_t nimages,
+        uint32_t bcflags,
+        TEX_FILTER_FLAGS srgb,
+        float threshold,
+        size_t threadCount,
+        size_t tileSize,
+        const std::function<bool __cdecl(size_t, size_t)>& statusCallBack) noexcept
+    {
+        if (!tileSize)
+            tileSize = c_DefaultTileSize;
+
+        struct ImageTiles
+        {
+            BCEncoder   encoder;
+            size_t      blocksWide;
+            size_t      blocksHigh;
+            size_t      tilesWide;
+            size_t      firstTile;
+        };
+
+        std::vector<ImageTiles> images;
+        size_t tileCount = 0;
+        try
+        {
+            images.resize(nimages);
+        }
+        catch (...)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        for (size_t index = 0; index < nimages; ++index)
+        {
+            ImageTiles& tiles = images[index];
+            const HRESULT hr = GetBCEncoder(srcImages[index], destImages[index], bcflags, srgb, threshold, tiles.encoder);
+            if (FAILED(hr))
+                return hr;
+
+            tiles.blocksWide = std::max<size_t>(1, (srcImages[index].width + 3) / 4);
+            tiles.blocksHigh = std::max<size_t>(1, (srcImages[index].height + 3) / 4);
+            tiles.tilesWide = (tiles.blocksWide + tileSize - 1) / tileSize;
+            tiles.firstTile = tileCount;
+            tileCount += tiles.tilesWide * ((tiles.blocksHigh + tileSize - 1) / tileSize);
+        }
+
+        auto work = [&](size_t tile) -> bool
+        {
+            // Find the image this tile belongs to (images are in firstTile order)
+            auto it = std::upper_bound(images.cbegin(), images.cend(), tile,
+                [](size_t value, const ImageTiles& tiles) { return value < tiles.firstTile; });
+            assert(it != images.cbegin());
+            --it;
+
+            const size_t index = size_t(it - images.cbegin());
+            const size_t local = tile - it->firstTile;
+            const size_t bx0 = (local % it->tilesWide) * tileSize;
+            const size_t by0 = (local / it->tilesWide) * tileSize;
+            return CompressBCBlocks(srcImages[index], destImages[index], it->encoder,
+                bx0, by0, std::min(bx0 + tileSize, it->blocksWide), std::min(by0 + tileSize, it->blocksHigh));
+        };
+
+        return RunTiles(tileCount, threadCount, work, statusCallBack);
     }
-#endif // _OPENMP
 
 
     //-------------------------------------------------------------------------------------
@@ -379,7 +572,21 @@ namespace
 
 
     //-------------------------------------------------------------------------------------
-    HRESULT DecompressBC(_In_ const Image& cImage, _In_ const Image& result) noexcept
+    struct BCDecoder
+    {
+        DXGI_FORMAT         srcFormat;      // "typeless" promoted
+        DXGI_FORMAT         destFormat;
+        size_t              dbpp;
+        size_t              sbpp;
+        BC_DECODE           pfDecode;
+        BC_DECODE_RGBA8     pfDecodeRGBA8;  // direct 8-bit path, or nullptr
+    };
+
+    HRESULT GetBCDecoder(
+        const Image& cImage,
+        const Image& result,
+        bool direct,
+        BCDecoder& decoder) noexcept
     {
         if (!cImage.pixels || !result.pixels)
             return E_POINTER;
@@ -399,11 +606,7 @@ namespace
         }
 
         // Round to bytes
-        dbpp = (dbpp + 7) / 8;
-
-        uint8_t *pDest = result.pixels;
-        if (!pDest)
-            return E_POINTER;
+        decoder.dbpp = (dbpp + 7) / 8;
 
         // Promote "typeless" BC formats
         DXGI_FORMAT cformat;
@@ -420,75 +623,148 @@ namespace
         }
 
         // Determine BC format decoder
-        BC_DECODE pfDecode;
-        size_t sbpp;
+        BC_DECODE_RGBA8 pfDecodeRGBA8;
         switch (cformat)
         {
         case DXGI_FORMAT_BC1_UNORM:
-        case DXGI_FORMAT_BC1_UNORM_SRGB:    pfDecode = D3DXDecodeBC1;   sbpp = 8;   break;
+        case DXGI_FORMAT_BC1_UNORM_SRGB:    decoder.pfDecode = D3DXDecodeBC1;   decoder.sbpp = 8;   pfDecodeRGBA8 = D3DXDecodeBC1RGBA8;  break;
         case DXGI_FORMAT_BC2_UNORM:
-        case DXGI_FORMAT_BC2_UNORM_SRGB:    pfDecode = D3DXDecodeBC2;   sbpp = 16;  break;
+        case DXGI_FORMAT_BC2_UNORM_SRGB:    decoder.pfDecode = D3DXDecodeBC2;   decoder.sbpp = 16;  pfDecodeRGBA8 = D3DXDecodeBC2RGBA8;  break;
         case DXGI_FORMAT_BC3_UNORM:
-        case DXGI_FORMAT_BC3_UNORM_SRGB:    pfDecode = D3DXDecodeBC3;   sbpp = 16;  break;
-        case DXGI_FORMAT_BC4_UNORM:         pfDecode = D3DXDecodeBC4U;  sbpp = 8;   break;
-        case DXGI_FORMAT_BC4_SNORM:         pfDecode = D3DXDecodeBC4S;  sbpp = 8;   break;
-        case DXGI_FORMAT_BC5_UNORM:         pfDecode = D3DXDecodeBC5U;  sbpp = 16;  break;
-        case DXGI_FORMAT_BC5_SNORM:         pfDecode = D3DXDecodeBC5S;  sbpp = 16;  break;
-        case DXGI_FORMAT_BC6H_UF16:         pfDecode = D3DXDecodeBC6HU; sbpp = 16;  break;
-        case DXGI_FORMAT_BC6H_SF16:         pfDecode = D3DXDecodeBC6HS; sbpp = 16;  break;
+        case DXGI_FORMAT_BC3_UNORM_SRGB:    decoder.pfDecode = D3DXDecodeBC3;   decoder.sbpp = 16;  pfDecodeRGBA8 = D3DXDecodeBC3RGBA8;  break;
+        case DXGI_FORMAT_BC4_UNORM:         decoder.pfDecode = D3DXDecodeBC4U;  decoder.sbpp = 8;   pfDecodeRGBA8 = D3DXDecodeBC4URGBA8; break;
+        case DXGI_FORMAT_BC4_SNORM:         decoder.pfDecode = D3DXDecodeBC4S;  decoder.sbpp = 8;   pfDecodeRGBA8 = nullptr;             break;
+        case DXGI_FORMAT_BC5_UNORM:         decoder.pfDecode = D3DXDecodeBC5U;  decoder.sbpp = 16;  pfDecodeRGBA8 = D3DXDecodeBC5URGBA8; break;
+        case DXGI_FORMAT_BC5_SNORM:         decoder.pfDecode = D3DXDecodeBC5S;  decoder.sbpp = 16;  pfDecodeRGBA8 = nullptr;             break;
+        case DXGI_FORMAT_BC6H_UF16:         decoder.pfDecode = D3DXDecodeBC6HU; decoder.sbpp = 16;  pfDecodeRGBA8 = nullptr;             break;
+        case DXGI_FORMAT_BC6H_SF16:         decoder.pfDecode = D3DXDecodeBC6HS; decoder.sbpp = 16;  pfDecodeRGBA8 = nullptr;             break;
         case DXGI_FORMAT_BC7_UNORM:
-        case DXGI_FORMAT_BC7_UNORM_SRGB:    pfDecode = D3DXDecodeBC7;   sbpp = 16;  break;
+        case DXGI_FORMAT_BC7_UNORM_SRGB:    decoder.pfDecode = D3DXDecodeBC7;   decoder.sbpp = 16;  pfDecodeRGBA8 = D3DXDecodeBC7RGBA8;  break;
         default:
             return HRESULT_E_NOT_SUPPORTED;
         }
 
-        XM_ALIGNED_DATA(16) XMVECTOR temp[16];
-        const uint8_t *pSrc = cImage.pixels;
+        // The 8-bit decoders only stand in for the float path when the conversion is the identity:
+        // R8G8B8A8_UNORM from a linear block, R8G8B8A8_UNORM_SRGB from an sRGB one
+        const bool identity = (format == DXGI_FORMAT_R8G8B8A8_UNORM && !IsSRGB(cformat))
+            || (format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB && IsSRGB(cformat));
+
+        decoder.srcFormat = cformat;
+        decoder.destFormat = format;
+        decoder.pfDecodeRGBA8 = (direct && identity) ? pfDecodeRGBA8 : nullptr;
+        return S_OK;
+    }
+
+    // Decompresses block rows [by0, by1) of one image
+    bool DecompressBCBlocks(
+        const Image& cImage,
+        const Image& result,
+        const BCDecoder& decoder,
+        size_t by0,
+        size_t by1) noexcept
+    {
         const size_t rowPitch = result.rowPitch;
-        for (size_t h = 0; h < cImage.height; h += 4)
+
+        XM_ALIGNED_DATA(16) XMVECTOR temp[16];
+        uint8_t texels[16 * 4];
+        for (size_t by = by0; by < by1; ++by)
         {
-            const uint8_t *sptr = pSrc;
-            uint8_t* dptr = pDest;
+            const size_t h = by * 4;
+            const uint8_t *sptr = cImage.pixels + by * cImage.rowPitch;
+            uint8_t* dptr = result.pixels + h * rowPitch;
             const size_t ph = std::min<size_t>(4, cImage.height - h);
             size_t w = 0;
-            for (size_t count = 0; (count < cImage.rowPitch) && (w < cImage.width); count += sbpp, w += 4)
+            for (size_t count = 0; (count < cImage.rowPitch) && (w < cImage.width); count += decoder.sbpp, w += 4)
             {
-                pfDecode(temp, sptr);
-                ConvertScanline(temp, 16, format, cformat, TEX_FILTER_DEFAULT);
-
                 const size_t pw = std::min<size_t>(4, cImage.width - w);
                 assert(pw > 0 && ph > 0);
 
-                if (!StoreScanline(dptr, rowPitch, format, &temp[0], pw))
-                    return E_FAIL;
-
-                if (ph > 1)
+                if (decoder.pfDecodeRGBA8)
                 {
-                    if (!StoreScanline(dptr + rowPitch, rowPitch, format, &temp[4], pw))
-                        return E_FAIL;
-
-                    if (ph > 2)
+                    if (pw == 4 && ph == 4)
                     {
-                        if (!StoreScanline(dptr + rowPitch * 2, rowPitch, format, &temp[8], pw))
-                            return E_FAIL;
-
-                        if (ph > 3)
+                        decoder.pfDecodeRGBA8(dptr, rowPitch, sptr);
+                    }
+                    else
+                    {
+                        // Partial block: decode aside, then copy the texels that exist
+                        decoder.pfDecodeRGBA8(texels, 16, sptr);
+                        for (size_t row = 0; row < ph; ++row)
                         {
-                            if (!StoreScanline(dptr + rowPitch * 3, rowPitch, format, &temp[12], pw))
-                                return E_FAIL;
+                            memcpy(dptr + rowPitch * row, texels + row * 16, pw * 4);
                         }
                     }
                 }
+                else
+                {
+                    decoder.pfDecode(temp, sptr);
+                    ConvertScanline(temp, 16, decoder.destFormat, decoder.srcFormat, TEX_FILTER_DEFAULT);
 
-                sptr += sbpp;
-                dptr += dbpp * 4;
+                    for (size_t row = 0; row < ph; ++row)
+                    {
+                        if (!StoreScanline(dptr + rowPitch * row, rowPitch, decoder.destFormat, &temp[row * 4], pw))
+                            return false;
+                    }
+                }
+
+                sptr += decoder.sbpp;
+                dptr += decoder.dbpp * 4;
             }
+        }
+
+        return true;
+    }
 
-            pSrc += cImage.rowPitch;
-            pDest += rowPitch * 4;
+    //-------------------------------------------------------------------------------------
+    // Every block row of every image is one work item for RunTiles. direct allows the 8-bit decoders;
+    // with threadCount 1 the rows simply run in order on the calling thread.
+    HRESULT DecompressBC(
+        const Image* cImages,
+        const Image* results,
+        size_t nimages,
+        bool direct,
+        size_t threadCount) noexcept
+    {
+        struct ImageRows
+        {
+            BCDecoder   decoder;
+            size_t      firstRow;
+        };
+
+        std::vector<ImageRows> images;
+        size_t rowCount = 0;
+        try
+        {
+            images.resize(nimages);
+        }
+        catch (...)
+        {
+            return E_OUTOFMEMORY;
         }
 
-        return S_OK;
+        for (size_t index = 0; index < nimages; ++index)
+        {
+            const HRESULT hr = GetBCDecoder(cImages[index], results[index], direct, images[index].decoder);
+            if (FAILED(hr))
+                return hr;
+
+            images[index].firstRow = rowCount;
+            rowCount += (cImages[index].height + 3) / 4;
+        }
+
+        auto work = [&](size_t row) -> bool
+        {
+            auto it = std::upper_bound(images.cbegin(), images.cend(), row,
+                [](size_t value, const ImageRows& rows) { return value < rows.firstRow; });
+            assert(it != images.cbegin());
+            --it;
+
+            const size_t index = size_t(it - images.cbegin());
+            const size_t by = row - it->firstRow;
+            return DecompressBCBlocks(cImages[index], results[index], it->decoder, by, by + 1);
+        };
+
+        return RunTiles(rowCount, threadCount, work, nullptr);
     }
 }
 
@@ -592,6 +868,36 @@ HRESULT DirectX::Compress(
     TEX_COMPRESS_FLAGS compress,
     float threshold,
     ScratchImage& image) noexcept
+{
+    CompressOptions options;
+    options.flags = compress;
+    options.threshold = threshold;
+    return CompressEx(srcImage, format, options, image, nullptr);
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::Compress(
+    const Image* srcImages,
+    size_t nimages,
+    const TexMetadata& metadata,
+    DXGI_FORMAT format,
+    TEX_COMPRESS_FLAGS compress,
+    float threshold,
+    ScratchImage& cImages) noexcept
+{
+    CompressOptions options;
+    options.flags = compress;
+    options.threshold = threshold;
+    return CompressEx(srcImages, nimages, metadata, format, options, cImages, nullptr);
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::CompressEx(
+    const Image& srcImage,
+    DXGI_FORMAT format,
+    const CompressOptions& options,
+    ScratchImage& image,
+    std::function<bool __cdecl(size_t, size_t)> statusCallBack) noexcept
 {
     if (IsCompressed(srcImage.format) || !IsCompressed(format))
         return E_INVALIDARG;
@@ -613,17 +919,16 @@ HRESULT DirectX::Compress(
     }
 
     // Compress single image
-    if (compress & TEX_COMPRESS_PARALLEL)
+    const TEX_COMPRESS_FLAGS compress = options.flags;
+    if ((compress & TEX_COMPRESS_PARALLEL) || statusCallBack)
     {
-    #ifndef _OPENMP
-        return E_NOTIMPL;
-    #else
-        hr = CompressBC_Parallel(srcImage, *img, GetBCFlags(compress), GetSRGBFlags(compress), threshold);
-    #endif // _OPENMP
+        // Without TEX_COMPRESS_PARALLEL the tiles still run in order on the calling thread, so progress can be reported
+        hr = CompressBC_Parallel(&srcImage, img, 1, GetBCFlags(compress), GetSRGBFlags(compress), options.threshold,
+            (compress & TEX_COMPRESS_PARALLEL) ? options.threadCount : 1, options.tileSize, statusCallBack);
     }
     else
     {
-        hr = CompressBC(srcImage, *img, GetBCFlags(compress), GetSRGBFlags(compress), threshold);
+        hr = CompressBC(srcImage, *img, GetBCFlags(compress), GetSRGBFlags(compress), options.threshold);
     }
 
     if (FAILED(hr))
@@ -633,14 +938,14 @@ HRESULT DirectX::Compress(
 }
 
 _Use_decl_annotations_
-HRESULT DirectX::Compress(
+HRESULT DirectX::CompressEx(
     const Image* srcImages,
     size_t nimages,
     const TexMetadata& metadata,
     DXGI_FORMAT format,
-    TEX_COMPRESS_FLAGS compress,
-    float threshold,
-    ScratchImage& cImages) noexcept
+    const CompressOptions& options,
+    ScratchImage& cImages,
+    std::function<bool __cdecl(size_t, size_t)> statusCallBack) noexcept
 {
     if (!srcImages || !nimages)
         return E_INVALIDARG;
@@ -684,26 +989,25 @@ HRESULT DirectX::Compress(
             cImages.Release();
             return E_FAIL;
         }
+    }
 
-        if ((compress & TEX_COMPRESS_PARALLEL))
+    const TEX_COMPRESS_FLAGS compress = options.flags;
+    if ((compress & TEX_COMPRESS_PARALLEL) || statusCallBack)
+    {
+        // Every image goes into one tile list, so the small mips don't serialize at the end
+        hr = CompressBC_Parallel(srcImages, dest, nimages, GetBCFlags(compress), GetSRGBFlags(compress), options.threshold,
+            (compress & TEX_COMPRESS_PARALLEL) ? options.threadCount : 1, options.tileSize, statusCallBack);
+        if (FAILED(hr))
         {
-        #ifndef _OPENMP
-            return E_NOTIMPL;
-        #else
-            if (compress & TEX_COMPRESS_PARALLEL)
-            {
-                hr = CompressBC_Parallel(src, dest[index], GetBCFlags(compress), GetSRGBFlags(compress), threshold);
-                if (FAILED(hr))
-                {
-                    cImages.Release();
-                    return  hr;
-                }
-            }
-        #endif // _OPENMP
+            cImages.Release();
+            return hr;
         }
-        else
+    }
+    else
+    {
+        for (size_t index = 0; index < nimages; ++index)
         {
-            hr = CompressBC(src, dest[index], GetBCFlags(compress), GetSRGBFlags(compress), threshold);
+            hr = CompressBC(srcImages[index], dest[index], GetBCFlags(compress), GetSRGBFlags(compress), options.threshold);
             if (FAILED(hr))
             {
                 cImages.Release();
@@ -715,136 +1019,184 @@ HRESULT DirectX::Compress(
     return S_OK;
 }
 
-
 //-------------------------------------------------------------------------------------
 // Decompression
 //-------------------------------------------------------------------------------------
-_Use_decl_annotations_
-HRESULT DirectX::Decompress(
-    const Image& cImage,
-    DXGI_FORMAT format,
-    ScratchImage& image) noexcept
+namespace
 {
-    if (!IsCompressed(cImage.format) || IsCompressed(format))
-        return E_INVALIDARG;
-
-    if (format == DXGI_FORMAT_UNKNOWN)
+    HRESULT DecompressImage(
+        const Image& cImage,
+        DXGI_FORMAT format,
+        bool direct,
+        size_t threadCount,
+        ScratchImage& image) noexcept
     {
-        // Pick a default decompressed format based on BC input format
-        format = DefaultDecompress(cImage.format);
+        if (!IsCompressed(cImage.format) || IsCompressed(format))
+            return E_INVALIDARG;
+
         if (format == DXGI_FORMAT_UNKNOWN)
         {
-            // Input is not a compressed format
-            return E_INVALIDARG;
+            // Pick a default decompressed format based on BC input format
+            format = DefaultDecompress(cImage.format);
+            if (format == DXGI_FORMAT_UNKNOWN)
+            {
+                // Input is not a compressed format
+                return E_INVALIDARG;
+            }
         }
-    }
-    else
-    {
-        if (!IsValid(format))
-            return E_INVALIDARG;
+        else
+        {
+            if (!IsValid(format))
+                return E_INVALIDARG;
 
-        if (IsTypeless(format) || IsPlanar(format) || IsPalettized(format))
-            return HRESULT_E_NOT_SUPPORTED;
-    }
+            if (IsTypeless(format) || IsPlanar(format) || IsPalettized(format))
+                return HRESULT_E_NOT_SUPPORTED;
+        }
 
-    // Create decompressed image
-    HRESULT hr = image.Initialize2D(format, cImage.width, cImage.height, 1, 1);
-    if (FAILED(hr))
-        return hr;
+        // Create decompressed image
+        HRESULT hr = image.Initialize2D(format, cImage.width, cImage.height, 1, 1);
+        if (FAILED(hr))
+            return hr;
 
-    const Image *img = image.GetImage(0, 0, 0);
-    if (!img)
-    {
-        image.Release();
-        return E_POINTER;
-    }
+        const Image *img = image.GetImage(0, 0, 0);
+        if (!img)
+        {
+            image.Release();
+            return E_POINTER;
+        }
 
-    // Decompress single image
-    hr = DecompressBC(cImage, *img);
-    if (FAILED(hr))
-        image.Release();
+        // Decompress single image
+        hr = DecompressBC(&cImage, img, 1, direct, threadCount);
+        if (FAILED(hr))
+            image.Release();
 
-    return hr;
-}
+        return hr;
+    }
 
-_Use_decl_annotations_
-HRESULT DirectX::Decompress(
-    const Image* cImages,
-    size_t nimages,
-    const TexMetadata& metadata,
-    DXGI_FORMAT format,
-    ScratchImage& images) noexcept
-{
-    if (!cImages || !nimages)
-        return E_INVALIDARG;
+    HRESULT DecompressImages(
+        const Image* cImages,
+        size_t nimages,
+        const TexMetadata& metadata,
+        DXGI_FORMAT format,
+        bool direct,
+        size_t threadCount,
+        ScratchImage& images) noexcept
+    {
+        if (!cImages || !nimages)
+            return E_INVALIDARG;
 
-    if (!IsCompressed(metadata.format) || IsCompressed(format))
-        return E_INVALIDARG;
+        if (!IsCompressed(metadata.format) || IsCompressed(format))
+            return E_INVALIDARG;
 
-    if (format == DXGI_FORMAT_UNKNOWN)
-    {
-        // Pick a default decompressed format based on BC input format
-        format = DefaultDecompress(cImages[0].format);
         if (format == DXGI_FORMAT_UNKNOWN)
         {
-            // Input is not a compressed format
-            return E_FAIL;
+            // Pick a default decompressed format based on BC input format
+            format = DefaultDecompress(cImages[0].format);
+            if (format == DXGI_FORMAT_UNKNOWN)
+            {
+                // Input is not a compressed format
+                return E_FAIL;
+            }
         }
-    }
-    else
-    {
-        if (!IsValid(format))
-            return E_INVALIDARG;
-
-        if (IsTypeless(format) || IsPlanar(format) || IsPalettized(format))
-            return HRESULT_E_NOT_SUPPORTED;
-    }
-
-    images.Release();
-
-    TexMetadata mdata2 = metadata;
-    mdata2.format = format;
-    HRESULT hr = images.Initialize(mdata2);
-    if (FAILED(hr))
-        return hr;
+        else
+        {
+            if (!IsValid(format))
+                return E_INVALIDARG;
 
-    if (nimages != images.GetImageCount())
-    {
-        images.Release();
-        return E_FAIL;
-    }
+            if (IsTypeless(format) || IsPlanar(format) || IsPalettized(format))
+                return HRESULT_E_NOT_SUPPORTED;
+        }
 
-    const Image* dest = images.GetImages();
-    if (!dest)
-    {
         images.Release();
-        return E_POINTER;
-    }
 
-    for (size_t index = 0; index < nimages; ++index)
-    {
-        assert(dest[index].format == format);
+        TexMetadata mdata2 = metadata;
+        mdata2.format = format;
+        HRESULT hr = images.Initialize(mdata2);
+        if (FAILED(hr))
+            return hr;
 
-        const Image& src = cImages[index];
-        if (!IsCompressed(src.format))
+        if (nimages != images.GetImageCount())
         {
             images.Release();
             return E_FAIL;
         }
 
-        if (src.width != dest[index].width || src.height != dest[index].height)
+        const Image* dest = images.GetImages();
+        if (!dest)
         {
             images.Release();
-            return E_FAIL;
+            return E_POINTER;
         }
 
-        hr = DecompressBC(src, dest[index]);
+        for (size_t index = 0; index < nimages; ++index)
+        {
+            assert(dest[index].format == format);
+
+            const Image& src = cImages[index];
+            if (!IsCompressed(src.format))
+            {
+                images.Release();
+                return E_FAIL;
+            }
+
+            if (src.width != dest[index].width || src.height != dest[index].height)
+            {
+                images.Release();
+                return E_FAIL;
+            }
+        }
+
+        // All mips/array slices share one list of block rows
+        hr = DecompressBC(cImages, dest, nimages, direct, threadCount);
         if (FAILED(hr))
         {
             images.Release();
             return hr;
         }
+
+        return S_OK;
     }
+}
 
-    return S_OK;
+_Use_decl_annotations_
+HRESULT DirectX::Decompress(
+    const Image& cImage,
+    DXGI_FORMAT format,
+    ScratchImage& image) noexcept
+{
+    return DecompressImage(cImage, format, false, 1, image);
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::Decompress(
+    const Image* cImages,
+    size_t nimages,
+    const TexMetadata& metadata,
+    DXGI_FORMAT format,
+    ScratchImage& images) noexcept
+{
+    return DecompressImages(cImages, nimages, metadata, format, false, 1, images);
 }
+
+_Use_decl_annotations_
+HRESULT DirectX::DecompressEx(
+    const Image& cImage,
+    DXGI_FORMAT format,
+    const DecompressOptions& options,
+    ScratchImage& image) noexcept
+{
+    return DecompressImage(cImage, format, true, options.threadCount, image);
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::DecompressEx(
+    const Image* cImages,
+    size_t nimages,
+    const TexMetadata& metadata,
+    DXGI_FORMAT format,
+    const DecompressOptions& options,
+    ScratchImage& images) noexcept
+{
+    return DecompressImages(cImages, nimages, metadata, format, true, options.threadCount, images);
+}
+
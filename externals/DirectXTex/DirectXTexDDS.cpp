@@ -1732,6 +1732,73 @@ HRESULT DirectX::LoadFromDDSMemory(
 }
 
 
+//-------------------------------------------------------------------------------------
+// Return Image views into a DDS file in memory without copying the pixels
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::GetDDSImageViews(
+    const void* pSource,
+    size_t size,
+    DDS_FLAGS flags,
+    TexMetadata& metadata,
+    std::vector<Image>& images) noexcept
+{
+    images.clear();
+
+    if (!pSource || size == 0)
+        return E_INVALIDARG;
+
+    // Pitch overrides change the layout of the pixels, so they cannot be used as-is
+    if (flags & (DDS_FLAGS_LEGACY_DWORD | DDS_FLAGS_BAD_DXTN_TAILS))
+        return HRESULT_E_NOT_SUPPORTED;
+
+    uint32_t convFlags = 0;
+    HRESULT hr = DecodeDDSHeader(pSource, size, flags, metadata, convFlags);
+    if (FAILED(hr))
+        return hr;
+
+    // Only the DX10 header and the premultiplied-alpha hint leave the pixel data untouched
+    if (convFlags & ~static_cast<uint32_t>(CONV_FLAGS_DX10 | CONV_FLAGS_PMALPHA))
+        return HRESULT_E_NOT_SUPPORTED;
+
+    size_t offset = sizeof(uint32_t) + sizeof(DDS_HEADER);
+    if (convFlags & CONV_FLAGS_DX10)
+        offset += sizeof(DDS_HEADER_DXT10);
+
+    if (offset >= size)
+        return E_FAIL;
+
+    size_t pixelSize, nimages;
+    hr = DetermineImageArray(metadata, CP_FLAGS_NONE, nimages, pixelSize);
+    if (FAILED(hr))
+        return hr;
+
+    if (nimages == 0)
+        return E_FAIL;
+
+    if (pixelSize > (size - offset))
+        return HRESULT_E_HANDLE_EOF;
+
+    try
+    {
+        images.resize(nimages);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    auto pPixels = const_cast<uint8_t*>(static_cast<const uint8_t*>(pSource) + offset);
+    if (!SetupImageArray(pPixels, pixelSize, metadata, CP_FLAGS_NONE, images.data(), nimages))
+    {
+        images.clear();
+        return E_FAIL;
+    }
+
+    return S_OK;
+}
+
+
 //-------------------------------------------------------------------------------------
 // Load a DDS file from disk
 //-------------------------------------------------------------------------------------
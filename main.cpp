@@ -13,6 +13,7 @@
 #include <dxgidebug.h>
 #include <dxcapi.h>
 #include <vector>
+#include <algorithm>
 
 #include "externals/DirectXTex/DirectXTex.h"
 #include "externals/DirectXTex/d3dx12.h"
@@ -21,6 +22,29 @@
 #include "externals/imgui/imgui_impl_dx12.h"
 #include "externals/imgui/imgui_impl_win32.h"
 
+#include "MyMath.h"
+#include "TransformBatch.h"
+#include "ResourceUtility.h"
+#include "FrameRing.h"
+#include "D3D12GpuTimeline.h"
+#include "LinearUploadAllocator.h"
+#include "D3D12UploadPageProvider.h"
+#include "D3D12ResourceAllocator.h"
+#include "StringUtility.h"
+#include "ThreadPool.h"
+#include "TextureStreamer.h"
+#include "TextureLoader.h"
+#include "D3D12TextureUploader.h"
+#include "ShaderCache.h"
+#include "DxcShaderCompiler.h"
+#include "ShaderBuildProfile.h"
+#include "ShaderPermutation.h"
+#include "D3D12PipelineStateCache.h"
+#include "ShaderHotReloader.h"
+#include "Mesh.h"
+#include "VertexCompression.h"
+#include "RenderBatcher.h"
+
 
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
@@ -29,64 +53,8 @@ extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hwnd, UINT msg
 #pragma comment(lib, "dxgi.lib")
 #pragma comment(lib, "Dbghelp.lib")
 #pragma comment(lib, "dxguid.lib")
-#pragma comment(lib, "dxcompiler.lib")
 #pragma comment(lib, "DirectXTex.lib")
 
-struct Vector2 {
-	float x;
-	float y;
-};
-
-struct Vector3 {
-	float x;
-	float y;
-	float z;
-};
-
-struct Vector4 {
-	float x;
-	float y;
-	float z;
-	float w;
-};
-
-struct VertexData {
-	Vector4 position;
-	Vector2 texcoord;
-};
-
-struct Matrix4x4 {
-	float m[4][4];
-};
-
-struct Transform {
-	Vector3 scale;
-	Vector3 rotate;
-	Vector3 translate;
-};
-
-// 単位行列の作成
-Matrix4x4 MakeIdentity4x4();
-
-// 4x4行列の積
-Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2);
-
-// X軸回転行列
-Matrix4x4 MakeRotateXMatrix(float angle);
-// Y軸回転行列
-Matrix4x4 MakeRotateYMatrix(float angle);
-// Z軸回転行列
-Matrix4x4 MakeRotateZMatrix(float angle);
-
-// 3次元アフィン変換行列
-Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Vector3& rotate, const Vector3& translate);
-
-// 透視投影行列
-Matrix4x4 MakePerspectiveFovMatrix(float fovY, float aspectRatio, float nearClip, float farClip);
-
-// 逆行列
-Matrix4x4 Inverse(const Matrix4x4& m);
-
 
 void Log(const std::string& message) {
 	OutputDebugStringA(message.c_str());
@@ -97,35 +65,6 @@ void Log(std::ostream& os, const std::string& message) {
 	OutputDebugStringA(message.c_str());
 }
 
-// string->wstring
-std::wstring ConvertString(const std::string& str) {
-	if (str.empty()) {
-		return std::wstring();
-	}
-
-	auto sizeNeeded = MultiByteToWideChar(CP_UTF8, 0, reinterpret_cast<const char*>(&str[0]), static_cast<int>(str.size()), NULL, 0);
-	if (sizeNeeded == 0) {
-		return std::wstring();
-	}
-	std::wstring result(sizeNeeded, 0);
-	MultiByteToWideChar(CP_UTF8, 0, reinterpret_cast<const char*>(&str[0]), static_cast<int>(str.size()), &result[0], sizeNeeded);
-	return result;
-}
-// wstring->string
-std::string ConvertString(const std::wstring& str) {
-	if (str.empty()) {
-		return std::string();
-	}
-
-	auto sizeNeeded = WideCharToMultiByte(CP_UTF8, 0, str.data(), static_cast<int>(str.size()), NULL, 0, NULL, NULL);
-	if (sizeNeeded == 0) {
-		return std::string();
-	}
-	std::string result(sizeNeeded, 0);
-	WideCharToMultiByte(CP_UTF8, 0, str.data(), static_cast<int>(str.size()), result.data(), sizeNeeded, NULL, NULL);
-	return result;
-}
-
 static LONG WINAPI ExportDump(EXCEPTION_POINTERS* exception) {
 	// 時刻を取得して、時刻を名前に入れたファイルを作成。Dumpsディレクトリいかに出力
 	SYSTEMTIME time;
@@ -152,6 +91,15 @@ static LONG WINAPI ExportDump(EXCEPTION_POINTERS* exception) {
 const int32_t kClientWidth = 1280;
 const int32_t kClientHeight = 720;
 
+// 同時に処理中にできるフレーム数。CommandAllocatorやConstantBufferはこの数だけ用意する
+const uint32_t kFrameCount = 2;
+// ConstantBufferViewの配置は256バイト単位
+const uint32_t kConstantBufferAlignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+// SRV用のDescriptorHeapの大きさ。先頭はImGui、その後ろはテクスチャが使う
+const uint32_t kSrvDescriptorCount = 128;
+// PixelShaderのバリアントの最大数。キーワードの組み合わせが増えすぎたら申告を断る
+const uint32_t kPixelShaderVariantCap = 8;
+
 // ウィンドウサイズを表す構造体にクライアント領域を入れる
 RECT wrc = { 0, 0, kClientWidth, kClientHeight };
 
@@ -177,103 +125,22 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg,
 }
 
 
-// Shaderをコンパイルする関数
-IDxcBlob* CompileShader(
+// Shaderのコンパイル内容を作る関数
+ShaderCompileRequest MakeShaderCompileRequest(
 	// CompilerするShaderファイルへのパス
 	const std::wstring& filePath,
 	// Compileに使用するProfile
 	const wchar_t* profile,
-	// 初期化で生成したものを3つ
-	IDxcUtils* dxcUtils,
-	IDxcCompiler3* dxcCompiler,
-	IDxcIncludeHandler* includeHandler) {
-	// 1.hlslファイルを読む
-	// これからシェーダーをコンパイルする旨をログに出す
-	Log(ConvertString(std::format(L"Begin CompileShader, path:{}, profile:{}\n", filePath, profile)));
-	// hlslファイルを読む
-	IDxcBlobEncoding* shaderSource = nullptr;
-	HRESULT hr = dxcUtils->LoadFile(filePath.c_str(), nullptr, &shaderSource);
-	// 読めなかったら止める
-	assert(SUCCEEDED(hr));
-	// 読み込んだファイルの内容を設定する
-	DxcBuffer shaderSourceBuffer;
-	shaderSourceBuffer.Ptr = shaderSource->GetBufferPointer();
-	shaderSourceBuffer.Size = shaderSource->GetBufferSize();
-	shaderSourceBuffer.Encoding = DXC_CP_UTF8;  // UTF8の文字コードであることを通知
-
-	// 2.Compileする
-	LPCWSTR arguments[] = {
-		filePath.c_str(), // コンパイル対象のhlslファイル名
-		L"-E", L"main", // エントリーポイントの指定。基本的にmain以外には市内
-		L"-T", profile, // ShaderProfileの設定
-		L"-Zi", L"-Qembed_debug",   // デバッグ用の情報を埋め込む
-		L"-Od",     // 最適化を外しておく
+	// 最適化やデバッグ情報の設定
+	ShaderBuildProfile buildProfile) {
+	ShaderCompileRequest request;
+	request.filePath = filePath;
+	request.profile = profile;
+	request.arguments = {
 		L"-Zpr",     // メモリレイアウトは行優先
 	};
-	// 実際にShaderをコンパイルする
-	IDxcResult* shaderResult = nullptr;
-	hr = dxcCompiler->Compile(
-		&shaderSourceBuffer, // 読み込んだファイル
-		arguments,           // コンパイルオプション
-		_countof(arguments),  // コンパイルオプションの数
-		includeHandler,      // includeが含まれた諸々
-		IID_PPV_ARGS(&shaderResult) // コンパイル結果
-	);
-	// コンパイルエラーではなくdxcが起動できないなど致命的な状況
-	assert(SUCCEEDED(hr));
-
-	// 3.警告・エラーがでていないか確認する
-	// 警告・エラーが出てたらログに出して止める
-	IDxcBlobUtf8* shaderError = nullptr;
-	shaderResult->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&shaderError), nullptr);
-	if (shaderError != nullptr && shaderError->GetStringLength() != 0) {
-		Log(shaderError->GetStringPointer());
-		// 警告・エラーダメゼッタイ
-		assert(false);
-	}
-
-	// 4.Compile結果を受け取って返す
-	// コンパイル結果から実行用のバイナリ部分を取得
-	IDxcBlob* shaderBlob = nullptr;
-	hr = shaderResult->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&shaderBlob), nullptr);
-	assert(SUCCEEDED(hr));
-	// 成功したログを出す
-	Log(ConvertString(std::format(L"CompileSucceded, path:{}, profile:{}\n", filePath, profile)));
-	// もう使わないリソースを開放
-	shaderSource->Release();
-	shaderResult->Release();
-	// 実行用のバイナリを返却
-	return shaderBlob;
-}
-
-ID3D12Resource* CreateBufferResource(ID3D12Device* device, size_t sizeInBytes) {
-	// ヒープ設定（UploadHeap）
-	D3D12_HEAP_PROPERTIES uploadHeapProperties{};
-	uploadHeapProperties.Type = D3D12_HEAP_TYPE_UPLOAD;
-
-	// リソース設定（バッファ用）
-	D3D12_RESOURCE_DESC vertexResourceDesc{};
-	vertexResourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-	vertexResourceDesc.Width = sizeInBytes;
-	vertexResourceDesc.Height = 1;
-	vertexResourceDesc.DepthOrArraySize = 1;
-	vertexResourceDesc.MipLevels = 1;
-	vertexResourceDesc.SampleDesc.Count = 1;
-	vertexResourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-
-	// リソース作成
-	ID3D12Resource* vertexResource = nullptr;
-	HRESULT hr = device->CreateCommittedResource(
-		&uploadHeapProperties,
-		D3D12_HEAP_FLAG_NONE,
-		&vertexResourceDesc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&vertexResource)
-	);
-	assert(SUCCEEDED(hr));
-
-	return vertexResource;
+	ApplyShaderBuildProfile(buildProfile, "shaderPdb", request);
+	return request;
 }
 
 ID3D12DescriptorHeap* CreateDescriptorHeap(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE heapType, UINT numDescriptors, bool shaderVisible) {
@@ -289,132 +156,27 @@ ID3D12DescriptorHeap* CreateDescriptorHeap(ID3D12Device* device, D3D12_DESCRIPTO
 	return descriptorHeap;
 }
 
-
-DirectX::ScratchImage LoadTexture(const std::string& filePath) {
-	// テクスチャを読み込んでプログラムで扱えるようにする
-	DirectX::ScratchImage image{};
-	std::wstring filePathW = ConvertString(filePath);
-	HRESULT hr = DirectX::LoadFromWICFile(filePathW.c_str(), DirectX::WIC_FLAGS_FORCE_SRGB, nullptr, image);
-	assert(SUCCEEDED(hr));
-
-	// ミップマップの作成
-	DirectX::ScratchImage mipImages{};
-	hr = DirectX::GenerateMipMaps(image.GetImages(), image.GetImageCount(), image.GetMetadata(), DirectX::TEX_FILTER_SRGB, 0, mipImages);
-	assert(SUCCEEDED(hr));
-
-	// ミップマップ付きのデータを返す
-	return mipImages;
-}
-
-ID3D12Resource* CreateTextureResource(ID3D12Device* device, const DirectX::TexMetadata& metadata) 	{
-	// metadataを基にResourceの設定
-	D3D12_RESOURCE_DESC resourceDesc{};
-	resourceDesc.Width = UINT(metadata.width); // Textureの幅
-	resourceDesc.Height = UINT(metadata.height); // Textureの高さ
-	resourceDesc.MipLevels = UINT16(metadata.mipLevels); // mipmapの数
-	resourceDesc.DepthOrArraySize = UINT16(metadata.arraySize); // 奥行き or 配列Textureの配列数
-	resourceDesc.Format = metadata.format; // TextureのFormat
-	resourceDesc.SampleDesc.Count = 1; // サンプリングカウント。1固定。
-	resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION(metadata.dimension); // Textureの次元数。普段使っているのは2次元
-
-	// 利用するHeapの設定。非常に特殊な運用。->一般的なケースに変更
-	D3D12_HEAP_PROPERTIES heapProperties{};
-	heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT; // 細かい設定を行う->VRAM上に作る
-	//heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_WRITE_BACK; // WriteBackポリシーでCPUアクセス可能
-	//heapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_L0; // プロセッサの近くに配置
-
-	// Resourceを生成する
-	ID3D12Resource* resource = nullptr;
-	HRESULT hr = device->CreateCommittedResource(
-		&heapProperties, // Heapの設定
-		D3D12_HEAP_FLAG_NONE, // Heapの特殊な設定。特になし。
-		&resourceDesc,  // Resourceの設定
-		D3D12_RESOURCE_STATE_COPY_DEST,  // データ転送される設定(03_00ex)
-		nullptr, // Clear最適値。使わないでnullptr
-		IID_PPV_ARGS(&resource)); // 作成するResourceポインタへのポインタ
-	assert(SUCCEEDED(hr));
-	return resource;
-}
-
-[[nodiscard]] // 戻り値を破棄しない
-ID3D12Resource* UploadTextureData(ID3D12Resource* texture, const DirectX::ScratchImage& mipImages, ID3D12Device* device, ID3D12GraphicsCommandList* commandList) {
-	std::vector<D3D12_SUBRESOURCE_DATA> subresources;
-	DirectX::PrepareUpload(device, mipImages.GetImages(), mipImages.GetImageCount(), mipImages.GetMetadata(), subresources);
-	uint64_t intermediateSize = GetRequiredIntermediateSize(texture, 0, UINT(subresources.size()));
-	ID3D12Resource* intermediateResource = CreateBufferResource(device, intermediateSize);
-	UpdateSubresources(commandList, texture, intermediateResource, 0, 0, UINT(subresources.size()), subresources.data());
-	// Textureへの転送後は利用できるよう、D3D12_RESOURCE_STATE_COPY_DESTからD3D12_RESOURCE_STATE_GENERIC_READへResourceStateを変更する
-	D3D12_RESOURCE_BARRIER barrier{};
-	barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-	barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-	barrier.Transition.pResource = texture;
-	barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-	barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
-	barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_GENERIC_READ;
-	commandList->ResourceBarrier(1, &barrier);
-	return intermediateResource;
-	
-	/*
-	// Meta情報を取得
-	const DirectX::TexMetadata& metadata = mipImages.GetMetadata();
-	// 全MipMapについて
-	for (size_t mipLevel = 0; mipLevel < metadata.mipLevels; ++mipLevel) {
-		// MipMapLevelを指定して各Imageを取得
-		const DirectX::Image* img = mipImages.GetImage(mipLevel, 0, 0);
-		// Textureに転送
-		HRESULT hr = texture->WriteToSubresource(
-			UINT(mipLevel),
-			nullptr,              // 全領域へコピー
-			img->pixels,          // 元データアドレス
-			UINT(img->rowPitch),  // 1ラインサイズ
-			UINT(img->slicePitch) // 1枚サイズ
-		);
-		assert(SUCCEEDED(hr));
-	}
-	*/
-}
-
-ID3D12Resource* CreateDepthStencilTextureResource(ID3D12Device* device, int32_t width, int32_t height) {
-	// Resourceの設定
-	D3D12_RESOURCE_DESC resourceDesc{};
-	resourceDesc.Width = width; // Textureの幅
-	resourceDesc.Height = height; // Textureの高さ
-	resourceDesc.MipLevels = 1; // mipmapの数
-	resourceDesc.DepthOrArraySize = 1; // 奥行き or 配列Textureの配列数
-	resourceDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT; // DepthStencilとして利用可能なフォーマット
-	resourceDesc.SampleDesc.Count = 1; // サンプリングカウント。1固定。
-	resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D; // 2次元
-	resourceDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL; // DepthStencilとして使う通知
-
-	// 利用するHeapの設定。
-	D3D12_HEAP_PROPERTIES heapProperties{};
-	heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT; // VRAM上に作る
-	
-	// 深度値のクリア設定
-	D3D12_CLEAR_VALUE depthClearValue{};
-	depthClearValue.DepthStencil.Depth = 1.0f; // 1.0f（最大値）でクリア
-	depthClearValue.Format = DXGI_FORMAT_D24_UNORM_S8_UINT; // フォーマット。Resourceと合わせる
-
-	// Resourceの生成
-	ID3D12Resource* resource = nullptr;
-	HRESULT hr = device->CreateCommittedResource(
-		&heapProperties, // Heapの設定
-		D3D12_HEAP_FLAG_NONE, // Heapの特殊な設定。特になし。
-		&resourceDesc,  // Resourceの設定
-		D3D12_RESOURCE_STATE_DEPTH_WRITE,  // 深度値を書き込む状態にしておく
-		&depthClearValue, // Clear最適値。
-		IID_PPV_ARGS(&resource)); // 作成するResourceポインタへのポインタ
-	assert(SUCCEEDED(hr));
-	return resource;
-}
+// 描画するメッシュ1つ分の値。RenderItemのmeshはこの表の番号
+struct DrawMesh {
+	// VertexShaderへ渡す位置の復元の値。HLSLのfloat4 2つに合わせて並べる
+	float positionDecodeConstants[8];
+	// UVの形式。InputLayoutとしてPSOに入るので、PSOを作ったときと同じ形式のメッシュしか描けない
+	TexcoordEncoding texcoordEncoding;
+	D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
+	D3D12_INDEX_BUFFER_VIEW indexBufferView;
+	uint32_t indexCount;
+};
 
 
 // Windowsアプリでのエントリーポイント(main関数)
-int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
+int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR commandLine, int) {
 	// 誰も捕捉しなかった場合に(Unhandled)、補足する関数を登録
 	// main関数始まってすぐに登録すると良い
 	SetUnhandledExceptionFilter(ExportDump);
 
+	// 起動にかかった時間を測る
+	auto startupStart = std::chrono::steady_clock::now();
+
 	// COMの初期化
 	CoInitializeEx(0, COINIT_MULTITHREADED);
 
@@ -571,15 +333,17 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	// コマンドキューの生成が上手くいかなかったので起動できない
 	assert(SUCCEEDED(hr));
 
-	// コマンドアロケータを生成する
-	ID3D12CommandAllocator* commandAllocator = nullptr;
-	hr = device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocator));
-	// コマンドアロケータの生成が上手くいかなかったので起動できない
-	assert(SUCCEEDED(hr));
+	// コマンドアロケータを生成する。GPUが使っている間はResetできないので、フレームの数だけ用意する
+	ID3D12CommandAllocator* commandAllocators[kFrameCount] = { nullptr };
+	for (uint32_t i = 0; i < kFrameCount; ++i) {
+		hr = device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocators[i]));
+		// コマンドアロケータの生成が上手くいかなかったので起動できない
+		assert(SUCCEEDED(hr));
+	}
 
 	// コマンドリストを生成する
 	ID3D12GraphicsCommandList* commandList = nullptr;
-	hr = device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocator, nullptr, IID_PPV_ARGS(&commandList));
+	hr = device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocators[0], nullptr, IID_PPV_ARGS(&commandList));
 	// コマンドリストの生成が上手くいかなかったので起動できない
 	assert(SUCCEEDED(hr));
 
@@ -603,7 +367,7 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	// RTV用のヒープでディスクリプタの数は2。RTVはShader内で触るものではないので、ShaderVisubleはfalse
 	ID3D12DescriptorHeap* rtvDescriptorHeap = CreateDescriptorHeap(device, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 2, false);
 	// SRV用のヒープでディスクリプタの数は128。SRVはShader内で触るものなので、ShaderVisubleはtrue
-	ID3D12DescriptorHeap* srvDescriptorHeap = CreateDescriptorHeap(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 128, true);
+	ID3D12DescriptorHeap* srvDescriptorHeap = CreateDescriptorHeap(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, kSrvDescriptorCount, true);
 	// DSV用のヒープでディスクリプタの数は1。DSVはShader内で触るものではないので、ShaderVisubleはfalse
 	ID3D12DescriptorHeap* dsvDescriptorHeap = CreateDescriptorHeap(device, D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 1, false);
 
@@ -633,43 +397,49 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	device->CreateRenderTargetView(swapChainResources[1], &rtvDesc, rtvHandles[1]);
 
 	
-	// 初期値０でFenceを作る
-	ID3D12Fence* fence = nullptr;
-	uint64_t fenceValue = 0;
-	hr = device->CreateFence(fenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence));
-	assert(SUCCEEDED(hr));
+	// Resourceは大きなHeapを切り分けて作る
+	D3D12ResourceAllocator resourceAllocator;
+	resourceAllocator.Initialize(device);
 
-	// FenceのSignalを持つためのイベントを作成する
-	HANDLE fenceEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
-	assert(fenceEvent != nullptr);
+	// FenceでGPUの進行を管理する
+	D3D12GpuTimeline gpuTimeline;
+	gpuTimeline.Initialize(device, commandQueue);
 
+	// フレームごとのリソースを持ち回す
+	FrameRing frameRing;
+	frameRing.Initialize(&gpuTimeline, kFrameCount);
 
-	// dxcCompilerを初期化
-	IDxcUtils* dxcUtils = nullptr;
-	IDxcCompiler3* dxcCompiler = nullptr;
-	hr = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&dxcUtils));
-	assert(SUCCEEDED(hr));
-	hr = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&dxcCompiler));
-	assert(SUCCEEDED(hr));
 
-	// 現時点でincludeはしないが、includeに対応するための設定を行っておく
-	IDxcIncludeHandler* includeHandler = nullptr;
-	hr = dxcUtils->CreateDefaultIncludeHandler(&includeHandler);
-	assert(SUCCEEDED(hr));
+	// dxcCompilerを初期化
+	DxcShaderCompiler shaderCompiler;
+	shaderCompiler.Initialize();
+	// コンパイル結果はshaderCacheディレクトリに残し、次の起動から使い回す
+	ShaderCache shaderCache;
+	shaderCache.Initialize("shaderCache", &shaderCompiler);
+	// シェーダーを並列にコンパイルするスレッド
+	ThreadPool shaderThreadPool;
+	// シェーダーのビルド設定。ビルド構成に合わせるが、起動オプションで切り替えられる
+	ShaderBuildProfile shaderBuildProfile = GetDefaultShaderBuildProfile();
+	if (strstr(commandLine, "--shader-debug")) {
+		shaderBuildProfile = ShaderBuildProfile::Debug;
+	} else if (strstr(commandLine, "--shader-release")) {
+		shaderBuildProfile = ShaderBuildProfile::Release;
+	}
 
 	
 	// RootSignature作成
 	D3D12_ROOT_SIGNATURE_DESC descriptionRootSignature{};
 	descriptionRootSignature.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 
-	// RootParameter作成。PixelShaderのMaterialとVertexShaderのTransform 
-	D3D12_ROOT_PARAMETER rootParameters[3] = {};
-	rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;    // CBVを使う(b0のbと一致する)
+	// RootParameter作成。PixelShaderのMaterialの配列とVertexShaderのインスタンスの配列
+	// どちらも毎フレームUploadBufferから切り出すので、Descriptorを作らずにアドレスを直接置く
+	D3D12_ROOT_PARAMETER rootParameters[4] = {};
+	rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;    // SRVを使う(t2のtと一致する)
 	rootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;   // PixelShaderで使う
-	rootParameters[0].Descriptor.ShaderRegister = 0;    // レジスタ番号0とバインド(b0の0と一致する。もしb11と紐づけたいなら11となる)
-	rootParameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;    // CBVを使う(b0のbと一致する)
+	rootParameters[0].Descriptor.ShaderRegister = 2;    // レジスタ番号2とバインド(t0はテクスチャ)
+	rootParameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;    // SRVを使う
 	rootParameters[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;   // VertexShaderで使う
-	rootParameters[1].Descriptor.ShaderRegister = 0;    // レジスタ番号0とバインド
+	rootParameters[1].Descriptor.ShaderRegister = 1;    // レジスタ番号1とバインド
 	descriptionRootSignature.pParameters = rootParameters; // ルートパラメータ配列へのポインタ
 	descriptionRootSignature.NumParameters = _countof(rootParameters); // 配列の長さ
 
@@ -682,6 +452,11 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	rootParameters[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL; // PixelShaderで使う
 	rootParameters[2].DescriptorTable.pDescriptorRanges = descriptorRange;  // Tableの中身の配列を指定
 	rootParameters[2].DescriptorTable.NumDescriptorRanges = _countof(descriptorRange); // Tableで利用する数
+	// 量子化した位置を戻すための値。メッシュごとに変わるので、CBufferを作らずRootSignatureに直接置く
+	rootParameters[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS; // 32bitの値を直接使う
+	rootParameters[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX; // VertexShaderで使う
+	rootParameters[3].Constants.ShaderRegister = 1; // レジスタ番号1とバインド
+	rootParameters[3].Constants.Num32BitValues = 8; // float4が2つ
 
 	// Samplerの設定
 	D3D12_STATIC_SAMPLER_DESC staticSamplers[1] = {};
@@ -710,15 +485,71 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	hr = device->CreateRootSignature(0, signatureBlob->GetBufferPointer(), signatureBlob->GetBufferSize(), IID_PPV_ARGS(&rootSignature));
 	assert(SUCCEEDED(hr));
 
-	// InputLayout
+	// PSOは記述のハッシュで使い回し、pipeline.binに保存して次の起動でも使う
+	D3D12PipelineStateCache pipelineStateCache;
+	pipelineStateCache.Initialize(device, "pipeline.bin");
+	pipelineStateCache.RegisterRootSignature(rootSignature, signatureBlob->GetBufferPointer(), signatureBlob->GetBufferSize());
+
+	// 三角形2枚の頂点。3頂点ずつ並べた形からインデックス付きのメッシュにする
+	std::vector<VertexData> triangleVertices(6);
+	// 左下1
+	triangleVertices[0].position = { -0.5f, -0.5f, 0.0f, 1.0f };
+	triangleVertices[0].texcoord = { 0.0f, 1.0f };
+	// 上1
+	triangleVertices[1].position = { 0.0f, 0.5f, 0.0f, 1.0f };
+	triangleVertices[1].texcoord = { 0.5f, 0.0f };
+	// 右下1
+	triangleVertices[2].position = { 0.5f, -0.5f, 0.0f, 1.0f };
+	triangleVertices[2].texcoord = { 1.0f, 1.0f };
+
+	// 左下2
+	triangleVertices[3].position = { -0.5f, -0.5f, 0.5f, 1.0f };
+	triangleVertices[3].texcoord = { 0.0f, 1.0f };
+	// 上2
+	triangleVertices[4].position = { 0.0f, 0.0f, 0.0f, 1.0f };
+	triangleVertices[4].texcoord = { 0.5f, 0.0f };
+	// 右下2
+	triangleVertices[5].position = { 0.5f, -0.5f, -0.5f, 1.0f };
+	triangleVertices[5].texcoord = { 1.0f, 1.0f };
+
+	// 同じ頂点をまとめ、頂点キャッシュに当たりやすい順に並べ替える
+	Mesh mesh = BuildIndexedMesh(triangleVertices);
+	float acmrBefore = ComputeACMR(mesh.indices, uint32_t(mesh.vertices.size()));
+	OptimizeVertexCache(mesh.indices, uint32_t(mesh.vertices.size()));
+	OptimizeVertexFetch(mesh);
+	float acmrAfter = ComputeACMR(mesh.indices, uint32_t(mesh.vertices.size()));
+	Log(logStream, std::format("Mesh: {} -> {} vertices, {} triangles, ACMR {:.3f} -> {:.3f}",
+		triangleVertices.size(), mesh.vertices.size(), mesh.GetTriangleCount(), acmrBefore, acmrAfter));
+
+	// 頂点を12バイトに詰める。InputLayoutの形式はUVの詰め方で変わるので、PSOより先に作っておく
+	CompressedMesh compressedMesh = CompressMesh(mesh);
+	VertexCompressionReport compressionReport = MeasureVertexCompression(mesh, compressedMesh);
+	Log(logStream, std::format("  Vertex compression: {} -> {} bytes/vertex, {} -> {} bytes, position error {:.6f} (bound {:.6f}), texcoord error {:.6f} ({})",
+		sizeof(VertexData), sizeof(CompressedVertex), compressionReport.sourceBytes, compressionReport.compressedBytes,
+		compressionReport.maxPositionError, compressionReport.positionErrorBound, compressionReport.maxTexcoordError,
+		compressedMesh.texcoordEncoding == TexcoordEncoding::Unorm16 ? "unorm16" : "half"));
+	// 復元の値とUVの形式はメッシュごとに持ち、描くときにバッチのメッシュのものを使う
+	std::vector<DrawMesh> drawMeshes;
+	drawMeshes.push_back({
+		{
+			compressedMesh.positionDecode.scale.x, compressedMesh.positionDecode.scale.y, compressedMesh.positionDecode.scale.z, 0.0f,
+			compressedMesh.positionDecode.offset.x, compressedMesh.positionDecode.offset.y, compressedMesh.positionDecode.offset.z, 0.0f,
+		},
+		compressedMesh.texcoordEncoding,
+	});
+	// PSOのInputLayoutのUVの形式。違う形式のメッシュを足すときは、その形式のPSOも作る
+	const TexcoordEncoding pipelineTexcoordEncoding = compressedMesh.texcoordEncoding;
+
+
+	// InputLayout。位置はUNORMで0～1として読み、VertexShaderで元に戻す
 	D3D12_INPUT_ELEMENT_DESC inputElementDescs[2] = {};
 	inputElementDescs[0].SemanticName = "POSITION";
 	inputElementDescs[0].SemanticIndex = 0;
-	inputElementDescs[0].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	inputElementDescs[0].Format = DXGI_FORMAT_R16G16B16A16_UNORM;
 	inputElementDescs[0].AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
 	inputElementDescs[1].SemanticName = "TEXCOORD";
 	inputElementDescs[1].SemanticIndex = 0;
-	inputElementDescs[1].Format = DXGI_FORMAT_R32G32_FLOAT;
+	inputElementDescs[1].Format = pipelineTexcoordEncoding == TexcoordEncoding::Unorm16 ? DXGI_FORMAT_R16G16_UNORM : DXGI_FORMAT_R16G16_FLOAT;
 	inputElementDescs[1].AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
 	D3D12_INPUT_LAYOUT_DESC inputLayoutDesc{};
 	inputLayoutDesc.pInputElementDescs = inputElementDescs;
@@ -736,19 +567,65 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	// 三角形の中を塗りつぶす
 	rasterizerDesc.FillMode = D3D12_FILL_MODE_SOLID;
 
-	// Shaderをコンパイルする
-	IDxcBlob* vertexShaderBlob = CompileShader(L"Object3D.VS.hlsl",	L"vs_6_0", dxcUtils, dxcCompiler, includeHandler);
-	assert(vertexShaderBlob != nullptr);
+	// Shaderをまとめて並列にコンパイルする。キャッシュにあるものはコンパイラを呼ばない
+	auto shaderStart = std::chrono::steady_clock::now();
+	std::vector<ShaderCompileRequest> shaderRequests = {
+		MakeShaderCompileRequest(L"Object3D.VS.hlsl", L"vs_6_0", shaderBuildProfile),
+	};
+	std::vector<std::future<ShaderCompileResult>> shaderFutures = shaderCache.CompileBatch(shaderRequests, shaderThreadPool);
+
+	// PixelShaderは機能キーワードの組み合わせで作り分ける。使うと申告したものだけを、VertexShaderと並行してコンパイルする
+	ShaderPermutationSet pixelShaderPermutations;
+	pixelShaderPermutations.Initialize(&shaderCache, MakeShaderCompileRequest(L"Object3D.PS.hlsl", L"ps_6_0", shaderBuildProfile),
+		{ "TEXTURED", "ALPHA_TEST" }, kPixelShaderVariantCap);
+	uint32_t pixelShaderMask = pixelShaderPermutations.MakeMask({ "TEXTURED" });
+	pixelShaderPermutations.Request(pixelShaderMask);
+	ShaderBatchDiagnostics permutationDiagnostics = pixelShaderPermutations.CompilePending(shaderThreadPool);
+
+	std::vector<ShaderCompileResult> shaderResults;
+	ShaderBatchDiagnostics shaderDiagnostics = ShaderCache::WaitForBatch(shaderRequests, shaderFutures, shaderResults);
+	// 失敗しても止めずに、ImGuiにエラーを出してファイルが直されるのを待つ
+	std::string shaderErrors = shaderDiagnostics.messages + permutationDiagnostics.messages;
+	if (!shaderErrors.empty()) {
+		Log(shaderErrors);
+	}
+	Log(std::format("Shaders compiled ({}): {} succeeded ({} cached), {} failed\n", GetShaderBuildProfileName(shaderBuildProfile),
+		shaderDiagnostics.succeededCount + permutationDiagnostics.succeededCount, shaderDiagnostics.cachedCount + permutationDiagnostics.cachedCount,
+		shaderDiagnostics.failedCount + permutationDiagnostics.failedCount));
+	// 組み合わせが増えすぎていないか確認できるように、バリアントの数を出す
+	ShaderPermutationSet::Report permutationReport = pixelShaderPermutations.GetReport();
+	Log(logStream, std::format("  Object3D.PS.hlsl permutations: {} keywords ({} possible), {}/{} variants requested, {} compiled ({} cached), {} rejected, {:.1f} ms, {} bytes",
+		permutationReport.keywordCount, permutationReport.possibleCount, permutationReport.requestedCount, permutationReport.variantCap,
+		permutationReport.compiledCount, permutationReport.cachedCount, permutationReport.rejectedCount,
+		permutationReport.compileSeconds * 1000.0, permutationReport.objectBytes));
+	// プロファイルごとの大きさと時間を比べられるように、1つずつログに出す
+	for (size_t i = 0; i < shaderResults.size(); ++i) {
+		Log(logStream, std::format("  {} {} [{}]: {} bytes, {:.1f} ms{}", shaderRequests[i].filePath.string(), ConvertString(shaderRequests[i].profile),
+			GetShaderBuildProfileName(shaderBuildProfile), shaderResults[i].object.size(), shaderResults[i].seconds * 1000.0,
+			shaderResults[i].cached ? " (cached)" : ""));
+	}
+	// PixelShaderのバリアントの結果をVertexShaderの後ろに並べて、パイプライン1つ分の組にする
+	ShaderCompileRequest pixelShaderRequest = pixelShaderPermutations.MakeRequest(pixelShaderMask);
+	shaderRequests.push_back(pixelShaderRequest);
+	ShaderCompileResult pixelShaderResult;
+	if (const std::vector<uint8_t>* pixelShaderObject = pixelShaderPermutations.Find(pixelShaderMask)) {
+		pixelShaderResult.succeeded = true;
+		pixelShaderResult.object = *pixelShaderObject;
+	}
+	shaderResults.push_back(std::move(pixelShaderResult));
 
-	IDxcBlob* pixelShaderBlob = CompileShader(L"Object3D.PS.hlsl", L"ps_6_0", dxcUtils, dxcCompiler, includeHandler);
-	assert(pixelShaderBlob != nullptr);
+	// シェーダーのファイルを監視して、保存されたらワーカースレッドでコンパイルし直す
+	ShaderHotReloader shaderHotReloader;
+	if (!shaderHotReloader.Initialize(&shaderCache, &shaderThreadPool, ".")) {
+		Log("Shader hot reload is disabled: cannot watch the shader directory\n");
+	}
+	uint32_t objectShaderProgram = shaderHotReloader.AddProgram(shaderRequests, shaderResults, shaderErrors);
+	double shaderSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - shaderStart).count();
 
 	// PSOを生成する
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC graphicsPipelineStateDesc{};
 	graphicsPipelineStateDesc.pRootSignature = rootSignature; // RootSignature
 	graphicsPipelineStateDesc.InputLayout = inputLayoutDesc; // InputLayout
-	graphicsPipelineStateDesc.VS = { vertexShaderBlob->GetBufferPointer(), vertexShaderBlob->GetBufferSize() }; // VertexShader
-	graphicsPipelineStateDesc.PS = { pixelShaderBlob->GetBufferPointer(), pixelShaderBlob->GetBufferSize() }; // PixelShader
 	graphicsPipelineStateDesc.BlendState = blendDesc; // BlendState
 	graphicsPipelineStateDesc.RasterizerState = rasterizerDesc; // RasterizerState
 	// 書き込むRTVの情報
@@ -773,65 +650,77 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	graphicsPipelineStateDesc.DepthStencilState = depthStencilDesc;
 	graphicsPipelineStateDesc.DSVFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
 
-	// 実際に生成
-	ID3D12PipelineState* graphicsPipelineState = nullptr;
-	hr = device->CreateGraphicsPipelineState(&graphicsPipelineStateDesc, IID_PPV_ARGS(&graphicsPipelineState));
-	assert(SUCCEEDED(hr));
+	// シェーダーの組からPSOを作る。前回の起動で作ったものはライブラリから読み込む
+	// 古いPSOもキャッシュが終了まで持っているので、差し替えた後もGPUが使っている間は生きている
+	auto createGraphicsPipelineState = [&](const std::vector<ShaderCompileResult>& results) -> ID3D12PipelineState* {
+		if (results.empty()) {
+			return nullptr;
+		}
+		graphicsPipelineStateDesc.VS = { results[0].object.data(), results[0].object.size() }; // VertexShader
+		graphicsPipelineStateDesc.PS = { results[1].object.data(), results[1].object.size() }; // PixelShader
+		return pipelineStateCache.GetGraphicsPipelineState(graphicsPipelineStateDesc);
+	};
+	// 起動時にコンパイルできていなければnullptrのまま、直されるまで描かない
+	ID3D12PipelineState* graphicsPipelineState = createGraphicsPipelineState(shaderHotReloader.GetResults(objectShaderProgram));
 
 	
 	// 実際に頂点リソースを作る
-	ID3D12Resource* vertexResource = CreateBufferResource(device, sizeof(VertexData) * 6);
+	const uint32_t vertexBufferSize = uint32_t(sizeof(CompressedVertex) * compressedMesh.vertices.size());
+	ID3D12Resource* vertexResource = CreateBufferResource(&resourceAllocator, vertexBufferSize);
 
 	// 頂点バッファビューを作成する
 	D3D12_VERTEX_BUFFER_VIEW vertexBufferView{};
 	// リソースの先頭アドレスから使う
 	vertexBufferView.BufferLocation = vertexResource->GetGPUVirtualAddress();
-	// 使用するリソースのサイズは頂点３つ分のサイズ
-	vertexBufferView.SizeInBytes = sizeof(VertexData) * 6;
+	// 使用するリソースのサイズは頂点全部のサイズ
+	vertexBufferView.SizeInBytes = vertexBufferSize;
 	// １頂点当たりのサイズ
-	vertexBufferView.StrideInBytes = sizeof(VertexData);
+	vertexBufferView.StrideInBytes = sizeof(CompressedVertex);
 
 	// 頂点リソースにデータを書き込む
-	VertexData* vertexData = nullptr;
+	CompressedVertex* vertexData = nullptr;
 	// 書き込むためのアドレスを取得
 	vertexResource->Map(0, nullptr, reinterpret_cast<void**>(&vertexData));
-	// 左下1
-	vertexData[0].position = { -0.5f, -0.5f, 0.0f, 1.0f };
-	vertexData[0].texcoord = { 0.0f, 1.0f };
-	// 上1
-	vertexData[1].position = { 0.0f, 0.5f, 0.0f, 1.0f };
-	vertexData[1].texcoord = { 0.5f, 0.0f };
-	// 右下1
-	vertexData[2].position = { 0.5f, -0.5f, 0.0f, 1.0f };
-	vertexData[2].texcoord = { 1.0f, 1.0f };
-
-	// 左下2
-	vertexData[3].position = { -0.5f, -0.5f, 0.5f, 1.0f };
-	vertexData[3].texcoord = { 0.0f, 1.0f };
-	// 上2
-	vertexData[4].position = { 0.0f, 0.0f, 0.0f, 1.0f };
-	vertexData[4].texcoord = { 0.5f, 0.0f };
-	// 右下2
-	vertexData[5].position = { 0.5f, -0.5f, -0.5f, 1.0f };
-	vertexData[5].texcoord = { 1.0f, 1.0f };
+	std::copy(compressedMesh.vertices.begin(), compressedMesh.vertices.end(), vertexData);
+
+	// インデックスリソース。頂点が少なければ16bitにして半分にする
+	const uint32_t indexSize = mesh.UsesShortIndices() ? sizeof(uint16_t) : sizeof(uint32_t);
+	const uint32_t indexBufferSize = indexSize * uint32_t(mesh.indices.size());
+	ID3D12Resource* indexResource = CreateBufferResource(&resourceAllocator, indexBufferSize);
+
+	// インデックスバッファビューを作成する
+	D3D12_INDEX_BUFFER_VIEW indexBufferView{};
+	indexBufferView.BufferLocation = indexResource->GetGPUVirtualAddress();
+	indexBufferView.SizeInBytes = indexBufferSize;
+	indexBufferView.Format = mesh.UsesShortIndices() ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+
+	// インデックスリソースにデータを書き込む
+	void* indexData = nullptr;
+	indexResource->Map(0, nullptr, &indexData);
+	if (mesh.UsesShortIndices()) {
+		std::copy(mesh.indices.begin(), mesh.indices.end(), static_cast<uint16_t*>(indexData));
+	} else {
+		std::copy(mesh.indices.begin(), mesh.indices.end(), static_cast<uint32_t*>(indexData));
+	}
+	// 作ったバッファをメッシュの表に入れる
+	drawMeshes[0].vertexBufferView = vertexBufferView;
+	drawMeshes[0].indexBufferView = indexBufferView;
+	drawMeshes[0].indexCount = uint32_t(mesh.indices.size());
+
+	// ConstantBufferは毎フレーム、フレームの区画ごとのアロケータから切り出す
+	// GPUが読んでいる区画には書き込まないので、区画を使い回すときにResetするだけで良い
+	D3D12UploadPageProvider uploadPageProvider(&resourceAllocator);
+	LinearUploadAllocator uploadAllocators[kFrameCount];
+	for (LinearUploadAllocator& uploadAllocator : uploadAllocators) {
+		uploadAllocator.Initialize(&uploadPageProvider);
+	}
 
-	// マテリアル用のリソースを作る。今回はcolor1つ分のサイズを用意する
-	ID3D12Resource* materialResource = CreateBufferResource(device, sizeof(Vector4));
-	// マテリアルにデータを書き込む
-	Vector4* materialData = nullptr;
-	// 書き込むためのアドレスを取得
-	materialResource->Map(0, nullptr, reinterpret_cast<void**>(&materialData));
-	// 今回は赤を書き込んでみる
-	*materialData = Vector4(1.0f, 1.0f, 1.0f, 1.0f);
-
-	// WVP用のリソースを作る。Matrix4x4　1つ分のサイズを用意する
-	ID3D12Resource* wvpResource = CreateBufferResource(device, sizeof(Matrix4x4));
-	// データを書き込む
-	Matrix4x4* wvpData = nullptr;
-	// 書き込むためのアドレスを取得
-	wvpResource->Map(0, nullptr, reinterpret_cast<void**>(&wvpData));
-	// 単位行列を書き込んでおく
-	*wvpData = MakeIdentity4x4();
+	// マテリアルの色。毎フレームまとめてStructuredBufferへ書き込み、インスタンスが番号で引く
+	std::vector<Vector4> materialColors = {
+		Vector4(1.0f, 1.0f, 1.0f, 1.0f),
+		Vector4(1.0f, 0.6f, 0.3f, 1.0f),
+		Vector4(0.4f, 0.8f, 1.0f, 1.0f),
+	};
 
 	// ビューポート
 	D3D12_VIEWPORT viewport{};
@@ -852,54 +741,46 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	scissorRect.bottom = kClientHeight;
 
 
-	// Transform変数を作る
-	Transform transform{ {1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f} };
-
-
-	// リソースの読み込みとアップロード
-	DirectX::ScratchImage mipImages = LoadTexture("resources/uvChecker.png");
-	const DirectX::TexMetadata& metadata = mipImages.GetMetadata();
-	ID3D12Resource* textureResource = CreateTextureResource(device, metadata);
-	
-	ID3D12Resource* depthStencilResource = CreateDepthStencilTextureResource(device, kClientWidth, kClientWidth);
-
-	ID3D12Resource* intermediateResource = UploadTextureData(textureResource, mipImages, device, commandList);
-	// commandListをcloseし、commandQueue->ExecuteCommandListsを使いキックする
-	commandList->Close();
-	ID3D12CommandList* commandLists[] = { commandList };
-	commandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
-    
-	// 実行を待つ
-	fenceValue++;
-	commandQueue->Signal(fence, fenceValue);
-	if (fence->GetCompletedValue() < fenceValue) {
-		fence->SetEventOnCompletion(fenceValue, fenceEvent);
-		WaitForSingleObject(fenceEvent, INFINITE);
+	// 描画するオブジェクトのTransformをまとめて持つ
+	TransformBatch transformBatch;
+	uint32_t triangleIndex = transformBatch.Add({ {1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f} });
+	// 描画するもの。PSOとメッシュはまだ1つずつなので番号は0
+	std::vector<RenderItem> renderItems;
+	renderItems.push_back({ 0, 0, 0, triangleIndex });
+	// 奥に同じメッシュのタイルを並べる。マテリアルが違っても、PSOとメッシュが同じなら1回のドローコールにまとまる
+	const uint32_t kTileGridSize = 16;
+	for (uint32_t y = 0; y < kTileGridSize; ++y) {
+		for (uint32_t x = 0; x < kTileGridSize; ++x) {
+			Vector3 translate = { (float(x) - float(kTileGridSize - 1) * 0.5f) * 0.5f, (float(y) - float(kTileGridSize - 1) * 0.5f) * 0.5f, 3.0f };
+			uint32_t tileIndex = transformBatch.Add({ {0.4f, 0.4f, 0.4f}, {0.0f, 0.0f, 0.0f}, translate });
+			renderItems.push_back({ 0, 0, 1 + (x + y) % 2, tileIndex });
+		}
 	}
+	RenderBatcher renderBatcher;
+	renderBatcher.Reserve(renderItems.size());
+	// オブジェクトが多いときにWVPの計算を分担するスレッド。コンパイルや読み込みのタスクを待たないよう専用にする
+	ThreadPool transformThreadPool;
 
-    // 実行が完了したので、allcatorとcommandListをresetして次のコマンドを積めるようにする
-	commandAllocator->Reset();
-	commandList->Reset(commandAllocator, nullptr);
-
-    // ここまできたら転送は終わっているので、intermediateResourceはReleaseしても良い
-	intermediateResource->Release();
 
+	ID3D12Resource* depthStencilResource = CreateDepthStencilTextureResource(&resourceAllocator, kClientWidth, kClientWidth);
 
-	// metaDataを基にSRVの設定
-	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
-	srvDesc.Format = metadata.format;
-	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;//2Dテクスチャ
-	srvDesc.Texture2D.MipLevels = UINT(metadata.mipLevels);
+	// 最初のフレームでResetできるように、作った直後で開いているcommandListを閉じておく
+	commandList->Close();
 
-	// SRVを作成するDescriptorHeapの場所を決める
-	D3D12_CPU_DESCRIPTOR_HANDLE textureSrvHandleCPU = srvDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
-	D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandleGPU = srvDescriptorHeap->GetGPUDescriptorHandleForHeapStart();
-	// 先頭はImGuiが使っているのでその次を使う
-	textureSrvHandleCPU.ptr += device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	textureSrvHandleGPU.ptr += device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	// SRVの生成
-	device->CreateShaderResourceView(textureResource, &srvDesc, textureSrvHandleCPU);
+	// テクスチャはワーカースレッドで読み込み、コピー用のキューで転送する。届くまではプレースホルダを使う
+	// SRVHeapの先頭はImGuiが使っているので、その次からをテクスチャ用にする
+	const uint32_t descriptorSizeSRV = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	D3D12_CPU_DESCRIPTOR_HANDLE textureSrvStartCPU = srvDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
+	D3D12_GPU_DESCRIPTOR_HANDLE textureSrvStartGPU = srvDescriptorHeap->GetGPUDescriptorHandleForHeapStart();
+	textureSrvStartCPU.ptr += descriptorSizeSRV;
+	textureSrvStartGPU.ptr += descriptorSizeSRV;
+	D3D12TextureUploader textureUploader;
+	textureUploader.Initialize(device, &resourceAllocator, textureSrvStartCPU, descriptorSizeSRV, kSrvDescriptorCount - 1);
+	ThreadPool textureThreadPool(2);
+	TextureStreamer textureStreamer;
+	textureStreamer.Initialize(&textureUploader, &textureThreadPool, DecodeTexture);
+	uint32_t uvCheckerTexture = textureStreamer.Request("resources/uvChecker.png");
+	bool textureStreamingLogged = false;
 
 	// DSVの設定
 	D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc{};
@@ -916,7 +797,7 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	ImGui::StyleColorsDark();
 	ImGui_ImplWin32_Init(hwnd);
 	ImGui_ImplDX12_Init(device,
-		swapChainDesc.BufferCount,
+		kFrameCount,
 		rtvDesc.Format, 
 		srvDescriptorHeap,
 		srvDescriptorHeap->GetCPUDescriptorHandleForHeapStart(), 
@@ -926,7 +807,17 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 
 
 	
-
+	// 起動時間をログに出す。シェーダーが全てキャッシュから読めた起動をwarm、一つでもコンパイルした起動をcoldとする
+	ShaderCache::Statistics shaderCacheStatistics = shaderCache.GetStatistics();
+	double startupSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startupStart).count();
+	Log(logStream, std::format("Startup ({}): {:.1f} ms, shaders {:.1f} ms ({} cached, {} compiled, {} corrupt, {} evicted, lookup {:.1f} ms, compile {:.1f} ms)",
+		shaderCacheStatistics.missCount == 0 ? "warm" : "cold", startupSeconds * 1000.0, shaderSeconds * 1000.0,
+		shaderCacheStatistics.hitCount, shaderCacheStatistics.missCount, shaderCacheStatistics.corruptCount, shaderCacheStatistics.evictedCount,
+		shaderCacheStatistics.lookupSeconds * 1000.0, shaderCacheStatistics.compileSeconds * 1000.0));
+	D3D12PipelineStateCache::Statistics pipelineStatistics = pipelineStateCache.GetStatistics();
+	Log(logStream, std::format("  PSO: {} from library, {} created, {:.1f} ms (library load {:.1f} ms{})",
+		pipelineStatistics.libraryHitCount, pipelineStatistics.createdCount, pipelineStatistics.createSeconds * 1000.0,
+		pipelineStatistics.libraryLoadSeconds * 1000.0, pipelineStatistics.libraryRejected ? ", rejected and rebuilt" : ""));
 
 	MSG msg{};
 	// ウィンドウのxボタンが押されるまでループ
@@ -936,6 +827,20 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 			TranslateMessage(&msg);
 			DispatchMessage(&msg);
 		} else {
+			// 今回使うフレームの区画を決める。GPUがその区画をまだ使っていればここで待つ
+			uint32_t frameIndex = frameRing.BeginFrame();
+			ID3D12CommandAllocator* commandAllocator = commandAllocators[frameIndex];
+			// 前回この区画を使ったフレームは終わっているので、コマンドリストを準備できる
+			hr = commandAllocator->Reset();
+			assert(SUCCEEDED(hr));
+			hr = commandList->Reset(commandAllocator, nullptr);
+			assert(SUCCEEDED(hr));
+			// ConstantBufferの区画も使い直す
+			LinearUploadAllocator& uploadAllocator = uploadAllocators[frameIndex];
+			uploadAllocator.Reset();
+			// 読み込みが終わったテクスチャを転送し、転送が終わったものを使えるようにする
+			textureStreamer.Update();
+
 			// フレームの開始を告げる
 			ImGui_ImplDX12_NewFrame();
 			ImGui_ImplWin32_NewFrame();
@@ -944,17 +849,100 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 			// 開発用UIの処理。実際に開発用のUIを出す場合はここをゲーム固有の処理に置き換える
 			//ImGui::ShowDemoWindow();
 
+			// シェーダーの再コンパイルが終わっていれば、フレームの頭でPSOを差し替える
+			for (uint32_t programId : shaderHotReloader.Update()) {
+				if (programId == objectShaderProgram) {
+					// 起動時に失敗したバリアントも直ったので、申告し直す。ホットリロードでコンパイルした結果がキャッシュに当たる
+					pixelShaderPermutations.ClearFailed();
+					pixelShaderPermutations.Request(pixelShaderMask);
+					pixelShaderPermutations.CompilePending(shaderThreadPool);
+					ID3D12PipelineState* reloadedPipelineState = createGraphicsPipelineState(shaderHotReloader.GetResults(programId));
+					// 前のPSOは処理中のフレームがまだ使っているので、キャッシュから外してGPUが終えてから解放する
+					// 中身が同じならキャッシュから同じものが返るので、外さない
+					if (graphicsPipelineState && graphicsPipelineState != reloadedPipelineState &&
+						pipelineStateCache.RemoveGraphicsPipelineState(graphicsPipelineState)) {
+						ID3D12PipelineState* replacedPipelineState = graphicsPipelineState;
+						frameRing.DeferRelease([replacedPipelineState]() { replacedPipelineState->Release(); });
+					}
+					graphicsPipelineState = reloadedPipelineState;
+					Log(std::format("Shader reloaded in {:.1f} ms\n", shaderHotReloader.GetStatistics().lastReloadSeconds * 1000.0));
+				}
+			}
+			ImGui::Begin("Shaders");
+			ShaderHotReloader::Statistics hotReloadStatistics = shaderHotReloader.GetStatistics();
+			ImGui::Text("Hot reload: %s%s, %u reloaded, %u failed, last %.1f ms",
+				shaderHotReloader.IsWatching() ? "watching" : "disabled", shaderHotReloader.IsCompiling() ? " (compiling)" : "",
+				hotReloadStatistics.reloadCount, hotReloadStatistics.failedCount, hotReloadStatistics.lastReloadSeconds * 1000.0);
+			const std::string& objectShaderErrors = shaderHotReloader.GetErrors(objectShaderProgram);
+			if (!objectShaderErrors.empty()) {
+				// 失敗している間は前のPSOで描き続ける
+				ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), graphicsPipelineState ? "Build failed, using the last good pipeline" : "Build failed");
+				ImGui::PushTextWrapPos(0.0f);
+				ImGui::TextUnformatted(objectShaderErrors.c_str());
+				ImGui::PopTextWrapPos();
+			}
+			ImGui::End();
+
+			// インスタンス描画でまとめた結果。バッチは後で作るので、前のフレームの値を出す
+			ImGui::Begin("Rendering");
+			ImGui::Text("Objects: %zu, draw calls: %zu", renderItems.size(), renderBatcher.GetBatches().size());
+			ImGui::End();
+
+			// GPUメモリの使用状況
+			ImGui::Begin("GPU Memory");
+			const char* heapTypeNames[] = { "Default", "Upload", "Readback" };
+			const char* categoryNames[] = { "Buffer", "Texture", "RT/DS" };
+			for (uint32_t heapType = 0; heapType < uint32_t(GpuHeapType::Count); ++heapType) {
+				for (uint32_t category = 0; category < uint32_t(GpuResourceCategory::Count); ++category) {
+					GpuMemoryAllocator::PoolStatistics statistics = resourceAllocator.GetStatistics(GpuHeapType(heapType), GpuResourceCategory(category));
+					if (statistics.heapCount == 0 && statistics.dedicatedCount == 0) {
+						continue;
+					}
+					ImGui::Text("%s/%s: heaps %u, %.1f/%.1f MB used, %llu allocs, frag %.2f, dedicated %u (%.1f MB)",
+						heapTypeNames[heapType], categoryNames[category], statistics.heapCount,
+						double(statistics.usedBytes) / (1024.0 * 1024.0), double(statistics.reservedBytes) / (1024.0 * 1024.0),
+						statistics.allocationCount, statistics.fragmentation,
+						statistics.dedicatedCount, double(statistics.dedicatedBytes) / (1024.0 * 1024.0));
+				}
+			}
+			TextureStreamer::Statistics streamingStatistics = textureStreamer.GetStatistics();
+			ImGui::Text("Texture streaming: %u/%u resident, %.1f MB, %.1f MB/s",
+				streamingStatistics.residentCount, streamingStatistics.requestedCount,
+				double(streamingStatistics.uploadedBytes) / (1024.0 * 1024.0), streamingStatistics.GetThroughputMBps());
+			ImGui::End();
+			// 全て届いたら一度だけログに出す
+			if (!textureStreamingLogged && textureStreamer.GetPendingCount() == 0) {
+				Log(std::format("Texture streaming finished: {} textures, {:.1f} MB in {:.3f} s ({:.1f} MB/s), decode {:.3f} s\n",
+					streamingStatistics.residentCount, double(streamingStatistics.uploadedBytes) / (1024.0 * 1024.0),
+					streamingStatistics.elapsedSeconds, streamingStatistics.GetThroughputMBps(), streamingStatistics.decodeSeconds));
+				textureStreamingLogged = true;
+			}
+
 			// ゲームの処理-----------------------------------------------------------------------------------
 
+			Transform transform = transformBatch.Get(triangleIndex);
 			transform.rotate.y += 0.01f;
+			transformBatch.Set(triangleIndex, transform);
 
 			Transform cameraTransform = { { 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -5.0f } };
-			Matrix4x4 worldMatrix = MakeAffineMatrix(transform.scale, transform.rotate, transform.translate);
-			Matrix4x4 cameraMatrix = MakeAffineMatrix(cameraTransform.scale, cameraTransform.rotate, cameraTransform.translate);
-			Matrix4x4 viewMatrix = Inverse(cameraMatrix);
+			// カメラ行列は常にアフィンなので、汎用のInverseを使わずに直接ビュー行列を作る
+			Matrix4x4 viewMatrix = MakeViewMatrix(cameraTransform);
 			Matrix4x4 projectionMatrix = MakePerspectiveFovMatrix(0.45f, float(kClientWidth) / float(kClientHeight), 0.1f, 100.0f);
-			Matrix4x4 worldViewProjectionMatrix = Multiply(worldMatrix, Multiply(viewMatrix, projectionMatrix));
-			*wvpData = worldViewProjectionMatrix;
+			Matrix4x4 viewProjectionMatrix = Multiply(viewMatrix, projectionMatrix);
+			// PSOとメッシュが同じものをまとめ、まとめた順にインスタンスの値を切り出したUploadBufferへ書き込む
+			renderBatcher.Clear();
+			for (const RenderItem& renderItem : renderItems) {
+				renderBatcher.Add(renderItem);
+			}
+			renderBatcher.Build(transformBatch.GetCount());
+			UploadAllocation instanceAllocation = uploadAllocator.Allocate(sizeof(InstanceData) * renderBatcher.GetItemCount());
+			InstanceData* instanceData = reinterpret_cast<InstanceData*>(instanceAllocation.cpuAddress);
+			// 全オブジェクトのWVPを計算し、各オブジェクトのインスタンスの場所へ直接書き込む
+			transformBatch.Update(viewProjectionMatrix, &instanceData[0].wvp, sizeof(InstanceData), nullptr, &transformThreadPool,
+				renderBatcher.GetObjectInstances().data());
+			renderBatcher.WriteMaterialIndices(instanceData);
+			UploadAllocation materialAllocation = uploadAllocator.Allocate(sizeof(Vector4) * materialColors.size());
+			std::copy(materialColors.begin(), materialColors.end(), reinterpret_cast<Vector4*>(materialAllocation.cpuAddress));
 
 			//ここまで----------------------------------------------------------------------------------------
 
@@ -1000,20 +988,48 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 			commandList->RSSetScissorRects(1, &scissorRect);    // Scissorを設定
 			// RootSignatureを設定。PSOに設定しているけど別途設定が必要
 			commandList->SetGraphicsRootSignature(rootSignature);
-			commandList->SetPipelineState(graphicsPipelineState);   // PSOを設定
-			commandList->IASetVertexBuffers(0, 1, &vertexBufferView); // VBVを設定
 			// 形状を設定。PSOに設定しているものとはまた別。同じものを設定すると考えておけばいい
 			commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-			// マテリアルCBufferの場所を設定
-			commandList->SetGraphicsRootConstantBufferView(0, materialResource->GetGPUVirtualAddress());
-			// WVP用のCBufferの場所を設定
-			commandList->SetGraphicsRootConstantBufferView(1, wvpResource->GetGPUVirtualAddress());
+			// マテリアルの配列の場所を設定
+			commandList->SetGraphicsRootShaderResourceView(0, materialAllocation.gpuAddress);
 			// SRVのDescriptorTableの先頭を設定。2はrootParameter[2]である。
+			// 転送が終わるまではプレースホルダのSRVを使う
+			uint32_t textureDescriptorIndex = textureStreamer.IsResident(uvCheckerTexture) ?
+				D3D12TextureUploader::GetDescriptorIndex(uvCheckerTexture) : D3D12TextureUploader::kPlaceholderDescriptorIndex;
+			D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandleGPU = textureSrvStartGPU;
+			textureSrvHandleGPU.ptr += size_t(descriptorSizeSRV) * textureDescriptorIndex;
 			commandList->SetGraphicsRootDescriptorTable(2, textureSrvHandleGPU);
 
 
-			// 描画！（DrawCall/ドローコール）。３頂点で１つのインスタンス。インスタンスについては今後
-			commandList->DrawInstanced(6, 1, 0, 0);
+			// 描画！（DrawCall/ドローコール）。バッチごとに、まとめたインスタンスを1回で描く
+			// SV_InstanceIDはStartInstanceLocationを足さないので、インスタンスの配列の場所をバッチの先頭へずらして渡す
+			// バッチはPSO、メッシュの順に並んでいるので、変わったときだけ設定し直す
+			// RenderItemのpipelineはこの表の番号。ホットリロードで差し替わるので毎フレーム作る
+			ID3D12PipelineState* const pipelineStates[] = { graphicsPipelineState };
+			uint32_t boundPipeline = UINT32_MAX;
+			uint32_t boundMesh = UINT32_MAX;
+			for (const RenderBatch& batch : renderBatcher.GetBatches()) {
+				assert(batch.pipeline < _countof(pipelineStates));
+				// コンパイルできていないPSOのバッチは描かない
+				if (!pipelineStates[batch.pipeline]) {
+					continue;
+				}
+				if (batch.pipeline != boundPipeline) {
+					commandList->SetPipelineState(pipelineStates[batch.pipeline]);   // PSOを設定
+					boundPipeline = batch.pipeline;
+				}
+				const DrawMesh& drawMesh = drawMeshes[batch.mesh];
+				assert(drawMesh.texcoordEncoding == pipelineTexcoordEncoding);
+				if (batch.mesh != boundMesh) {
+					commandList->IASetVertexBuffers(0, 1, &drawMesh.vertexBufferView); // VBVを設定
+					commandList->IASetIndexBuffer(&drawMesh.indexBufferView); // IBVを設定
+					// 位置の復元の値を設定
+					commandList->SetGraphicsRoot32BitConstants(3, _countof(drawMesh.positionDecodeConstants), drawMesh.positionDecodeConstants, 0);
+					boundMesh = batch.mesh;
+				}
+				commandList->SetGraphicsRootShaderResourceView(1, instanceAllocation.gpuAddress + sizeof(InstanceData) * batch.firstInstance);
+				commandList->DrawIndexedInstanced(drawMesh.indexCount, batch.instanceCount, 0, 0, 0);
+			}
 
 			//ここまで-ImGui_ImplDX12_Init()--------------------------------------------------------------------------------------
 			
@@ -1037,25 +1053,8 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 			// GPUとOSに画面の交換を行うよう通知する
 			swapChain->Present(1, 0);
 
-			// Fenceの値を更新
-			fenceValue++;
-			// GPUがここまでたどり着いたときに、Fenceの値を指定した値に代入するようにSignalを送る
-			commandQueue->Signal(fence, fenceValue);
-
-			// Fenceの値が指定したSignal値にたどり着いているか確認する
-			// GetCompletedValueの初期値はFence作成時に渡した初期値
-			if (fence->GetCompletedValue() < fenceValue) {
-				// 指定したSignalにたどりついていないので、たどり着くまで待つようにイベントを設定する
-				fence->SetEventOnCompletion(fenceValue, fenceEvent);
-				// イベントを待つ
-				WaitForSingleObject(fenceEvent, INFINITE);
-			}
-
-			// 次のフレーム用のコマンドリストを準備
-			hr = commandAllocator->Reset();
-			assert(SUCCEEDED(hr));
-			hr = commandList->Reset(commandAllocator, nullptr);
-			assert(SUCCEEDED(hr));
+			// このフレームのコマンドの後ろにSignalを積む。GPUの完了は次にこの区画を使うときまで待たない
+			frameRing.EndFrame();
 		}
 	}
 
@@ -1063,9 +1062,11 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	OutputDebugStringA("Hello,DirectX!\n");
 
 
+	// GPUが全て終わってから解放する
+	frameRing.WaitForIdle();
+
 	// 解放処理
-	CloseHandle(fenceEvent);
-	fence->Release();
+	gpuTimeline.Finalize();
 	srvDescriptorHeap->Release();
 	rtvDescriptorHeap->Release();
 	dsvDescriptorHeap->Release();
@@ -1073,7 +1074,9 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	swapChainResources[1]->Release();
 	swapChain->Release();
 	commandList->Release();
-	commandAllocator->Release();
+	for (ID3D12CommandAllocator* commandAllocator : commandAllocators) {
+		commandAllocator->Release();
+	}
 	commandQueue->Release();
 	device->Release();
 	useAdapter->Release();
@@ -1083,24 +1086,28 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 #endif
 	CloseWindow(hwnd);
 
-	vertexResource->Release();
-	graphicsPipelineState->Release();
+	resourceAllocator.ReleaseResource(indexResource);
+	resourceAllocator.ReleaseResource(vertexResource);
+	// コンパイル中のものを待つ。コンパイラより先に止める
+	shaderHotReloader.Finalize();
+	// PSOはキャッシュが持っている。新しく作ったものがあればここで保存される
+	pipelineStateCache.Finalize();
 	signatureBlob->Release();
 	if (errorBlob) {
 		errorBlob->Release();
 	}
 	rootSignature->Release();
-	pixelShaderBlob->Release();
-	vertexShaderBlob->Release();
-	materialResource->Release();
-	wvpResource->Release();
-	includeHandler->Release();
-	dxcCompiler->Release();
-	dxcUtils->Release();
+	for (LinearUploadAllocator& uploadAllocator : uploadAllocators) {
+		uploadAllocator.Finalize();
+	}
+	shaderCompiler.Finalize();
 
-	depthStencilResource->Release();
+	resourceAllocator.ReleaseResource(depthStencilResource);
 
-	textureResource->Release();
+	textureStreamer.Finalize();
+	textureUploader.Finalize();
+	// 全てのResourceを返したのでHeapを解放する
+	resourceAllocator.Finalize();
 
 	// ImGuiの終了処理。詳細はさして重要ではないので開設は省略する。
 	// こういうもんである。初期化と逆順に行う
@@ -1123,156 +1130,3 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 
 	return 0;
 }
-
-// 単位行列の作成
-Matrix4x4 MakeIdentity4x4() {
-	Matrix4x4 result;
-	for (int i = 0; i < 4; i++) {
-		for (int j = 0; j < 4; j++) {
-			if (i == j) {
-				result.m[i][j] = 1.0f;
-			} else {
-				result.m[i][j] = 0.0f;
-			}
-		}
-	}
-	return result;
-}
-
-// 4x4行列の積
-Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2) {
-	Matrix4x4 result;
-	for (int i = 0; i < 4; i++) {
-		for (int j = 0; j < 4; j++) {
-			result.m[i][j] = 0;
-			for (int k = 0; k < 4; k++) {
-				result.m[i][j] += m1.m[i][k] * m2.m[k][j];
-			}
-		}
-	}
-	return result;
-}
-
-// X軸回転行列
-Matrix4x4 MakeRotateXMatrix(float angle) {
-	Matrix4x4 result = {};
-	result.m[0][0] = 1.0f;
-	result.m[3][3] = 1.0f;
-	result.m[1][1] = std::cos(angle);
-	result.m[1][2] = std::sin(angle);
-	result.m[2][1] = -std::sin(angle);
-	result.m[2][2] = std::cos(angle);
-	return result;
-}
-// Y軸回転行列
-Matrix4x4 MakeRotateYMatrix(float angle) {
-	Matrix4x4 result = {};
-	result.m[1][1] = 1.0f;
-	result.m[3][3] = 1.0f;
-	result.m[0][0] = std::cos(angle);
-	result.m[0][2] = -std::sin(angle);
-	result.m[2][0] = std::sin(angle);
-	result.m[2][2] = std::cos(angle);
-	return result;
-}
-// Z軸回転行列
-Matrix4x4 MakeRotateZMatrix(float angle) {
-	Matrix4x4 result = {};
-	result.m[2][2] = 1.0f;
-	result.m[3][3] = 1.0f;
-	result.m[0][0] = std::cos(angle);
-	result.m[0][1] = std::sin(angle);
-	result.m[1][0] = -std::sin(angle);
-	result.m[1][1] = std::cos(angle);
-	return result;
-}
-
-// 3次元アフィン変換行列
-Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Vector3& rotate, const Vector3& translate) {
-	Matrix4x4 result = {};
-	// X,Y,Z軸の回転をまとめる
-	Matrix4x4 rotateXYZ =
-		Multiply(MakeRotateXMatrix(rotate.x), Multiply(MakeRotateYMatrix(rotate.y), MakeRotateZMatrix(rotate.z)));
-
-	result.m[0][0] = scale.x * rotateXYZ.m[0][0];
-	result.m[0][1] = scale.x * rotateXYZ.m[0][1];
-	result.m[0][2] = scale.x * rotateXYZ.m[0][2];
-	result.m[1][0] = scale.y * rotateXYZ.m[1][0];
-	result.m[1][1] = scale.y * rotateXYZ.m[1][1];
-	result.m[1][2] = scale.y * rotateXYZ.m[1][2];
-	result.m[2][0] = scale.z * rotateXYZ.m[2][0];
-	result.m[2][1] = scale.z * rotateXYZ.m[2][1];
-	result.m[2][2] = scale.z * rotateXYZ.m[2][2];
-	result.m[3][0] = translate.x;
-	result.m[3][1] = translate.y;
-	result.m[3][2] = translate.z;
-	result.m[3][3] = 1.0f;
-
-	return result;
-}
-
-// 透視投影行列
-Matrix4x4 MakePerspectiveFovMatrix(float fovY, float aspectRatio, float nearClip, float farClip) {
-	Matrix4x4 result = {};
-	result.m[0][0] = 1.0f / (aspectRatio * std::tan(fovY / 2.0f));
-	result.m[1][1] = 1.0f / std::tan(fovY / 2.0f);
-	result.m[2][2] = farClip / (farClip - nearClip);
-	result.m[2][3] = 1.0f;
-	result.m[3][2] = -(farClip * nearClip) / (farClip - nearClip);
-	return result;
-}
-
-// 逆行列
-Matrix4x4 Inverse(const Matrix4x4& m) {
-	Matrix4x4 result;
-	float determinant = 0;
-	// 行列式を計算
-	determinant =
-		m.m[0][0] * m.m[1][1] * m.m[2][2] * m.m[3][3] + m.m[0][0] * m.m[1][2] * m.m[2][3] * m.m[3][1] + m.m[0][0] * m.m[1][3] * m.m[2][1] * m.m[3][2]
-		- m.m[0][0] * m.m[1][3] * m.m[2][2] * m.m[3][1] - m.m[0][0] * m.m[1][2] * m.m[2][1] * m.m[3][3] - m.m[0][0] * m.m[1][1] * m.m[2][3] * m.m[3][2]
-		- m.m[0][1] * m.m[1][0] * m.m[2][2] * m.m[3][3] - m.m[0][2] * m.m[1][0] * m.m[2][3] * m.m[3][1] - m.m[0][3] * m.m[1][0] * m.m[2][1] * m.m[3][2]
-		+ m.m[0][3] * m.m[1][0] * m.m[2][2] * m.m[3][1] + m.m[0][2] * m.m[1][0] * m.m[2][1] * m.m[3][3] + m.m[0][1] * m.m[1][0] * m.m[2][3] * m.m[3][2]
-		+ m.m[0][1] * m.m[1][2] * m.m[2][0] * m.m[3][3] + m.m[0][2] * m.m[1][3] * m.m[2][0] * m.m[3][1] + m.m[0][3] * m.m[1][1] * m.m[2][0] * m.m[3][2]
-		- m.m[0][3] * m.m[1][2] * m.m[2][0] * m.m[3][1] - m.m[0][2] * m.m[1][1] * m.m[2][0] * m.m[3][3] - m.m[0][1] * m.m[1][3] * m.m[2][0] * m.m[3][2]
-		- m.m[0][1] * m.m[1][2] * m.m[2][3] * m.m[3][0] - m.m[0][2] * m.m[1][3] * m.m[2][1] * m.m[3][0] - m.m[0][3] * m.m[1][1] * m.m[2][2] * m.m[3][0]
-		+ m.m[0][3] * m.m[1][2] * m.m[2][1] * m.m[3][0] + m.m[0][2] * m.m[1][1] * m.m[2][3] * m.m[3][0] + m.m[0][1] * m.m[1][3] * m.m[2][2] * m.m[3][0];
-
-	// 逆行列を計算
-	result.m[0][0] = (m.m[1][1] * m.m[2][2] * m.m[3][3] + m.m[1][2] * m.m[2][3] * m.m[3][1] + m.m[1][3] * m.m[2][1] * m.m[3][2]
-		- m.m[1][3] * m.m[2][2] * m.m[3][1] - m.m[1][2] * m.m[2][1] * m.m[3][3] - m.m[1][1] * m.m[2][3] * m.m[3][2]) / determinant;
-	result.m[0][1] = (-m.m[0][1] * m.m[2][2] * m.m[3][3] - m.m[0][2] * m.m[2][3] * m.m[3][1] - m.m[0][3] * m.m[2][1] * m.m[3][2]
-		+ m.m[0][3] * m.m[2][2] * m.m[3][1] + m.m[0][2] * m.m[2][1] * m.m[3][3] + m.m[0][1] * m.m[2][3] * m.m[3][2]) / determinant;
-	result.m[0][2] = (m.m[0][1] * m.m[1][2] * m.m[3][3] + m.m[0][2] * m.m[1][3] * m.m[3][1] + m.m[0][3] * m.m[1][1] * m.m[3][2]
-		- m.m[0][3] * m.m[1][2] * m.m[3][1] - m.m[0][2] * m.m[1][1] * m.m[3][3] - m.m[0][1] * m.m[1][3] * m.m[3][2]) / determinant;
-	result.m[0][3] = (-m.m[0][1] * m.m[1][2] * m.m[2][3] - m.m[0][2] * m.m[1][3] * m.m[2][1] - m.m[0][3] * m.m[1][1] * m.m[2][2]
-		+ m.m[0][3] * m.m[1][2] * m.m[2][1] + m.m[0][2] * m.m[1][1] * m.m[2][3] + m.m[0][1] * m.m[1][3] * m.m[2][2]) / determinant;
-
-	result.m[1][0] = (-m.m[1][0] * m.m[2][2] * m.m[3][3] - m.m[1][2] * m.m[2][3] * m.m[3][0] - m.m[1][3] * m.m[2][0] * m.m[3][2]
-		+ m.m[1][3] * m.m[2][2] * m.m[3][0] + m.m[1][2] * m.m[2][0] * m.m[3][3] + m.m[1][0] * m.m[2][3] * m.m[3][2]) / determinant;
-	result.m[1][1] = (m.m[0][0] * m.m[2][2] * m.m[3][3] + m.m[0][2] * m.m[2][3] * m.m[3][0] + m.m[0][3] * m.m[2][0] * m.m[3][2]
-		- m.m[0][3] * m.m[2][2] * m.m[3][0] - m.m[0][2] * m.m[2][0] * m.m[3][3] - m.m[0][0] * m.m[2][3] * m.m[3][2]) / determinant;
-	result.m[1][2] = (-m.m[0][0] * m.m[1][2] * m.m[3][3] - m.m[0][2] * m.m[1][3] * m.m[3][0] - m.m[0][3] * m.m[1][0] * m.m[3][2]
-		+ m.m[0][3] * m.m[1][2] * m.m[3][0] + m.m[0][2] * m.m[1][0] * m.m[3][3] + m.m[0][0] * m.m[1][3] * m.m[3][2]) / determinant;
-	result.m[1][3] = (m.m[0][0] * m.m[1][2] * m.m[2][3] + m.m[0][2] * m.m[1][3] * m.m[2][0] + m.m[0][3] * m.m[1][0] * m.m[2][2]
-		- m.m[0][3] * m.m[1][2] * m.m[2][0] - m.m[0][2] * m.m[1][0] * m.m[2][3] - m.m[0][0] * m.m[1][3] * m.m[2][2]) / determinant;
-
-	result.m[2][0] = (m.m[1][0] * m.m[2][1] * m.m[3][3] + m.m[1][1] * m.m[2][3] * m.m[3][0] + m.m[1][3] * m.m[2][0] * m.m[3][1]
-		- m.m[1][3] * m.m[2][1] * m.m[3][0] - m.m[1][1] * m.m[2][0] * m.m[3][3] - m.m[1][0] * m.m[2][3] * m.m[3][1]) / determinant;
-	result.m[2][1] = (-m.m[0][0] * m.m[2][1] * m.m[3][3] - m.m[0][1] * m.m[2][3] * m.m[3][0] - m.m[0][3] * m.m[2][0] * m.m[3][1]
-		+ m.m[0][3] * m.m[2][1] * m.m[3][0] + m.m[0][1] * m.m[2][0] * m.m[3][3] + m.m[0][0] * m.m[2][3] * m.m[3][1]) / determinant;
-	result.m[2][2] = (m.m[0][0] * m.m[1][1] * m.m[3][3] + m.m[0][1] * m.m[1][3] * m.m[3][0] + m.m[0][3] * m.m[1][0] * m.m[3][1]
-		- m.m[0][3] * m.m[1][1] * m.m[3][0] - m.m[0][1] * m.m[1][0] * m.m[3][3] - m.m[0][0] * m.m[1][3] * m.m[3][1]) / determinant;
-	result.m[2][3] = (-m.m[0][0] * m.m[1][1] * m.m[2][3] - m.m[0][1] * m.m[1][3] * m.m[2][0] - m.m[0][3] * m.m[1][0] * m.m[2][1]
-		+ m.m[0][3] * m.m[1][1] * m.m[2][0] + m.m[0][1] * m.m[1][0] * m.m[2][3] + m.m[0][0] * m.m[1][3] * m.m[2][1]) / determinant;
-
-	result.m[3][0] = (-m.m[1][0] * m.m[2][1] * m.m[3][2] - m.m[1][1] * m.m[2][2] * m.m[3][0] - m.m[1][2] * m.m[2][0] * m.m[3][1]
-		+ m.m[1][2] * m.m[2][1] * m.m[3][0] + m.m[1][1] * m.m[2][0] * m.m[3][2] + m.m[1][0] * m.m[2][2] * m.m[3][1]) / determinant;
-	result.m[3][1] = (m.m[0][0] * m.m[2][1] * m.m[3][2] + m.m[0][1] * m.m[2][2] * m.m[3][0] + m.m[0][2] * m.m[2][0] * m.m[3][1]
-		- m.m[0][2] * m.m[2][1] * m.m[3][0] - m.m[0][1] * m.m[2][0] * m.m[3][2] - m.m[0][0] * m.m[2][2] * m.m[3][1]) / determinant;
-	result.m[3][2] = (-m.m[0][0] * m.m[1][1] * m.m[3][2] - m.m[0][1] * m.m[1][2] * m.m[3][0] - m.m[0][2] * m.m[1][0] * m.m[3][1]
-		+ m.m[0][2] * m.m[1][1] * m.m[3][0] + m.m[0][1] * m.m[1][0] * m.m[3][2] + m.m[0][0] * m.m[1][2] * m.m[3][1]) / determinant;
-	result.m[3][3] = (m.m[0][0] * m.m[1][1] * m.m[2][2] + m.m[0][1] * m.m[1][2] * m.m[2][0] + m.m[0][2] * m.m[1][0] * m.m[2][1]
-		- m.m[0][2] * m.m[1][1] * m.m[2][0] - m.m[0][1] * m.m[1][0] * m.m[2][2] - m.m[0][0] * m.m[1][2] * m.m[2][1]) / determinant;
-
-	return result;
-}
\ No newline at end of file